@@ -0,0 +1,68 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/test/CMakeLists.txt"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCXXSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFileCXX.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/brg_sim.dir/DependInfo.cmake"
+  "CMakeFiles/test_baud_switch.dir/DependInfo.cmake"
+  "CMakeFiles/test_boot_seq.dir/DependInfo.cmake"
+  "CMakeFiles/test_cmd_stats.dir/DependInfo.cmake"
+  "CMakeFiles/test_cyclic_sched.dir/DependInfo.cmake"
+  "CMakeFiles/test_errlog.dir/DependInfo.cmake"
+  "CMakeFiles/test_event_loop.dir/DependInfo.cmake"
+  "CMakeFiles/test_gpio_wave.dir/DependInfo.cmake"
+  "CMakeFiles/test_hw_time.dir/DependInfo.cmake"
+  "CMakeFiles/test_i2c_eeprom.dir/DependInfo.cmake"
+  "CMakeFiles/test_i2c_read.dir/DependInfo.cmake"
+  "CMakeFiles/test_i2c_timing.dir/DependInfo.cmake"
+  "CMakeFiles/test_rx_pump.dir/DependInfo.cmake"
+  "CMakeFiles/test_shared_mode.dir/DependInfo.cmake"
+  "CMakeFiles/test_shm_bus.dir/DependInfo.cmake"
+  "CMakeFiles/test_spi_flash.dir/DependInfo.cmake"
+  "CMakeFiles/test_spi_stream.dir/DependInfo.cmake"
+  "CMakeFiles/test_tx_queue.dir/DependInfo.cmake"
+  "CMakeFiles/test_voltage_sampler.dir/DependInfo.cmake"
+  )
@@ -0,0 +1,40 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/ErrLog.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/ErrLog.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/ErrLog.cpp.o.d"
+  "/root/repo/src/brg_baud_switch.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_baud_switch.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_baud_switch.cpp.o.d"
+  "/root/repo/src/brg_boot_seq.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_boot_seq.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_boot_seq.cpp.o.d"
+  "/root/repo/src/brg_chrome_trace.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_chrome_trace.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_chrome_trace.cpp.o.d"
+  "/root/repo/src/brg_correlator.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_correlator.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_correlator.cpp.o.d"
+  "/root/repo/src/brg_cyclic_sched.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_cyclic_sched.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_cyclic_sched.cpp.o.d"
+  "/root/repo/src/brg_event_loop.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_event_loop.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_event_loop.cpp.o.d"
+  "/root/repo/src/brg_frame.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_frame.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_frame.cpp.o.d"
+  "/root/repo/src/brg_gpio_wave.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_gpio_wave.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_gpio_wave.cpp.o.d"
+  "/root/repo/src/brg_hw_time.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_hw_time.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_hw_time.cpp.o.d"
+  "/root/repo/src/brg_i2c_eeprom.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_i2c_eeprom.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_i2c_eeprom.cpp.o.d"
+  "/root/repo/src/brg_latency.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_latency.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_latency.cpp.o.d"
+  "/root/repo/src/brg_rx_pump.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_rx_pump.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_rx_pump.cpp.o.d"
+  "/root/repo/src/brg_shm_bus.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_shm_bus.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_shm_bus.cpp.o.d"
+  "/root/repo/src/brg_spi_flash.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_spi_flash.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_spi_flash.cpp.o.d"
+  "/root/repo/src/brg_tx_queue.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_tx_queue.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_tx_queue.cpp.o.d"
+  "/root/repo/src/brg_voltage_sampler.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/brg_voltage_sampler.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/brg_voltage_sampler.cpp.o.d"
+  "/root/repo/src/bridge.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/bridge.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/bridge.cpp.o.d"
+  "/root/repo/src/criticalsectionlock.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/criticalsectionlock.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/criticalsectionlock.cpp.o.d"
+  "/root/repo/src/stlink_device.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/stlink_device.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/stlink_device.cpp.o.d"
+  "/root/repo/src/stlink_interface.cpp" "CMakeFiles/brg_sim.dir/root/repo/src/stlink_interface.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/root/repo/src/stlink_interface.cpp.o.d"
+  "/root/repo/test/sim/brg_sim_driver.cpp" "CMakeFiles/brg_sim.dir/sim/brg_sim_driver.cpp.o" "gcc" "CMakeFiles/brg_sim.dir/sim/brg_sim_driver.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
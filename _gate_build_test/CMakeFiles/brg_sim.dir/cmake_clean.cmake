@@ -0,0 +1,53 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/brg_sim.dir/root/repo/src/ErrLog.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/ErrLog.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_baud_switch.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_baud_switch.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_boot_seq.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_boot_seq.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_chrome_trace.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_chrome_trace.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_correlator.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_correlator.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_cyclic_sched.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_cyclic_sched.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_event_loop.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_event_loop.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_frame.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_frame.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_gpio_wave.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_gpio_wave.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_hw_time.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_hw_time.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_i2c_eeprom.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_i2c_eeprom.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_latency.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_latency.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_rx_pump.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_rx_pump.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_shm_bus.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_shm_bus.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_spi_flash.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_spi_flash.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_tx_queue.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_tx_queue.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_voltage_sampler.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/brg_voltage_sampler.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/bridge.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/bridge.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/criticalsectionlock.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/criticalsectionlock.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/stlink_device.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/stlink_device.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/root/repo/src/stlink_interface.cpp.o"
+  "CMakeFiles/brg_sim.dir/root/repo/src/stlink_interface.cpp.o.d"
+  "CMakeFiles/brg_sim.dir/sim/brg_sim_driver.cpp.o"
+  "CMakeFiles/brg_sim.dir/sim/brg_sim_driver.cpp.o.d"
+  "libbrg_sim.a"
+  "libbrg_sim.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/brg_sim.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_baud_switch.dir/test_baud_switch.cpp.o"
+  "CMakeFiles/test_baud_switch.dir/test_baud_switch.cpp.o.d"
+  "test_baud_switch"
+  "test_baud_switch.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_baud_switch.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
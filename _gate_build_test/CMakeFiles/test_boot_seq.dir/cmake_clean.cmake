@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_boot_seq.dir/test_boot_seq.cpp.o"
+  "CMakeFiles/test_boot_seq.dir/test_boot_seq.cpp.o.d"
+  "test_boot_seq"
+  "test_boot_seq.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_boot_seq.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_cmd_stats.dir/test_cmd_stats.cpp.o"
+  "CMakeFiles/test_cmd_stats.dir/test_cmd_stats.cpp.o.d"
+  "test_cmd_stats"
+  "test_cmd_stats.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_cmd_stats.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_cyclic_sched.dir/test_cyclic_sched.cpp.o"
+  "CMakeFiles/test_cyclic_sched.dir/test_cyclic_sched.cpp.o.d"
+  "test_cyclic_sched"
+  "test_cyclic_sched.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_cyclic_sched.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
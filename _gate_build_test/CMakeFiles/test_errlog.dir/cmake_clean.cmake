@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_errlog.dir/test_errlog.cpp.o"
+  "CMakeFiles/test_errlog.dir/test_errlog.cpp.o.d"
+  "test_errlog"
+  "test_errlog.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_errlog.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
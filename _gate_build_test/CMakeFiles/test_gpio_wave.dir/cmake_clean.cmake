@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_gpio_wave.dir/test_gpio_wave.cpp.o"
+  "CMakeFiles/test_gpio_wave.dir/test_gpio_wave.cpp.o.d"
+  "test_gpio_wave"
+  "test_gpio_wave.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_gpio_wave.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_hw_time.dir/test_hw_time.cpp.o"
+  "CMakeFiles/test_hw_time.dir/test_hw_time.cpp.o.d"
+  "test_hw_time"
+  "test_hw_time.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_hw_time.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
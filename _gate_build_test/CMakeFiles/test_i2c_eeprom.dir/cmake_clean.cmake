@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_i2c_eeprom.dir/test_i2c_eeprom.cpp.o"
+  "CMakeFiles/test_i2c_eeprom.dir/test_i2c_eeprom.cpp.o.d"
+  "test_i2c_eeprom"
+  "test_i2c_eeprom.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_i2c_eeprom.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_i2c_read.dir/test_i2c_read.cpp.o"
+  "CMakeFiles/test_i2c_read.dir/test_i2c_read.cpp.o.d"
+  "test_i2c_read"
+  "test_i2c_read.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_i2c_read.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
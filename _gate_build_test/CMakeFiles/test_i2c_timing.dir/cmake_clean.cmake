@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_i2c_timing.dir/test_i2c_timing.cpp.o"
+  "CMakeFiles/test_i2c_timing.dir/test_i2c_timing.cpp.o.d"
+  "test_i2c_timing"
+  "test_i2c_timing.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_i2c_timing.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
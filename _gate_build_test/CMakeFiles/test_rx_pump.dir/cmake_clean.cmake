@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_rx_pump.dir/test_rx_pump.cpp.o"
+  "CMakeFiles/test_rx_pump.dir/test_rx_pump.cpp.o.d"
+  "test_rx_pump"
+  "test_rx_pump.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_rx_pump.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
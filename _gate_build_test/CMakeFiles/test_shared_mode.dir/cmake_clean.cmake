@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_shared_mode.dir/test_shared_mode.cpp.o"
+  "CMakeFiles/test_shared_mode.dir/test_shared_mode.cpp.o.d"
+  "test_shared_mode"
+  "test_shared_mode.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_shared_mode.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
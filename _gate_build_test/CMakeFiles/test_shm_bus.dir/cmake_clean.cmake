@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_shm_bus.dir/test_shm_bus.cpp.o"
+  "CMakeFiles/test_shm_bus.dir/test_shm_bus.cpp.o.d"
+  "test_shm_bus"
+  "test_shm_bus.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_shm_bus.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_spi_flash.dir/test_spi_flash.cpp.o"
+  "CMakeFiles/test_spi_flash.dir/test_spi_flash.cpp.o.d"
+  "test_spi_flash"
+  "test_spi_flash.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_spi_flash.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
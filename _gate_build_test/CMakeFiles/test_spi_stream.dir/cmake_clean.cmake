@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_spi_stream.dir/test_spi_stream.cpp.o"
+  "CMakeFiles/test_spi_stream.dir/test_spi_stream.cpp.o.d"
+  "test_spi_stream"
+  "test_spi_stream.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_spi_stream.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
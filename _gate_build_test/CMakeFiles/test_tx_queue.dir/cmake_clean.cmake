@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_tx_queue.dir/test_tx_queue.cpp.o"
+  "CMakeFiles/test_tx_queue.dir/test_tx_queue.cpp.o.d"
+  "test_tx_queue"
+  "test_tx_queue.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_tx_queue.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_voltage_sampler.dir/test_voltage_sampler.cpp.o"
+  "CMakeFiles/test_voltage_sampler.dir/test_voltage_sampler.cpp.o.d"
+  "test_voltage_sampler"
+  "test_voltage_sampler.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_voltage_sampler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,42 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/test
+# Build directory: /root/repo/_gate_build_test
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(test_baud_switch "/root/repo/_gate_build_test/test_baud_switch")
+set_tests_properties(test_baud_switch PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_boot_seq "/root/repo/_gate_build_test/test_boot_seq")
+set_tests_properties(test_boot_seq PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_cmd_stats "/root/repo/_gate_build_test/test_cmd_stats")
+set_tests_properties(test_cmd_stats PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_cyclic_sched "/root/repo/_gate_build_test/test_cyclic_sched")
+set_tests_properties(test_cyclic_sched PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_errlog "/root/repo/_gate_build_test/test_errlog")
+set_tests_properties(test_errlog PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_event_loop "/root/repo/_gate_build_test/test_event_loop")
+set_tests_properties(test_event_loop PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_gpio_wave "/root/repo/_gate_build_test/test_gpio_wave")
+set_tests_properties(test_gpio_wave PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_hw_time "/root/repo/_gate_build_test/test_hw_time")
+set_tests_properties(test_hw_time PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_i2c_eeprom "/root/repo/_gate_build_test/test_i2c_eeprom")
+set_tests_properties(test_i2c_eeprom PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_i2c_read "/root/repo/_gate_build_test/test_i2c_read")
+set_tests_properties(test_i2c_read PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_i2c_timing "/root/repo/_gate_build_test/test_i2c_timing")
+set_tests_properties(test_i2c_timing PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_rx_pump "/root/repo/_gate_build_test/test_rx_pump")
+set_tests_properties(test_rx_pump PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_shared_mode "/root/repo/_gate_build_test/test_shared_mode")
+set_tests_properties(test_shared_mode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_shm_bus "/root/repo/_gate_build_test/test_shm_bus")
+set_tests_properties(test_shm_bus PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_spi_flash "/root/repo/_gate_build_test/test_spi_flash")
+set_tests_properties(test_spi_flash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_spi_stream "/root/repo/_gate_build_test/test_spi_stream")
+set_tests_properties(test_spi_stream PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_tx_queue "/root/repo/_gate_build_test/test_tx_queue")
+set_tests_properties(test_tx_queue PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
+add_test(test_voltage_sampler "/root/repo/_gate_build_test/test_voltage_sampler")
+set_tests_properties(test_voltage_sampler PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;44;add_test;/root/repo/test/CMakeLists.txt;0;")
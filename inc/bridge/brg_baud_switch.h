@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file    brg_baud_switch.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_baud_switch.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_BAUD_SWITCH_H
+#define _BRG_BAUD_SWITCH_H
+/* Includes ------------------------------------------------------------------*/
+#include "brg_correlator.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_BAUD_SWITCH_POLL_SLEEP_US 200 ///< Sleep between two Rx polls while waiting for a response
+
+/// Frame sent to the target and response expected from it (see BrgCanBaudSwitch)
+typedef struct {
+	Brg_CanTxMsgT Msg;       ///< Frame to send (DLC set from Size)
+	uint8_t Data[8];         ///< Data of the frame
+	uint8_t Size;            ///< Number of bytes of Data (0 to 8)
+	Brg_CorrMatchT Response; ///< Expected response
+	uint32_t TimeoutMs;      ///< Max time to wait for the response
+} Brg_CanExchangeT;
+
+/// BrgCanBaudSwitch statistics, see BrgCanBaudSwitch::GetStats()
+typedef struct {
+	uint32_t NominalBaudrate; ///< Bus rate outside of the fast sessions
+	uint32_t FastBaudrate;    ///< Bus rate of the last fast session (0 if none)
+	uint32_t SwitchNb;        ///< Successful switches to the fast rate
+	uint32_t FailedSwitchNb;  ///< Negotiations or probes failed (reverted to nominal rate)
+	uint64_t FastFrameNb;     ///< Frames sent with BrgCanBaudSwitch::WriteMsgCAN() at the fast rate
+	uint64_t FastBitNb;       ///< Their size on the bus (unstuffed bits, interframe space included)
+	uint64_t FastTimeUs;      ///< Time spent at the fast rate (switch to revert)
+	uint64_t SavedUs;         ///< Bus time saved by FastBitNb versus the nominal rate
+} Brg_BaudSwitchStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Coordinated CAN bitrate switch for flashing sessions: the switch is negotiated with
+/// the target at the nominal rate, the bridge is reinitialized (#BRG_REINIT: filters and
+/// reception kept) at the fast rate, a probe exchange verifies the link and any failure
+/// reverts to the nominal rate. The bridge must be CAN initialized at the nominal rate
+/// with reception started and filters letting the responses through; frames received
+/// while waiting for a response and not matching it are dropped. Each call holds
+/// Brg::GetTransactionLock(), SwitchUp() and Revert() for the whole sequence, so that
+/// BrgTxQueue or BrgRxPump traffic waits for the end of the switch.
+class BrgCanBaudSwitch
+{
+public:
+	BrgCanBaudSwitch(Brg &Bridge, const Brg_CanInitT *pNominalInit, uint32_t NominalBaudrate);
+	virtual ~BrgCanBaudSwitch(void);
+
+	Brg_StatusT SwitchUp(uint32_t FastBaudrate, uint16_t SamplePointPermil,
+	                     const Brg_CanExchangeT *pNegotiate, const Brg_CanExchangeT *pProbe);
+	Brg_StatusT Revert(const Brg_CanExchangeT *pNotify=NULL);
+	Brg_StatusT WriteMsgCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes);
+	Brg_StatusT Exchange(const Brg_CanExchangeT *pExchange, Brg_RxFrameT *pResponse=NULL);
+
+	/**
+	 * @ingroup CAN
+	 * @retval true between a successful SwitchUp() and Revert().
+	 */
+	bool IsFast(void) const {
+		return m_bFast;
+	}
+	void GetStats(Brg_BaudSwitchStatsT *pStats) const;
+
+	static uint32_t GetFrameBitNb(const Brg_CanTxMsgT *pCanMsg, uint8_t SizeInBytes);
+
+private:
+	static void ExchangeDone(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+	                         const Brg_RxFrameT *pFrame);
+
+	Brg &m_brg;
+	BrgCorrelator m_correlator;
+	Brg_CanInitT m_nominalInit;
+	Brg_CanInitT m_fastInit;
+	bool m_bFast;
+	uint64_t m_fastStartUs;
+
+	// Current Exchange() outcome, set by ExchangeDone()
+	bool m_bExchangeDone;
+	Brg_CorrResultT m_exchangeResult;
+	Brg_RxFrameT m_exchangeFrame;
+
+	Brg_BaudSwitchStatsT m_stats;
+};
+
+#endif //_BRG_BAUD_SWITCH_H
+/** @} */
+/**********************************END OF FILE*********************************/
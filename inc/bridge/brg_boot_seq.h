@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    brg_boot_seq.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_boot_seq.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_BOOT_SEQ_H
+#define _BRG_BOOT_SEQ_H
+/* Includes ------------------------------------------------------------------*/
+#include "brg_baud_switch.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup GPIO
+ * @{
+ */
+#define BRG_BOOTSEQ_MAX_STEPS   16   ///< Max number of steps of a sequence
+#define BRG_BOOTSEQ_SPIN_US     1000 ///< Last part of a wait done by reading the clock instead of sleeping
+
+/// Action of a #Brg_BootSeqStepT
+typedef enum {
+	BRG_BOOTSEQ_GPIO = 0,      ///< Drive the GPIOs of GpioMask (Brg::SetResetGPIO())
+	BRG_BOOTSEQ_CAN_START = 1  ///< Send the start frame given to BrgBootSequencer::Run()
+} Brg_BootSeqActionT;
+
+/// One step of a reset/boot sequence
+typedef struct {
+	Brg_BootSeqActionT Action; ///< Step action
+	uint8_t GpioMask;          ///< #BRG_BOOTSEQ_GPIO: GPIO(s) driven (one or several value of #Brg_GpioMaskT)
+	uint8_t GpioSetMask;       ///< #BRG_BOOTSEQ_GPIO: GPIO(s) of GpioMask driven high, the others low
+	uint32_t AtUs;             ///< Step time from the sequence start (steps given in time order)
+} Brg_BootSeqStepT;
+
+/// Timing of the last BrgBootSequencer::Run(), times in us from the first step
+typedef struct {
+	uint8_t StepNb;                              ///< Steps executed
+	uint32_t StepLateUs[BRG_BOOTSEQ_MAX_STEPS];  ///< Step start minus planned time (AtUs)
+	uint32_t StepCmdUs[BRG_BOOTSEQ_MAX_STEPS];   ///< Duration of the USB command(s) of the step
+	uint32_t MaxLateUs;                          ///< Largest StepLateUs
+	uint32_t FrameSentUs;                        ///< End of the start frame write
+	uint32_t ReadyUs;                            ///< Response of the bootloader received (0 if none expected)
+} Brg_BootSeqResultT;
+// end group doxygen GPIO
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Target reset and bootloader entry through the bridge GPIOs, interleaved with the CAN
+/// bootloader start frame: a target whose application does not answer (hung module) is
+/// reset with its boot pin strapped and the start frame is sent in the bootloader
+/// listening window, without waiting for an application timeout.
+/// Each step starts at its planned time from the first step (sleep, then clock reads for
+/// the last #BRG_BOOTSEQ_SPIN_US), so the USB latency of a step does not shift the next
+/// ones. The GPIOs used by the steps are configured as outputs by Run() just before the
+/// first step; CAN must be initialized, with reception started if a response is expected.
+/// Each call holds Brg::GetTransactionLock().
+class BrgBootSequencer
+{
+public:
+	BrgBootSequencer(Brg &Bridge, Brg_GpioOutputT OutputType=GPIO_OUTPUT_PUSHPULL);
+	virtual ~BrgBootSequencer(void) {}
+
+	Brg_StatusT Run(const Brg_BootSeqStepT *pSteps, uint8_t StepNb, const Brg_CanExchangeT *pStartFrame,
+	                Brg_BootSeqResultT *pResult=NULL);
+
+	static uint8_t MakeResetIntoBoot(Brg_BootSeqStepT *pSteps, uint8_t ResetMask, uint8_t BootMask,
+	                                 Brg_GpioValT BootLevel, uint32_t ResetPulseUs, uint32_t FrameDelayUs,
+	                                 uint32_t BootHoldUs);
+
+private:
+	static void ResponseDone(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+	                         const Brg_RxFrameT *pFrame);
+	Brg_StatusT WaitUntil(uint64_t TimeUs, bool bPollCan);
+	Brg_StatusT SetGpio(uint8_t GpioMask, uint8_t GpioSetMask);
+
+	Brg &m_brg;
+	Brg_GpioOutputT m_outputType;
+	BrgCorrelator m_correlator;
+
+	// Response outcome, set by ResponseDone()
+	bool m_bResponseDone;
+	Brg_CorrResultT m_responseResult;
+	uint64_t m_responseUs;
+};
+
+#endif //_BRG_BOOT_SEQ_H
+/** @} */
+/**********************************END OF FILE*********************************/
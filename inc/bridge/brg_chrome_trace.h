@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    brg_chrome_trace.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_chrome_trace.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_CHROME_TRACE_H
+#define _BRG_CHROME_TRACE_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup GENERAL
+ * @{
+ */
+#define BRG_CHROME_TRACE_DEFAULT_MAX_EVENTS 1000000 ///< Default span limit (next spans dropped)
+
+#define BRG_TRACE_CAT_USB   "usb"   ///< One USB command (StlinkDevice::SendRequest())
+#define BRG_TRACE_CAT_API   "api"   ///< One Brg public function call
+#define BRG_TRACE_CAT_PHASE "phase" ///< Application phase (connection, flashing...)
+
+/// Record a span from here to the end of the enclosing scope (pName and pCat must be
+/// string literals or otherwise outlive BrgChromeTraceStop())
+#define BRG_TRACE_SCOPE(pName, pCat) BrgChromeTraceScope brgTraceScope_(pName, pCat)
+/// Record the enclosing Brg function as a #BRG_TRACE_CAT_API span
+#define BRG_TRACE_API() BRG_TRACE_SCOPE(__func__, BRG_TRACE_CAT_API)
+// end group doxygen GENERAL
+/** @} */
+
+/* Exported variables --------------------------------------------------------*/
+extern std::atomic<bool> g_brgChromeTraceOn;
+
+/* Exported functions --------------------------------------------------------*/
+Brg_StatusT BrgChromeTraceStart(const char *pFileName, uint32_t MaxEvents=BRG_CHROME_TRACE_DEFAULT_MAX_EVENTS);
+Brg_StatusT BrgChromeTraceStop(void);
+void BrgChromeTraceSpan(const char *pName, const char *pCat, uint64_t StartUs, uint64_t EndUs, int64_t Arg=-1);
+
+/**
+ * @ingroup GENERAL
+ * @retval true between BrgChromeTraceStart() and BrgChromeTraceStop().
+ */
+inline bool BrgChromeTraceIsOn(void)
+{
+	return g_brgChromeTraceOn.load(std::memory_order_relaxed);
+}
+
+/* Class -------------------------------------------------------------------- */
+/// Scoped span, see #BRG_TRACE_SCOPE: costs one atomic load when tracing is off
+class BrgChromeTraceScope
+{
+public:
+	BrgChromeTraceScope(const char *pName, const char *pCat): m_pName(pName), m_pCat(pCat),
+		m_startUs((BrgChromeTraceIsOn() == true) ? BrgGetMonotonicUs() : 0) {}
+	~BrgChromeTraceScope(void) {
+		if( (m_startUs != 0) && (BrgChromeTraceIsOn() == true) ) {
+			BrgChromeTraceSpan(m_pName, m_pCat, m_startUs, BrgGetMonotonicUs());
+		}
+	}
+
+private:
+	const char *m_pName;
+	const char *m_pCat;
+	uint64_t m_startUs;
+};
+
+#endif //_BRG_CHROME_TRACE_H
+/** @} */
+/**********************************END OF FILE*********************************/
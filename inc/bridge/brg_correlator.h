@@ -0,0 +1,160 @@
+/**
+  ******************************************************************************
+  * @file    brg_correlator.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_correlator.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_CORRELATOR_H
+#define _BRG_CORRELATOR_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include "brg_frame.h"
+#include "brg_latency.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_CORR_DEFAULT_MAX_PENDING 1024   ///< Default max number of outstanding requests
+#define BRG_CORR_MAX_PENDING         0xFFFF ///< Upper limit of MaxPending (handle index on 16 bits)
+#define BRG_CORR_MAX_PREFIX_SIZE     8      ///< Max payload prefix compared by a #Brg_CorrMatchT
+#define BRG_CORR_WHEEL_SLOTS         512    ///< Deadline wheel size (1ms ticks, power of 2)
+#define BRG_CORR_POLL_MAX_MSG        64     ///< Max messages read per BrgCorrelator::PollCAN() call
+#define BRG_CORR_INVALID_HANDLE      0      ///< Never returned as a valid handle
+
+/// Outcome of an outstanding request, given to the #Brg_CorrCallbackT
+typedef enum {
+	BRG_CORR_RESOLVED = 0,  ///< Matching frame received (pFrame valid)
+	BRG_CORR_EXPIRED = 1,   ///< Deadline reached without matching frame
+	BRG_CORR_CANCELLED = 2  ///< BrgCorrelator::Cancel() or BrgCorrelator::CancelAll() called
+} Brg_CorrResultT;
+
+/// Expected response: identifier and optional payload prefix
+typedef struct {
+	Brg_CanMsgIdT IDE;   ///< Standard or extended identifier
+	uint32_t ID;         ///< Response identifier
+	uint8_t PrefixSize;  ///< Number of leading data bytes to compare (0: any payload, max #BRG_CORR_MAX_PREFIX_SIZE)
+	uint8_t Prefix[BRG_CORR_MAX_PREFIX_SIZE]; ///< Expected leading data bytes
+} Brg_CorrMatchT;
+
+/// Completion callback, called once per registered request from the thread calling
+/// BrgCorrelator::DispatchRx(), BrgCorrelator::ExpireDue() or BrgCorrelator::Cancel()
+/// (never with the BrgCorrelator lock held, so it may register a new request).
+/// pFrame is NULL unless Result is #BRG_CORR_RESOLVED.
+typedef void (*Brg_CorrCallbackT)(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+                                  const Brg_RxFrameT *pFrame);
+
+/// BrgCorrelator statistics, see BrgCorrelator::GetStats()
+typedef struct {
+	uint32_t PendingNb;     ///< Currently outstanding requests
+	uint32_t MaxPendingNb;  ///< Highest PendingNb since last ResetStats()
+	uint64_t RegisteredNb;  ///< Requests registered
+	uint64_t ResolvedNb;    ///< Requests resolved by a matching frame
+	uint64_t ExpiredNb;     ///< Requests expired
+	uint64_t CancelledNb;   ///< Requests cancelled
+	uint64_t UnmatchedRxNb; ///< Dispatched frames matching no outstanding request
+	Brg_LatencySummaryT ResponseTime; ///< Register to matching frame reception time
+} Brg_CorrStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Request/response correlation: outstanding requests are registered with the
+/// response they expect (ID + optional payload prefix) and a deadline. Received
+/// frames are resolved in O(1) through a hash table keyed by IDE/ID (requests
+/// waiting on the same ID are matched oldest first) and deadlines are kept in a
+/// hashed timing wheel of 1ms ticks.
+class BrgCorrelator
+{
+public:
+	BrgCorrelator(uint32_t MaxPending=BRG_CORR_DEFAULT_MAX_PENDING);
+	virtual ~BrgCorrelator(void);
+
+	Brg_StatusT Register(const Brg_CorrMatchT *pMatch, uint32_t TimeoutMs,
+	                     Brg_CorrCallbackT Callback, void *pContext, uint32_t *pHandle);
+	Brg_StatusT Cancel(uint32_t Handle);
+	void CancelAll(void);
+
+	bool DispatchRx(const Brg_RxFrameT *pFrame);
+	uint32_t ExpireDue(uint64_t NowUs);
+	Brg_StatusT PollCAN(Brg &Bridge, uint32_t *pMatchedNb=NULL);
+
+	void GetStats(Brg_CorrStatsT *pStats) const;
+	void ResetStats(void);
+
+private:
+	typedef struct {
+		Brg_CorrMatchT Match;
+		Brg_CorrCallbackT Callback;
+		void *pContext;
+		uint64_t RegisterUs;
+		uint64_t DueTick;
+		int32_t IdPrev;     // list of requests waiting on the same IDE/ID
+		int32_t IdNext;
+		int32_t WheelPrev;  // deadline wheel slot list (WheelNext also used as free list)
+		int32_t WheelNext;
+		uint16_t Generation;
+		bool bUsed;
+	} CorrEntryT;
+
+	typedef struct {
+		int32_t Head;
+		int32_t Tail;
+	} IdListT;
+
+	// Completion gathered under lock, reported after unlock
+	typedef struct {
+		Brg_CorrCallbackT Callback;
+		void *pContext;
+		uint32_t Handle;
+	} CorrDoneT;
+
+	static uint64_t IdKey(Brg_CanMsgIdT IDE, uint32_t ID) {
+		return (((uint64_t)IDE) << 32) | ID;
+	}
+	uint64_t UsToTick(uint64_t TimeUs) const;
+	int32_t HandleToIndex(uint32_t Handle) const;
+	uint32_t IndexToHandle(int32_t Idx) const;
+	void UnlinkEntry(int32_t Idx);
+	void FreeEntry(int32_t Idx);
+
+	CorrEntryT *m_pEntries;
+	uint32_t m_maxPending;
+	int32_t m_freeHead;
+	uint32_t m_pendingNb;
+	std::unordered_map<uint64_t, IdListT> m_idMap;
+	int32_t m_slots[BRG_CORR_WHEEL_SLOTS];
+	uint64_t m_originUs;
+	uint64_t m_lastTick;
+
+	mutable std::mutex m_mutex;
+
+	// Statistics
+	uint32_t m_maxPendingNb;
+	std::atomic<uint64_t> m_registeredNb;
+	std::atomic<uint64_t> m_resolvedNb;
+	std::atomic<uint64_t> m_expiredNb;
+	std::atomic<uint64_t> m_cancelledNb;
+	std::atomic<uint64_t> m_unmatchedRxNb;
+	BrgLatencyHist m_responseTime;
+};
+
+#endif //_BRG_CORRELATOR_H
+/** @} */
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,136 @@
+/**
+  ******************************************************************************
+  * @file    brg_cyclic_sched.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_cyclic_sched.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_CYCLIC_SCHED_H
+#define _BRG_CYCLIC_SCHED_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "brg_tx_queue.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_CYC_DEFAULT_TICK_US     1000  ///< Default scheduler resolution (1ms)
+#define BRG_CYC_DEFAULT_MAX_ENTRIES 4096  ///< Default max number of scheduled frames
+#define BRG_CYC_MAX_ENTRIES         0xFFFF ///< Upper limit of MaxEntries (handle index on 16 bits)
+#define BRG_CYC_WHEEL_SLOTS         1024  ///< Timing wheel size (power of 2)
+#define BRG_CYC_INVALID_HANDLE      0     ///< Never returned as a valid handle
+
+/// BrgCyclicScheduler statistics, see BrgCyclicScheduler::GetStats()
+typedef struct {
+	uint32_t ActiveNb;        ///< Currently scheduled entries (periodic + one-shot)
+	uint64_t ReleasedNb;      ///< Frames handed to the BrgTxQueue
+	uint64_t TxDroppedNb;     ///< Frames refused by the BrgTxQueue (class queue full)
+	uint64_t MissedNb;        ///< Periodic occurrences skipped because more than one period late
+	uint64_t BatchNb;         ///< Number of batched pushes (one per tick with due frames)
+	uint32_t MaxBatchSize;    ///< Largest number of frames released in the same tick
+	uint64_t LateTickNb;      ///< Ticks processed later than their deadline + 1 tick
+	Brg_LatencySummaryT Jitter; ///< Release time minus ideal due time
+} Brg_CyclicStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Periodic and one-shot CAN/FDCAN transmissions (keepalives, heartbeat requests)
+/// on top of BrgTxQueue. Entries are kept in a hashed timing wheel of
+/// #BRG_CYC_WHEEL_SLOTS slots: insert, remove and expiry are O(1) per entry.
+/// Frames due in the same tick are pushed together with BrgTxQueue::PushFrames().
+/// Periodic entries do not drift: the next due time is the previous ideal due time
+/// plus the period.
+class BrgCyclicScheduler
+{
+public:
+	BrgCyclicScheduler(BrgTxQueue &TxQueue, uint32_t TickUs=BRG_CYC_DEFAULT_TICK_US,
+	                   uint32_t MaxEntries=BRG_CYC_DEFAULT_MAX_ENTRIES);
+	virtual ~BrgCyclicScheduler(void);
+
+	Brg_StatusT Start(void);
+	Brg_StatusT Stop(void);
+
+	Brg_StatusT AddPeriodicCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+	                           uint32_t PeriodUs, uint32_t *pHandle, uint32_t FirstDelayUs=0,
+	                           Brg_TxPriorityT Priority=BRG_TX_PRIO_NORMAL);
+	Brg_StatusT AddOneShotCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+	                          uint32_t DelayUs, uint32_t *pHandle,
+	                          Brg_TxPriorityT Priority=BRG_TX_PRIO_NORMAL);
+	Brg_StatusT AddFrame(const Brg_TxFrameT *pFrame, uint32_t PeriodUs, uint32_t FirstDelayUs, uint32_t *pHandle);
+	Brg_StatusT UpdateData(uint32_t Handle, const uint8_t *pBuffer, uint8_t SizeInBytes);
+	Brg_StatusT Remove(uint32_t Handle);
+
+	void GetStats(Brg_CyclicStatsT *pStats) const;
+	void ResetStats(void);
+
+private:
+	typedef struct {
+		Brg_TxFrameT Frame;
+		uint64_t PeriodUs;   // 0 for one-shot
+		uint64_t DueUs;      // ideal due time (host monotonic)
+		uint64_t DueTick;    // absolute tick of DueUs (rounded up)
+		int32_t Prev;        // slot list or free list links (-1: none)
+		int32_t Next;
+		uint16_t Generation; // handle check, incremented at each release of the entry
+		bool bUsed;
+	} CyclicEntryT;
+
+	uint64_t UsToTick(uint64_t TimeUs) const;
+	void LinkEntry(int32_t Idx, uint64_t MinTick);
+	void UnlinkEntry(int32_t Idx);
+	void FreeEntry(int32_t Idx);
+	int32_t HandleToIndex(uint32_t Handle) const;
+	void ProcessTick(uint64_t Tick, uint64_t NowUs);
+	void TickThread(void);
+
+	BrgTxQueue &m_txQueue;
+	uint32_t m_tickUs;
+	uint64_t m_originUs;  // time of tick 0
+	uint64_t m_lastTick;  // last processed tick
+
+	CyclicEntryT *m_pEntries;
+	uint32_t m_maxEntries;
+	int32_t m_freeHead;
+	int32_t m_slots[BRG_CYC_WHEEL_SLOTS];
+	uint32_t m_activeNb;
+	Brg_TxFrameT *m_pBatch; // frames due in the current tick
+
+	// Protects the wheel and entries between API calls and the tick thread
+	mutable std::mutex m_wheelMutex;
+
+	std::thread m_ticker;
+	std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bStopReq;
+	std::mutex m_stopMutex;
+	std::condition_variable m_stopCond;
+
+	// Statistics
+	std::atomic<uint64_t> m_releasedNb;
+	std::atomic<uint64_t> m_txDroppedNb;
+	std::atomic<uint64_t> m_missedNb;
+	std::atomic<uint64_t> m_batchNb;
+	std::atomic<uint32_t> m_maxBatchSize;
+	std::atomic<uint64_t> m_lateTickNb;
+	BrgLatencyHist m_jitter;
+};
+
+#endif //_BRG_CYCLIC_SCHED_H
+/** @} */
+/**********************************END OF FILE*********************************/
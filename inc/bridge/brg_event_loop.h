@@ -0,0 +1,195 @@
+/**
+  ******************************************************************************
+  * @file    brg_event_loop.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_event_loop.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_EVENT_LOOP_H
+#define _BRG_EVENT_LOOP_H
+/* Includes ------------------------------------------------------------------*/
+#include <vector>
+#include <deque>
+#include <queue>
+#include "brg_correlator.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_LOOP_IDLE_SLEEP_US 200 ///< Sleep of BrgEventLoop::Run() when no task is ready
+
+/// Result of the asynchronous operation a BrgAsyncTask was waiting for
+typedef struct {
+	Brg_StatusT Status;   ///< #BRG_NO_ERR, #BRG_TARGET_CMD_TIMEOUT (NextFrameAsync() deadline) or Brg error
+	Brg_RxFrameT Frame;   ///< Received frame (NextFrameAsync() with Status #BRG_NO_ERR only)
+} Brg_AsyncResultT;
+
+/// BrgEventLoop statistics, see BrgEventLoop::GetStats()
+typedef struct {
+	uint32_t ActiveTaskNb;    ///< Tasks not finished
+	uint64_t ResumeNb;        ///< BrgAsyncTask::Resume() calls
+	uint64_t WriteNb;         ///< CAN messages written
+	uint64_t RxPollNb;        ///< Rx FIFO polls (shared by all tasks waiting for a frame)
+	uint64_t IterationNb;     ///< RunOnce() iterations
+} Brg_EventLoopStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+class BrgEventLoop;
+
+/// Resumable task run by a BrgEventLoop: an explicit state machine standing for a
+/// coroutine (the API is C++17). Each asynchronous call of BrgEventLoop suspends the
+/// task, Resume() is called again with the result once the operation is complete.
+class BrgAsyncTask
+{
+public:
+	BrgAsyncTask(void): m_state(0), m_pLoop(NULL), m_cancelStatus(BRG_NO_ERR) {}
+	virtual ~BrgAsyncTask(void) {}
+
+	/**
+	 * @brief Run the task until its next asynchronous call.
+	 * @param[in]  Loop     Event loop running the task.
+	 * @param[in]  pResult  NULL at first call, then result of the awaited operation.
+	 * @retval true if the task is waiting for an operation started on Loop,
+	 *         false if the task is finished.
+	 */
+	virtual bool Resume(BrgEventLoop &Loop, const Brg_AsyncResultT *pResult) = 0;
+
+protected:
+	int m_state; ///< Free for derived classes: resume point
+
+private:
+	friend class BrgEventLoop;
+	BrgEventLoop *m_pLoop;       // loop running the task
+	Brg_StatusT m_cancelStatus;  // status reported if the awaited frame is cancelled
+};
+
+/// Single-thread event loop multiplexing the bridge between many BrgAsyncTask:
+/// writes of all tasks are sent back to back, one Rx poll serves every task
+/// waiting for a frame (BrgCorrelator) and delays are served from a timer heap.
+/// A task must start exactly one asynchronous operation before returning true
+/// from Resume().
+///
+/// Example: several modules driven concurrently from one thread (CAN initialized in
+/// #CAN_MODE_LOOPBACK, reception started: every written frame is received back and
+/// stands for the module answer). This example is built and run by test/test_event_loop.cpp.
+/// @code
+/// class ModuleSession : public BrgAsyncTask {
+/// public:
+///   ModuleSession(uint8_t ModuleId, int FrameNb): m_id(ModuleId), m_frameNb(FrameNb), m_sent(0) {}
+///   bool Resume(BrgEventLoop &Loop, const Brg_AsyncResultT *pResult) {
+///     Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0, CAN_DATA_FRAME, 8 };
+///     Brg_CorrMatchT match = { CAN_ID_STANDARD, 0, 1, { m_id } };
+///     uint8_t data[8] = { m_id };
+///     if( (pResult != NULL) && (pResult->Status != BRG_NO_ERR) ) {
+///       return false; // write error or no answer: session aborted
+///     }
+///     switch( m_state ) {
+///     case 0: // bootloader start frame
+///       msg.ID = 0x069; match.ID = 0x069;
+///       m_state = 1;
+///       Loop.NextFrameAsync(this, &match, 100, &msg, data, 8); // write + wait answer
+///       return true;
+///     case 1: // one data frame per answer
+///       if( m_sent == m_frameNb ) {
+///         return false; // done
+///       }
+///       msg.ID = 0x100 + m_id; match.ID = 0x100 + m_id;
+///       data[1] = (uint8_t)m_sent++;
+///       Loop.NextFrameAsync(this, &match, 100, &msg, data, 8);
+///       return true;
+///     }
+///     return false;
+///   }
+/// private:
+///   uint8_t m_id; int m_frameNb; int m_sent;
+/// };
+///
+/// BrgEventLoop loop(*pBrg);
+/// ModuleSession s1(1, 64), s2(2, 64), s3(3, 64);
+/// loop.Spawn(&s1); loop.Spawn(&s2); loop.Spawn(&s3);
+/// loop.Run(5000);
+/// @endcode
+class BrgEventLoop
+{
+public:
+	BrgEventLoop(Brg &Bridge, uint32_t MaxPendingRx=BRG_CORR_DEFAULT_MAX_PENDING);
+	virtual ~BrgEventLoop(void);
+
+	Brg_StatusT Spawn(BrgAsyncTask *pTask);
+
+	Brg_StatusT WriteMsgCANAsync(BrgAsyncTask *pTask, const Brg_CanTxMsgT *pCanMsg,
+	                             const uint8_t *pBuffer, uint8_t SizeInBytes);
+	Brg_StatusT NextFrameAsync(BrgAsyncTask *pTask, const Brg_CorrMatchT *pMatch, uint32_t TimeoutMs,
+	                           const Brg_CanTxMsgT *pCanMsg=NULL, const uint8_t *pBuffer=NULL,
+	                           uint8_t SizeInBytes=0);
+	Brg_StatusT DelayAsync(BrgAsyncTask *pTask, uint32_t DelayUs);
+
+	bool RunOnce(void);
+	Brg_StatusT Run(uint32_t TimeoutMs=0);
+
+	void GetStats(Brg_EventLoopStatsT *pStats) const;
+
+private:
+	typedef struct {
+		BrgAsyncTask *pTask;
+		Brg_CanTxMsgT CanMsg;
+		uint8_t Data[8];
+		uint8_t SizeInBytes;
+		bool bCompleteOnWrite; // false: task resumed by the awaited frame instead
+		uint32_t RxHandle;     // request to cancel if the write fails
+	} PendingWriteT;
+
+	typedef struct {
+		BrgAsyncTask *pTask;
+		Brg_AsyncResultT Result;
+		bool bStart;           // first Resume() (NULL result)
+	} ReadyT;
+
+	typedef struct {
+		uint64_t DueUs;
+		BrgAsyncTask *pTask;
+	} TimerT;
+
+	struct TimerLater {
+		bool operator()(const TimerT &A, const TimerT &B) const {
+			return A.DueUs > B.DueUs;
+		}
+	};
+
+	static void RxCallback(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+	                       const Brg_RxFrameT *pFrame);
+	void MakeReady(BrgAsyncTask *pTask, Brg_StatusT Status, const Brg_RxFrameT *pFrame);
+
+	Brg &m_brg;
+	BrgCorrelator m_correlator;
+	std::vector<PendingWriteT> m_writes;
+	std::deque<ReadyT> m_ready;
+	std::priority_queue<TimerT, std::vector<TimerT>, TimerLater> m_timers;
+	uint32_t m_activeTaskNb;
+	uint32_t m_rxWaitNb;
+
+	// Statistics
+	uint64_t m_resumeNb;
+	uint64_t m_writeNb;
+	uint64_t m_rxPollNb;
+	uint64_t m_iterationNb;
+};
+
+#endif //_BRG_EVENT_LOOP_H
+/** @} */
+/**********************************END OF FILE*********************************/
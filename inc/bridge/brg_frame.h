@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    brg_frame.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_frame.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_FRAME_H
+#define _BRG_FRAME_H
+/* Includes ------------------------------------------------------------------*/
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_FRAME_MAX_DATA_SIZE 64 ///< Max data field size of a #Brg_RxFrameT (FDCAN)
+
+/// Received CAN or FDCAN frame with its data field, built from Brg::GetRxMsgCAN()
+/// or Brg::GetRxMsgFDCAN() output
+typedef struct {
+	bool bIsFdcan;             ///< true if read with Brg::GetRxMsgFDCAN()
+	Brg_CanMsgIdT IDE;         ///< Standard or extended identifier
+	uint32_t ID;               ///< Identifier (11bit or 29bit according to IDE)
+	Brg_CanMsgRtrT RTR;        ///< Remote or data frame
+	uint8_t DLC;               ///< Number of data bytes (or requested bytes for RTR)
+	uint8_t SizeInBytes;       ///< Number of valid bytes in Data
+	uint8_t Data[BRG_FRAME_MAX_DATA_SIZE]; ///< Data field
+	Brg_CanRxOverrunT Overrun; ///< Overrun reported before this frame
+	uint16_t HwTimeStamp;      ///< Bridge timestamp (FDCAN only, 0 otherwise)
+	uint64_t RxTimeUs;         ///< Host monotonic reception time estimate (HostTimeUs of the message)
+} Brg_RxFrameT;
+// end group doxygen CAN
+/** @} */
+
+/* Exported functions --------------------------------------------------------*/
+uint16_t BrgFramesFromCAN(const Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, const uint8_t *pBuffer,
+                          uint16_t DataSizeInBytes, Brg_RxFrameT *pFrames);
+uint16_t BrgFramesFromFDCAN(const Brg_FdcanRxMsgT *pFdcanMsg, uint16_t MsgNb, const uint8_t *pBuffer,
+                            uint16_t DataSizeInBytes, Brg_RxFrameT *pFrames);
+
+#endif //_BRG_FRAME_H
+/** @} */
+/**********************************END OF FILE*********************************/
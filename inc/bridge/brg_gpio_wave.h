@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * @file    brg_gpio_wave.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_gpio_wave.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_GPIO_WAVE_H
+#define _BRG_GPIO_WAVE_H
+/* Includes ------------------------------------------------------------------*/
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup GPIO
+ * @{
+ */
+#define BRG_GPIOWAVE_SPIN_US        1000 ///< Last part of a wait done by reading the clock instead of sleeping
+#define BRG_GPIOWAVE_DEFAULT_CMD_US 250  ///< Initial Brg::SetResetGPIO() duration estimate
+
+/// One waveform step: drive GpioMask, then wait DelayUs before the next step
+typedef struct {
+	uint8_t GpioMask;     ///< GPIO(s) driven (one or several value of #Brg_GpioMaskT)
+	uint8_t GpioSetMask;  ///< GPIO(s) of GpioMask driven high, the others low
+	uint32_t DelayUs;     ///< Time from this step to the next one
+} Brg_GpioWaveStepT;
+
+/// How a step was executed
+typedef enum {
+	BRG_GPIOWAVE_SENT = 0,    ///< First step of a USB command
+	BRG_GPIOWAVE_MERGED = 1,  ///< Sent in the command of a previous step (see BrgGpioWave::Run())
+	BRG_GPIOWAVE_SKIPPED = 2  ///< GPIO(s) already at the requested level, no command
+} Brg_GpioWaveStepStateT;
+
+/// Achieved timing of a step, times in us from the waveform start (first command start,
+/// earlier by the DelayUs of the leading skipped steps)
+typedef struct {
+	Brg_GpioWaveStepStateT State; ///< How the step was executed
+	uint32_t PlannedUs;           ///< Planned time: first command middle plus the previous DelayUs
+	uint32_t CmdStartUs;          ///< Start of the USB command driving the step
+	uint32_t CmdEndUs;            ///< End of this command: GPIO(s) driven between CmdStartUs and CmdEndUs
+	int32_t LateUs;               ///< Command middle minus PlannedUs (0 if skipped)
+} Brg_GpioWaveStepResultT;
+
+/// BrgGpioWave::Run() summary
+typedef struct {
+	uint32_t StepNb;     ///< Steps of the waveform
+	uint32_t CmdNb;      ///< USB commands sent
+	uint32_t MergedNb;   ///< Steps merged into the command of a previous step
+	uint32_t SkippedNb;  ///< Steps without level change
+	uint32_t MaxLateUs;  ///< Largest |LateUs| of the executed steps
+	uint32_t CmdUs;      ///< Current Brg::SetResetGPIO() duration estimate
+	uint32_t TotalUs;    ///< First command start to last command end
+} Brg_GpioWaveStatsT;
+// end group doxygen GPIO
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// GPIO waveform execution with as few USB commands as possible: one Brg::SetResetGPIO()
+/// drives all the GPIOs, so the steps less than half a command duration after a
+/// sent step are sent in the same command when they drive other GPIOs (a pin changed twice
+/// always takes two commands, so that no pulse is lost), and a step whose GPIOs already
+/// have the requested level is not sent. The steps are timed from the first command:
+/// a command is started half its measured duration before its planned time, so that
+/// the GPIOs change around that time and the latency of a step does not shift the next
+/// ones. Reset pulses and boot straps of several modules (one GPIO each) are driven by
+/// the same waveform.
+/// The levels written are remembered between calls and forgotten by Init(): GPIOs must
+/// not be driven by other means in between. Each call holds Brg::GetTransactionLock().
+class BrgGpioWave
+{
+public:
+	BrgGpioWave(Brg &Bridge);
+	virtual ~BrgGpioWave(void) {}
+
+	Brg_StatusT Init(uint8_t GpioMask, Brg_GpioOutputT OutputType=GPIO_OUTPUT_PUSHPULL);
+	Brg_StatusT Run(const Brg_GpioWaveStepT *pSteps, uint32_t StepNb,
+	                Brg_GpioWaveStepResultT *pStepResults=NULL, Brg_GpioWaveStatsT *pStats=NULL);
+
+private:
+	void WaitUntil(uint64_t TimeUs) const;
+
+	Brg &m_brg;
+	uint8_t m_knownMask;   // GPIOs whose level is known (written by Run())
+	uint8_t m_setMask;     // their level (1: high)
+	uint32_t m_cmdUs;      // smoothed SetResetGPIO() duration
+};
+
+#endif //_BRG_GPIO_WAVE_H
+/** @} */
+/**********************************END OF FILE*********************************/
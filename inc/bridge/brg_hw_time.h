@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file    brg_hw_time.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_hw_time.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_HW_TIME_H
+#define _BRG_HW_TIME_H
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup FDCAN
+ * @{
+ */
+#define BRG_HWTIME_MIN_SPAN_US 100000 ///< Host time span needed before the tick period is estimated
+
+/// BrgHwTimeMap state, see BrgHwTimeMap::GetState()
+typedef struct {
+	bool bTickKnown;     ///< true once the tick period is estimated (before: batch host time given)
+	double TickUs;       ///< Estimated bridge timestamp tick period in microseconds
+	uint64_t TickNb;     ///< Unwrapped ticks since the first timestamp
+	uint32_t WrapNb;     ///< 16-bit counter wraps seen
+	uint32_t LostWrapNb; ///< Wraps missed by the counter (more than 65536 ticks between two reads) and recovered from host time
+} Brg_HwTimeStateT;
+// end group doxygen FDCAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Maps the 16-bit bridge Rx timestamps (FDCAN) onto the host monotonic time
+/// (BrgGetMonotonicUs()): the counter is unwrapped to 64 bits and the tick period is
+/// estimated from the host times of the reads, the line goes through the first read
+/// and the latest one. The host time of a read (start of the USB transfer) is an upper
+/// bound of the reception of the messages it returns.
+/// Not thread safe: used under Brg::GetTransactionLock().
+class BrgHwTimeMap
+{
+public:
+	BrgHwTimeMap(void);
+
+	void Reset(void);
+	uint64_t Map(uint16_t HwTimeStamp, uint64_t ReadUs);
+	void GetState(Brg_HwTimeStateT *pState) const;
+
+private:
+	uint64_t Unwrap(uint16_t HwTimeStamp, uint64_t ReadUs);
+
+	bool m_bStarted;
+	uint16_t m_lastStamp;
+	uint64_t m_lastTick;   // unwrapped m_lastStamp
+	uint64_t m_lastReadUs; // read giving m_lastStamp
+	uint64_t m_firstReadUs;
+	double m_tickUs;       // 0 while unknown
+	uint32_t m_wrapNb;
+	uint32_t m_lostWrapNb;
+};
+
+#endif //_BRG_HW_TIME_H
+/** @} */
+/**********************************END OF FILE*********************************/
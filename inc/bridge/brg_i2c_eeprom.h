@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file    brg_i2c_eeprom.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_i2c_eeprom.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_I2C_EEPROM_H
+#define _BRG_I2C_EEPROM_H
+/* Includes ------------------------------------------------------------------*/
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup I2C
+ * @{
+ */
+#define BRG_I2CEEPROM_MAX_PAGE_SIZE      256 ///< Largest supported page (24M02)
+#define BRG_I2CEEPROM_WRITE_TIMEOUT_MS   20  ///< Max write cycle time (acknowledge polling timeout)
+
+/// 24Cxx-class EEPROM description, see BrgI2cEeprom::BrgI2cEeprom()
+typedef struct {
+	uint16_t DevAddr;      ///< 7-bit device address (0x50 + A2..A0 pins)
+	uint32_t SizeInBytes;  ///< Memory size (e.g. 4096 for a 24C32)
+	uint16_t PageSize;     ///< Page write size (e.g. 32 for a 24C32), max #BRG_I2CEEPROM_MAX_PAGE_SIZE
+	uint8_t AddrBytes;     ///< Memory address bytes: 1 (24C01-24C16) or 2 (24C32 and above), the
+	                       ///< address bits above them go to the device address (block select)
+} Brg_I2cEepromConfT;
+
+/// BrgI2cEeprom statistics, see BrgI2cEeprom::GetStats()
+typedef struct {
+	uint64_t WriteBytes;   ///< Bytes written by the successful Write() calls
+	uint32_t PageWriteNb;  ///< Page write transactions
+	uint32_t NackNb;       ///< Page writes not acknowledged (write cycle in progress), retried
+	uint32_t WriteCycleUs; ///< Estimated write cycle time (acknowledge polling start)
+	uint64_t WriteTimeUs;  ///< Time spent in the successful Write() calls
+	uint64_t BytesPerSec;  ///< Effective write throughput (WriteBytes / WriteTimeUs)
+} Brg_I2cEepromStatsT;
+// end group doxygen I2C
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// 24Cxx-class I2C EEPROM reader and writer on top of the I2C bridge (Brg::InitI2C() done,
+/// master mode). Write() splits the data on page boundaries and sends each page (memory
+/// address and data) in one USB command. The end of the write cycle is detected by
+/// acknowledge polling merged with the next page write: the EEPROM does not acknowledge
+/// its address while busy, the page is sent again until acknowledged. The write cycle time
+/// learned from the acknowledges delays the next page so that few attempts are refused.
+/// Each call holds Brg::GetTransactionLock().
+class BrgI2cEeprom
+{
+public:
+	BrgI2cEeprom(Brg &Bridge, const Brg_I2cEepromConfT &Conf);
+	virtual ~BrgI2cEeprom(void) {}
+
+	Brg_StatusT Read(uint32_t Addr, uint8_t *pBuffer, uint32_t SizeInBytes);
+	Brg_StatusT Write(uint32_t Addr, const uint8_t *pData, uint32_t SizeInBytes, bool bVerify=true);
+
+	void GetStats(Brg_I2cEepromStatsT *pStats) const;
+
+private:
+	Brg_StatusT WritePage(uint32_t Addr, const uint8_t *pData, uint16_t SizeInBytes);
+	Brg_StatusT WaitReady(uint32_t Addr);
+	uint16_t SetAddr(uint8_t *pCmd, uint32_t Addr) const;
+
+	Brg &m_brg;
+	Brg_I2cEepromConfT m_conf;
+	bool m_bConfOk;
+
+	uint64_t m_lastStopUs; // end of the last page write (write cycle start), 0 if none
+	uint8_t m_pageCmd[2 + BRG_I2CEEPROM_MAX_PAGE_SIZE];
+	uint8_t m_verify[BRG_I2CEEPROM_MAX_PAGE_SIZE];
+
+	Brg_I2cEepromStatsT m_stats;
+};
+
+#endif //_BRG_I2C_EEPROM_H
+/** @} */
+/**********************************END OF FILE*********************************/
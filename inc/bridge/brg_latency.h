@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * @file    brg_latency.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_latency.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_LATENCY_H
+#define _BRG_LATENCY_H
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <atomic>
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup GENERAL
+ * @{
+ */
+// Log-linear histogram layout: values below 2^BRG_LAT_SUB_BUCKET_BITS are exact,
+// above that each power of two is split in BRG_LAT_SUB_BUCKETS linear buckets
+// (relative precision 1/BRG_LAT_SUB_BUCKETS).
+#define BRG_LAT_SUB_BUCKET_BITS 4
+#define BRG_LAT_SUB_BUCKETS     (1<<BRG_LAT_SUB_BUCKET_BITS)
+#define BRG_LAT_MAX_MSB         39  ///< Values above 2^40-1 us are counted in the last bucket
+#define BRG_LAT_BUCKETS         ((BRG_LAT_MAX_MSB-BRG_LAT_SUB_BUCKET_BITS+2)*BRG_LAT_SUB_BUCKETS)
+
+/// Snapshot of a #BrgLatencyHist, all values in microseconds
+typedef struct {
+	uint64_t Count;  ///< Number of recorded samples
+	uint64_t MinUs;  ///< Minimum recorded value (0 if Count=0)
+	uint64_t MaxUs;  ///< Maximum recorded value
+	double MeanUs;   ///< Arithmetic mean
+	uint64_t P50Us;  ///< 50th percentile (bucket upper bound)
+	uint64_t P90Us;  ///< 90th percentile (bucket upper bound)
+	uint64_t P99Us;  ///< 99th percentile (bucket upper bound)
+	uint64_t P999Us; ///< 99.9th percentile (bucket upper bound)
+} Brg_LatencySummaryT;
+// end group doxygen GENERAL
+/** @} */
+
+/* Exported functions --------------------------------------------------------*/
+uint64_t BrgGetMonotonicUs(void);
+
+/* Class -------------------------------------------------------------------- */
+/// Latency histogram: Record() is lock-free and can be called from any thread
+class BrgLatencyHist
+{
+public:
+	BrgLatencyHist(void);
+
+	void Record(uint64_t ValueUs);
+	void Reset(void);
+
+	uint64_t GetCount(void) const {
+		return m_count.load(std::memory_order_relaxed);
+	}
+	uint64_t GetPercentile(double Percentile) const;
+	void GetSummary(Brg_LatencySummaryT *pSummary) const;
+
+private:
+	static uint32_t BucketIndex(uint64_t ValueUs);
+	static uint64_t BucketUpperValue(uint32_t Index);
+
+	std::atomic<uint32_t> m_buckets[BRG_LAT_BUCKETS];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sumUs;
+	std::atomic<uint64_t> m_minUs;
+	std::atomic<uint64_t> m_maxUs;
+};
+
+#endif //_BRG_LATENCY_H
+/** @} */
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    brg_rx_pump.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_rx_pump.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_RX_PUMP_H
+#define _BRG_RX_PUMP_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "brg_frame.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_RXPUMP_DEFAULT_MIN_INTERVAL_US 100   ///< Default shortest poll interval (most aggressive)
+#define BRG_RXPUMP_DEFAULT_MAX_INTERVAL_US 5000  ///< Default longest poll interval (quiet bus)
+#define BRG_RXPUMP_DEFAULT_MIN_BATCH       16    ///< Default smallest number of messages read per poll
+#define BRG_RXPUMP_DEFAULT_MAX_BATCH       256   ///< Default largest number of messages read per poll
+#define BRG_RXPUMP_DEFAULT_QUIET_POLL_NB   20    ///< Default quiet polls before backing off one step
+#define BRG_RXPUMP_MAX_BATCH               1024  ///< Upper limit of Brg_RxPumpConfT::MaxBatch
+
+/// Frames read by the pump thread, called without any lock held
+typedef void (*Brg_RxPumpCallbackT)(void *pContext, const Brg_RxFrameT *pFrames, uint16_t FrameNb);
+
+/// BrgRxPump drain rate limits: the pump starts at the least aggressive level
+/// (MaxIntervalUs, MinBatch) and moves between the limits one step (x2) at a time
+typedef struct {
+	uint32_t MinIntervalUs; ///< Shortest poll interval
+	uint32_t MaxIntervalUs; ///< Longest poll interval
+	uint16_t MinBatch;      ///< Smallest number of messages read per poll
+	uint16_t MaxBatch;      ///< Largest number of messages read per poll (max #BRG_RXPUMP_MAX_BATCH)
+	uint16_t QuietPollNb;   ///< Consecutive polls with few messages (less than a quarter of the batch) before backing off
+} Brg_RxPumpConfT;
+
+/// BrgRxPump statistics, see BrgRxPump::GetStats()
+typedef struct {
+	uint64_t PollNb;        ///< Brg::GetRxMsgNbCAN() calls
+	uint64_t FrameNb;       ///< Frames given to the callback
+	uint64_t FifoOverrunNb; ///< Frames flagged #CAN_RX_FIFO_OVERRUN
+	uint64_t BuffOverrunNb; ///< Frames flagged #CAN_RX_BUFF_OVERRUN (cause an escalation)
+	uint64_t ErrorNb;       ///< Polls failed (other than #BRG_OVERRUN_ERR)
+	uint32_t EscalationNb;  ///< Steps towards MinIntervalUs/MaxBatch
+	uint32_t BackoffNb;     ///< Steps towards MaxIntervalUs/MinBatch
+	uint32_t IntervalUs;    ///< Current poll interval
+	uint16_t Batch;         ///< Current messages read per poll
+} Brg_RxPumpStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// CAN receive pump: a thread polls Brg::GetRxMsgNbCAN()/Brg::GetRxMsgCAN() and gives
+/// the frames to a callback. The drain rate adapts to the traffic: a buffer overrun
+/// (#CAN_RX_BUFF_OVERRUN: the STLink Rx buffer was not emptied in time) or messages
+/// left after a full batch halve the poll interval and double the batch, a quiet bus
+/// does the opposite. The thread holds Brg::GetTransactionLock() around each poll.
+/// CAN must be initialized and the reception started (Brg::StartMsgReceptionCAN()).
+class BrgRxPump
+{
+public:
+	BrgRxPump(Brg &Bridge, Brg_RxPumpCallbackT Callback, void *pContext, const Brg_RxPumpConfT *pConf=NULL);
+	virtual ~BrgRxPump(void);
+
+	Brg_StatusT Start(void);
+	Brg_StatusT Stop(void);
+
+	void GetStats(Brg_RxPumpStatsT *pStats) const;
+
+private:
+	void PumpThread(void);
+	void Escalate(void);
+	void BackOff(void);
+
+	Brg &m_brg;
+	Brg_RxPumpCallbackT m_callback;
+	void *m_pContext;
+	Brg_RxPumpConfT m_conf;
+
+	// Poll buffers (MaxBatch messages), pump thread only
+	Brg_CanRxMsgT *m_pCanMsg;
+	uint8_t *m_pData;
+	Brg_RxFrameT *m_pFrames;
+
+	std::thread m_pump;
+	std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bStopReq;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCond;
+
+	// Statistics and current level (written by the pump thread only)
+	std::atomic<uint64_t> m_pollNb;
+	std::atomic<uint64_t> m_frameNb;
+	std::atomic<uint64_t> m_fifoOverrunNb;
+	std::atomic<uint64_t> m_buffOverrunNb;
+	std::atomic<uint64_t> m_errorNb;
+	std::atomic<uint32_t> m_escalationNb;
+	std::atomic<uint32_t> m_backoffNb;
+	std::atomic<uint32_t> m_intervalUs;
+	std::atomic<uint16_t> m_batch;
+};
+
+#endif //_BRG_RX_PUMP_H
+/** @} */
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,208 @@
+/**
+  ******************************************************************************
+  * @file    brg_shm_bus.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_shm_bus.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_SHM_BUS_H
+#define _BRG_SHM_BUS_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include "brg_frame.h"
+#include "brg_tx_queue.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_SHMBUS_DEFAULT_RX_SLOTS 4096 ///< Default frame ring size (rounded up to a power of 2)
+#define BRG_SHMBUS_DEFAULT_TX_SLOTS 256  ///< Default transmit request ring size (rounded up to a power of 2)
+#define BRG_SHMBUS_NAME_MAX_LEN     64   ///< Max bus name length (terminating 0 included)
+#define BRG_SHMBUS_SERVICE_MAX_NB   64   ///< Default max requests written by one BrgShmBus::ServiceTx() call
+#define BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS 100 ///< Transmit cell claimed but not confirmed (client died or stalled): skipped by the owner after this time
+
+/// Origin of a frame published on the bus
+typedef enum {
+	BRG_SHMBUS_RX = 0, ///< Received by the bridge
+	BRG_SHMBUS_TX = 1  ///< Written by the owner process (own frame or client request)
+} Brg_ShmDirT;
+
+/// Frame published on the bus
+typedef struct {
+	Brg_ShmDirT Direction; ///< Received or written frame
+	uint32_t SourceId;     ///< #BRG_SHMBUS_TX: BrgShmBus::GetClientId() of the requester (0: owner)
+	Brg_RxFrameT Frame;    ///< Frame, RxTimeUs is the reception or write time
+} Brg_ShmFrameT;
+
+/// BrgShmBus statistics, see BrgShmBus::GetStats()
+typedef struct {
+	uint64_t PublishedNb;   ///< Frames published on the bus (all processes)
+	uint64_t ReadNb;        ///< Frames read through this instance
+	uint64_t LostNb;        ///< Frames overwritten before this instance read them
+	uint64_t SubmittedNb;   ///< Transmit requests queued through this instance
+	uint64_t RejectedNb;    ///< Transmit requests rejected through this instance (ring full)
+	uint64_t TxWrittenNb;   ///< Owner: transmit requests written
+	uint64_t TxErrorNb;     ///< Owner: transmit requests whose write failed
+	uint64_t TxSkippedNb;   ///< Owner: transmit cells skipped, claimed by a client that did not confirm them
+	uint32_t ClientNb;      ///< Instances opened on the bus since its creation
+} Brg_ShmBusStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Shared-memory frame bus between the process owning the STLink (exclusive open mode)
+/// and other local processes (logger, dashboard, flasher), without STLINK_TCP.
+/// The owner Create()s the bus and Publish()es every received frame (e.g. from a
+/// BrgRxPump callback) and every frame it writes; it calls ServiceTx() to write the
+/// transmit requests of the clients, which are published too.
+/// Frame ring: single producer (owner), any number of readers, each with its own cursor
+/// in its own process; the producer never waits for the readers, a reader overtaken
+/// by the producer skips the overwritten frames (counted in LostNb). Peek() gives
+/// the frame in the shared memory (zero-copy), Release() tells whether it was still
+/// valid. Transmit ring: bounded multi-producer queue (same algorithm as BrgTxQueue)
+/// drained by the owner; a cell claimed by a client that dies or stalls before
+/// confirming it is skipped after #BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS (the late client's
+/// request is rejected). A client dying while it copies a confirmed request blocks the
+/// transmit ring until the bus is created again.
+/// Shared memory: POSIX shm_open() object "/<name>" or Windows named file mapping
+/// "Local\<name>". Processes must use the same library build (the frame layout is
+/// checked at Open()). A BrgShmBus instance is used by one thread.
+///
+/// @code
+/// // Owner process
+/// BrgShmBus bus;
+/// bus.Create("brg_can0");
+/// // BrgRxPump callback: bus.Publish(pFrames, FrameNb);
+/// for( ;; ) { bus.ServiceTx(*pBrg); ... }
+///
+/// // Logger process
+/// BrgShmBus bus;
+/// const Brg_ShmFrameT *pFrame;
+/// bus.Open("brg_can0");
+/// for( ;; ) {
+///   while( (pFrame = bus.Peek()) != NULL ) {
+///     Log(pFrame);
+///     bus.Release();
+///   }
+///   std::this_thread::sleep_for(std::chrono::milliseconds(1));
+/// }
+/// @endcode
+class BrgShmBus
+{
+public:
+	BrgShmBus(void);
+	virtual ~BrgShmBus(void);
+
+	Brg_StatusT Create(const char *pName, uint32_t RxSlotNb=BRG_SHMBUS_DEFAULT_RX_SLOTS,
+	                   uint32_t TxSlotNb=BRG_SHMBUS_DEFAULT_TX_SLOTS);
+	Brg_StatusT Open(const char *pName);
+	void Close(void);
+
+	// Owner
+	Brg_StatusT Publish(const Brg_RxFrameT *pFrames, uint32_t FrameNb,
+	                    Brg_ShmDirT Direction=BRG_SHMBUS_RX, uint32_t SourceId=0);
+	uint32_t ServiceTx(Brg &Bridge, uint32_t MaxNb=BRG_SHMBUS_SERVICE_MAX_NB);
+
+	// Readers
+	const Brg_ShmFrameT* Peek(void);
+	bool Release(void);
+	Brg_StatusT Read(Brg_ShmFrameT *pFrames, uint32_t MaxNb, uint32_t *pReadNb);
+
+	// Clients
+	Brg_StatusT SubmitCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes);
+	Brg_StatusT SubmitFDCAN(const Brg_FdcanMsgT *pFdcanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes);
+
+	/**
+	 * @ingroup CAN
+	 * @retval Identifier of this instance on the bus (0: owner), given in Brg_ShmFrameT::SourceId
+	 *         of the frames written for its requests.
+	 */
+	uint32_t GetClientId(void) const {
+		return m_clientId;
+	}
+	void GetStats(Brg_ShmBusStatsT *pStats) const;
+
+private:
+	// Frame ring slot: Sequence 2*pos+1 while the frame of position pos is written,
+	// 2*pos+2 once it is complete
+	typedef struct {
+		std::atomic<uint64_t> Sequence;
+		Brg_ShmFrameT Frame;
+	} RxSlotT;
+
+	// Transmit ring cell (bounded MPMC algorithm, used with one consumer): Sequence 4*pos
+	// while free, 4*pos+1 once confirmed by the client that claimed it, 4*pos+2 when filled
+	typedef struct {
+		std::atomic<uint64_t> Sequence;
+		uint32_t SourceId;
+		Brg_TxFrameT Frame;
+	} TxCellT;
+
+	// Start of the shared memory, followed by the RxSlotT then the TxCellT tables
+	typedef struct {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t TotalSize;
+		uint32_t RxSlotSize;   // sizeof(RxSlotT), layout check
+		uint32_t TxCellSize;   // sizeof(TxCellT), layout check
+		uint32_t RxSlotNb;
+		uint32_t TxSlotNb;
+		std::atomic<uint32_t> ClientNb;
+		alignas(64) std::atomic<uint64_t> RxHead;        // next position published
+		alignas(64) std::atomic<uint64_t> TxEnqueuePos;
+		alignas(64) std::atomic<uint64_t> TxDequeuePos;
+	} ShmHeaderT;
+
+	Brg_StatusT Map(const char *pName, bool bCreate, uint32_t TotalSize);
+#ifndef WIN32
+	Brg_StatusT CreateObject(int *pFd);
+	bool LockAsOwner(int Fd, bool bNew);
+#endif
+	bool PopTx(uint32_t *pSourceId, Brg_TxFrameT *pFrame);
+	Brg_StatusT Submit(const Brg_TxFrameT *pFrame);
+	void Resync(uint64_t Head);
+
+	ShmHeaderT *m_pHeader;
+	RxSlotT *m_pRxSlots;
+	TxCellT *m_pTxCells;
+	uint64_t m_rxMask;
+	uint64_t m_txMask;
+	bool m_bOwner;
+	uint32_t m_clientId;
+	uint64_t m_cursor;      // next position read by this instance
+	char m_name[BRG_SHMBUS_NAME_MAX_LEN];
+	size_t m_mapSize;
+#ifdef WIN32 //Defined for applications for Win32 and Win64.
+	void *m_hMapping;      // file mapping handle
+#else
+	int m_ownerFd;         // owner: shared memory object kept open and locked (-1: none)
+#endif
+	uint64_t m_txStallPos; // owner: transmit position claimed but not confirmed
+	uint64_t m_txStallUs;  // owner: first time m_txStallPos was seen not confirmed (0: none)
+
+	// Statistics of this instance
+	uint64_t m_readNb;
+	uint64_t m_lostNb;
+	uint64_t m_submittedNb;
+	uint64_t m_rejectedNb;
+	uint64_t m_txWrittenNb;
+	uint64_t m_txErrorNb;
+	uint64_t m_txSkippedNb;
+};
+
+#endif //_BRG_SHM_BUS_H
+/** @} */
+/**********************************END OF FILE*********************************/
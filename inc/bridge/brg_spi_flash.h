@@ -0,0 +1,105 @@
+/**
+  ******************************************************************************
+  * @file    brg_spi_flash.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_spi_flash.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_SPI_FLASH_H
+#define _BRG_SPI_FLASH_H
+/* Includes ------------------------------------------------------------------*/
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup SPI
+ * @{
+ */
+#define BRG_SPIFLASH_PAGE_SIZE          256   ///< Page program size
+#define BRG_SPIFLASH_SECTOR_SIZE        4096  ///< Smallest erase unit (sector erase)
+#define BRG_SPIFLASH_PAGE_TIMEOUT_MS    10    ///< Max page program time
+#define BRG_SPIFLASH_ERASE_TIMEOUT_MS   1000  ///< Max sector erase time
+#define BRG_SPIFLASH_DEFAULT_PAGE_US    700   ///< Initial page program time estimate (poll sizing)
+#define BRG_SPIFLASH_MAX_POLL_SIZE      512   ///< Max status bytes read by one poll
+
+/// SPI NOR flash identification, see BrgSpiFlash::Probe()
+typedef struct {
+	uint8_t JedecId[3];    ///< Manufacturer, memory type and capacity bytes (JEDEC 0x9F command)
+	uint32_t SizeInBytes;  ///< Size decoded from the capacity byte (see BrgSpiFlash::Probe())
+	bool bAddr4Byte;       ///< 4-byte address commands used (more than 16 MBytes)
+} Brg_SpiFlashInfoT;
+
+/// BrgSpiFlash statistics, see BrgSpiFlash::GetStats()
+typedef struct {
+	uint64_t ProgBytes;       ///< Bytes programmed by Program() without error
+	uint32_t PageProgNb;      ///< Pages programmed
+	uint32_t PageSkipNb;      ///< Pages already holding the data
+	uint32_t SectorEraseNb;   ///< Sectors erased
+	uint32_t SectorSkipNb;    ///< Sectors not erased (data written by clearing bits only)
+	uint32_t PollNb;          ///< Status register reads
+	uint32_t PageBusyUs;      ///< Smoothed page program time (poll sizing)
+	uint64_t ProgTimeUs;      ///< Time spent in Program()
+	uint64_t BytesPerSec;     ///< Effective programming throughput (ProgBytes / ProgTimeUs)
+} Brg_SpiFlashStatsT;
+// end group doxygen SPI
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// SPI NOR flash programmer (JEDEC standard commands) on top of the SPI bridge: the bridge
+/// SPI must be initialized in master mode, 8-bit data, #SPI_NSS_SOFT (chip select driven
+/// with Brg::SetSPIpinCS()). Program() works sector by sector: read, erase only if a bit
+/// must go from 0 to 1, program only the pages that differ, read back and compare.
+/// A NOR flash accepts no command but status reads while it programs a page, and the
+/// bridge runs one USB command at a time: the next page cannot be sent during the busy
+/// time. Instead the status register is polled with one continuous read sized to the
+/// expected busy time, so that the end of the page program is seen without extra round trips.
+/// Each call holds Brg::GetTransactionLock().
+class BrgSpiFlash
+{
+public:
+	BrgSpiFlash(Brg &Bridge, uint32_t SpiFreqKHz);
+	virtual ~BrgSpiFlash(void) {}
+
+	Brg_StatusT Probe(Brg_SpiFlashInfoT *pInfo);
+	Brg_StatusT Read(uint32_t Addr, uint8_t *pBuffer, uint32_t SizeInBytes);
+	Brg_StatusT Erase(uint32_t Addr, uint32_t SizeInBytes);
+	Brg_StatusT Program(uint32_t Addr, const uint8_t *pData, uint32_t SizeInBytes, bool bVerify=true);
+
+	void GetStats(Brg_SpiFlashStatsT *pStats) const;
+
+private:
+	Brg_StatusT Transfer(const uint8_t *pTx, uint32_t TxSize, uint8_t *pRx, uint32_t RxSize);
+	Brg_StatusT WriteEnable(void);
+	Brg_StatusT WaitReady(uint32_t ExpectedUs, uint32_t TimeoutMs, uint32_t *pBusyUs);
+	Brg_StatusT EraseSector(uint32_t Addr);
+	Brg_StatusT ProgramPage(uint32_t Addr, const uint8_t *pData);
+	Brg_StatusT ProgramSector(uint32_t SectorAddr, const uint8_t *pNewData, bool bVerify);
+	uint8_t SetCmdAddr(uint8_t *pCmd, uint8_t Cmd3Byte, uint8_t Cmd4Byte, uint32_t Addr) const;
+
+	Brg &m_brg;
+	uint32_t m_spiFreqKHz;
+	Brg_SpiFlashInfoT m_info;
+	bool m_bProbed;
+
+	uint8_t m_sector[BRG_SPIFLASH_SECTOR_SIZE];
+	uint8_t m_newSector[BRG_SPIFLASH_SECTOR_SIZE];
+	uint8_t m_pageCmd[5 + BRG_SPIFLASH_PAGE_SIZE];
+	uint8_t m_poll[BRG_SPIFLASH_MAX_POLL_SIZE];
+
+	Brg_SpiFlashStatsT m_stats;
+};
+
+#endif //_BRG_SPI_FLASH_H
+/** @} */
+/**********************************END OF FILE*********************************/
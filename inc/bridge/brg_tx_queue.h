@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file    brg_tx_queue.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_tx_queue.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_TX_QUEUE_H
+#define _BRG_TX_QUEUE_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "bridge.h"
+#include "brg_latency.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup CAN
+ * @{
+ */
+#define BRG_TXQ_DEFAULT_CAPACITY 1024 ///< Default number of frames in BrgTxQueue (rounded up to a power of 2)
+#define BRG_TXQ_MAX_DATA_SIZE    64   ///< Max data field size of a queued frame (FDCAN)
+
+/// BrgTxQueue priority classes, dequeued in strict priority order
+/// (a lower class is written only when all higher classes are empty)
+typedef enum {
+	BRG_TX_PRIO_CONTROL = 0, ///< Control frames: bootloader start (0x069), abort, ...
+	BRG_TX_PRIO_NORMAL = 1,  ///< Default class: diagnostic requests, keepalives
+	BRG_TX_PRIO_BULK = 2,    ///< Bulk transfers: firmware data frames
+	BRG_TX_PRIO_NB = 3       ///< Number of priority classes
+} Brg_TxPriorityT;
+
+/// Frame stored in BrgTxQueue: either a CAN message for Brg::WriteMsgCAN()
+/// or an FDCAN message for Brg::WriteMsgFDCAN()
+typedef struct {
+	bool bIsFdcan;                        ///< true: FdcanMsg is used, false: CanMsg is used
+	Brg_CanTxMsgT CanMsg;                 ///< Classic CAN header (bIsFdcan = false)
+	Brg_FdcanMsgT FdcanMsg;               ///< FDCAN header (bIsFdcan = true)
+	uint8_t Data[BRG_TXQ_MAX_DATA_SIZE];  ///< Data field
+	uint8_t SizeInBytes;                  ///< Data field size
+	Brg_TxPriorityT Priority;             ///< Priority class the frame was queued in
+	uint64_t EnqueueTimeUs;               ///< Host monotonic time at enqueue (BrgGetMonotonicUs())
+} Brg_TxFrameT;
+
+/// BrgTxQueue per class statistics
+typedef struct {
+	uint64_t EnqueuedNb;     ///< Frames accepted by Push functions
+	uint64_t SentNb;         ///< Frames written without error
+	uint64_t DroppedFullNb;  ///< Frames rejected because the queue was full
+	uint64_t DiscardedNb;    ///< Queued frames discarded by BrgTxQueue::Stop() without drain
+	uint64_t WriteErrorNb;   ///< Frames for which WriteMsgCAN/WriteMsgFDCAN failed
+	uint32_t Depth;          ///< Current number of queued frames
+	uint32_t MaxDepth;       ///< Highest depth observed since last ResetStats()
+	Brg_LatencySummaryT EnqueueToWire; ///< Latency from Push to end of USB write
+} Brg_TxClassStatsT;
+
+/// BrgTxQueue statistics, see BrgTxQueue::GetStats()
+typedef struct {
+	Brg_TxClassStatsT Total;                     ///< All classes together
+	Brg_TxClassStatsT Class[BRG_TX_PRIO_NB];     ///< Per priority class (index #Brg_TxPriorityT)
+	uint64_t PreemptedNb;   ///< Higher class frames written while lower class frames were waiting
+} Brg_TxQueueStatsT;
+// end group doxygen CAN
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Multi-producer single-consumer transmit queue with a dedicated writer thread.\n
+/// Producers never wait for USB: Push functions are lock-free and fail with
+/// #BRG_OVERRUN_ERR when the queue is full. One ring per #Brg_TxPriorityT, the
+/// writer always takes the next frame from the highest non-empty class, so a control
+/// frame waits at most for the write already in progress. For the bus order to
+/// follow this host order, CAN must be initialized with Brg_CanInitT::bIsTxfpEn=true
+/// (see BrgTxQueue::SetHostOrderCAN()). The writer thread holds
+/// Brg::GetTransactionLock() around each write, other threads using the same Brg
+/// instance must do the same.
+class BrgTxQueue
+{
+public:
+	BrgTxQueue(Brg &Bridge, uint32_t Capacity=BRG_TXQ_DEFAULT_CAPACITY);
+	virtual ~BrgTxQueue(void);
+
+	Brg_StatusT Start(void);
+	Brg_StatusT Stop(bool bDrain=true);
+
+	Brg_StatusT PushCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+	                    Brg_TxPriorityT Priority=BRG_TX_PRIO_NORMAL);
+	Brg_StatusT PushFDCAN(const Brg_FdcanMsgT *pFdcanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+	                      Brg_TxPriorityT Priority=BRG_TX_PRIO_NORMAL);
+
+	Brg_StatusT PushFrames(const Brg_TxFrameT *pFrames, uint32_t FrameNb, uint32_t *pPushedNb);
+
+	static void SetHostOrderCAN(Brg_CanInitT *pInitParams);
+
+	uint32_t GetDepth(void) const;
+	uint32_t GetDepth(Brg_TxPriorityT Priority) const;
+	void GetStats(Brg_TxQueueStatsT *pStats) const;
+	void ResetStats(void);
+
+private:
+	// Ring cell: Sequence implements the bounded MPMC algorithm (used here with one consumer)
+	typedef struct {
+		std::atomic<uint64_t> Sequence;
+		Brg_TxFrameT Frame;
+	} TxCellT;
+
+	// One ring and its statistics per priority class
+	typedef struct {
+		TxCellT *pCells;
+		uint64_t Mask;
+		std::atomic<uint64_t> EnqueuePos;
+		std::atomic<uint64_t> DequeuePos;
+		std::atomic<uint64_t> EnqueuedNb;
+		std::atomic<uint64_t> SentNb;
+		std::atomic<uint64_t> DroppedFullNb;
+		std::atomic<uint64_t> DiscardedNb;
+		std::atomic<uint64_t> WriteErrorNb;
+		std::atomic<uint32_t> MaxDepth;
+		BrgLatencyHist EnqueueToWire;
+	} TxRingT;
+
+	Brg_StatusT Push(const Brg_TxFrameT *pFrame, bool bWakeWriter=true);
+	bool Pop(TxRingT *pRing, Brg_TxFrameT *pFrame);
+	bool PopHighest(Brg_TxFrameT *pFrame);
+	void GetClassStats(const TxRingT *pRing, Brg_TxClassStatsT *pStats) const;
+	void WriterThread(void);
+	void WakeWriter(void);
+
+	Brg &m_brg;
+
+	TxRingT m_rings[BRG_TX_PRIO_NB];
+
+	// Writer thread management
+	std::thread m_writer;
+	std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bStopReq;
+	std::atomic<bool> m_bDrainOnStop;
+	std::atomic<bool> m_bWriterIdle;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCond;
+
+	// Statistics (per class ones are in m_rings)
+	std::atomic<uint32_t> m_maxDepth;
+	std::atomic<uint64_t> m_preemptedNb;
+	BrgLatencyHist m_enqueueToWire;
+};
+
+#endif //_BRG_TX_QUEUE_H
+/** @} */
+/**********************************END OF FILE*********************************/
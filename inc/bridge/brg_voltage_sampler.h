@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * @file    brg_voltage_sampler.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_voltage_sampler.cpp module
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/** @addtogroup BRIDGE
+ * @{
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_VOLTAGE_SAMPLER_H
+#define _BRG_VOLTAGE_SAMPLER_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "bridge.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/** @addtogroup DEVICE
+ * @{
+ */
+#define BRG_VSAMPLER_DEFAULT_PERIOD_MS   100   ///< Default sampling period
+#define BRG_VSAMPLER_DEFAULT_WINDOW_NB   50    ///< Default number of samples of the rolling window
+#define BRG_VSAMPLER_DEFAULT_IDLE_GAP_US 100   ///< Default USB idle time before a sample is taken
+#define BRG_VSAMPLER_RETRY_US            100   ///< Wait before looking again for an idle USB slot
+#define BRG_VSAMPLER_MAX_WINDOW_NB       4096  ///< Upper limit of Brg_VoltageSamplerConfT::WindowNb
+
+/// Brown-out event, see #Brg_VoltageEventCallbackT
+typedef struct {
+	uint64_t TimeUs;   ///< Host time of the sample (BrgGetMonotonicUs())
+	float Voltage;     ///< Sample below the threshold
+	float Threshold;   ///< Brg_VoltageSamplerConfT::BrownOutV
+} Brg_VoltageEventT;
+
+/// Brown-out callback, called by the sampler thread without any lock held
+typedef void (*Brg_VoltageEventCallbackT)(void *pContext, const Brg_VoltageEventT *pEvent);
+
+/// BrgVoltageSampler configuration
+typedef struct {
+	uint32_t PeriodMs;     ///< Sampling period
+	uint32_t WindowNb;     ///< Samples of the rolling window (max #BRG_VSAMPLER_MAX_WINDOW_NB)
+	uint32_t IdleGapUs;    ///< Time without bridge command before a sample may be taken
+	uint32_t MaxDeferMs;   ///< Sample skipped if no idle slot within this time (0: one period)
+	float BrownOutV;       ///< Brown-out threshold (0: no event)
+	float HysteresisV;     ///< New event only after a sample above BrownOutV + HysteresisV
+} Brg_VoltageSamplerConfT;
+
+/// BrgVoltageSampler statistics and rolling window, see BrgVoltageSampler::GetStats()
+typedef struct {
+	uint64_t SampleNb;      ///< Samples taken
+	uint64_t SkippedNb;     ///< Samples skipped: no idle USB slot within MaxDeferMs
+	uint64_t ErrorNb;       ///< Brg::GetTargetVoltage() failures
+	uint64_t BrownOutNb;    ///< Brown-outs detected (events raised only while flashing)
+	uint32_t WindowNb;      ///< Samples in the window
+	float Last;             ///< Last sample
+	float Min;              ///< Window minimum
+	float Max;              ///< Window maximum
+	float Mean;             ///< Window mean
+	uint32_t MaxDeferUs;    ///< Longest wait for an idle USB slot
+} Brg_VoltageStatsT;
+// end group doxygen DEVICE
+/** @} */
+
+/* Class -------------------------------------------------------------------- */
+/// Target voltage sampler: a thread reads Brg::GetTargetVoltage() at a fixed period and
+/// keeps a rolling window of the samples. A sample is taken only in an idle USB slot:
+/// Brg::GetTransactionLock() free (try_lock, the thread never waits for it) and no bridge
+/// command for IdleGapUs (Brg::GetLastCmdEndUs()). The CAN lanes (BrgTxQueue, BrgRxPump,
+/// BrgEventLoop) release the lock between commands: a short gap is enough to let a burst
+/// of back to back commands finish, the sample then goes in the pause following the
+/// burst. A longer gap does not predict a longer pause and makes idle slots rarer.
+/// A sample without idle slot within MaxDeferMs is skipped.
+/// Any other thread calling the same Brg directly must hold Brg::GetTransactionLock()
+/// around its calls, otherwise a sample can be taken in the middle of its transaction.
+/// A sample below BrownOutV while SetFlashing(true) raises the brown-out callback, once
+/// until the voltage comes back above BrownOutV + HysteresisV (brown-outs outside of
+/// flashing are only counted).
+/// Requires the target voltage on T_VCC (see Brg::GetTargetVoltage()).
+class BrgVoltageSampler
+{
+public:
+	BrgVoltageSampler(Brg &Bridge, const Brg_VoltageSamplerConfT *pConf=NULL,
+	                  Brg_VoltageEventCallbackT Callback=NULL, void *pContext=NULL);
+	virtual ~BrgVoltageSampler(void);
+
+	Brg_StatusT Start(void);
+	Brg_StatusT Stop(void);
+
+	void SetFlashing(bool bFlashing);
+	void GetStats(Brg_VoltageStatsT *pStats) const;
+
+private:
+	void SamplerThread(void);
+	bool TakeSample(uint64_t DeadlineUs);
+	void AddSample(float Voltage, uint64_t TimeUs);
+
+	Brg &m_brg;
+	Brg_VoltageSamplerConfT m_conf;
+	Brg_VoltageEventCallbackT m_callback;
+	void *m_pContext;
+
+	std::thread m_sampler;
+	std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bStopReq;
+	std::atomic<bool> m_bFlashing;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCond;
+
+	// Rolling window and statistics, protected by m_dataMutex
+	mutable std::mutex m_dataMutex;
+	float *m_pWindow;
+	uint32_t m_windowNb;
+	uint32_t m_windowNext;
+	Brg_VoltageStatsT m_stats;
+	bool m_bBrownOut;      // below threshold, hysteresis not passed yet
+	bool m_bEventRaised;   // callback called for the current brown-out
+};
+
+#endif //_BRG_VOLTAGE_SAMPLER_H
+/** @} */
+/**********************************END OF FILE*********************************/
@@ -20,8 +20,12 @@
 #ifndef _BRIDGE_H
 #define _BRIDGE_H
 /* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <mutex>
 #include "stlink_device.h"
 #include "stlink_fw_const_bridge.h"
+#include "brg_latency.h"
+#include "brg_hw_time.h"
 
 
 /* Exported types and constants ----------------------------------------------*/
@@ -178,6 +182,11 @@ typedef struct {
 	///< Note for larger delay: call N time Read/Write function transmitting 1 byte instead of 1 time
 	///<                        Read/write function transmitting N bytes (~200us delay)
 } Brg_SpiInitT;
+
+/// Brg::ReadStreamSPI()/Brg::WriteStreamSPI() default chunk size: one command transfers
+/// 127 USB high speed packets (the 8 first bytes of a write chunk go in the command,
+/// a read chunk is 65024 bytes)
+#define BRG_SPI_STREAM_CHUNK_SIZE   65032
 // end group doxygen SPI
 /** @} */
 // -------------------------------- I2C ------------------------------------ //
@@ -216,6 +225,8 @@ typedef enum {
 #define I2C_10B_ADDR_FLAG  0x8000   ///< I2C 10bit addressing flag
 #define I2C_10B_ADDR(_addr) (_addr|I2C_10B_ADDR_FLAG) ///< I2C 10bit addressing macro
 #define I2C_7B_ADDR(_addr) (_addr)  ///< I2C 7bit addressing macro
+#define I2C_NO_WAIT_MAX_SIZE 512   ///< Max size of Brg::ReadNoWaitI2C() and Brg::GetReadDataI2C()
+#define BRG_I2C_TIMING_CACHE_NB 8  ///< Brg::GetI2cTiming() results kept (oldest replaced)
 
 // Private low level struct for partial transfer management
 typedef enum {
@@ -261,6 +272,13 @@ typedef struct {
 						   ///<      FDCAN Nominal BitTime: 1 to max 128 time quantum, (must be less than PHASE_SEG2)\n
 						   ///<      FDCAN: Data BitTime: 1 to max 16 time quantum,(must be less than PHASE_SEG2)
 } Brg_CanBitTimeConfT;
+
+/// CAN and FDCAN Init: exact bit timing found by Brg::FindCANbitTiming() or Brg::FindFDCANbitTiming()
+typedef struct {
+	Brg_CanBitTimeConfT BitTimeConf; ///< Segments to use in InitCAN()/InitFDCAN()
+	uint32_t Prescaler;              ///< Prescaler to use with BitTimeConf
+	uint16_t SamplePointPermil;      ///< Achieved sample point: (1 + PROP_SEG + PHASE_SEG1) / N in 1/1000
+} Brg_CanBitTimingT;
 // end group doxygen FDCAN (common CAN/FDCAN)
 /** @} */
 
@@ -326,6 +344,16 @@ typedef enum {
 	CAN_RX_FIFO_OVERRUN = 1, ///< STLink CAN HW fifo overrun
 	CAN_RX_BUFF_OVERRUN = 2  ///< STLink CAN Rx buffer overrun
 } Brg_CanRxOverrunT;
+
+/// Rx overrun accounting of Brg::GetRxMsgCAN() and Brg::GetRxMsgFDCAN(), see Brg::GetRxOverrunStats()
+typedef struct {
+	uint64_t RxMsgNb;           ///< Messages read
+	uint64_t FifoOverrunNb;     ///< Messages flagged #CAN_RX_FIFO_OVERRUN (messages lost before them)
+	uint64_t BuffOverrunNb;     ///< Messages flagged #CAN_RX_BUFF_OVERRUN (messages lost before them)
+	uint64_t FirstOverrunUs;    ///< Host time of the first overrun (BrgGetMonotonicUs(), 0 if none)
+	uint64_t LastFifoOverrunUs; ///< Host time of the last #CAN_RX_FIFO_OVERRUN (0 if none)
+	uint64_t LastBuffOverrunUs; ///< Host time of the last #CAN_RX_BUFF_OVERRUN (0 if none)
+} Brg_RxOverrunStatsT;
 // end group doxygen FDCAN (common CAN/FDCAN)
 /** @} */
 
@@ -340,6 +368,8 @@ typedef struct {
 	                     ///< with Brg::InitFilterCAN(): AssignedFifo in #Brg_CanFilterConfT)
 	Brg_CanRxOverrunT Overrun; ///< Indicate if overrun has occurred before this message.
 	uint16_t TimeStamp;  ///< unused
+	uint64_t HostTimeUs; ///< Host reception time estimate (BrgGetMonotonicUs() base): start of the
+	                     ///< Brg::GetRxMsgCAN() USB transfer, the message was received before.
 } Brg_CanRxMsgT;
 
 /// Structure for Tx CAN messages (except data field), see also \ref LIMITATION
@@ -419,6 +449,8 @@ typedef struct {
 	                         ///< Mask[1] used only if 16bit and ID_MASK.
 	Brg_CanRxFifoT AssignedFifo;     ///< Rx FIFO in which message is received
 }Brg_CanFilterConfT;
+
+#define BRG_CAN_FILTER_BANK_NB 14 ///< CAN filter banks (Brg_CanFilterConfT::FilterBankNb 0 to 13)
 // end group doxygen CAN
 /** @} */
 
@@ -538,6 +570,9 @@ typedef struct {
 						///< with Brg::InitFilterFDCAN())
 	Brg_CanRxOverrunT Overrun; ///< Indicate if overrun has occurred before this message.
 	uint16_t TimeStamp;  ///<  Rx Message time stamp, if timestamp enabled: 16bit counter value captured on SOF detection else 0.
+	uint64_t HostTimeUs; ///< Host reception time estimate (BrgGetMonotonicUs() base): TimeStamp unwrapped
+	                     ///< and mapped onto the host time (see #BrgHwTimeMap), start of the
+	                     ///< Brg::GetRxMsgFDCAN() USB transfer until the tick period is known.
 } Brg_FdcanRxMsgT;
 
 /// Filter mode \n
@@ -639,6 +674,24 @@ typedef enum {
 	GPIO_SET = 1    ///< GPIO High level
 }Brg_GpioValT;
 /** @} */
+
+// ------------------------------ STATISTICS ------------------------------- //
+/** @addtogroup DEVICE
+ * @{
+ */
+#define BRG_CMD_STATS_OPCODE_NB 256 ///< Command opcodes with statistics: bridge commands (CDBByte[1]) and STLink commands (CDBByte[0])
+
+/// Statistics of one bridge command opcode, see Brg::GetCmdStats()
+typedef struct {
+	uint64_t CmdNb;        ///< Commands sent
+	uint64_t TxBytes;      ///< Data bytes written after the command (CDB not included)
+	uint64_t RxBytes;      ///< Data bytes read as answer
+	uint64_t UsbErrNb;     ///< Commands failed with #BRG_USB_COMM_ERR
+	uint64_t StatusErrNb;  ///< Commands for which the bridge returned an error status
+	Brg_LatencySummaryT Latency; ///< USB round trip (StlinkDevice::SendRequest()) in us
+} Brg_CmdStatsT;
+// end group doxygen DEVICE
+/** @} */
 // ------------------------------------------------------------------------- //
 /* Class -------------------------------------------------------------------- */
 /// Bridge Class
@@ -675,6 +728,10 @@ public:
 	Brg_StatusT SetSPIpinCS(Brg_SpiNssLevelT NssLevel);
 	Brg_StatusT ReadSPI(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeRead);
 	Brg_StatusT WriteSPI(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeWritten);
+	Brg_StatusT ReadStreamSPI(uint8_t *pBuffer, uint32_t SizeInBytes, uint32_t *pSizeRead,
+	                          uint16_t ChunkSize=BRG_SPI_STREAM_CHUNK_SIZE);
+	Brg_StatusT WriteStreamSPI(const uint8_t *pBuffer, uint32_t SizeInBytes, uint32_t *pSizeWritten,
+	                           uint16_t ChunkSize=BRG_SPI_STREAM_CHUNK_SIZE);
 
 	Brg_StatusT InitI2C(const Brg_I2cInitT *pInitParams);
 	Brg_StatusT GetI2cTiming(I2cModeT I2CSpeedMode, int SpeedFrequency, int DNFn, int RiseTime,
@@ -708,6 +765,8 @@ public:
 	Brg_StatusT InitCAN(const Brg_CanInitT *pInitParams, Brg_InitTypeT InitType);
 	Brg_StatusT GetCANbaudratePrescal(const Brg_CanBitTimeConfT *pBitTimeConf, uint32_t ReqBaudrate,
 	                                  uint32_t *pPrescal, uint32_t *pFinalBaudrate);
+	Brg_StatusT FindCANbitTiming(uint32_t ReqBaudrate, uint16_t SamplePointPermil, Brg_CanBitTimingT *pCandidates,
+	                             uint8_t MaxCandidateNb, uint8_t *pCandidateNb);
 	Brg_StatusT InitFilterCAN(const Brg_CanFilterConfT *pInitParams);
 	Brg_StatusT StartMsgReceptionCAN(void);
 	Brg_StatusT StopMsgReceptionCAN(void);
@@ -715,12 +774,18 @@ public:
 	Brg_StatusT GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pBuffer,
 	                        uint16_t BufSizeInBytes, uint16_t *pDataSizeInBytes);
 	Brg_StatusT WriteMsgCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes);
+	void ClearCanConfCache(void);
+	void GetRxOverrunStats(Brg_RxOverrunStatsT *pStats) const;
+	void ResetRxOverrunStats(void);
 
 	Brg_StatusT InitFDCAN(const Brg_FdcanInitT* pInitParams, Brg_InitTypeT InitType, bool bStartBus=true);
 	Brg_StatusT StartFDCAN(void);
 	Brg_StatusT StopFDCAN(void);
 	Brg_StatusT GetFDCANbaudratePrescal(const Brg_CanBitTimeConfT* pBitTimeConf, uint32_t ReqBaudrate,
 	                                uint32_t* pPrescal, uint32_t* pFinalBaudrate, const Brg_FdcanFrameModeT CanMode, const bool bIsNomBitTime);
+	Brg_StatusT FindFDCANbitTiming(uint32_t ReqBaudrate, uint16_t SamplePointPermil, const Brg_FdcanFrameModeT FrameMode,
+	                               const bool bIsNomBitTime, Brg_CanBitTimingT* pCandidates, uint8_t MaxCandidateNb,
+	                               uint8_t* pCandidateNb);
 	Brg_StatusT InitFilterFDCAN(const Brg_FdcanFilterConfT* pInitParams);
 	Brg_StatusT StartMsgReceptionFDCAN(void);
 	Brg_StatusT StopMsgReceptionFDCAN(void);
@@ -729,6 +794,7 @@ public:
 	                          uint16_t BufSizeInBytes, uint16_t* pDataSizeInBytes,
 	                          const Brg_CanRxFifoT FifoNb = CAN_MSG_RX_FIFO0);
 	Brg_StatusT WriteMsgFDCAN(const Brg_FdcanMsgT* pFdcanMsg, const uint8_t* pBuffer, uint8_t SizeInBytes);
+	void GetRxTimeStateFDCAN(Brg_HwTimeStateT* pState) const;
 
 	Brg_StatusT InitGPIO(const Brg_GpioInitT *pInitParams);
 	Brg_StatusT ReadGPIO(uint8_t GpioMask, Brg_GpioValT *pGpioVal, uint8_t *pGpioErrorMask);
@@ -736,6 +802,32 @@ public:
 
 	static Brg_StatusT ConvSTLinkIfToBrgStatus(STLinkIf_StatusT IfStat);
 
+	/**
+	 * @ingroup DEVICE
+	 * @brief Lock to be held around each Brg call when the same Brg instance is shared
+	 *        between several threads (e.g. BrgTxQueue writer thread): it keeps a command
+	 *        and its Brg::GetLastReadWriteStatus() together.
+	 * @retval Recursive mutex of this Brg instance.
+	 */
+	std::recursive_mutex& GetTransactionLock(void) {
+		return m_transactionLock;
+	}
+
+	/**
+	 * @ingroup DEVICE
+	 * @brief Can be called from any thread, used to find idle USB slots (see BrgVoltageSampler).
+	 * @retval Host time (BrgGetMonotonicUs()) of the end of the last USB command, 0 if none.
+	 */
+	uint64_t GetLastCmdEndUs(void) const {
+		return m_lastCmdEndUs.load(std::memory_order_relaxed);
+	}
+
+	Brg_StatusT GetCmdStats(uint8_t Opcode, Brg_CmdStatsT *pStats) const;
+	void ResetCmdStats(void);
+	void DumpCmdStats(FILE *pFile) const;
+	void SetCmdStatsDumpOnExit(FILE *pFile);
+	static const char* GetCmdName(uint8_t Opcode);
+
 	bool IsCanSupport(void) const;
 	bool IsReadNoWaitI2CSupport(void) const;
 	bool IsOldBrgFwVersion(void) const;
@@ -750,6 +842,12 @@ private:
 	                                        const uint16_t *pStatus,
 	                                        const uint16_t UsbTimeoutMs=0);
 
+	STLinkIf_StatusT SendDeviceRequest(STLink_DeviceRequestT *pDevReq, const uint16_t UsbTimeoutMs=0) const;
+
+
+	Brg_StatusT ReadSPIcmd(uint8_t *pBuffer, uint16_t SizeInBytes);
+	Brg_StatusT WriteSPIcmd(const uint8_t *pBuffer, uint16_t SizeInBytes);
+	static uint16_t GetStreamChunkSPI(uint16_t ChunkSize, bool bIsWrite);
 
 	Brg_StatusT WriteI2Ccmd(const uint8_t *pBuffer, uint16_t Addr, uint16_t Size,
 	                        Brg_I2cRWTransfer RwTransType, uint16_t *pSizeWritten, uint32_t *pErrorInfo);
@@ -761,11 +859,82 @@ private:
 	// Global to manage I2C partial transaction (START, STOP, CONT)
 	uint16_t m_slaveAddrPartialI2cTrans;
 
+	// Serialize multi-command transactions between threads sharing this instance
+	std::recursive_mutex m_transactionLock;
+
+	// Per opcode command statistics, allocated at first use of the opcode
+	typedef struct {
+		BrgLatencyHist Latency;
+		std::atomic<uint64_t> CmdNb;
+		std::atomic<uint64_t> TxBytes;
+		std::atomic<uint64_t> RxBytes;
+		std::atomic<uint64_t> UsbErrNb;
+		std::atomic<uint64_t> StatusErrNb;
+	} CmdStatsT;
+	mutable std::atomic<CmdStatsT*> m_pCmdStats[BRG_CMD_STATS_OPCODE_NB];
+	FILE *m_pCmdStatsDumpFile;
+	CmdStatsT* GetCmdStatsEntry(uint8_t Opcode) const;
+	static uint8_t GetCmdStatsOpcode(const STLink_DeviceRequestT *pDevReq);
+	mutable std::atomic<uint64_t> m_lastCmdEndUs;
+
+	// CAN configuration applied in this session (request bytes of the last successful
+	// InitCAN()/InitFilterCAN()), an identical configuration is not sent again
+	typedef struct {
+		bool bValid;
+		uint8_t Conf[6]; // Mode, BS1, BS2+SJW, configuration bits, prescaler (2 bytes)
+	} CanInitCacheT;
+	typedef struct {
+		bool bValid;
+		uint8_t Conf[9]; // Filter configuration, FilterId (4 bytes), FilterMask (4 bytes)
+	} CanFilterCacheT;
+	CanInitCacheT m_canInitCache;
+	CanFilterCacheT m_canFilterCache[BRG_CAN_FILTER_BANK_NB];
+
+	// GetI2cTiming() results per I2C input clock
+	void ClearI2cTimingCache(void);
+	typedef struct {
+		bool bValid;
+		I2cModeT I2CSpeedMode;
+		int SpeedFrequency;
+		int DNFn;
+		int RiseTime;
+		int FallTime;
+		bool bAF;
+		uint32_t ClockKHz;
+		Brg_StatusT Status;
+		uint32_t TimingReg;
+	} I2cTimingCacheT;
+	I2cTimingCacheT m_i2cTimingCache[BRG_I2C_TIMING_CACHE_NB];
+	int m_i2cTimingCacheNext;
+
+	// Rx overrun accounting (GetRxMsgCAN()/GetRxMsgFDCAN() may run in any thread)
+	void RecordRxOverrun(Brg_CanRxOverrunT Overrun);
+	std::atomic<uint64_t> m_rxMsgNb;
+	std::atomic<uint64_t> m_fifoOverrunNb;
+	std::atomic<uint64_t> m_buffOverrunNb;
+	std::atomic<uint64_t> m_firstOverrunUs;
+	std::atomic<uint64_t> m_lastFifoOverrunUs;
+	std::atomic<uint64_t> m_lastBuffOverrunUs;
+
+	// FDCAN Rx timestamps to host time (GetRxMsgFDCAN())
+	BrgHwTimeMap m_fdcanTimeMap;
+
 	Brg_StatusT CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency, double ClockSource,
 	                                  int DNFn, int RiseTime, int FallTime, bool bAF, uint32_t *pTimingReg);
 	Brg_StatusT FormatFilter32bitCAN(const Brg_FilterBitsT *pInConf, uint8_t *pOutConf);
 	Brg_StatusT FormatFilter16bitCAN(const Brg_FilterBitsT *pInConf, uint8_t *pOutConf);
 	Brg_StatusT CheckBitTimeClassicCAN(const Brg_CanBitTimeConfT* pBitTimeConf);
+	// Segment and prescaler limits of CheckBitTimeClassicCAN()/CheckBitTimeFDCAN() for the bit timing solver
+	typedef struct {
+		uint16_t Bs1Max;      // PROP_SEG + PHASE_SEG1
+		uint8_t SegMax;       // PROP_SEG and PHASE_SEG1 each
+		uint8_t Bs2Max;       // PHASE_SEG2
+		uint8_t SjwMax;
+		uint16_t PrescalerMax;
+	} BitTimeLimitsT;
+	static Brg_StatusT SolveBitTiming(uint32_t CanClkHz, uint32_t ReqBaudrate, uint16_t SamplePointPermil,
+	                                  const BitTimeLimitsT *pLimits, Brg_CanBitTimingT *pCandidates,
+	                                  uint8_t MaxCandidateNb, uint8_t *pCandidateNb);
 	Brg_StatusT CheckBitTimeFDCAN(const Brg_CanBitTimeConfT* pBitTimeConf, const Brg_FdcanFrameModeT CanMode, const bool bIsNomBitTime);
 	Brg_StatusT InitBitTimeFDCAN(const Brg_CanBitTimeConfT* pBitTimeConf, const uint32_t Prescaler, const Brg_FdcanFrameModeT CanMode, const bool bIsNomBitTime);
 };
@@ -119,6 +119,9 @@ protected:
 	STLinkIf_StatusT GetTargetVoltage(float *pVoltage) const;
 
 	STLinkIf_StatusT SendRequest(STLink_DeviceRequestT *pDevReq, const uint16_t UsbTimeoutMs=0) const;
+	// Used by the StlinkDevice commands (version, target voltage), derived classes may
+	// override it to instrument the request. Default: SendRequest().
+	virtual STLinkIf_StatusT SendDeviceRequest(STLink_DeviceRequestT *pDevReq, const uint16_t UsbTimeoutMs=0) const;
 	void LogTrace(const char *pMessage, ...) const;
 
 	char m_SerialNum[SERIAL_NUM_STR_MAX_LEN];
@@ -3,10 +3,11 @@
   * @file    ErrLog.h
   * @author  MCD Application Team
   * @brief   Header for ErrLog.cpp module. All tracing mechanisms:
-	1. ErrorLog: circular buffer always filled in, that can be dumped into
-	    a file after an error for instance
-	2. TraceLog: immediate trace logging in a file (once activated, the file
-	   is opened then closed on each trace action)
+	1. ErrorLog: binary trace records always filled in (one lock-free ring per
+	    thread: timestamp, format string pointer and raw arguments), formatted
+	    later by a dumper thread into the log file or on Dump()
+	2. TraceLog: once Init() is called the dumper thread appends the formatted
+	   records to the file every ERRLOG_DUMP_PERIOD_MS
 	3. TraceFunctionCall: manages automatic indentation for tracing function
 	   callings in ErrorLog and/or TraceLog systems. In order to trace a function,
 		 just instantiate the object.
@@ -33,33 +34,91 @@
 #ifndef WIN32 //Linux MacOS (not Win32 and Win64)
 #include <stdarg.h> // for va_list
 #endif
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
 
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
+#define ERRLOG_RING_RECORDS   1024 // Records per thread ring (power of 2)
+#define ERRLOG_MAX_ARGS       12   // Arguments kept per record, next ones are dropped
+                                   // (BRIDGE error trace of SendRequestAndAnalyzeStatus(): 11)
+#define ERRLOG_STR_SIZE       48   // Bytes per record for the %s arguments (copied, truncated)
+#define ERRLOG_DUMP_PERIOD_MS 100  // Dumper thread period
+
 /* External variables --------------------------------------------------------*/
 /* Exported macros -----------------------------------------------------------*/
 
 /* Class -------------------------------------------------------------------- */
-class cErrLog 	// To be completed: implementation defined
+// LogTrace() is lock-free and does not format: the format string must stay valid
+// until the record is dumped (string literal), %s arguments are copied.
+class cErrLog
 {
 public:
 	cErrLog();
-	// to be completed: implementation defined
+	~cErrLog();
+	// Open the log file and start the dumper thread
 	// bResetFile == true clear the content of the file if it exists
 	void Init (const char *pSzFileName, bool bResetFile);
-	// Flush the file if not already done in LogTrace: to be completed: implementation defined
+	// Format the pending records into the file and flush it (any thread)
 	void Dump();
 
-	// General log trace routine: to be completed: implementation defined
+	// General log trace routine: binary record in the calling thread ring
 	void LogTrace(const char *pMessage, ...);
 	void LogTrace(const char *pMessage, va_list Args);
 
+	// Records lost because a ring was full (dumper too slow or not started)
+	uint64_t GetDroppedNb(void) const;
+	// Rings allocated: threads which traced, minus the exited ones already dumped
+	uint32_t GetRingNb(void) const;
+
 private:
+	typedef struct {
+		uint64_t TimeUs;
+		const char *pFormat;
+		uint64_t Args[ERRLOG_MAX_ARGS]; // integer, double bits, pointer or Str offset (%s)
+		uint16_t ThreadNb;
+		uint8_t ArgNb;
+		uint8_t StrSize;
+		char Str[ERRLOG_STR_SIZE];
+	} ErrLogRecordT;
+
+	// Single producer (owner thread) / single consumer (dumper) ring
+	typedef struct {
+		ErrLogRecordT Records[ERRLOG_RING_RECORDS];
+		std::atomic<uint32_t> Head;   // written by the owner thread
+		std::atomic<uint32_t> Tail;   // written by the dumper
+		std::atomic<uint64_t> DroppedNb;
+		uint64_t ReportedDroppedNb;   // dumper only
+		uint16_t ThreadNb;            // registration order, printed as T<nb>
+		std::atomic<bool> bThreadExited; // freed by the next drain
+	} ErrLogRingT;
 
-	// To be completed: implementation defined
+	// Thread exit (thread_local destructor) of the rings of the exiting thread
+	friend class cErrLogThreadRings;
+	static void ReleaseThreadRing(cErrLog *pLog, uint64_t InstanceId, void *pRing);
+
+	ErrLogRingT* GetThreadRing(void);
+	void DrainRings(void);
+	void FormatRecord(const ErrLogRecordT *pRecord, char *pLine, size_t LineSize) const;
+	void DumperThread(void);
+
+	uint64_t m_instanceId;     // identifies this instance in the thread_local ring cache
+	uint64_t m_originUs;
+	std::vector<ErrLogRingT*> m_rings;
+	mutable std::mutex m_ringsMutex; // m_rings registration, and drain (one consumer at a time)
+	uint16_t m_threadNb;             // rings created
+	uint64_t m_releasedDroppedNb;    // DroppedNb of the rings freed at thread exit
+	FILE *m_pFile;
+	std::thread m_dumper;
+	std::mutex m_dumperMutex;
+	std::condition_variable m_dumperCv;
+	bool m_bStop;
 };
 
 #endif /* ERRLOG_H */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
-
@@ -19,39 +19,202 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "ErrLog.h"
-#include <stdio.h> // fopen... 
+#include <stdio.h> // fopen...
 #ifdef WIN32
 #include <stdlib.h> // for _countof
 #endif
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
 /* Private typedef -----------------------------------------------------------*/
+// Conversion specification parsed from a printf format string
+typedef struct {
+	const char *pStart;  // '%'
+	const char *pEnd;    // conversion character
+	int StarNb;          // '*' width and/or precision (one int argument each)
+	char Length;         // 0, 'H' (hh), 'h', 'l', 'q' (ll), 'z', 'j', 't' or 'L'
+	char Conv;
+} ErrLogSpecT;
+
+// Ring of the calling thread for one cErrLog instance
+typedef struct {
+	cErrLog *pLog;
+	uint64_t InstanceId;
+	void *pRing;
+} ErrLogThreadRingT;
+
+// Rings of the calling thread (thread_local): flagged for release when the thread exits
+class cErrLogThreadRings
+{
+public:
+	cErrLogThreadRings(): LastInstanceId(0), pLastRing(NULL) {}
+	~cErrLogThreadRings()
+	{
+		for( size_t i = 0; i < Rings.size(); i++ ) {
+			cErrLog::ReleaseThreadRing(Rings[i].pLog, Rings[i].InstanceId, Rings[i].pRing);
+		}
+	}
+	std::vector<ErrLogThreadRingT> Rings;
+	uint64_t LastInstanceId; // instance of the last LogTrace(), lock-free path
+	void *pLastRing;
+};
+
 /* Private defines -----------------------------------------------------------*/
+#define ERRLOG_RING_MASK      (ERRLOG_RING_RECORDS-1)
+#define ERRLOG_STR_NONE       0xFFFF // %s argument not stored (NULL or no room left)
+#define ERRLOG_LINE_SIZE      512
+#define ERRLOG_SPEC_SIZE      32
+
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 // static variables
+static std::atomic<uint64_t> g_errLogInstanceNb(0);
+static thread_local cErrLogThreadRings t_errLogRings;
 
 /* Global variables ----------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+// cErrLog instances not destroyed, checked by the exiting threads before touching a ring.
+// Never freed: a thread or a static cErrLog may still use them during static destruction.
+static std::mutex& ErrLogLiveMutex(void)
+{
+	static std::mutex *pMutex = new std::mutex;
+	return *pMutex;
+}
+
+static std::vector<cErrLog*>& ErrLogLiveInstances(void)
+{
+	static std::vector<cErrLog*> *pInstances = new std::vector<cErrLog*>;
+	return *pInstances;
+}
+
+static uint64_t ErrLogGetTimeUs(void)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Parse the conversion specification starting at pFormat ('%'), pSpec->Conv is 0
+ * for "%%" and for an incomplete specification at end of string.
+ */
+static const char* ErrLogParseSpec(const char *pFormat, ErrLogSpecT *pSpec)
+{
+	const char *p = pFormat + 1;
+
+	pSpec->pStart = pFormat;
+	pSpec->StarNb = 0;
+	pSpec->Length = 0;
+	pSpec->Conv = 0;
+	if( *p == '%' ) {
+		pSpec->pEnd = p;
+		return p + 1;
+	}
+	while( (*p == '-') || (*p == '+') || (*p == ' ') || (*p == '#') || (*p == '0') ) {
+		p++;
+	}
+	if( *p == '*' ) {
+		pSpec->StarNb++;
+		p++;
+	}
+	while( (*p >= '0') && (*p <= '9') ) {
+		p++;
+	}
+	if( *p == '.' ) {
+		p++;
+		if( *p == '*' ) {
+			pSpec->StarNb++;
+			p++;
+		}
+		while( (*p >= '0') && (*p <= '9') ) {
+			p++;
+		}
+	}
+	if( (*p == 'h') || (*p == 'l') ) {
+		pSpec->Length = *p;
+		if( p[1] == *p ) {
+			pSpec->Length = (*p == 'h') ? 'H' : 'q';
+			p++;
+		}
+		p++;
+	} else if( (*p == 'z') || (*p == 'j') || (*p == 't') || (*p == 'L') ) {
+		pSpec->Length = *p;
+		p++;
+	}
+	pSpec->pEnd = p;
+	if( *p == 0 ) {
+		return p;
+	}
+	pSpec->Conv = *p;
+	return p + 1;
+}
+
 /* Class Functions Definition ------------------------------------------------*/
 
-/*****************************************************************************/    
-cErrLog::cErrLog()
+/*****************************************************************************/
+cErrLog::cErrLog(): m_threadNb(0), m_releasedDroppedNb(0), m_pFile(NULL), m_bStop(false)
 {
-	// To be completed: implementation defined
+	m_instanceId = g_errLogInstanceNb.fetch_add(1) + 1;
+	m_originUs = ErrLogGetTimeUs();
+	std::lock_guard<std::mutex> lock(ErrLogLiveMutex());
+	ErrLogLiveInstances().push_back(this);
 }
 
-/*****************************************************************************/    
+/*****************************************************************************/
+cErrLog::~cErrLog()
+{
+	{
+		// Threads exiting from now on do not touch the rings
+		std::lock_guard<std::mutex> lock(ErrLogLiveMutex());
+		std::vector<cErrLog*> &instances = ErrLogLiveInstances();
+		for( size_t i = 0; i < instances.size(); i++ ) {
+			if( instances[i] == this ) {
+				instances.erase(instances.begin() + i);
+				break;
+			}
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_dumperMutex);
+		m_bStop = true;
+	}
+	m_dumperCv.notify_all();
+	if( m_dumper.joinable() ) {
+		m_dumper.join();
+	}
+	Dump();
+	if( m_pFile != NULL ) {
+		fclose(m_pFile);
+		m_pFile = NULL;
+	}
+	for( size_t i = 0; i < m_rings.size(); i++ ) {
+		delete m_rings[i];
+	}
+}
+
+/*****************************************************************************/
 void cErrLog::Init (const char *pSzFileName, bool bResetFile)
 {
-	// To be completed: implementation defined
+	if( pSzFileName == NULL ) {
+		return;
+	}
+	// Records logged before are written to the new file
+	{
+		std::lock_guard<std::mutex> lock(m_ringsMutex);
+		if( m_pFile != NULL ) {
+			fclose(m_pFile);
+		}
+		m_pFile = fopen(pSzFileName, (bResetFile == true) ? "w" : "a");
+	}
+	if( (m_pFile != NULL) && (m_dumper.joinable() == false) ) {
+		m_dumper = std::thread(&cErrLog::DumperThread, this);
+	}
 }
-/*****************************************************************************/    
+/*****************************************************************************/
 void cErrLog::Dump()
 {
-	// To be completed: implementation defined
-	// possible implementation:
-	// if records available, open errorLog file
-	// copy errorLog buffer in the errorLog file, add timestamp ...
-	// close errorLog file
-	// reset errorLog buffer
+	// Format the pending records into the log file (stderr if Init() not done)
+	DrainRings();
 }
 
 void cErrLog::LogTrace(const char *pMessage, ...)
@@ -59,18 +222,381 @@ void cErrLog::LogTrace(const char *pMessage, ...)
 	// Trace the specified string into log file
 
 	va_list args; // used to manage the variable argument list
-	va_start(args, pMessage);     
+	va_start(args, pMessage);
 
 	LogTrace(pMessage, args);
 
-	va_end(args);     
+	va_end(args);
 }
 
 void cErrLog::LogTrace(const char *pMessage, va_list Args)
 {
-	// Trace the specified string into log file
-	// To be completed: implementation defined
-	// possible implementation: write in a buffer or in a file
+	// Store a binary record in the calling thread ring: arguments are read according to
+	// the format string but not formatted, %s arguments are copied (truncated)
+	ErrLogRingT *pRing;
+	ErrLogRecordT *pRecord;
+	ErrLogSpecT spec;
+	const char *p, *pStr;
+	uint32_t head;
+	uint64_t value;
+	size_t strLen;
+	double dValue;
+
+	if( pMessage == NULL ) {
+		return;
+	}
+	pRing = GetThreadRing();
+	if( pRing == NULL ) {
+		return;
+	}
+	head = pRing->Head.load(std::memory_order_relaxed);
+	if( (head - pRing->Tail.load(std::memory_order_acquire)) >= ERRLOG_RING_RECORDS ) {
+		// Never block the caller: the record is lost
+		pRing->DroppedNb.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	pRecord = &pRing->Records[head & ERRLOG_RING_MASK];
+	pRecord->TimeUs = ErrLogGetTimeUs() - m_originUs;
+	pRecord->pFormat = pMessage;
+	pRecord->ThreadNb = pRing->ThreadNb;
+	pRecord->ArgNb = 0;
+	pRecord->StrSize = 0;
+
+	p = pMessage;
+	while( (*p != 0) && (pRecord->ArgNb < ERRLOG_MAX_ARGS) ) {
+		if( *p != '%' ) {
+			p++;
+			continue;
+		}
+		p = ErrLogParseSpec(p, &spec);
+		if( spec.Conv == 0 ) {
+			continue;
+		}
+		for( int i = 0; (i < spec.StarNb) && (pRecord->ArgNb < ERRLOG_MAX_ARGS); i++ ) {
+			pRecord->Args[pRecord->ArgNb++] = (uint64_t)(int64_t)va_arg(Args, int);
+		}
+		if( pRecord->ArgNb >= ERRLOG_MAX_ARGS ) {
+			break;
+		}
+		switch( spec.Conv ) {
+			case 'd':
+			case 'i':
+				if( spec.Length == 'q' ) {
+					value = (uint64_t)va_arg(Args, long long);
+				} else if( spec.Length == 'l' ) {
+					value = (uint64_t)(int64_t)va_arg(Args, long);
+				} else if( spec.Length == 'z' ) {
+					value = (uint64_t)va_arg(Args, size_t);
+				} else if( spec.Length == 'j' ) {
+					value = (uint64_t)va_arg(Args, intmax_t);
+				} else if( spec.Length == 't' ) {
+					value = (uint64_t)(int64_t)va_arg(Args, ptrdiff_t);
+				} else {
+					value = (uint64_t)(int64_t)va_arg(Args, int);
+				}
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				if( spec.Length == 'q' ) {
+					value = (uint64_t)va_arg(Args, unsigned long long);
+				} else if( spec.Length == 'l' ) {
+					value = (uint64_t)va_arg(Args, unsigned long);
+				} else if( spec.Length == 'z' ) {
+					value = (uint64_t)va_arg(Args, size_t);
+				} else if( spec.Length == 'j' ) {
+					value = (uint64_t)va_arg(Args, uintmax_t);
+				} else if( spec.Length == 't' ) {
+					value = (uint64_t)va_arg(Args, ptrdiff_t);
+				} else {
+					value = (uint64_t)va_arg(Args, unsigned int);
+				}
+				break;
+			case 'c':
+				value = (uint64_t)va_arg(Args, int);
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				if( spec.Length == 'L' ) {
+					dValue = (double)va_arg(Args, long double);
+				} else {
+					dValue = va_arg(Args, double);
+				}
+				memcpy(&value, &dValue, sizeof(value));
+				break;
+			case 's':
+				pStr = va_arg(Args, const char*);
+				value = ERRLOG_STR_NONE;
+				if( (pStr != NULL) && (pRecord->StrSize < ERRLOG_STR_SIZE) ) {
+					strLen = strlen(pStr);
+					if( strLen > (size_t)(ERRLOG_STR_SIZE - 1 - pRecord->StrSize) ) {
+						strLen = ERRLOG_STR_SIZE - 1 - pRecord->StrSize;
+					}
+					memcpy(&pRecord->Str[pRecord->StrSize], pStr, strLen);
+					pRecord->Str[pRecord->StrSize + strLen] = 0;
+					value = pRecord->StrSize;
+					pRecord->StrSize += (uint8_t)(strLen + 1);
+				}
+				break;
+			default: // 'p', 'n' and unknown conversions: pointer sized argument
+				value = (uint64_t)(uintptr_t)va_arg(Args, void*);
+				break;
+		}
+		pRecord->Args[pRecord->ArgNb++] = value;
+	}
+	pRing->Head.store(head + 1, std::memory_order_release);
+	if( (head + 1 - pRing->Tail.load(std::memory_order_relaxed)) == (ERRLOG_RING_RECORDS / 2) ) {
+		// Burst: do not wait for the dumper period
+		m_dumperCv.notify_one();
+	}
+}
+
+uint64_t cErrLog::GetDroppedNb(void) const
+{
+	uint64_t droppedNb = 0;
+
+	std::lock_guard<std::mutex> lock(m_ringsMutex);
+	droppedNb = m_releasedDroppedNb;
+	for( size_t i = 0; i < m_rings.size(); i++ ) {
+		droppedNb += m_rings[i]->DroppedNb.load(std::memory_order_relaxed);
+	}
+	return droppedNb;
+}
+
+uint32_t cErrLog::GetRingNb(void) const
+{
+	std::lock_guard<std::mutex> lock(m_ringsMutex);
+	return (uint32_t)m_rings.size();
+}
+
+/*
+ * Ring of the calling thread, created at its first trace (only locked path)
+ */
+cErrLog::ErrLogRingT* cErrLog::GetThreadRing(void)
+{
+	ErrLogRingT *pRing = NULL;
+	ErrLogThreadRingT threadRing;
+
+	if( t_errLogRings.LastInstanceId == m_instanceId ) {
+		return (ErrLogRingT*)t_errLogRings.pLastRing;
+	}
+	for( size_t i = 0; i < t_errLogRings.Rings.size(); i++ ) {
+		if( t_errLogRings.Rings[i].InstanceId == m_instanceId ) {
+			pRing = (ErrLogRingT*)t_errLogRings.Rings[i].pRing;
+			break;
+		}
+	}
+	if( pRing == NULL ) {
+		std::lock_guard<std::mutex> lock(m_ringsMutex);
+		pRing = new ErrLogRingT;
+		pRing->Head.store(0, std::memory_order_relaxed);
+		pRing->Tail.store(0, std::memory_order_relaxed);
+		pRing->DroppedNb.store(0, std::memory_order_relaxed);
+		pRing->ReportedDroppedNb = 0;
+		pRing->ThreadNb = m_threadNb++;
+		pRing->bThreadExited.store(false, std::memory_order_relaxed);
+		m_rings.push_back(pRing);
+		threadRing.pLog = this;
+		threadRing.InstanceId = m_instanceId;
+		threadRing.pRing = pRing;
+		t_errLogRings.Rings.push_back(threadRing);
+	}
+	t_errLogRings.LastInstanceId = m_instanceId;
+	t_errLogRings.pLastRing = pRing;
+	return pRing;
+}
+
+/*
+ * Exit of a thread which traced in pLog: its ring is freed by the next drain, once its
+ * last records are written (nothing to do if pLog was destroyed before)
+ */
+void cErrLog::ReleaseThreadRing(cErrLog *pLog, uint64_t InstanceId, void *pRing)
+{
+	std::lock_guard<std::mutex> lock(ErrLogLiveMutex());
+	std::vector<cErrLog*> &instances = ErrLogLiveInstances();
+
+	for( size_t i = 0; i < instances.size(); i++ ) {
+		if( (instances[i] == pLog) && (pLog->m_instanceId == InstanceId) ) {
+			((ErrLogRingT*)pRing)->bThreadExited.store(true, std::memory_order_release);
+			return;
+		}
+	}
+}
+
+/*
+ * Format and write the pending records of all the rings (single consumer at a time)
+ */
+void cErrLog::DrainRings(void)
+{
+	char line[ERRLOG_LINE_SIZE];
+	ErrLogRingT *pRing;
+	FILE *pFile;
+	uint32_t tail, head;
+	uint64_t droppedNb;
+	bool bThreadExited;
+
+	std::lock_guard<std::mutex> lock(m_ringsMutex);
+	pFile = (m_pFile != NULL) ? m_pFile : stderr;
+	for( size_t i = 0; i < m_rings.size(); ) {
+		pRing = m_rings[i];
+		// Read before Head: no record is added after the flag
+		bThreadExited = pRing->bThreadExited.load(std::memory_order_acquire);
+		tail = pRing->Tail.load(std::memory_order_relaxed);
+		head = pRing->Head.load(std::memory_order_acquire);
+		while( tail != head ) {
+			FormatRecord(&pRing->Records[tail & ERRLOG_RING_MASK], line, sizeof(line));
+			fputs(line, pFile);
+			tail++;
+			pRing->Tail.store(tail, std::memory_order_release);
+		}
+		droppedNb = pRing->DroppedNb.load(std::memory_order_relaxed);
+		if( droppedNb != pRing->ReportedDroppedNb ) {
+			fprintf(pFile, "T%02u %llu trace records lost (ring full)\n", (unsigned)pRing->ThreadNb,
+			        (unsigned long long)(droppedNb - pRing->ReportedDroppedNb));
+			pRing->ReportedDroppedNb = droppedNb;
+		}
+		if( bThreadExited == true ) {
+			m_releasedDroppedNb += droppedNb;
+			delete pRing;
+			m_rings.erase(m_rings.begin() + i);
+		} else {
+			i++;
+		}
+	}
+	fflush(pFile);
+}
+
+/*
+ * Rebuild the traced message: each conversion specification is formatted alone with
+ * its stored argument ('*' replaced by the stored width/precision)
+ */
+void cErrLog::FormatRecord(const ErrLogRecordT *pRecord, char *pLine, size_t LineSize) const
+{
+	char spec[ERRLOG_SPEC_SIZE];
+	ErrLogSpecT parsed;
+	const char *p, *pNext;
+	size_t len, specLen;
+	uint8_t argIdx = 0;
+	uint64_t value;
+	double dValue;
+	int n;
+
+	n = snprintf(pLine, LineSize, "[%6llu.%06llu] T%02u ", (unsigned long long)(pRecord->TimeUs / 1000000),
+	             (unsigned long long)(pRecord->TimeUs % 1000000), (unsigned)pRecord->ThreadNb);
+	len = (n > 0) ? (size_t)n : 0;
+	p = pRecord->pFormat;
+	while( (*p != 0) && (len < (LineSize - 2)) ) {
+		if( *p != '%' ) {
+			pLine[len++] = *p++;
+			continue;
+		}
+		pNext = ErrLogParseSpec(p, &parsed);
+		if( parsed.Conv == 0 ) {
+			if( *parsed.pEnd == '%' ) {
+				pLine[len++] = '%';
+			}
+			p = pNext;
+			continue;
+		}
+		if( (argIdx + parsed.StarNb) >= pRecord->ArgNb ) {
+			// Argument beyond ERRLOG_MAX_ARGS
+			n = snprintf(&pLine[len], LineSize - len, "<?>");
+			len += (n > 0) ? (size_t)n : 0;
+			p = pNext;
+			continue;
+		}
+		// Copy the specification, '*' replaced by the stored value
+		specLen = 0;
+		for( const char *q = p; (q < pNext) && (specLen < (sizeof(spec) - 12)); q++ ) {
+			if( *q == '*' ) {
+				n = snprintf(&spec[specLen], sizeof(spec) - specLen, "%d", (int)(int64_t)pRecord->Args[argIdx++]);
+				specLen += (n > 0) ? (size_t)n : 0;
+			} else {
+				spec[specLen++] = *q;
+			}
+		}
+		spec[specLen] = 0;
+		value = pRecord->Args[argIdx++];
+		switch( parsed.Conv ) {
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				if( parsed.Length == 'q' ) {
+					n = snprintf(&pLine[len], LineSize - len, spec, (long long)value);
+				} else if( parsed.Length == 'l' ) {
+					n = snprintf(&pLine[len], LineSize - len, spec, (long)value);
+				} else if( (parsed.Length == 'z') || (parsed.Length == 't') ) {
+					n = snprintf(&pLine[len], LineSize - len, spec, (size_t)value);
+				} else if( parsed.Length == 'j' ) {
+					n = snprintf(&pLine[len], LineSize - len, spec, (intmax_t)value);
+				} else {
+					n = snprintf(&pLine[len], LineSize - len, spec, (int)value);
+				}
+				break;
+			case 'c':
+				n = snprintf(&pLine[len], LineSize - len, spec, (int)value);
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				memcpy(&dValue, &value, sizeof(dValue));
+				if( parsed.Length == 'L' ) {
+					n = snprintf(&pLine[len], LineSize - len, spec, (long double)dValue);
+				} else {
+					n = snprintf(&pLine[len], LineSize - len, spec, dValue);
+				}
+				break;
+			case 's':
+				n = snprintf(&pLine[len], LineSize - len, spec,
+				             (value == ERRLOG_STR_NONE) ? "(null)" : &pRecord->Str[value]);
+				break;
+			case 'p':
+				n = snprintf(&pLine[len], LineSize - len, spec, (void*)(uintptr_t)value);
+				break;
+			default: // 'n' (never written back) and unknown conversions
+				n = 0;
+				break;
+		}
+		if( n > 0 ) {
+			len += ((size_t)n < (LineSize - len)) ? (size_t)n : (LineSize - len - 1);
+		}
+		p = pNext;
+	}
+	if( len > (LineSize - 2) ) {
+		len = LineSize - 2;
+	}
+	pLine[len++] = '\n';
+	pLine[len] = 0;
+}
+
+/*
+ * Dumper thread started by Init(): formats the records every ERRLOG_DUMP_PERIOD_MS
+ */
+void cErrLog::DumperThread(void)
+{
+	std::unique_lock<std::mutex> lock(m_dumperMutex);
+
+	while( m_bStop == false ) {
+		m_dumperCv.wait_for(lock, std::chrono::milliseconds(ERRLOG_DUMP_PERIOD_MS));
+		lock.unlock();
+		DrainRings();
+		lock.lock();
+	}
 }
 
-/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
\ No newline at end of file
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
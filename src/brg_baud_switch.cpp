@@ -0,0 +1,280 @@
+/**
+  ******************************************************************************
+  * @file    brg_baud_switch.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Coordinated CAN bitrate switch (negotiate, reinit, probe, revert)
+  *          for high speed flashing sessions.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_baud_switch.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+// Classic CAN data frame without data and without stuff bits: SOF, arbitration, control,
+// CRC, CRC delimiter, ACK slot and delimiter, EOF and interframe space
+#define BRG_CAN_STD_FRAME_BITS 47
+#define BRG_CAN_EXT_FRAME_BITS 67
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgCanBaudSwitch constructor
+ * @param[in]  Bridge           Opened Brg, CAN initialized with pNominalInit and reception started.
+ * @param[in]  pNominalInit     CAN configuration currently applied (nominal rate), restored by Revert().
+ * @param[in]  NominalBaudrate  Bitrate given by pNominalInit (for the time saved estimation).
+ */
+BrgCanBaudSwitch::BrgCanBaudSwitch(Brg &Bridge, const Brg_CanInitT *pNominalInit, uint32_t NominalBaudrate):
+	m_brg(Bridge), m_correlator(1), m_bFast(false), m_fastStartUs(0), m_bExchangeDone(false),
+	m_exchangeResult(BRG_CORR_CANCELLED)
+{
+	memset(&m_nominalInit, 0, sizeof(m_nominalInit));
+	if( pNominalInit != NULL ) {
+		m_nominalInit = *pNominalInit;
+	}
+	m_fastInit = m_nominalInit;
+	memset(&m_exchangeFrame, 0, sizeof(m_exchangeFrame));
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.NominalBaudrate = NominalBaudrate;
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgCanBaudSwitch destructor: reverts to the nominal rate if still switched.
+ */
+BrgCanBaudSwitch::~BrgCanBaudSwitch(void)
+{
+	if( m_bFast == true ) {
+		Revert(NULL);
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Switch the bus to FastBaudrate: pNegotiate exchange at the nominal rate, bridge
+ *        reinitialized at the exact FastBaudrate (Brg::FindCANbitTiming()) then pProbe
+ *        exchange at the fast rate. The nominal rate is restored if the probe fails.
+ * @param[in]  FastBaudrate       Bitrate of the flashing session (max 1000000).
+ * @param[in]  SamplePointPermil  Sample point of the fast rate in 1/1000 (e.g. 875).
+ * @param[in]  pNegotiate  Switch request to the target and its acknowledge (NULL: no negotiation).
+ * @param[in]  pProbe      Exchange verifying the fast rate (NULL: no verification).
+ * @note Brg::GetTransactionLock() is held from the negotiation to the end of the probe (or
+ *       the revert): no other thread can send a frame at a rate the target is not using.
+ * @retval #BRG_CMD_NOT_ALLOWED If already switched
+ * @retval #BRG_COM_FREQ_NOT_SUPPORTED If FastBaudrate cannot be obtained exactly
+ * @retval #BRG_TARGET_CMD_TIMEOUT If the negotiation or probe response is not received
+ * @retval #BRG_NO_ERR If the bus runs at FastBaudrate
+ * @return Brg::FindCANbitTiming(), Brg::InitCAN() and Exchange() errors
+ */
+Brg_StatusT BrgCanBaudSwitch::SwitchUp(uint32_t FastBaudrate, uint16_t SamplePointPermil,
+                                       const Brg_CanExchangeT *pNegotiate, const Brg_CanExchangeT *pProbe)
+{
+	Brg_StatusT brgStat;
+	Brg_CanBitTimingT bitTiming;
+	uint8_t candidateNb = 0;
+
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	if( m_bFast == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	brgStat = m_brg.FindCANbitTiming(FastBaudrate, SamplePointPermil, &bitTiming, 1, &candidateNb);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	m_fastInit = m_nominalInit;
+	m_fastInit.BitTimeConf = bitTiming.BitTimeConf;
+	m_fastInit.Prescaler = bitTiming.Prescaler;
+
+	// Target agreement at the nominal rate
+	if( pNegotiate != NULL ) {
+		brgStat = Exchange(pNegotiate, NULL);
+		if( brgStat != BRG_NO_ERR ) {
+			m_stats.FailedSwitchNb++;
+			return brgStat;
+		}
+	}
+	brgStat = m_brg.InitCAN(&m_fastInit, BRG_REINIT);
+	if( (brgStat == BRG_NO_ERR) && (pProbe != NULL) ) {
+		brgStat = Exchange(pProbe, NULL);
+	}
+	if( brgStat != BRG_NO_ERR ) {
+		// Back to the nominal rate (the target is expected to fall back on its own)
+		m_brg.InitCAN(&m_nominalInit, BRG_REINIT);
+		m_stats.FailedSwitchNb++;
+		return brgStat;
+	}
+	m_bFast = true;
+	m_fastStartUs = BrgGetMonotonicUs();
+	m_stats.FastBaudrate = FastBaudrate;
+	m_stats.SwitchNb++;
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief End of the fast session: optional pNotify exchange at the fast rate, then the
+ *        bridge is reinitialized at the nominal rate (also if pNotify fails), both under
+ *        Brg::GetTransactionLock().
+ * @param[in]  pNotify  Switch back request to the target (NULL: none).
+ * @retval #BRG_NO_ERR If no error (also if not switched)
+ * @return Exchange() (pNotify) or Brg::InitCAN() errors
+ */
+Brg_StatusT BrgCanBaudSwitch::Revert(const Brg_CanExchangeT *pNotify)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	Brg_StatusT initStat;
+
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	if( m_bFast == false ) {
+		return BRG_NO_ERR;
+	}
+	if( pNotify != NULL ) {
+		brgStat = Exchange(pNotify, NULL);
+	}
+	initStat = m_brg.InitCAN(&m_nominalInit, BRG_REINIT);
+	if( brgStat == BRG_NO_ERR ) {
+		brgStat = initStat;
+	}
+	m_stats.FastTimeUs += BrgGetMonotonicUs() - m_fastStartUs;
+	m_bFast = false;
+	return brgStat;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Brg::WriteMsgCAN() counting the bus time of the frames sent at the fast rate
+ *        (write and status under Brg::GetTransactionLock()).
+ * @retval Brg::WriteMsgCAN() status
+ */
+Brg_StatusT BrgCanBaudSwitch::WriteMsgCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes)
+{
+	Brg_StatusT brgStat;
+
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	brgStat = m_brg.WriteMsgCAN(pCanMsg, pBuffer, SizeInBytes);
+	if( (brgStat == BRG_NO_ERR) && (m_bFast == true) ) {
+		m_stats.FastFrameNb++;
+		m_stats.FastBitNb += GetFrameBitNb(pCanMsg, SizeInBytes);
+	}
+	return brgStat;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Send pExchange->Msg and wait for pExchange->Response (polling the bridge Rx),
+ *        holding Brg::GetTransactionLock() until the response or the timeout.
+ * @param[in]  pExchange  Frame to send and expected response.
+ * @param[out] pResponse  Received response (may be NULL).
+ * @retval #BRG_PARAM_ERR If pExchange is NULL or wrong
+ * @retval #BRG_TARGET_CMD_TIMEOUT If the response is not received within pExchange->TimeoutMs
+ * @retval #BRG_NO_ERR If the response is received
+ * @return WriteMsgCAN() and BrgCorrelator::PollCAN() errors
+ */
+Brg_StatusT BrgCanBaudSwitch::Exchange(const Brg_CanExchangeT *pExchange, Brg_RxFrameT *pResponse)
+{
+	Brg_StatusT brgStat;
+	uint32_t handle;
+
+	if( (pExchange == NULL) || (pExchange->Size > 8) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	m_bExchangeDone = false;
+	// Registered before sending so that a fast response is not missed
+	brgStat = m_correlator.Register(&pExchange->Response, pExchange->TimeoutMs, ExchangeDone, this, &handle);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	brgStat = WriteMsgCAN(&pExchange->Msg, pExchange->Data, pExchange->Size);
+	while( (brgStat == BRG_NO_ERR) && (m_bExchangeDone == false) ) {
+		brgStat = m_correlator.PollCAN(m_brg, NULL);
+		if( brgStat == BRG_OVERRUN_ERR ) {
+			brgStat = BRG_NO_ERR; // frames lost, the response may still come
+		}
+		if( (brgStat == BRG_NO_ERR) && (m_bExchangeDone == false) ) {
+			std::this_thread::sleep_for(std::chrono::microseconds(BRG_BAUD_SWITCH_POLL_SLEEP_US));
+		}
+	}
+	if( m_bExchangeDone == false ) {
+		m_correlator.Cancel(handle);
+		return brgStat;
+	}
+	if( m_exchangeResult != BRG_CORR_RESOLVED ) {
+		return BRG_TARGET_CMD_TIMEOUT;
+	}
+	if( pResponse != NULL ) {
+		*pResponse = m_exchangeFrame;
+	}
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get the switch statistics, SavedUs is computed from the frames sent at the fast rate.
+ * @param[out] pStats  Statistics.
+ */
+void BrgCanBaudSwitch::GetStats(Brg_BaudSwitchStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	*pStats = m_stats;
+	if( m_bFast == true ) {
+		pStats->FastTimeUs += BrgGetMonotonicUs() - m_fastStartUs;
+	}
+	pStats->SavedUs = 0;
+	if( (m_stats.NominalBaudrate != 0) && (m_stats.FastBaudrate > m_stats.NominalBaudrate) ) {
+		pStats->SavedUs = (m_stats.FastBitNb * 1000000 / m_stats.NominalBaudrate) -
+		                  (m_stats.FastBitNb * 1000000 / m_stats.FastBaudrate);
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Size of a classic CAN frame on the bus, stuff bits not included.
+ * @param[in]  pCanMsg      Frame header (IDE and RTR used).
+ * @param[in]  SizeInBytes  Data size (ignored for remote frames).
+ * @retval Number of bits, interframe space included.
+ */
+uint32_t BrgCanBaudSwitch::GetFrameBitNb(const Brg_CanTxMsgT *pCanMsg, uint8_t SizeInBytes)
+{
+	uint32_t bitNb;
+
+	bitNb = (pCanMsg->IDE == CAN_ID_EXTENDED) ? BRG_CAN_EXT_FRAME_BITS : BRG_CAN_STD_FRAME_BITS;
+	if( pCanMsg->RTR == CAN_DATA_FRAME ) {
+		bitNb += 8 * (uint32_t)SizeInBytes;
+	}
+	return bitNb;
+}
+
+// BrgCorrelator completion of the current Exchange()
+void BrgCanBaudSwitch::ExchangeDone(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+                                    const Brg_RxFrameT *pFrame)
+{
+	BrgCanBaudSwitch *pThis = (BrgCanBaudSwitch*)pContext;
+
+	(void)Handle;
+	pThis->m_exchangeResult = Result;
+	if( pFrame != NULL ) {
+		pThis->m_exchangeFrame = *pFrame;
+	}
+	pThis->m_bExchangeDone = true;
+}
+
+/**********************************END OF FILE*********************************/
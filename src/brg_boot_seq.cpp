@@ -0,0 +1,285 @@
+/**
+  ******************************************************************************
+  * @file    brg_boot_seq.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Target reset and bootloader entry sequencing with the bridge GPIOs
+  *          and the CAN bootloader start frame.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_boot_seq.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+// CAN reception poll period while waiting for the bootloader response
+#define BRG_BOOTSEQ_POLL_SLEEP_US 200
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup GPIO
+ * @brief BrgBootSequencer constructor
+ * @param[in]  Bridge      Opened Brg.
+ * @param[in]  OutputType  Output type of the sequenced GPIOs (#GPIO_OUTPUT_OPENDRAIN for a
+ *                         reset line with its own pull-up).
+ */
+BrgBootSequencer::BrgBootSequencer(Brg &Bridge, Brg_GpioOutputT OutputType):
+	m_brg(Bridge), m_outputType(OutputType), m_correlator(1), m_bResponseDone(false),
+	m_responseResult(BRG_CORR_CANCELLED), m_responseUs(0)
+{
+}
+
+/**
+ * @ingroup GPIO
+ * @brief Build the usual reset-into-bootloader sequence (reset active low):
+ *        boot strap set and reset asserted, reset released after ResetPulseUs,
+ *        start frame FrameDelayUs later and boot strap released BootHoldUs after the
+ *        reset release (strap sampled by the target at reset release).
+ * @param[out] pSteps        Table of at least 4 steps.
+ * @param[in]  ResetMask     Bridge GPIO wired to the target reset (one #Brg_GpioMaskT value).
+ * @param[in]  BootMask      Bridge GPIO wired to the target boot strap, 0 if none.
+ * @param[in]  BootLevel     Boot strap level selecting the bootloader.
+ * @param[in]  ResetPulseUs  Reset assertion time.
+ * @param[in]  FrameDelayUs  Start frame time from the reset release (target boot time).
+ * @param[in]  BootHoldUs    Boot strap hold time from the reset release.
+ * @retval Number of steps written in pSteps, 0 if ResetMask is invalid.
+ */
+uint8_t BrgBootSequencer::MakeResetIntoBoot(Brg_BootSeqStepT *pSteps, uint8_t ResetMask, uint8_t BootMask,
+                                            Brg_GpioValT BootLevel, uint32_t ResetPulseUs,
+                                            uint32_t FrameDelayUs, uint32_t BootHoldUs)
+{
+	Brg_BootSeqStepT step;
+	uint8_t stepNb, i;
+
+	if( (pSteps == NULL) || ((ResetMask & BRG_GPIO_ALL) == 0) || ((ResetMask & BootMask) != 0) ) {
+		return 0;
+	}
+	memset(pSteps, 0, 4*sizeof(Brg_BootSeqStepT));
+	// Strap and reset in the same command: the strap is stable before the release
+	pSteps[0].Action = BRG_BOOTSEQ_GPIO;
+	pSteps[0].GpioMask = ResetMask | BootMask;
+	pSteps[0].GpioSetMask = (BootLevel == GPIO_SET) ? BootMask : 0;
+	pSteps[0].AtUs = 0;
+	pSteps[1].Action = BRG_BOOTSEQ_GPIO;
+	pSteps[1].GpioMask = ResetMask | BootMask;
+	pSteps[1].GpioSetMask = pSteps[0].GpioSetMask | ResetMask;
+	pSteps[1].AtUs = ResetPulseUs;
+	pSteps[2].Action = BRG_BOOTSEQ_CAN_START;
+	pSteps[2].AtUs = ResetPulseUs + FrameDelayUs;
+	stepNb = 3;
+	if( BootMask != 0 ) {
+		pSteps[3].Action = BRG_BOOTSEQ_GPIO;
+		pSteps[3].GpioMask = BootMask;
+		pSteps[3].GpioSetMask = (BootLevel == GPIO_SET) ? 0 : BootMask;
+		pSteps[3].AtUs = ResetPulseUs + BootHoldUs;
+		stepNb = 4;
+		// Strap released before the frame: keep the time order
+		for( i=3; (i > 1) && (pSteps[i].AtUs < pSteps[i-1].AtUs); i-- ) {
+			step = pSteps[i-1];
+			pSteps[i-1] = pSteps[i];
+			pSteps[i] = step;
+		}
+	}
+	return stepNb;
+}
+
+/**
+ * @ingroup GPIO
+ * @brief Execute a reset/boot sequence and optionally wait for the bootloader response.
+ * @param[in]  pSteps       Steps in time order (AtUs not decreasing).
+ * @param[in]  StepNb       Number of steps, 1 to #BRG_BOOTSEQ_MAX_STEPS.
+ * @param[in]  pStartFrame  Start frame sent by the #BRG_BOOTSEQ_CAN_START steps and expected
+ *                          response (TimeoutMs 0: no response awaited), may be NULL without
+ *                          such a step.
+ * @param[out] pResult      Achieved timing, may be NULL (filled on every return, zero
+ *                          if the parameters are invalid).
+ *
+ * @retval #BRG_PARAM_ERR If invalid step table or start frame
+ * @retval #BRG_GPIO_ERR If a GPIO could not be driven
+ * @retval #BRG_TARGET_CMD_TIMEOUT If the bootloader response did not come in time
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgBootSequencer::Run(const Brg_BootSeqStepT *pSteps, uint8_t StepNb,
+                                  const Brg_CanExchangeT *pStartFrame, Brg_BootSeqResultT *pResult)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	Brg_GpioConfT gpioConf;
+	Brg_GpioInitT gpioInit;
+	Brg_BootSeqResultT result;
+	uint64_t startUs, stepUs, nowUs;
+	uint32_t handle = BRG_CORR_INVALID_HANDLE;
+	uint8_t gpioMask = 0;
+	bool bWait = false;
+	uint8_t i;
+
+	if( pResult != NULL ) {
+		memset(pResult, 0, sizeof(Brg_BootSeqResultT));
+	}
+	if( (pSteps == NULL) || (StepNb == 0) || (StepNb > BRG_BOOTSEQ_MAX_STEPS) ) {
+		return BRG_PARAM_ERR;
+	}
+	for( i=0; i<StepNb; i++ ) {
+		if( (i > 0) && (pSteps[i].AtUs < pSteps[i-1].AtUs) ) {
+			return BRG_PARAM_ERR;
+		}
+		if( pSteps[i].Action == BRG_BOOTSEQ_CAN_START ) {
+			if( (pStartFrame == NULL) || (pStartFrame->Size > 8) ) {
+				return BRG_PARAM_ERR;
+			}
+			bWait = (pStartFrame->TimeoutMs != 0);
+		} else if( (pSteps[i].GpioMask & BRG_GPIO_ALL) == 0 ) {
+			return BRG_PARAM_ERR;
+		}
+		gpioMask |= pSteps[i].GpioMask & BRG_GPIO_ALL;
+	}
+	memset(&result, 0, sizeof(result));
+
+	if( gpioMask != 0 ) {
+		gpioConf.Mode = GPIO_MODE_OUTPUT;
+		gpioConf.Speed = GPIO_SPEED_HIGH;
+		gpioConf.Pull = GPIO_NO_PULL;
+		gpioConf.OutputType = m_outputType;
+		gpioInit.GpioMask = gpioMask;
+		gpioInit.ConfigNb = 1;
+		gpioInit.pGpioConf = &gpioConf;
+		brgStat = m_brg.InitGPIO(&gpioInit);
+	}
+
+	startUs = BrgGetMonotonicUs();
+	m_bResponseDone = false;
+	for( i=0; (i<StepNb) && (brgStat == BRG_NO_ERR); i++ ) {
+		brgStat = WaitUntil(startUs + pSteps[i].AtUs, handle != BRG_CORR_INVALID_HANDLE);
+		if( brgStat != BRG_NO_ERR ) {
+			break;
+		}
+		stepUs = BrgGetMonotonicUs();
+		result.StepLateUs[i] = (uint32_t)(stepUs - (startUs + pSteps[i].AtUs));
+		if( pSteps[i].Action == BRG_BOOTSEQ_CAN_START ) {
+			// Registered before sending so that a fast response is not missed
+			if( (bWait == true) && (handle == BRG_CORR_INVALID_HANDLE) ) {
+				brgStat = m_correlator.Register(&pStartFrame->Response, pStartFrame->TimeoutMs,
+				                                ResponseDone, this, &handle);
+			}
+			if( brgStat == BRG_NO_ERR ) {
+				brgStat = m_brg.WriteMsgCAN(&pStartFrame->Msg, pStartFrame->Data, pStartFrame->Size);
+			}
+			result.FrameSentUs = (uint32_t)(BrgGetMonotonicUs() - startUs);
+		} else {
+			brgStat = SetGpio(pSteps[i].GpioMask, pSteps[i].GpioSetMask);
+		}
+		nowUs = BrgGetMonotonicUs();
+		result.StepCmdUs[i] = (uint32_t)(nowUs - stepUs);
+		if( result.StepLateUs[i] > result.MaxLateUs ) {
+			result.MaxLateUs = result.StepLateUs[i];
+		}
+		result.StepNb = i+1;
+	}
+
+	while( (brgStat == BRG_NO_ERR) && (handle != BRG_CORR_INVALID_HANDLE) && (m_bResponseDone == false) ) {
+		brgStat = m_correlator.PollCAN(m_brg, NULL);
+		if( brgStat == BRG_OVERRUN_ERR ) {
+			brgStat = BRG_NO_ERR; // frames lost, the response may still come
+		}
+		if( (brgStat == BRG_NO_ERR) && (m_bResponseDone == false) ) {
+			std::this_thread::sleep_for(std::chrono::microseconds(BRG_BOOTSEQ_POLL_SLEEP_US));
+		}
+	}
+	if( handle != BRG_CORR_INVALID_HANDLE ) {
+		if( m_bResponseDone == false ) {
+			m_correlator.Cancel(handle);
+		} else if( m_responseResult != BRG_CORR_RESOLVED ) {
+			brgStat = BRG_TARGET_CMD_TIMEOUT;
+		} else {
+			result.ReadyUs = (uint32_t)(m_responseUs - startUs);
+		}
+	}
+	if( pResult != NULL ) {
+		*pResult = result;
+	}
+	return brgStat;
+}
+
+/*
+ * Wait until the host monotonic time TimeUs: sleep, then read the clock for the last
+ * BRG_BOOTSEQ_SPIN_US (sleep granularity). With a pending response the CAN reception is
+ * polled while there is time for it, so that the response time is not shifted by the
+ * remaining steps.
+ */
+Brg_StatusT BrgBootSequencer::WaitUntil(uint64_t TimeUs, bool bPollCan)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint64_t nowUs;
+
+	nowUs = BrgGetMonotonicUs();
+	while( nowUs + BRG_BOOTSEQ_SPIN_US < TimeUs ) {
+		if( (bPollCan == true) && (m_bResponseDone == false) ) {
+			brgStat = m_correlator.PollCAN(m_brg, NULL);
+			if( brgStat == BRG_OVERRUN_ERR ) {
+				brgStat = BRG_NO_ERR;
+			}
+			if( brgStat != BRG_NO_ERR ) {
+				return brgStat;
+			}
+			nowUs = BrgGetMonotonicUs();
+			if( nowUs + BRG_BOOTSEQ_SPIN_US + BRG_BOOTSEQ_POLL_SLEEP_US >= TimeUs ) {
+				continue;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(BRG_BOOTSEQ_POLL_SLEEP_US));
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(TimeUs - nowUs - BRG_BOOTSEQ_SPIN_US));
+		}
+		nowUs = BrgGetMonotonicUs();
+	}
+	while( nowUs < TimeUs ) {
+		nowUs = BrgGetMonotonicUs();
+	}
+	return brgStat;
+}
+
+/*
+ * Drive the GPIOs of GpioMask: high for the ones of GpioSetMask, low for the others.
+ */
+Brg_StatusT BrgBootSequencer::SetGpio(uint8_t GpioMask, uint8_t GpioSetMask)
+{
+	Brg_GpioValT gpioVal[BRG_GPIO_MAX_NB];
+	uint8_t gpioErrorMask = 0;
+	int i;
+
+	for( i=0; i<BRG_GPIO_MAX_NB; i++ ) {
+		gpioVal[i] = ((GpioSetMask & (1<<i)) != 0) ? GPIO_SET : GPIO_RESET;
+	}
+	return m_brg.SetResetGPIO(GpioMask, gpioVal, &gpioErrorMask);
+}
+
+/*
+ * Correlator callback of the bootloader response.
+ */
+void BrgBootSequencer::ResponseDone(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+                                    const Brg_RxFrameT *pFrame)
+{
+	BrgBootSequencer *pThis = (BrgBootSequencer*)pContext;
+
+	(void)Handle;
+	(void)pFrame;
+	pThis->m_responseResult = Result;
+	pThis->m_responseUs = BrgGetMonotonicUs();
+	pThis->m_bResponseDone = true;
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file    brg_chrome_trace.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Chrome trace-event (JSON) recording of bridge activity: USB commands,
+  *          Brg calls and application phases as spans, kept in memory and written
+  *          when the recording is stopped (chrome://tracing or ui.perfetto.dev).
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "brg_chrome_trace.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+	const char *pName;
+	const char *pCat;
+	uint64_t StartUs;
+	uint64_t DurUs;
+	int64_t Arg;        // -1: none
+} TraceEventT;
+
+// Spans of one thread: its mutex is only contended by BrgChromeTraceStop()
+typedef struct {
+	std::mutex Mutex;
+	std::vector<TraceEventT> Events;
+	uint32_t Tid;
+} TraceThreadBufT;
+
+/* Private defines -----------------------------------------------------------*/
+#define BRG_TRACE_PID 1
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_traceMutex; // session start/stop and thread registration
+// Thread buffers are never freed: a thread may still hold its pointer after a stop
+static std::vector<TraceThreadBufT*> g_traceBufs;
+static thread_local TraceThreadBufT *t_pTraceBuf = NULL;
+static std::string g_traceFileName;
+static uint64_t g_traceOriginUs = 0;
+static uint32_t g_traceMaxEvents = 0;
+static std::atomic<uint32_t> g_traceEventNb(0);
+static std::atomic<uint32_t> g_traceDroppedNb(0);
+
+/* Global variables ----------------------------------------------------------*/
+std::atomic<bool> g_brgChromeTraceOn(false);
+
+/* Private functions ---------------------------------------------------------*/
+static TraceThreadBufT* GetThreadBuf(void)
+{
+	if( t_pTraceBuf == NULL ) {
+		std::lock_guard<std::mutex> lock(g_traceMutex);
+		t_pTraceBuf = new TraceThreadBufT;
+		t_pTraceBuf->Tid = (uint32_t)g_traceBufs.size() + 1;
+		g_traceBufs.push_back(t_pTraceBuf);
+	}
+	return t_pTraceBuf;
+}
+
+// Names are identifiers or literals, escape anyway to always produce valid JSON
+static void WriteJsonString(FILE *pFile, const char *pStr)
+{
+	fputc('"', pFile);
+	for( ; (pStr != NULL) && (*pStr != 0); pStr++ ) {
+		if( (*pStr == '"') || (*pStr == '\\') ) {
+			fputc('\\', pFile);
+			fputc(*pStr, pFile);
+		} else if( (unsigned char)*pStr < 0x20 ) {
+			fprintf(pFile, "\\u%04x", (unsigned)(unsigned char)*pStr);
+		} else {
+			fputc(*pStr, pFile);
+		}
+	}
+	fputc('"', pFile);
+}
+
+/* Functions Definition ------------------------------------------------------*/
+/**
+ * @ingroup GENERAL
+ * @brief Start recording spans in memory (previous unsaved spans are discarded).
+ * @param[in]  pFileName  JSON file written by BrgChromeTraceStop().
+ * @param[in]  MaxEvents  Max number of spans kept (memory bound), next ones are counted as dropped.
+ * @retval #BRG_PARAM_ERR If pFileName is NULL or empty
+ * @retval #BRG_CMD_NOT_ALLOWED If already started
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgChromeTraceStart(const char *pFileName, uint32_t MaxEvents)
+{
+	if( (pFileName == NULL) || (pFileName[0] == 0) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+	if( g_brgChromeTraceOn.load(std::memory_order_relaxed) == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	for( size_t i = 0; i < g_traceBufs.size(); i++ ) {
+		std::lock_guard<std::mutex> bufLock(g_traceBufs[i]->Mutex);
+		g_traceBufs[i]->Events.clear();
+	}
+	g_traceFileName = pFileName;
+	g_traceMaxEvents = MaxEvents;
+	g_traceEventNb.store(0, std::memory_order_relaxed);
+	g_traceDroppedNb.store(0, std::memory_order_relaxed);
+	g_traceOriginUs = BrgGetMonotonicUs();
+	g_brgChromeTraceOn.store(true, std::memory_order_release);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Stop recording and write the spans of all threads as Chrome trace-event JSON
+ *        ("X" complete events, one tid per thread). Typically called at shutdown.
+ * @retval #BRG_CMD_NOT_ALLOWED If not started
+ * @retval #BRG_PARAM_ERR If the file cannot be created
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgChromeTraceStop(void)
+{
+	FILE *pFile;
+	bool bFirst = true;
+	TraceThreadBufT *pBuf;
+	const TraceEventT *pEvent;
+
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+	if( g_brgChromeTraceOn.exchange(false) == false ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	pFile = fopen(g_traceFileName.c_str(), "w");
+	if( pFile == NULL ) {
+		return BRG_PARAM_ERR;
+	}
+	fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedSpans\":%u},\"traceEvents\":[\n",
+	        (unsigned)g_traceDroppedNb.load(std::memory_order_relaxed));
+	for( size_t i = 0; i < g_traceBufs.size(); i++ ) {
+		pBuf = g_traceBufs[i];
+		std::lock_guard<std::mutex> bufLock(pBuf->Mutex);
+		if( pBuf->Events.empty() == true ) {
+			continue;
+		}
+		fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+		        (bFirst == true) ? "" : ",\n", BRG_TRACE_PID, (unsigned)pBuf->Tid, (unsigned)pBuf->Tid);
+		bFirst = false;
+		for( size_t j = 0; j < pBuf->Events.size(); j++ ) {
+			pEvent = &pBuf->Events[j];
+			fprintf(pFile, ",\n{\"name\":");
+			WriteJsonString(pFile, pEvent->pName);
+			fprintf(pFile, ",\"cat\":");
+			WriteJsonString(pFile, pEvent->pCat);
+			fprintf(pFile, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%llu,\"dur\":%llu", BRG_TRACE_PID,
+			        (unsigned)pBuf->Tid, (unsigned long long)pEvent->StartUs, (unsigned long long)pEvent->DurUs);
+			if( pEvent->Arg >= 0 ) {
+				fprintf(pFile, ",\"args\":{\"bytes\":%lld}", (long long)pEvent->Arg);
+			}
+			fputc('}', pFile);
+		}
+		pBuf->Events.clear();
+	}
+	fprintf(pFile, "\n]}\n");
+	fclose(pFile);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Record a span of the calling thread (ignored if not started or MaxEvents reached).
+ * @param[in]  pName    Span name (must outlive BrgChromeTraceStop(), e.g. string literal).
+ * @param[in]  pCat     Category, e.g. #BRG_TRACE_CAT_USB (same lifetime constraint).
+ * @param[in]  StartUs  Start time (BrgGetMonotonicUs() base).
+ * @param[in]  EndUs    End time (BrgGetMonotonicUs() base).
+ * @param[in]  Arg      Byte count shown in the span arguments, -1 for none.
+ */
+void BrgChromeTraceSpan(const char *pName, const char *pCat, uint64_t StartUs, uint64_t EndUs, int64_t Arg)
+{
+	TraceThreadBufT *pBuf;
+	TraceEventT event;
+
+	// Acquire: g_traceOriginUs and g_traceMaxEvents are set before the flag
+	if( g_brgChromeTraceOn.load(std::memory_order_acquire) == false ) {
+		return;
+	}
+	if( g_traceEventNb.fetch_add(1, std::memory_order_relaxed) >= g_traceMaxEvents ) {
+		g_traceDroppedNb.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	event.pName = pName;
+	event.pCat = pCat;
+	event.StartUs = (StartUs > g_traceOriginUs) ? (StartUs - g_traceOriginUs) : 0;
+	event.DurUs = (EndUs > StartUs) ? (EndUs - StartUs) : 0;
+	event.Arg = Arg;
+	pBuf = GetThreadBuf();
+	std::lock_guard<std::mutex> lock(pBuf->Mutex);
+	pBuf->Events.push_back(event);
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,481 @@
+/**
+  ******************************************************************************
+  * @file    brg_correlator.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Request/response correlation engine: match received CAN/FDCAN frames
+  *          to outstanding requests and expire them on deadline.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include "brg_correlator.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+#define BRG_CORR_WHEEL_MASK (BRG_CORR_WHEEL_SLOTS-1)
+#define BRG_CORR_TICK_US    1000
+#define BRG_CORR_NO_ENTRY   (-1)
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgCorrelator constructor
+ * @param[in]  MaxPending  Max number of outstanding requests (max #BRG_CORR_MAX_PENDING).
+ */
+BrgCorrelator::BrgCorrelator(uint32_t MaxPending): m_pendingNb(0), m_lastTick(0)
+{
+	if( MaxPending == 0 ) {
+		MaxPending = 1;
+	} else if( MaxPending > BRG_CORR_MAX_PENDING ) {
+		MaxPending = BRG_CORR_MAX_PENDING;
+	}
+	m_maxPending = MaxPending;
+	m_pEntries = new CorrEntryT[MaxPending];
+	for( uint32_t i = 0; i < MaxPending; i++ ) {
+		memset(&m_pEntries[i], 0, sizeof(CorrEntryT));
+		m_pEntries[i].IdPrev = BRG_CORR_NO_ENTRY;
+		m_pEntries[i].IdNext = BRG_CORR_NO_ENTRY;
+		m_pEntries[i].WheelPrev = BRG_CORR_NO_ENTRY;
+		m_pEntries[i].WheelNext = ((i + 1) < MaxPending) ? (int32_t)(i + 1) : BRG_CORR_NO_ENTRY;
+	}
+	m_freeHead = 0;
+	for( int i = 0; i < BRG_CORR_WHEEL_SLOTS; i++ ) {
+		m_slots[i] = BRG_CORR_NO_ENTRY;
+	}
+	m_idMap.reserve(MaxPending);
+	m_originUs = BrgGetMonotonicUs();
+	ResetStats();
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgCorrelator destructor: outstanding requests are cancelled (callbacks called).
+ */
+BrgCorrelator::~BrgCorrelator(void)
+{
+	CancelAll();
+	delete[] m_pEntries;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Register an outstanding request, typically just before sending it.
+ * @param[in]  pMatch     Expected response.
+ * @param[in]  TimeoutMs  Deadline from now (1ms resolution, expiry reported by ExpireDue()).
+ * @param[in]  Callback   Completion callback (mandatory).
+ * @param[in]  pContext   User pointer given back to Callback.
+ * @param[out] pHandle    Request handle (also given to Callback), for Cancel().
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_MEM_ALLOC_ERR If MaxPending requests already outstanding
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCorrelator::Register(const Brg_CorrMatchT *pMatch, uint32_t TimeoutMs,
+                                    Brg_CorrCallbackT Callback, void *pContext, uint32_t *pHandle)
+{
+	std::unordered_map<uint64_t, IdListT>::iterator it;
+	CorrEntryT *pEntry;
+	IdListT *pList;
+	int32_t idx;
+	uint32_t slot;
+	uint64_t nowUs;
+
+	if( (pMatch == NULL) || (Callback == NULL) || (pHandle == NULL) ||
+	    (pMatch->PrefixSize > BRG_CORR_MAX_PREFIX_SIZE) ) {
+		return BRG_PARAM_ERR;
+	}
+	nowUs = BrgGetMonotonicUs();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if( m_freeHead == BRG_CORR_NO_ENTRY ) {
+		return BRG_MEM_ALLOC_ERR;
+	}
+	idx = m_freeHead;
+	pEntry = &m_pEntries[idx];
+	m_freeHead = pEntry->WheelNext;
+
+	pEntry->Match = *pMatch;
+	pEntry->Callback = Callback;
+	pEntry->pContext = pContext;
+	pEntry->RegisterUs = nowUs;
+	pEntry->bUsed = true;
+
+	// Append to the IDE/ID list (oldest request matched first)
+	it = m_idMap.find(IdKey(pMatch->IDE, pMatch->ID));
+	if( it == m_idMap.end() ) {
+		IdListT emptyList = { BRG_CORR_NO_ENTRY, BRG_CORR_NO_ENTRY };
+		it = m_idMap.emplace(IdKey(pMatch->IDE, pMatch->ID), emptyList).first;
+	}
+	pList = &it->second;
+	pEntry->IdNext = BRG_CORR_NO_ENTRY;
+	if( pList->Head == BRG_CORR_NO_ENTRY ) {
+		pEntry->IdPrev = BRG_CORR_NO_ENTRY;
+		pList->Head = idx;
+	} else {
+		pEntry->IdPrev = pList->Tail;
+		m_pEntries[pList->Tail].IdNext = idx;
+	}
+	pList->Tail = idx;
+
+	// Insert in the deadline wheel
+	pEntry->DueTick = UsToTick(nowUs + (uint64_t)TimeoutMs * 1000);
+	if( pEntry->DueTick <= m_lastTick ) {
+		pEntry->DueTick = m_lastTick + 1;
+	}
+	slot = (uint32_t)(pEntry->DueTick & BRG_CORR_WHEEL_MASK);
+	pEntry->WheelPrev = BRG_CORR_NO_ENTRY;
+	pEntry->WheelNext = m_slots[slot];
+	if( m_slots[slot] != BRG_CORR_NO_ENTRY ) {
+		m_pEntries[m_slots[slot]].WheelPrev = idx;
+	}
+	m_slots[slot] = idx;
+
+	m_pendingNb++;
+	if( m_pendingNb > m_maxPendingNb ) {
+		m_maxPendingNb = m_pendingNb;
+	}
+	m_registeredNb.fetch_add(1, std::memory_order_relaxed);
+	*pHandle = IndexToHandle(idx);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Cancel an outstanding request: its callback is called with #BRG_CORR_CANCELLED.
+ * @param[in]  Handle  Handle returned by Register().
+ * @retval #BRG_PARAM_ERR If unknown handle (already completed)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCorrelator::Cancel(uint32_t Handle)
+{
+	CorrDoneT done;
+	int32_t idx;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		idx = HandleToIndex(Handle);
+		if( idx == BRG_CORR_NO_ENTRY ) {
+			return BRG_PARAM_ERR;
+		}
+		done.Callback = m_pEntries[idx].Callback;
+		done.pContext = m_pEntries[idx].pContext;
+		done.Handle = Handle;
+		UnlinkEntry(idx);
+		FreeEntry(idx);
+	}
+	m_cancelledNb.fetch_add(1, std::memory_order_relaxed);
+	done.Callback(done.pContext, done.Handle, BRG_CORR_CANCELLED, NULL);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Cancel all outstanding requests (e.g. at end of session).
+ */
+void BrgCorrelator::CancelAll(void)
+{
+	std::vector<CorrDoneT> cancelled;
+	CorrDoneT done;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		cancelled.reserve(m_pendingNb);
+		for( uint32_t i = 0; i < m_maxPending; i++ ) {
+			if( m_pEntries[i].bUsed == true ) {
+				done.Callback = m_pEntries[i].Callback;
+				done.pContext = m_pEntries[i].pContext;
+				done.Handle = IndexToHandle((int32_t)i);
+				cancelled.push_back(done);
+				UnlinkEntry((int32_t)i);
+				FreeEntry((int32_t)i);
+			}
+		}
+	}
+	m_cancelledNb.fetch_add(cancelled.size(), std::memory_order_relaxed);
+	for( size_t i = 0; i < cancelled.size(); i++ ) {
+		cancelled[i].Callback(cancelled[i].pContext, cancelled[i].Handle, BRG_CORR_CANCELLED, NULL);
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Offer a received frame to the outstanding requests. The oldest request waiting
+ *        on this IDE/ID whose prefix matches is resolved (its callback called).
+ * @param[in]  pFrame  Received frame.
+ * @retval true if the frame resolved a request, false otherwise.
+ */
+bool BrgCorrelator::DispatchRx(const Brg_RxFrameT *pFrame)
+{
+	std::unordered_map<uint64_t, IdListT>::iterator it;
+	CorrDoneT done;
+	CorrEntryT *pEntry;
+	int32_t idx;
+	uint64_t registerUs = 0;
+
+	if( pFrame == NULL ) {
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		it = m_idMap.find(IdKey(pFrame->IDE, pFrame->ID));
+		idx = (it != m_idMap.end()) ? it->second.Head : BRG_CORR_NO_ENTRY;
+		while( idx != BRG_CORR_NO_ENTRY ) {
+			pEntry = &m_pEntries[idx];
+			if( (pEntry->Match.PrefixSize <= pFrame->SizeInBytes) &&
+			    (memcmp(pEntry->Match.Prefix, pFrame->Data, pEntry->Match.PrefixSize) == 0) ) {
+				break;
+			}
+			idx = pEntry->IdNext;
+		}
+		if( idx == BRG_CORR_NO_ENTRY ) {
+			m_unmatchedRxNb.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		done.Callback = m_pEntries[idx].Callback;
+		done.pContext = m_pEntries[idx].pContext;
+		done.Handle = IndexToHandle(idx);
+		registerUs = m_pEntries[idx].RegisterUs;
+		UnlinkEntry(idx);
+		FreeEntry(idx);
+	}
+	m_resolvedNb.fetch_add(1, std::memory_order_relaxed);
+	m_responseTime.Record((pFrame->RxTimeUs > registerUs) ? (pFrame->RxTimeUs - registerUs) : 0);
+	done.Callback(done.pContext, done.Handle, BRG_CORR_RESOLVED, pFrame);
+	return true;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Expire the requests whose deadline is reached. To be called periodically
+ *        (PollCAN() calls it), cost proportional to the elapsed ticks and expired requests.
+ * @param[in]  NowUs  Current host time (BrgGetMonotonicUs()).
+ * @retval Number of expired requests.
+ */
+uint32_t BrgCorrelator::ExpireDue(uint64_t NowUs)
+{
+	std::vector<CorrDoneT> expired;
+	uint64_t nowTick, tick, lastTick;
+	uint32_t slot;
+	int32_t idx, next;
+	CorrDoneT done;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		nowTick = (NowUs > m_originUs) ? ((NowUs - m_originUs) / BRG_CORR_TICK_US) : 0;
+		if( nowTick <= m_lastTick ) {
+			return 0;
+		}
+		// A full wheel turn covers every slot: no need to scan more after a long pause
+		lastTick = m_lastTick;
+		if( (nowTick - lastTick) > BRG_CORR_WHEEL_SLOTS ) {
+			lastTick = nowTick - BRG_CORR_WHEEL_SLOTS;
+		}
+		for( tick = lastTick + 1; tick <= nowTick; tick++ ) {
+			slot = (uint32_t)(tick & BRG_CORR_WHEEL_MASK);
+			idx = m_slots[slot];
+			while( idx != BRG_CORR_NO_ENTRY ) {
+				next = m_pEntries[idx].WheelNext;
+				if( m_pEntries[idx].DueTick <= nowTick ) {
+					done.Callback = m_pEntries[idx].Callback;
+					done.pContext = m_pEntries[idx].pContext;
+					done.Handle = IndexToHandle(idx);
+					expired.push_back(done);
+					UnlinkEntry(idx);
+					FreeEntry(idx);
+				}
+				idx = next;
+			}
+		}
+		m_lastTick = nowTick;
+	}
+	// Callbacks may register new requests: called with the lock released
+	m_expiredNb.fetch_add(expired.size(), std::memory_order_relaxed);
+	for( size_t i = 0; i < expired.size(); i++ ) {
+		expired[i].Callback(expired[i].pContext, expired[i].Handle, BRG_CORR_EXPIRED, NULL);
+	}
+	return (uint32_t)expired.size();
+}
+
+/**
+ * @ingroup CAN
+ * @brief Read the CAN frames waiting in the bridge (Brg::GetRxMsgNbCAN() and
+ *        Brg::GetRxMsgCAN(), under Brg::GetTransactionLock()), dispatch them, then expire
+ *        the due requests. Received frames matching no request are dropped.
+ * @param[in]  Bridge      Opened Brg with CAN reception started.
+ * @param[out] pMatchedNb  If not NULL, number of frames that resolved a request.
+ * @retval #BRG_OVERRUN_ERR If an overrun was reported (frames still dispatched)
+ * @retval #BRG_NO_ERR If no error, else Brg::GetRxMsgNbCAN() or Brg::GetRxMsgCAN() error
+ */
+Brg_StatusT BrgCorrelator::PollCAN(Brg &Bridge, uint32_t *pMatchedNb)
+{
+	Brg_CanRxMsgT canMsg[BRG_CORR_POLL_MAX_MSG];
+	uint8_t buffer[BRG_CORR_POLL_MAX_MSG * 8];
+	Brg_RxFrameT frame;
+	Brg_StatusT brgStat;
+	uint16_t msgNb = 0, dataSize = 0, offset = 0;
+	uint32_t matchedNb = 0;
+
+	{
+		std::lock_guard<std::recursive_mutex> lock(Bridge.GetTransactionLock());
+		brgStat = Bridge.GetRxMsgNbCAN(&msgNb);
+		if( (brgStat == BRG_NO_ERR) && (msgNb != 0) ) {
+			if( msgNb > BRG_CORR_POLL_MAX_MSG ) {
+				msgNb = BRG_CORR_POLL_MAX_MSG;
+			}
+			brgStat = Bridge.GetRxMsgCAN(canMsg, msgNb, buffer, sizeof(buffer), &dataSize);
+		}
+	}
+	if( ((brgStat == BRG_NO_ERR) || (brgStat == BRG_OVERRUN_ERR)) && (msgNb != 0) ) {
+		for( uint16_t i = 0; i < msgNb; i++ ) {
+			// One frame at a time to keep the stack small
+			BrgFramesFromCAN(&canMsg[i], 1, &buffer[offset], dataSize - offset, &frame);
+			offset += frame.SizeInBytes;
+			if( DispatchRx(&frame) == true ) {
+				matchedNb++;
+			}
+		}
+	}
+	ExpireDue(BrgGetMonotonicUs());
+	if( pMatchedNb != NULL ) {
+		*pMatchedNb = matchedNb;
+	}
+	return brgStat;
+}
+
+/*
+ * Absolute tick holding TimeUs (rounded up so that a request never expires early)
+ */
+uint64_t BrgCorrelator::UsToTick(uint64_t TimeUs) const
+{
+	if( TimeUs <= m_originUs ) {
+		return 0;
+	}
+	return (TimeUs - m_originUs + BRG_CORR_TICK_US - 1) / BRG_CORR_TICK_US;
+}
+
+int32_t BrgCorrelator::HandleToIndex(uint32_t Handle) const
+{
+	uint32_t idx = (Handle & 0xFFFF);
+
+	if( (idx == 0) || (idx > m_maxPending) ) {
+		return BRG_CORR_NO_ENTRY;
+	}
+	idx--;
+	if( (m_pEntries[idx].bUsed == false) || (m_pEntries[idx].Generation != (uint16_t)(Handle >> 16)) ) {
+		return BRG_CORR_NO_ENTRY;
+	}
+	return (int32_t)idx;
+}
+
+// Handle: generation in the 16 MSB, entry index + 1 in the 16 LSB (0 is never valid)
+uint32_t BrgCorrelator::IndexToHandle(int32_t Idx) const
+{
+	return (((uint32_t)m_pEntries[Idx].Generation) << 16) | (uint32_t)(Idx + 1);
+}
+
+/*
+ * Remove an entry from its IDE/ID list and from the deadline wheel. O(1).
+ */
+void BrgCorrelator::UnlinkEntry(int32_t Idx)
+{
+	CorrEntryT *pEntry = &m_pEntries[Idx];
+	std::unordered_map<uint64_t, IdListT>::iterator it;
+
+	it = m_idMap.find(IdKey(pEntry->Match.IDE, pEntry->Match.ID));
+	if( it != m_idMap.end() ) {
+		if( pEntry->IdPrev != BRG_CORR_NO_ENTRY ) {
+			m_pEntries[pEntry->IdPrev].IdNext = pEntry->IdNext;
+		} else {
+			it->second.Head = pEntry->IdNext;
+		}
+		if( pEntry->IdNext != BRG_CORR_NO_ENTRY ) {
+			m_pEntries[pEntry->IdNext].IdPrev = pEntry->IdPrev;
+		} else {
+			it->second.Tail = pEntry->IdPrev;
+		}
+		if( it->second.Head == BRG_CORR_NO_ENTRY ) {
+			m_idMap.erase(it);
+		}
+	}
+	if( pEntry->WheelPrev != BRG_CORR_NO_ENTRY ) {
+		m_pEntries[pEntry->WheelPrev].WheelNext = pEntry->WheelNext;
+	} else {
+		m_slots[pEntry->DueTick & BRG_CORR_WHEEL_MASK] = pEntry->WheelNext;
+	}
+	if( pEntry->WheelNext != BRG_CORR_NO_ENTRY ) {
+		m_pEntries[pEntry->WheelNext].WheelPrev = pEntry->WheelPrev;
+	}
+	pEntry->IdPrev = BRG_CORR_NO_ENTRY;
+	pEntry->IdNext = BRG_CORR_NO_ENTRY;
+	pEntry->WheelPrev = BRG_CORR_NO_ENTRY;
+	pEntry->WheelNext = BRG_CORR_NO_ENTRY;
+}
+
+/*
+ * Return an unlinked entry to the free list, invalidating its handle
+ */
+void BrgCorrelator::FreeEntry(int32_t Idx)
+{
+	CorrEntryT *pEntry = &m_pEntries[Idx];
+
+	pEntry->bUsed = false;
+	pEntry->Generation++;
+	pEntry->WheelNext = m_freeHead;
+	m_freeHead = Idx;
+	m_pendingNb--;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get correlation counters and response time percentiles.
+ * @param[out] pStats  Filled with current statistics.
+ */
+void BrgCorrelator::GetStats(Brg_CorrStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pStats->PendingNb = m_pendingNb;
+		pStats->MaxPendingNb = m_maxPendingNb;
+	}
+	pStats->RegisteredNb = m_registeredNb.load(std::memory_order_relaxed);
+	pStats->ResolvedNb = m_resolvedNb.load(std::memory_order_relaxed);
+	pStats->ExpiredNb = m_expiredNb.load(std::memory_order_relaxed);
+	pStats->CancelledNb = m_cancelledNb.load(std::memory_order_relaxed);
+	pStats->UnmatchedRxNb = m_unmatchedRxNb.load(std::memory_order_relaxed);
+	m_responseTime.GetSummary(&pStats->ResponseTime);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Clear counters and response time histogram (outstanding requests are kept).
+ */
+void BrgCorrelator::ResetStats(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_maxPendingNb = m_pendingNb;
+	}
+	m_registeredNb.store(0);
+	m_resolvedNb.store(0);
+	m_expiredNb.store(0);
+	m_cancelledNb.store(0);
+	m_unmatchedRxNb.store(0);
+	m_responseTime.Reset();
+}
+
+/**********************************END OF FILE*********************************/
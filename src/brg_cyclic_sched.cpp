@@ -0,0 +1,499 @@
+/**
+  ******************************************************************************
+  * @file    brg_cyclic_sched.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Cyclic message scheduler: periodic and one-shot CAN/FDCAN frames
+  *          managed in a hashed timing wheel and released into a BrgTxQueue.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include "brg_cyclic_sched.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+#define BRG_CYC_WHEEL_MASK  (BRG_CYC_WHEEL_SLOTS-1)
+#define BRG_CYC_NO_ENTRY    (-1)
+
+/* Private macros ------------------------------------------------------------*/
+// Handle: generation in the 16 MSB, entry index + 1 in the 16 LSB (0 is never valid)
+#define BRG_CYC_HANDLE(gen, idx)   ((((uint32_t)(gen))<<16) | (uint32_t)((idx)+1))
+
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgCyclicScheduler constructor
+ * @param[in]  TxQueue     Transmit queue receiving the due frames (to be started by the caller).
+ * @param[in]  TickUs      Scheduler resolution in microseconds (min 100).
+ * @param[in]  MaxEntries  Max number of scheduled frames (max #BRG_CYC_MAX_ENTRIES).
+ */
+BrgCyclicScheduler::BrgCyclicScheduler(BrgTxQueue &TxQueue, uint32_t TickUs, uint32_t MaxEntries):
+	m_txQueue(TxQueue), m_originUs(0), m_lastTick(0), m_activeNb(0),
+	m_bRunning(false), m_bStopReq(false)
+{
+	m_tickUs = (TickUs < 100) ? 100 : TickUs;
+	if( MaxEntries == 0 ) {
+		MaxEntries = 1;
+	} else if( MaxEntries > BRG_CYC_MAX_ENTRIES ) {
+		MaxEntries = BRG_CYC_MAX_ENTRIES;
+	}
+	m_maxEntries = MaxEntries;
+	m_pEntries = new CyclicEntryT[MaxEntries];
+	m_pBatch = new Brg_TxFrameT[MaxEntries];
+	for( uint32_t i = 0; i < MaxEntries; i++ ) {
+		memset(&m_pEntries[i], 0, sizeof(CyclicEntryT));
+		m_pEntries[i].Prev = BRG_CYC_NO_ENTRY;
+		m_pEntries[i].Next = ((i + 1) < MaxEntries) ? (int32_t)(i + 1) : BRG_CYC_NO_ENTRY;
+	}
+	m_freeHead = 0;
+	for( int i = 0; i < BRG_CYC_WHEEL_SLOTS; i++ ) {
+		m_slots[i] = BRG_CYC_NO_ENTRY;
+	}
+	m_originUs = BrgGetMonotonicUs();
+	ResetStats();
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgCyclicScheduler destructor: stops the tick thread.
+ */
+BrgCyclicScheduler::~BrgCyclicScheduler(void)
+{
+	Stop();
+	delete[] m_pBatch;
+	delete[] m_pEntries;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Start the tick thread. Entries added before Start() are kept.
+ * @retval #BRG_CMD_NOT_ALLOWED If already started
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::Start(void)
+{
+	if( m_bRunning.load() == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wheelMutex);
+		m_lastTick = UsToTick(BrgGetMonotonicUs());
+		if( m_lastTick != 0 ) {
+			m_lastTick--;
+		}
+		// Entries added (or left) while stopped: move the overdue ones to the next tick
+		for( uint32_t i = 0; i < m_maxEntries; i++ ) {
+			if( (m_pEntries[i].bUsed == true) && (m_pEntries[i].DueTick <= m_lastTick) ) {
+				UnlinkEntry((int32_t)i);
+				LinkEntry((int32_t)i, m_lastTick + 1);
+			}
+		}
+	}
+	m_bStopReq.store(false);
+	m_bRunning.store(true);
+	m_ticker = std::thread(&BrgCyclicScheduler::TickThread, this);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Stop the tick thread. Entries are kept and resume at next Start().
+ * @retval #BRG_NO_ERR If no error (also if not started)
+ */
+Brg_StatusT BrgCyclicScheduler::Stop(void)
+{
+	if( m_bRunning.load() == false ) {
+		return BRG_NO_ERR;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_stopMutex);
+		m_bStopReq.store(true);
+		m_stopCond.notify_one();
+	}
+	if( m_ticker.joinable() ) {
+		m_ticker.join();
+	}
+	m_bRunning.store(false);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Schedule a CAN frame sent every PeriodUs.
+ * @param[in]  pCanMsg       CAN Tx message header (see Brg::WriteMsgCAN()).
+ * @param[in]  pBuffer       Data field (copied, see UpdateData() to change it).
+ * @param[in]  SizeInBytes   Data field size (max 8).
+ * @param[in]  PeriodUs      Period in microseconds, must be at least one tick.
+ * @param[out] pHandle       Handle for UpdateData() and Remove().
+ * @param[in]  FirstDelayUs  Delay before the first transmission (0: next tick).
+ * @param[in]  Priority      BrgTxQueue priority class.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_MEM_ALLOC_ERR If MaxEntries frames already scheduled
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::AddPeriodicCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer,
+                                               uint8_t SizeInBytes, uint32_t PeriodUs, uint32_t *pHandle,
+                                               uint32_t FirstDelayUs, Brg_TxPriorityT Priority)
+{
+	Brg_TxFrameT frame;
+
+	if( (pCanMsg == NULL) || ((pBuffer == NULL) && (SizeInBytes != 0)) || (SizeInBytes > 8) ||
+	    (PeriodUs < m_tickUs) ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(&frame, 0, sizeof(frame));
+	frame.bIsFdcan = false;
+	frame.CanMsg = *pCanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	frame.Priority = Priority;
+	return AddFrame(&frame, PeriodUs, FirstDelayUs, pHandle);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Schedule a single CAN frame transmission after DelayUs.
+ * @param[in]  pCanMsg      CAN Tx message header (see Brg::WriteMsgCAN()).
+ * @param[in]  pBuffer      Data field (copied).
+ * @param[in]  SizeInBytes  Data field size (max 8).
+ * @param[in]  DelayUs      Delay before transmission (0: next tick).
+ * @param[out] pHandle      Handle for Remove() (entry freed once sent).
+ * @param[in]  Priority     BrgTxQueue priority class.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_MEM_ALLOC_ERR If MaxEntries frames already scheduled
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::AddOneShotCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer,
+                                              uint8_t SizeInBytes, uint32_t DelayUs, uint32_t *pHandle,
+                                              Brg_TxPriorityT Priority)
+{
+	Brg_TxFrameT frame;
+
+	if( (pCanMsg == NULL) || ((pBuffer == NULL) && (SizeInBytes != 0)) || (SizeInBytes > 8) ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(&frame, 0, sizeof(frame));
+	frame.bIsFdcan = false;
+	frame.CanMsg = *pCanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	frame.Priority = Priority;
+	return AddFrame(&frame, 0, DelayUs, pHandle);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Schedule a prepared CAN or FDCAN frame.
+ * @param[in]  pFrame        Frame (bIsFdcan, header, data, Priority), copied.
+ * @param[in]  PeriodUs      Period in microseconds (at least one tick), 0 for a one-shot frame.
+ * @param[in]  FirstDelayUs  Delay before the first transmission (0: next tick).
+ * @param[out] pHandle       Handle for UpdateData() and Remove().
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_MEM_ALLOC_ERR If MaxEntries frames already scheduled
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::AddFrame(const Brg_TxFrameT *pFrame, uint32_t PeriodUs,
+                                         uint32_t FirstDelayUs, uint32_t *pHandle)
+{
+	CyclicEntryT *pEntry;
+	int32_t idx;
+
+	if( (pFrame == NULL) || (pHandle == NULL) || (pFrame->Priority >= BRG_TX_PRIO_NB) ||
+	    ((PeriodUs != 0) && (PeriodUs < m_tickUs)) ||
+	    (pFrame->SizeInBytes > ((pFrame->bIsFdcan == true) ? BRG_TXQ_MAX_DATA_SIZE : 8)) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::mutex> lock(m_wheelMutex);
+	if( m_freeHead == BRG_CYC_NO_ENTRY ) {
+		return BRG_MEM_ALLOC_ERR;
+	}
+	idx = m_freeHead;
+	pEntry = &m_pEntries[idx];
+	m_freeHead = pEntry->Next;
+
+	pEntry->Frame = *pFrame;
+	pEntry->PeriodUs = PeriodUs;
+	pEntry->DueUs = BrgGetMonotonicUs() + FirstDelayUs;
+	pEntry->bUsed = true;
+	LinkEntry(idx, m_lastTick + 1);
+	m_activeNb++;
+	*pHandle = BRG_CYC_HANDLE(pEntry->Generation, idx);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Change the data field of a scheduled frame (e.g. keepalive counter), applied
+ *        from the next transmission.
+ * @param[in]  Handle       Handle returned by an Add function.
+ * @param[in]  pBuffer      New data field (copied).
+ * @param[in]  SizeInBytes  New data field size.
+ * @retval #BRG_PARAM_ERR If wrong parameters or unknown (expired) handle
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::UpdateData(uint32_t Handle, const uint8_t *pBuffer, uint8_t SizeInBytes)
+{
+	CyclicEntryT *pEntry;
+	int32_t idx;
+
+	if( (pBuffer == NULL) && (SizeInBytes != 0) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::mutex> lock(m_wheelMutex);
+	idx = HandleToIndex(Handle);
+	if( idx == BRG_CYC_NO_ENTRY ) {
+		return BRG_PARAM_ERR;
+	}
+	pEntry = &m_pEntries[idx];
+	if( SizeInBytes > ((pEntry->Frame.bIsFdcan == true) ? BRG_TXQ_MAX_DATA_SIZE : 8) ) {
+		return BRG_PARAM_ERR;
+	}
+	if( SizeInBytes != 0 ) {
+		memcpy(pEntry->Frame.Data, pBuffer, SizeInBytes);
+	}
+	pEntry->Frame.SizeInBytes = SizeInBytes;
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Cancel a scheduled frame.
+ * @param[in]  Handle  Handle returned by an Add function.
+ * @retval #BRG_PARAM_ERR If unknown handle (already removed or one-shot already sent)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgCyclicScheduler::Remove(uint32_t Handle)
+{
+	int32_t idx;
+
+	std::lock_guard<std::mutex> lock(m_wheelMutex);
+	idx = HandleToIndex(Handle);
+	if( idx == BRG_CYC_NO_ENTRY ) {
+		return BRG_PARAM_ERR;
+	}
+	UnlinkEntry(idx);
+	FreeEntry(idx);
+	return BRG_NO_ERR;
+}
+
+/*
+ * Absolute tick holding TimeUs (rounded up so that a frame is never released early)
+ */
+uint64_t BrgCyclicScheduler::UsToTick(uint64_t TimeUs) const
+{
+	if( TimeUs <= m_originUs ) {
+		return 0;
+	}
+	return (TimeUs - m_originUs + m_tickUs - 1) / m_tickUs;
+}
+
+/*
+ * Insert entry at the head of the slot of its due tick (DueUs must be set). O(1).
+ * Entries due before MinTick (first tick not processed yet) go to MinTick.
+ */
+void BrgCyclicScheduler::LinkEntry(int32_t Idx, uint64_t MinTick)
+{
+	CyclicEntryT *pEntry = &m_pEntries[Idx];
+	uint32_t slot;
+
+	pEntry->DueTick = UsToTick(pEntry->DueUs);
+	if( pEntry->DueTick < MinTick ) {
+		pEntry->DueTick = MinTick;
+	}
+	slot = (uint32_t)(pEntry->DueTick & BRG_CYC_WHEEL_MASK);
+	pEntry->Prev = BRG_CYC_NO_ENTRY;
+	pEntry->Next = m_slots[slot];
+	if( m_slots[slot] != BRG_CYC_NO_ENTRY ) {
+		m_pEntries[m_slots[slot]].Prev = Idx;
+	}
+	m_slots[slot] = Idx;
+}
+
+/*
+ * Remove entry from its slot list. O(1).
+ */
+void BrgCyclicScheduler::UnlinkEntry(int32_t Idx)
+{
+	CyclicEntryT *pEntry = &m_pEntries[Idx];
+
+	if( pEntry->Prev != BRG_CYC_NO_ENTRY ) {
+		m_pEntries[pEntry->Prev].Next = pEntry->Next;
+	} else {
+		m_slots[pEntry->DueTick & BRG_CYC_WHEEL_MASK] = pEntry->Next;
+	}
+	if( pEntry->Next != BRG_CYC_NO_ENTRY ) {
+		m_pEntries[pEntry->Next].Prev = pEntry->Prev;
+	}
+	pEntry->Prev = BRG_CYC_NO_ENTRY;
+	pEntry->Next = BRG_CYC_NO_ENTRY;
+}
+
+/*
+ * Return an unlinked entry to the free list, invalidating its handle
+ */
+void BrgCyclicScheduler::FreeEntry(int32_t Idx)
+{
+	CyclicEntryT *pEntry = &m_pEntries[Idx];
+
+	pEntry->bUsed = false;
+	pEntry->Generation++;
+	pEntry->Next = m_freeHead;
+	m_freeHead = Idx;
+	m_activeNb--;
+}
+
+int32_t BrgCyclicScheduler::HandleToIndex(uint32_t Handle) const
+{
+	uint32_t idx = (Handle & 0xFFFF);
+
+	if( (idx == 0) || (idx > m_maxEntries) ) {
+		return BRG_CYC_NO_ENTRY;
+	}
+	idx--;
+	if( (m_pEntries[idx].bUsed == false) || (m_pEntries[idx].Generation != (uint16_t)(Handle >> 16)) ) {
+		return BRG_CYC_NO_ENTRY;
+	}
+	return (int32_t)idx;
+}
+
+/*
+ * Expire the entries of one tick (called with m_wheelMutex held): due frames are copied
+ * to m_pBatch, periodic entries are re-linked at their next due time.
+ * Entries of the same slot due in a later wheel turn are left in place.
+ */
+void BrgCyclicScheduler::ProcessTick(uint64_t Tick, uint64_t NowUs)
+{
+	uint32_t slot = (uint32_t)(Tick & BRG_CYC_WHEEL_MASK);
+	uint32_t batchNb = 0, pushedNb = 0, maxBatch;
+	int32_t idx, next;
+	CyclicEntryT *pEntry;
+	uint64_t periodsLate, limitUs;
+
+	idx = m_slots[slot];
+	while( idx != BRG_CYC_NO_ENTRY ) {
+		pEntry = &m_pEntries[idx];
+		next = pEntry->Next;
+		if( pEntry->DueTick <= Tick ) {
+			UnlinkEntry(idx);
+			m_pBatch[batchNb++] = pEntry->Frame;
+			m_jitter.Record((NowUs > pEntry->DueUs) ? (NowUs - pEntry->DueUs) : 0);
+			if( pEntry->PeriodUs != 0 ) {
+				pEntry->DueUs += pEntry->PeriodUs;
+				// Skip the occurrences due in a tick already processed or more than one
+				// period before now (tick thread late), keep the phase
+				limitUs = m_originUs + Tick * m_tickUs;
+				if( (NowUs > pEntry->PeriodUs) && (NowUs - pEntry->PeriodUs > limitUs) ) {
+					limitUs = NowUs - pEntry->PeriodUs;
+				}
+				if( pEntry->DueUs <= limitUs ) {
+					periodsLate = (limitUs - pEntry->DueUs) / pEntry->PeriodUs + 1;
+					pEntry->DueUs += periodsLate * pEntry->PeriodUs;
+					m_missedNb.fetch_add(periodsLate, std::memory_order_relaxed);
+				}
+				// Re-link after the current tick, m_lastTick is advanced by TickThread()
+				LinkEntry(idx, Tick + 1);
+			} else {
+				FreeEntry(idx);
+			}
+		}
+		idx = next;
+	}
+	if( batchNb != 0 ) {
+		m_txQueue.PushFrames(m_pBatch, batchNb, &pushedNb);
+		m_releasedNb.fetch_add(pushedNb, std::memory_order_relaxed);
+		m_txDroppedNb.fetch_add(batchNb - pushedNb, std::memory_order_relaxed);
+		m_batchNb.fetch_add(1, std::memory_order_relaxed);
+		maxBatch = m_maxBatchSize.load(std::memory_order_relaxed);
+		while( (batchNb > maxBatch) &&
+		       !m_maxBatchSize.compare_exchange_weak(maxBatch, batchNb, std::memory_order_relaxed) ) {
+		}
+	}
+}
+
+/*
+ * Tick thread: wakes up on tick boundaries and processes every tick elapsed since the
+ * last one (catch-up if the thread was delayed).
+ */
+void BrgCyclicScheduler::TickThread(void)
+{
+	uint64_t nowUs, nowTick, nextUs;
+
+	while( m_bStopReq.load() == false ) {
+		nowUs = BrgGetMonotonicUs();
+		{
+			std::lock_guard<std::mutex> lock(m_wheelMutex);
+			nowTick = (nowUs - m_originUs) / m_tickUs;
+			if( nowTick > m_lastTick + 1 ) {
+				m_lateTickNb.fetch_add(nowTick - m_lastTick - 1, std::memory_order_relaxed);
+			}
+			while( m_lastTick < nowTick ) {
+				ProcessTick(m_lastTick + 1, nowUs);
+				m_lastTick++;
+			}
+		}
+		nextUs = m_originUs + (nowTick + 1) * m_tickUs;
+		nowUs = BrgGetMonotonicUs();
+		if( nextUs > nowUs ) {
+			std::unique_lock<std::mutex> lock(m_stopMutex);
+			if( m_bStopReq.load() == false ) {
+				m_stopCond.wait_for(lock, std::chrono::microseconds(nextUs - nowUs));
+			}
+		}
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get scheduler counters and release jitter.
+ * @param[out] pStats  Filled with current statistics.
+ */
+void BrgCyclicScheduler::GetStats(Brg_CyclicStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wheelMutex);
+		pStats->ActiveNb = m_activeNb;
+	}
+	pStats->ReleasedNb = m_releasedNb.load(std::memory_order_relaxed);
+	pStats->TxDroppedNb = m_txDroppedNb.load(std::memory_order_relaxed);
+	pStats->MissedNb = m_missedNb.load(std::memory_order_relaxed);
+	pStats->BatchNb = m_batchNb.load(std::memory_order_relaxed);
+	pStats->MaxBatchSize = m_maxBatchSize.load(std::memory_order_relaxed);
+	pStats->LateTickNb = m_lateTickNb.load(std::memory_order_relaxed);
+	m_jitter.GetSummary(&pStats->Jitter);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Clear counters and jitter histogram (scheduled entries are kept).
+ */
+void BrgCyclicScheduler::ResetStats(void)
+{
+	m_releasedNb.store(0);
+	m_txDroppedNb.store(0);
+	m_missedNb.store(0);
+	m_batchNb.store(0);
+	m_maxBatchSize.store(0);
+	m_lateTickNb.store(0);
+	m_jitter.Reset();
+}
+
+/**********************************END OF FILE*********************************/
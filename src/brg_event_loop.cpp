@@ -0,0 +1,348 @@
+/**
+  ******************************************************************************
+  * @file    brg_event_loop.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Single-thread event loop running resumable tasks (one per target
+  *          module) over a shared bridge: writes, awaited frames and delays.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_event_loop.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgEventLoop constructor
+ * @param[in]  Bridge        Opened Brg, CAN initialized (reception started for NextFrameAsync()).
+ * @param[in]  MaxPendingRx  Max number of tasks waiting for a frame at the same time.
+ */
+BrgEventLoop::BrgEventLoop(Brg &Bridge, uint32_t MaxPendingRx): m_brg(Bridge),
+	m_correlator(MaxPendingRx), m_activeTaskNb(0), m_rxWaitNb(0), m_resumeNb(0),
+	m_writeNb(0), m_rxPollNb(0), m_iterationNb(0)
+{
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgEventLoop destructor: tasks still running are abandoned (not resumed).
+ */
+BrgEventLoop::~BrgEventLoop(void)
+{
+	// Cancel callbacks push to m_ready: must run before the members are destroyed
+	m_correlator.CancelAll();
+	while( m_ready.empty() == false ) {
+		m_ready.front().pTask->m_pLoop = NULL;
+		m_ready.pop_front();
+	}
+	while( m_timers.empty() == false ) {
+		m_timers.top().pTask->m_pLoop = NULL;
+		m_timers.pop();
+	}
+	for( size_t i = 0; i < m_writes.size(); i++ ) {
+		m_writes[i].pTask->m_pLoop = NULL;
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Add a task to the loop: its first Resume() (pResult NULL) is called by the next RunOnce().
+ * @param[in]  pTask  Task, not running in a loop, alive until finished or loop destroyed.
+ * @retval #BRG_PARAM_ERR If pTask is NULL or already running
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgEventLoop::Spawn(BrgAsyncTask *pTask)
+{
+	ReadyT ready;
+
+	if( (pTask == NULL) || (pTask->m_pLoop != NULL) ) {
+		return BRG_PARAM_ERR;
+	}
+	pTask->m_pLoop = this;
+	memset(&ready, 0, sizeof(ready));
+	ready.pTask = pTask;
+	ready.bStart = true;
+	m_ready.push_back(ready);
+	m_activeTaskNb++;
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Asynchronous Brg::WriteMsgCAN(): the task is resumed with the write status.
+ *        Writes of all tasks are sent back to back by the next RunOnce().
+ *        If an error is returned, nothing is started: the task must not wait for it.
+ * @param[in]  pTask        Calling task (running in this loop).
+ * @param[in]  pCanMsg      Message header, see Brg::WriteMsgCAN().
+ * @param[in]  pBuffer      Data bytes.
+ * @param[in]  SizeInBytes  Data size (0 to 8).
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgEventLoop::WriteMsgCANAsync(BrgAsyncTask *pTask, const Brg_CanTxMsgT *pCanMsg,
+                                           const uint8_t *pBuffer, uint8_t SizeInBytes)
+{
+	PendingWriteT write;
+
+	if( (pTask == NULL) || (pTask->m_pLoop != this) || (pCanMsg == NULL) ||
+	    (SizeInBytes > 8) || ((pBuffer == NULL) && (SizeInBytes != 0)) ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(&write, 0, sizeof(write));
+	write.pTask = pTask;
+	write.CanMsg = *pCanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(write.Data, pBuffer, SizeInBytes);
+	}
+	write.SizeInBytes = SizeInBytes;
+	write.bCompleteOnWrite = true;
+	m_writes.push_back(write);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Wait for a frame matching pMatch, optionally sending a request first (the
+ *        response is registered before the request is written so it cannot be missed).
+ *        The task is resumed with the frame, with #BRG_TARGET_CMD_TIMEOUT at deadline
+ *        or with the request write error.
+ *        If an error is returned, nothing is started: the task must not wait for it.
+ * @param[in]  pTask        Calling task (running in this loop).
+ * @param[in]  pMatch       Expected frame, see BrgCorrelator::Register().
+ * @param[in]  TimeoutMs    Deadline from now (1ms resolution).
+ * @param[in]  pCanMsg      If not NULL, request header to write, see Brg::WriteMsgCAN().
+ * @param[in]  pBuffer      Request data bytes.
+ * @param[in]  SizeInBytes  Request data size (0 to 8).
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_MEM_ALLOC_ERR If MaxPendingRx tasks are already waiting for a frame
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgEventLoop::NextFrameAsync(BrgAsyncTask *pTask, const Brg_CorrMatchT *pMatch, uint32_t TimeoutMs,
+                                         const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer,
+                                         uint8_t SizeInBytes)
+{
+	PendingWriteT write;
+	Brg_StatusT brgStat;
+	uint32_t handle;
+
+	if( (pTask == NULL) || (pTask->m_pLoop != this) || (pMatch == NULL) ) {
+		return BRG_PARAM_ERR;
+	}
+	if( (pCanMsg != NULL) && ((SizeInBytes > 8) || ((pBuffer == NULL) && (SizeInBytes != 0))) ) {
+		return BRG_PARAM_ERR;
+	}
+	pTask->m_cancelStatus = BRG_NO_ERR;
+	brgStat = m_correlator.Register(pMatch, TimeoutMs, RxCallback, pTask, &handle);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	m_rxWaitNb++;
+	if( pCanMsg != NULL ) {
+		memset(&write, 0, sizeof(write));
+		write.pTask = pTask;
+		write.CanMsg = *pCanMsg;
+		if( SizeInBytes != 0 ) {
+			memcpy(write.Data, pBuffer, SizeInBytes);
+		}
+		write.SizeInBytes = SizeInBytes;
+		write.bCompleteOnWrite = false;
+		write.RxHandle = handle;
+		m_writes.push_back(write);
+	}
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Resume the task after DelayUs (host monotonic time, resolution of one RunOnce()).
+ * @param[in]  pTask    Calling task (running in this loop).
+ * @param[in]  DelayUs  Delay in microseconds.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgEventLoop::DelayAsync(BrgAsyncTask *pTask, uint32_t DelayUs)
+{
+	TimerT timer;
+
+	if( (pTask == NULL) || (pTask->m_pLoop != this) ) {
+		return BRG_PARAM_ERR;
+	}
+	timer.DueUs = BrgGetMonotonicUs() + DelayUs;
+	timer.pTask = pTask;
+	m_timers.push(timer);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief One loop iteration: resume the ready tasks, send the writes they started,
+ *        expire the delays, then poll the CAN Rx FIFO once for all the tasks waiting
+ *        for a frame. Never blocks except for the USB commands.
+ * @retval true while tasks are running.
+ */
+bool BrgEventLoop::RunOnce(void)
+{
+	std::vector<PendingWriteT> writes;
+	std::vector<uint32_t> failedRx;
+	Brg_StatusT brgStat;
+	ReadyT ready;
+	uint64_t nowUs;
+
+	m_iterationNb++;
+	// Resume: tasks made ready during this pass (e.g. immediate errors) are run too
+	while( m_ready.empty() == false ) {
+		ready = m_ready.front();
+		m_ready.pop_front();
+		m_resumeNb++;
+		if( ready.pTask->Resume(*this, (ready.bStart == true) ? NULL : &ready.Result) == false ) {
+			ready.pTask->m_pLoop = NULL;
+			m_activeTaskNb--;
+		}
+	}
+
+	// Writes of all tasks back to back under one transaction lock
+	if( m_writes.empty() == false ) {
+		writes.swap(m_writes);
+		{
+			std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+			for( size_t i = 0; i < writes.size(); i++ ) {
+				brgStat = m_brg.WriteMsgCAN(&writes[i].CanMsg, writes[i].Data, writes[i].SizeInBytes);
+				m_writeNb++;
+				if( writes[i].bCompleteOnWrite == true ) {
+					MakeReady(writes[i].pTask, brgStat, NULL);
+				} else if( brgStat != BRG_NO_ERR ) {
+					writes[i].pTask->m_cancelStatus = brgStat;
+					failedRx.push_back(writes[i].RxHandle);
+				}
+			}
+		}
+		// No answer to wait for a request that was not sent
+		for( size_t i = 0; i < failedRx.size(); i++ ) {
+			m_correlator.Cancel(failedRx[i]);
+		}
+	}
+
+	nowUs = BrgGetMonotonicUs();
+	while( (m_timers.empty() == false) && (m_timers.top().DueUs <= nowUs) ) {
+		MakeReady(m_timers.top().pTask, BRG_NO_ERR, NULL);
+		m_timers.pop();
+	}
+
+	if( m_rxWaitNb != 0 ) {
+		// Dispatches frames and expires deadlines (RxCallback)
+		m_correlator.PollCAN(m_brg);
+		m_rxPollNb++;
+	}
+	return (m_activeTaskNb != 0);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Run the loop until all tasks are finished, sleeping #BRG_LOOP_IDLE_SLEEP_US
+ *        (or less if a delay is due sooner) when no task is ready.
+ * @param[in]  TimeoutMs  Max run time, 0 for no limit.
+ * @retval #BRG_TARGET_CMD_TIMEOUT If tasks are still running after TimeoutMs
+ * @retval #BRG_NO_ERR If all tasks are finished
+ */
+Brg_StatusT BrgEventLoop::Run(uint32_t TimeoutMs)
+{
+	uint64_t startUs = BrgGetMonotonicUs();
+	uint64_t nowUs, sleepUs;
+
+	while( RunOnce() == true ) {
+		nowUs = BrgGetMonotonicUs();
+		if( (TimeoutMs != 0) && ((nowUs - startUs) >= ((uint64_t)TimeoutMs * 1000)) ) {
+			return BRG_TARGET_CMD_TIMEOUT;
+		}
+		if( (m_ready.empty() == true) && (m_writes.empty() == true) ) {
+			sleepUs = BRG_LOOP_IDLE_SLEEP_US;
+			if( m_timers.empty() == false ) {
+				if( m_timers.top().DueUs <= nowUs ) {
+					sleepUs = 0;
+				} else if( (m_timers.top().DueUs - nowUs) < sleepUs ) {
+					sleepUs = m_timers.top().DueUs - nowUs;
+				}
+			}
+			if( sleepUs != 0 ) {
+				std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+			}
+		}
+	}
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get the loop statistics.
+ * @param[out] pStats  Statistics.
+ */
+void BrgEventLoop::GetStats(Brg_EventLoopStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	pStats->ActiveTaskNb = m_activeTaskNb;
+	pStats->ResumeNb = m_resumeNb;
+	pStats->WriteNb = m_writeNb;
+	pStats->RxPollNb = m_rxPollNb;
+	pStats->IterationNb = m_iterationNb;
+}
+
+/*
+ * BrgCorrelator completion of a NextFrameAsync(): pContext is the waiting task
+ */
+void BrgEventLoop::RxCallback(void *pContext, uint32_t Handle, Brg_CorrResultT Result,
+                              const Brg_RxFrameT *pFrame)
+{
+	BrgAsyncTask *pTask = (BrgAsyncTask*)pContext;
+	BrgEventLoop *pLoop = pTask->m_pLoop;
+	Brg_StatusT brgStat;
+
+	(void)Handle;
+	if( pLoop == NULL ) {
+		return;
+	}
+	pLoop->m_rxWaitNb--;
+	if( Result == BRG_CORR_RESOLVED ) {
+		brgStat = BRG_NO_ERR;
+	} else if( Result == BRG_CORR_EXPIRED ) {
+		brgStat = BRG_TARGET_CMD_TIMEOUT;
+	} else {
+		brgStat = (pTask->m_cancelStatus != BRG_NO_ERR) ? pTask->m_cancelStatus : BRG_CMD_NOT_ALLOWED;
+	}
+	pLoop->MakeReady(pTask, brgStat, pFrame);
+}
+
+void BrgEventLoop::MakeReady(BrgAsyncTask *pTask, Brg_StatusT Status, const Brg_RxFrameT *pFrame)
+{
+	ReadyT ready;
+
+	ready.pTask = pTask;
+	ready.bStart = false;
+	ready.Result.Status = Status;
+	if( pFrame != NULL ) {
+		ready.Result.Frame = *pFrame;
+	} else {
+		memset(&ready.Result.Frame, 0, sizeof(ready.Result.Frame));
+	}
+	m_ready.push_back(ready);
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,117 @@
+/**
+  ******************************************************************************
+  * @file    brg_frame.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Conversion of Brg::GetRxMsgCAN() / Brg::GetRxMsgFDCAN() output (headers
+  *          table + concatenated data buffer) into self-contained Brg_RxFrameT.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include "brg_frame.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Functions Definition ------------------------------------------------------*/
+/**
+ * @ingroup CAN
+ * @brief Split Brg::GetRxMsgCAN() output into frames.
+ * @param[in]  pCanMsg          Message headers filled by Brg::GetRxMsgCAN().
+ * @param[in]  MsgNb            Number of messages read.
+ * @param[in]  pBuffer          Data buffer filled by Brg::GetRxMsgCAN() (data of all messages, in order).
+ * @param[in]  DataSizeInBytes  Valid bytes in pBuffer (*pDataSizeInBytes of Brg::GetRxMsgCAN()).
+ * @param[out] pFrames          Table of at least MsgNb frames.
+ * @retval Number of frames filled (MsgNb, 0 if NULL parameter).
+ */
+uint16_t BrgFramesFromCAN(const Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, const uint8_t *pBuffer,
+                          uint16_t DataSizeInBytes, Brg_RxFrameT *pFrames)
+{
+	uint16_t offset = 0, size;
+
+	if( (pCanMsg == NULL) || (pFrames == NULL) || ((pBuffer == NULL) && (DataSizeInBytes != 0)) ) {
+		return 0;
+	}
+	for( uint16_t i = 0; i < MsgNb; i++ ) {
+		pFrames[i].bIsFdcan = false;
+		pFrames[i].IDE = pCanMsg[i].IDE;
+		pFrames[i].ID = pCanMsg[i].ID;
+		pFrames[i].RTR = pCanMsg[i].RTR;
+		pFrames[i].DLC = pCanMsg[i].DLC;
+		pFrames[i].Overrun = pCanMsg[i].Overrun;
+		pFrames[i].HwTimeStamp = pCanMsg[i].TimeStamp;
+		pFrames[i].RxTimeUs = pCanMsg[i].HostTimeUs;
+		size = 0;
+		if( pCanMsg[i].RTR == CAN_DATA_FRAME ) {
+			// Same rule as Brg::GetRxMsgCAN(): data truncated if buffer was too small
+			size = pCanMsg[i].DLC;
+			if( size > (uint16_t)(DataSizeInBytes - offset) ) {
+				size = DataSizeInBytes - offset;
+			}
+			if( size > 8 ) {
+				size = 8;
+			}
+			memcpy(pFrames[i].Data, &pBuffer[offset], size);
+			offset += size;
+		}
+		pFrames[i].SizeInBytes = (uint8_t)size;
+	}
+	return MsgNb;
+}
+
+/**
+ * @ingroup FDCAN
+ * @brief Split Brg::GetRxMsgFDCAN() output into frames.
+ * @param[in]  pFdcanMsg        Message headers filled by Brg::GetRxMsgFDCAN().
+ * @param[in]  MsgNb            Number of messages read.
+ * @param[in]  pBuffer          Data buffer filled by Brg::GetRxMsgFDCAN() (data of all messages, in order).
+ * @param[in]  DataSizeInBytes  Valid bytes in pBuffer (*pDataSizeInBytes of Brg::GetRxMsgFDCAN()).
+ * @param[out] pFrames          Table of at least MsgNb frames.
+ * @retval Number of frames filled (MsgNb, 0 if NULL parameter).
+ */
+uint16_t BrgFramesFromFDCAN(const Brg_FdcanRxMsgT *pFdcanMsg, uint16_t MsgNb, const uint8_t *pBuffer,
+                            uint16_t DataSizeInBytes, Brg_RxFrameT *pFrames)
+{
+	uint16_t offset = 0, size;
+
+	if( (pFdcanMsg == NULL) || (pFrames == NULL) || ((pBuffer == NULL) && (DataSizeInBytes != 0)) ) {
+		return 0;
+	}
+	for( uint16_t i = 0; i < MsgNb; i++ ) {
+		pFrames[i].bIsFdcan = true;
+		pFrames[i].IDE = pFdcanMsg[i].Header.IDE;
+		pFrames[i].ID = pFdcanMsg[i].Header.ID;
+		pFrames[i].RTR = pFdcanMsg[i].Header.RTR;
+		pFrames[i].DLC = pFdcanMsg[i].Header.DLC;
+		pFrames[i].Overrun = pFdcanMsg[i].Overrun;
+		pFrames[i].HwTimeStamp = pFdcanMsg[i].TimeStamp;
+		pFrames[i].RxTimeUs = pFdcanMsg[i].HostTimeUs;
+		size = 0;
+		if( pFdcanMsg[i].Header.RTR == CAN_DATA_FRAME ) {
+			size = pFdcanMsg[i].Header.DLC;
+			if( size > (uint16_t)(DataSizeInBytes - offset) ) {
+				size = DataSizeInBytes - offset;
+			}
+			if( size > BRG_FRAME_MAX_DATA_SIZE ) {
+				size = BRG_FRAME_MAX_DATA_SIZE;
+			}
+			memcpy(pFrames[i].Data, &pBuffer[offset], size);
+			offset += size;
+		}
+		pFrames[i].SizeInBytes = (uint8_t)size;
+	}
+	return MsgNb;
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,202 @@
+/**
+  ******************************************************************************
+  * @file    brg_gpio_wave.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   GPIO waveform execution with merged Brg::SetResetGPIO() commands.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_gpio_wave.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup GPIO
+ * @brief BrgGpioWave constructor
+ * @param[in]  Bridge  Opened Brg.
+ */
+BrgGpioWave::BrgGpioWave(Brg &Bridge):
+	m_brg(Bridge), m_knownMask(0), m_setMask(0), m_cmdUs(BRG_GPIOWAVE_DEFAULT_CMD_US)
+{
+}
+
+/**
+ * @ingroup GPIO
+ * @brief Configure the waveform GPIOs as outputs, their levels are unknown until
+ *        written by Run().
+ * @param[in]  GpioMask    GPIO(s) to configure (one or several value of #Brg_GpioMaskT).
+ * @param[in]  OutputType  Output type (#GPIO_OUTPUT_OPENDRAIN for lines with their own pull-up).
+ *
+ * @retval #BRG_PARAM_ERR If no GPIO given
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgGpioWave::Init(uint8_t GpioMask, Brg_GpioOutputT OutputType)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	Brg_GpioConfT gpioConf;
+	Brg_GpioInitT gpioInit;
+
+	if( (GpioMask & BRG_GPIO_ALL) == 0 ) {
+		return BRG_PARAM_ERR;
+	}
+	gpioConf.Mode = GPIO_MODE_OUTPUT;
+	gpioConf.Speed = GPIO_SPEED_HIGH;
+	gpioConf.Pull = GPIO_NO_PULL;
+	gpioConf.OutputType = OutputType;
+	gpioInit.GpioMask = GpioMask & BRG_GPIO_ALL;
+	gpioInit.ConfigNb = 1;
+	gpioInit.pGpioConf = &gpioConf;
+	m_knownMask &= (uint8_t)~GpioMask;
+	return m_brg.InitGPIO(&gpioInit);
+}
+
+/**
+ * @ingroup GPIO
+ * @brief Execute a GPIO waveform.
+ * A step is sent in the command of a previous step when it comes less than half a
+ * command duration after it and their GPIOs differ: the GPIOs change together, nearer
+ * to the planned time than with a second command.
+ * @param[in]  pSteps        Waveform steps, the DelayUs of the last one is not waited.
+ * @param[in]  StepNb        Number of steps.
+ * @param[out] pStepResults  Table of StepNb achieved step timings, may be NULL.
+ * @param[out] pStats        Run summary, may be NULL.
+ *
+ * @retval #BRG_PARAM_ERR If a step without GPIO
+ * @retval #BRG_GPIO_ERR If a GPIO could not be driven
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgGpioWave::Run(const Brg_GpioWaveStepT *pSteps, uint32_t StepNb,
+                             Brg_GpioWaveStepResultT *pStepResults, Brg_GpioWaveStatsT *pStats)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	Brg_GpioWaveStepResultT stepResult;
+	Brg_GpioWaveStatsT stats;
+	Brg_GpioValT gpioVal[BRG_GPIO_MAX_NB];
+	uint64_t originUs, cmdStartUs, cmdEndUs, plannedUs, leadUs, spanUs;
+	uint8_t gpioMask, setMask, changeMask, gpioErrorMask;
+	uint32_t i, j, k;
+	int32_t lateUs;
+
+	if( (pSteps == NULL) && (StepNb != 0) ) {
+		return BRG_PARAM_ERR;
+	}
+	for( i=0; i<StepNb; i++ ) {
+		if( (pSteps[i].GpioMask & BRG_GPIO_ALL) == 0 ) {
+			return BRG_PARAM_ERR;
+		}
+	}
+	memset(&stats, 0, sizeof(stats));
+	stats.StepNb = StepNb;
+
+	// Step times are planned from the middle of the first command
+	originUs = 0;
+	plannedUs = m_cmdUs/2;
+	cmdStartUs = 0;
+	cmdEndUs = 0;
+	for( i=0; (i<StepNb) && (brgStat == BRG_NO_ERR); i=j ) {
+		gpioMask = pSteps[i].GpioMask & BRG_GPIO_ALL;
+		setMask = pSteps[i].GpioSetMask & gpioMask;
+		// Following steps merged while they come less than half a command after step i
+		spanUs = 0;
+		for( j=i+1; j<StepNb; j++ ) {
+			spanUs += pSteps[j-1].DelayUs;
+			if( (spanUs*2 >= m_cmdUs) || ((pSteps[j].GpioMask & gpioMask) != 0) ) {
+				break;
+			}
+			gpioMask |= pSteps[j].GpioMask & BRG_GPIO_ALL;
+			setMask |= pSteps[j].GpioSetMask & pSteps[j].GpioMask & BRG_GPIO_ALL;
+		}
+		// GPIOs already at the requested level are not written
+		changeMask = gpioMask & (uint8_t)~(m_knownMask & (uint8_t)~(m_setMask ^ setMask));
+		if( changeMask != 0 ) {
+			leadUs = m_cmdUs/2;
+			if( stats.CmdNb == 0 ) {
+				originUs = BrgGetMonotonicUs() - (plannedUs - leadUs);
+			} else {
+				WaitUntil(originUs + ((plannedUs > leadUs) ? (plannedUs - leadUs) : 0));
+			}
+			for( k=0; k<BRG_GPIO_MAX_NB; k++ ) {
+				gpioVal[k] = ((setMask & (1<<k)) != 0) ? GPIO_SET : GPIO_RESET;
+			}
+			gpioErrorMask = 0;
+			cmdStartUs = BrgGetMonotonicUs();
+			brgStat = m_brg.SetResetGPIO(changeMask, gpioVal, &gpioErrorMask);
+			cmdEndUs = BrgGetMonotonicUs();
+			if( brgStat != BRG_NO_ERR ) {
+				m_knownMask &= (uint8_t)~changeMask;
+			} else {
+				m_knownMask |= changeMask;
+				m_setMask = (m_setMask & (uint8_t)~changeMask) | (setMask & changeMask);
+				m_cmdUs = (m_cmdUs*7 + (uint32_t)(cmdEndUs - cmdStartUs)) / 8;
+			}
+			stats.CmdNb++;
+		}
+
+		for( k=i; k<j; k++ ) {
+			memset(&stepResult, 0, sizeof(stepResult));
+			stepResult.PlannedUs = (uint32_t)plannedUs;
+			if( (pSteps[k].GpioMask & changeMask) == 0 ) {
+				stepResult.State = BRG_GPIOWAVE_SKIPPED;
+				stats.SkippedNb++;
+			} else {
+				stepResult.State = (k == i) ? BRG_GPIOWAVE_SENT : BRG_GPIOWAVE_MERGED;
+				if( k != i ) {
+					stats.MergedNb++;
+				}
+				stepResult.CmdStartUs = (uint32_t)(cmdStartUs - originUs);
+				stepResult.CmdEndUs = (uint32_t)(cmdEndUs - originUs);
+				lateUs = (int32_t)((int64_t)(stepResult.CmdStartUs + stepResult.CmdEndUs)/2 - (int64_t)plannedUs);
+				stepResult.LateUs = lateUs;
+				if( (uint32_t)((lateUs < 0) ? -lateUs : lateUs) > stats.MaxLateUs ) {
+					stats.MaxLateUs = (uint32_t)((lateUs < 0) ? -lateUs : lateUs);
+				}
+			}
+			if( pStepResults != NULL ) {
+				pStepResults[k] = stepResult;
+			}
+			plannedUs += pSteps[k].DelayUs;
+		}
+	}
+	stats.CmdUs = m_cmdUs;
+	stats.TotalUs = (uint32_t)(cmdEndUs - originUs);
+	if( pStats != NULL ) {
+		*pStats = stats;
+	}
+	return brgStat;
+}
+
+/*
+ * Wait until the host monotonic time TimeUs: sleep, then read the clock for the last
+ * BRG_GPIOWAVE_SPIN_US (sleep granularity).
+ */
+void BrgGpioWave::WaitUntil(uint64_t TimeUs) const
+{
+	uint64_t nowUs;
+
+	nowUs = BrgGetMonotonicUs();
+	if( nowUs + BRG_GPIOWAVE_SPIN_US < TimeUs ) {
+		std::this_thread::sleep_for(std::chrono::microseconds(TimeUs - nowUs - BRG_GPIOWAVE_SPIN_US));
+	}
+	while( BrgGetMonotonicUs() < TimeUs ) {
+	}
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file    brg_hw_time.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Unwrapping of the 16-bit bridge Rx timestamps and mapping onto the
+  *          host monotonic time.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <stddef.h>
+#include "brg_hw_time.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+#define BRG_HWTIME_WRAP 0x10000
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup FDCAN
+ * @brief BrgHwTimeMap constructor
+ */
+BrgHwTimeMap::BrgHwTimeMap(void)
+{
+	Reset();
+}
+
+/**
+ * @ingroup FDCAN
+ * @brief Forget the mapping, to be called when the bridge timestamp counter restarts
+ *        or changes its rate (FDCAN initialization).
+ */
+void BrgHwTimeMap::Reset(void)
+{
+	m_bStarted = false;
+	m_lastStamp = 0;
+	m_lastTick = 0;
+	m_lastReadUs = 0;
+	m_firstReadUs = 0;
+	m_tickUs = 0;
+	m_wrapNb = 0;
+	m_lostWrapNb = 0;
+}
+
+/**
+ * @ingroup FDCAN
+ * @brief Host time of a received message, messages given in reception order
+ *        per FIFO: a timestamp less than half the counter range before the previous one
+ *        is an older message (other FIFO), not a wrap, unless the host time elapsed
+ *        since the previous read shows a longer gap (tick period known).
+ * @param[in]  HwTimeStamp  16-bit bridge timestamp of the message.
+ * @param[in]  ReadUs       Host time (BrgGetMonotonicUs()) of the read returning the message.
+ * @retval Host reception time estimate, ReadUs until the tick period is known
+ *         (after #BRG_HWTIME_MIN_SPAN_US), never later than ReadUs.
+ */
+uint64_t BrgHwTimeMap::Map(uint16_t HwTimeStamp, uint64_t ReadUs)
+{
+	uint64_t tick, hostUs;
+
+	// New read: refine the tick period with the last message of the previous one
+	if( (m_bStarted == true) && (ReadUs != m_lastReadUs) && (m_lastTick != 0) &&
+	    ((m_lastReadUs - m_firstReadUs) >= BRG_HWTIME_MIN_SPAN_US) ) {
+		m_tickUs = (double)(m_lastReadUs - m_firstReadUs) / (double)m_lastTick;
+	}
+	tick = Unwrap(HwTimeStamp, ReadUs);
+	if( m_tickUs == 0 ) {
+		return ReadUs;
+	}
+	hostUs = m_firstReadUs + (uint64_t)((double)tick * m_tickUs);
+	return (hostUs > ReadUs) ? ReadUs : hostUs;
+}
+
+/**
+ * @ingroup FDCAN
+ * @brief Get the current mapping state.
+ * @param[out] pState  Mapping state.
+ */
+void BrgHwTimeMap::GetState(Brg_HwTimeStateT *pState) const
+{
+	if( pState == NULL ) {
+		return;
+	}
+	pState->bTickKnown = (m_tickUs != 0);
+	pState->TickUs = m_tickUs;
+	pState->TickNb = m_lastTick;
+	pState->WrapNb = m_wrapNb;
+	pState->LostWrapNb = m_lostWrapNb;
+}
+
+/*
+ * 64-bit tick count since the first timestamp. A step back of less than half the counter
+ * range is a message older than the previous one (other FIFO), never counted as a wrap
+ * before the period is known. Once it is known, the host time elapsed since the previous
+ * read recovers the wraps the 16-bit counter cannot show and tells a long gap from an
+ * older message.
+ */
+uint64_t BrgHwTimeMap::Unwrap(uint16_t HwTimeStamp, uint64_t ReadUs)
+{
+	uint64_t tick, expectedNb, lostNb, backNb;
+	uint16_t delta;
+
+	if( m_bStarted == false ) {
+		m_bStarted = true;
+		m_lastStamp = HwTimeStamp;
+		m_lastTick = 0;
+		m_lastReadUs = ReadUs;
+		m_firstReadUs = ReadUs;
+		return 0;
+	}
+	delta = (uint16_t)(HwTimeStamp - m_lastStamp);
+	expectedNb = 0;
+	if( (m_tickUs != 0) && (ReadUs > m_lastReadUs) ) {
+		expectedNb = (uint64_t)((double)(ReadUs - m_lastReadUs) / m_tickUs);
+	}
+	if( (delta >= BRG_HWTIME_WRAP/2) && ((m_tickUs == 0) || (expectedNb < BRG_HWTIME_WRAP/2)) ) {
+		// Older than the previous message (FIFO0 and FIFO1 read separately): not a wrap,
+		// a gap of more than half the range is not plausible while the period is unknown
+		backNb = BRG_HWTIME_WRAP - delta;
+		return (m_lastTick > backNb) ? (m_lastTick - backNb) : 0;
+	}
+	tick = m_lastTick + delta;
+	if( HwTimeStamp < m_lastStamp ) {
+		m_wrapNb++;
+	}
+	if( m_tickUs != 0 ) {
+		if( expectedNb > (uint64_t)delta + BRG_HWTIME_WRAP/2 ) {
+			lostNb = (expectedNb - delta + BRG_HWTIME_WRAP/2) / BRG_HWTIME_WRAP;
+			tick += lostNb * BRG_HWTIME_WRAP;
+			m_wrapNb += (uint32_t)lostNb;
+			m_lostWrapNb += (uint32_t)lostNb;
+		}
+	}
+	m_lastStamp = HwTimeStamp;
+	m_lastTick = tick;
+	m_lastReadUs = ReadUs;
+	return tick;
+}
+
+/**********************************END OF FILE*********************************/
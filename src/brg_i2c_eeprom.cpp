@@ -0,0 +1,235 @@
+/**
+  ******************************************************************************
+  * @file    brg_i2c_eeprom.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   24Cxx-class I2C EEPROM reader and writer (page split, acknowledge
+  *          polling, verify) using the I2C bridge.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_i2c_eeprom.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+#define BRG_I2CEEPROM_READ_MAX_SIZE 0x8000 // Brg::ReadI2C() size is 16-bit, 64 KB block split in two
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup I2C
+ * @brief BrgI2cEeprom constructor
+ * @param[in]  Bridge  Opened Brg, I2C initialized in master mode (7-bit addressing).
+ * @param[in]  Conf    EEPROM description, checked by the first Read() or Write() call.
+ */
+BrgI2cEeprom::BrgI2cEeprom(Brg &Bridge, const Brg_I2cEepromConfT &Conf):
+	m_brg(Bridge), m_conf(Conf), m_lastStopUs(0)
+{
+	m_bConfOk = (m_conf.SizeInBytes != 0) && (m_conf.PageSize != 0) &&
+	            (m_conf.PageSize <= BRG_I2CEEPROM_MAX_PAGE_SIZE) &&
+	            ((m_conf.SizeInBytes % m_conf.PageSize) == 0) &&
+	            ((m_conf.AddrBytes == 1) || (m_conf.AddrBytes == 2));
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * @ingroup I2C
+ * @brief Read the EEPROM content: memory address set (after acknowledge polling if a
+ *        write cycle is in progress), then sequential reads with Brg::ReadI2C(): one
+ *        I2C transaction per call whatever its size, so one USB command and one status
+ *        per #BRG_I2CEEPROM_READ_MAX_SIZE bytes.
+ * @retval #BRG_PARAM_ERR If NULL pointer, range outside of the EEPROM or wrong configuration
+ * @retval #BRG_TARGET_CMD_TIMEOUT If a write cycle does not end within #BRG_I2CEEPROM_WRITE_TIMEOUT_MS
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg I2C errors
+ */
+Brg_StatusT BrgI2cEeprom::Read(uint32_t Addr, uint8_t *pBuffer, uint32_t SizeInBytes)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t blockSize, size, doneSize = 0;
+
+	if( (m_bConfOk == false) || (pBuffer == NULL) || (Addr > m_conf.SizeInBytes) ||
+	    (SizeInBytes > m_conf.SizeInBytes - Addr) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	// The device address changes with the block select bits: sequential reads within a block
+	blockSize = (uint32_t)1 << (8 * m_conf.AddrBytes);
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		size = blockSize - ((Addr + doneSize) % blockSize);
+		if( size > SizeInBytes - doneSize ) {
+			size = SizeInBytes - doneSize;
+		}
+		if( size > BRG_I2CEEPROM_READ_MAX_SIZE ) {
+			size = BRG_I2CEEPROM_READ_MAX_SIZE;
+		}
+		brgStat = WaitReady(Addr + doneSize);
+		if( brgStat == BRG_NO_ERR ) {
+			brgStat = m_brg.ReadI2C(&pBuffer[doneSize], (uint16_t)(m_conf.DevAddr | ((Addr + doneSize) / blockSize)),
+			                        (uint16_t)size, NULL);
+		}
+		doneSize += size;
+	}
+	return brgStat;
+}
+
+/**
+ * @ingroup I2C
+ * @brief Write pData at Addr, one page write transaction per page (or part of page).
+ * @param[in]  Addr         EEPROM address (any alignment).
+ * @param[in]  pData        Data to write.
+ * @param[in]  SizeInBytes  Data size.
+ * @param[in]  bVerify      Read back the range and compare.
+ * @retval #BRG_PARAM_ERR If NULL pointer, range outside of the EEPROM or wrong configuration
+ * @retval #BRG_TARGET_CMD_TIMEOUT If a write cycle does not end within #BRG_I2CEEPROM_WRITE_TIMEOUT_MS
+ * @retval #BRG_VERIF_ERR If the read back data differ
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg I2C errors
+ */
+Brg_StatusT BrgI2cEeprom::Write(uint32_t Addr, const uint8_t *pData, uint32_t SizeInBytes, bool bVerify)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t size, doneSize = 0;
+	uint64_t startUs;
+
+	if( (m_bConfOk == false) || (pData == NULL) || (Addr > m_conf.SizeInBytes) ||
+	    (SizeInBytes > m_conf.SizeInBytes - Addr) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	startUs = BrgGetMonotonicUs();
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		// The EEPROM wraps inside the page: never cross a page boundary
+		size = m_conf.PageSize - ((Addr + doneSize) % m_conf.PageSize);
+		if( size > SizeInBytes - doneSize ) {
+			size = SizeInBytes - doneSize;
+		}
+		brgStat = WritePage(Addr + doneSize, &pData[doneSize], (uint16_t)size);
+		doneSize += size;
+	}
+	for( doneSize = 0; (brgStat == BRG_NO_ERR) && (bVerify == true) && (doneSize < SizeInBytes);
+	     doneSize += size ) {
+		size = SizeInBytes - doneSize;
+		if( size > BRG_I2CEEPROM_MAX_PAGE_SIZE ) {
+			size = BRG_I2CEEPROM_MAX_PAGE_SIZE;
+		}
+		brgStat = Read(Addr + doneSize, m_verify, size);
+		if( (brgStat == BRG_NO_ERR) && (memcmp(m_verify, &pData[doneSize], size) != 0) ) {
+			brgStat = BRG_VERIF_ERR;
+		}
+	}
+	if( brgStat == BRG_NO_ERR ) {
+		m_stats.WriteBytes += SizeInBytes;
+		m_stats.WriteTimeUs += BrgGetMonotonicUs() - startUs;
+	}
+	return brgStat;
+}
+
+/**
+ * @ingroup I2C
+ * @brief Get the write statistics.
+ * @param[out] pStats  Statistics.
+ */
+void BrgI2cEeprom::GetStats(Brg_I2cEepromStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	*pStats = m_stats;
+	pStats->BytesPerSec = 0;
+	if( m_stats.WriteTimeUs != 0 ) {
+		pStats->BytesPerSec = m_stats.WriteBytes * 1000000 / m_stats.WriteTimeUs;
+	}
+}
+
+/*
+ * Memory address and data in one transaction (one USB command). While the previous write
+ * cycle runs the EEPROM does not acknowledge its address: the transaction is sent again,
+ * first after the learned write cycle time, then back to back until acknowledged.
+ * SizeInBytes 0: memory address only (read address set).
+ */
+Brg_StatusT BrgI2cEeprom::WritePage(uint32_t Addr, const uint8_t *pData, uint16_t SizeInBytes)
+{
+	Brg_StatusT brgStat;
+	uint16_t cmdSize, devAddr, sizeWritten;
+	uint64_t nowUs, readyUs, issueUs, nackUs = 0;
+
+	cmdSize = SetAddr(m_pageCmd, Addr);
+	if( SizeInBytes != 0 ) {
+		memcpy(&m_pageCmd[cmdSize], pData, SizeInBytes);
+	}
+	devAddr = (uint16_t)(m_conf.DevAddr | (Addr >> (8 * m_conf.AddrBytes)));
+	if( (m_lastStopUs != 0) && (m_stats.WriteCycleUs != 0) ) {
+		readyUs = m_lastStopUs + m_stats.WriteCycleUs;
+		nowUs = BrgGetMonotonicUs();
+		if( readyUs > nowUs ) {
+			std::this_thread::sleep_for(std::chrono::microseconds(readyUs - nowUs));
+		}
+	}
+	while( true ) {
+		sizeWritten = 0;
+		issueUs = BrgGetMonotonicUs();
+		brgStat = m_brg.WriteI2C(m_pageCmd, devAddr, cmdSize + SizeInBytes, &sizeWritten);
+		if( (brgStat != BRG_I2C_ERR) || (sizeWritten != 0) || (m_lastStopUs == 0) ) {
+			break;
+		}
+		// Address not acknowledged: write cycle in progress
+		m_stats.NackNb++;
+		nackUs = issueUs;
+		if( (issueUs - m_lastStopUs) > (uint64_t)BRG_I2CEEPROM_WRITE_TIMEOUT_MS * 1000 ) {
+			return BRG_TARGET_CMD_TIMEOUT;
+		}
+	}
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	if( m_lastStopUs != 0 ) {
+		if( nackUs != 0 ) {
+			// End of the cycle between the last refused attempt and the accepted one
+			m_stats.WriteCycleUs = (uint32_t)((nackUs + issueUs) / 2 - m_lastStopUs);
+		} else {
+			// Accepted at first attempt: the cycle may be shorter, try earlier next time
+			m_stats.WriteCycleUs -= m_stats.WriteCycleUs / 16;
+		}
+		m_lastStopUs = 0;
+	}
+	if( SizeInBytes != 0 ) {
+		// The write cycle starts at the stop condition
+		m_lastStopUs = BrgGetMonotonicUs();
+		m_stats.PageWriteNb++;
+	}
+	return BRG_NO_ERR;
+}
+
+// Acknowledge polling if a write cycle is in progress and memory address set
+Brg_StatusT BrgI2cEeprom::WaitReady(uint32_t Addr)
+{
+	return WritePage(Addr, NULL, 0);
+}
+
+// Memory address (MSB first) in pCmd, returns its size
+uint16_t BrgI2cEeprom::SetAddr(uint8_t *pCmd, uint32_t Addr) const
+{
+	if( m_conf.AddrBytes == 2 ) {
+		pCmd[0] = (uint8_t)(Addr >> 8);
+		pCmd[1] = (uint8_t)Addr;
+		return 2;
+	}
+	pCmd[0] = (uint8_t)Addr;
+	return 1;
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    brg_latency.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Lock-free latency histogram (log-linear buckets) and host monotonic
+  *          clock used by the bridge statistics.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <chrono>
+#include "brg_latency.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+
+/* Functions Definition ------------------------------------------------------*/
+/**
+ * @ingroup GENERAL
+ * @brief Host monotonic time (not affected by system clock changes).
+ * @retval Time in microseconds since an unspecified origin.
+ */
+uint64_t BrgGetMonotonicUs(void)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Class Functions Definition ------------------------------------------------*/
+BrgLatencyHist::BrgLatencyHist(void)
+{
+	Reset();
+}
+
+/*
+ * Bucket index of a value: exact below BRG_LAT_SUB_BUCKETS, then
+ * BRG_LAT_SUB_BUCKETS linear buckets per power of two.
+ */
+uint32_t BrgLatencyHist::BucketIndex(uint64_t ValueUs)
+{
+	uint32_t msb = 0;
+	uint64_t val;
+
+	if( ValueUs < BRG_LAT_SUB_BUCKETS ) {
+		return (uint32_t)ValueUs;
+	}
+	val = ValueUs;
+	while( val > 1 ) {
+		val >>= 1;
+		msb++;
+	}
+	if( msb > BRG_LAT_MAX_MSB ) {
+		return BRG_LAT_BUCKETS - 1;
+	}
+	// (ValueUs >> shift) is in [BRG_LAT_SUB_BUCKETS, 2*BRG_LAT_SUB_BUCKETS[
+	return (msb - BRG_LAT_SUB_BUCKET_BITS + 1) * BRG_LAT_SUB_BUCKETS +
+	       (uint32_t)((ValueUs >> (msb - BRG_LAT_SUB_BUCKET_BITS)) - BRG_LAT_SUB_BUCKETS);
+}
+
+/*
+ * Highest value counted in the given bucket
+ */
+uint64_t BrgLatencyHist::BucketUpperValue(uint32_t Index)
+{
+	uint32_t msb, sub;
+	uint64_t lower;
+
+	if( Index < BRG_LAT_SUB_BUCKETS ) {
+		return Index;
+	}
+	msb = Index / BRG_LAT_SUB_BUCKETS + BRG_LAT_SUB_BUCKET_BITS - 1;
+	sub = Index % BRG_LAT_SUB_BUCKETS;
+	lower = ((uint64_t)(BRG_LAT_SUB_BUCKETS + sub)) << (msb - BRG_LAT_SUB_BUCKET_BITS);
+	return lower + (((uint64_t)1) << (msb - BRG_LAT_SUB_BUCKET_BITS)) - 1;
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Record one sample. Lock-free, may be called concurrently from several threads.
+ * @param[in]  ValueUs  Sample value in microseconds.
+ */
+void BrgLatencyHist::Record(uint64_t ValueUs)
+{
+	uint64_t prev;
+
+	m_buckets[BucketIndex(ValueUs)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sumUs.fetch_add(ValueUs, std::memory_order_relaxed);
+
+	prev = m_maxUs.load(std::memory_order_relaxed);
+	while( (ValueUs > prev) &&
+	       !m_maxUs.compare_exchange_weak(prev, ValueUs, std::memory_order_relaxed) ) {
+	}
+	prev = m_minUs.load(std::memory_order_relaxed);
+	while( (ValueUs < prev) &&
+	       !m_minUs.compare_exchange_weak(prev, ValueUs, std::memory_order_relaxed) ) {
+	}
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Clear all recorded samples. Not atomic with respect to concurrent Record() calls.
+ */
+void BrgLatencyHist::Reset(void)
+{
+	for( int i = 0; i < BRG_LAT_BUCKETS; i++ ) {
+		m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+	m_count.store(0, std::memory_order_relaxed);
+	m_sumUs.store(0, std::memory_order_relaxed);
+	m_minUs.store(UINT64_MAX, std::memory_order_relaxed);
+	m_maxUs.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Get a percentile of the recorded samples.
+ * @param[in]  Percentile  Percentile to compute (0.0 to 100.0).
+ * @retval Upper bound of the bucket holding the percentile (clamped to the max value),
+ *         0 if no sample recorded.
+ */
+uint64_t BrgLatencyHist::GetPercentile(double Percentile) const
+{
+	uint64_t count, target, cumul = 0;
+	uint64_t maxUs = m_maxUs.load(std::memory_order_relaxed);
+
+	count = m_count.load(std::memory_order_relaxed);
+	if( count == 0 ) {
+		return 0;
+	}
+	if( Percentile < 0.0 ) {
+		Percentile = 0.0;
+	} else if( Percentile > 100.0 ) {
+		Percentile = 100.0;
+	}
+	target = (uint64_t)((Percentile * (double)count) / 100.0 + 0.5);
+	if( target == 0 ) {
+		target = 1;
+	}
+	for( uint32_t i = 0; i < BRG_LAT_BUCKETS; i++ ) {
+		cumul += m_buckets[i].load(std::memory_order_relaxed);
+		if( cumul >= target ) {
+			uint64_t upper = BucketUpperValue(i);
+			return (upper < maxUs) ? upper : maxUs;
+		}
+	}
+	return maxUs;
+}
+
+/**
+ * @ingroup GENERAL
+ * @brief Get count, min, max, mean and main percentiles in one call.
+ * @param[out] pSummary  Filled with the current histogram values.
+ */
+void BrgLatencyHist::GetSummary(Brg_LatencySummaryT *pSummary) const
+{
+	if( pSummary == NULL ) {
+		return;
+	}
+	pSummary->Count = m_count.load(std::memory_order_relaxed);
+	if( pSummary->Count == 0 ) {
+		pSummary->MinUs = 0;
+		pSummary->MaxUs = 0;
+		pSummary->MeanUs = 0.0;
+	} else {
+		pSummary->MinUs = m_minUs.load(std::memory_order_relaxed);
+		pSummary->MaxUs = m_maxUs.load(std::memory_order_relaxed);
+		pSummary->MeanUs = (double)m_sumUs.load(std::memory_order_relaxed) / (double)pSummary->Count;
+	}
+	pSummary->P50Us = GetPercentile(50.0);
+	pSummary->P90Us = GetPercentile(90.0);
+	pSummary->P99Us = GetPercentile(99.0);
+	pSummary->P999Us = GetPercentile(99.9);
+}
+
+/**********************************END OF FILE*********************************/
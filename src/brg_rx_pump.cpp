@@ -0,0 +1,264 @@
+/**
+  ******************************************************************************
+  * @file    brg_rx_pump.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   CAN receive pump thread with a drain rate adapting to the traffic
+  *          and to the Rx buffer overruns reported by the bridge.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <chrono>
+#include "brg_rx_pump.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgRxPump constructor
+ * @param[in]  Bridge    Opened Brg instance polled by the pump thread.
+ * @param[in]  Callback  Called by the pump thread with the frames read (mandatory).
+ * @param[in]  pContext  User pointer given back to Callback.
+ * @param[in]  pConf     Drain rate limits, NULL for the BRG_RXPUMP_DEFAULT_xxx values
+ *                       (inconsistent limits are corrected).
+ */
+BrgRxPump::BrgRxPump(Brg &Bridge, Brg_RxPumpCallbackT Callback, void *pContext, const Brg_RxPumpConfT *pConf):
+	m_brg(Bridge), m_callback(Callback), m_pContext(pContext), m_bRunning(false), m_bStopReq(false),
+	m_pollNb(0), m_frameNb(0), m_fifoOverrunNb(0), m_buffOverrunNb(0), m_errorNb(0),
+	m_escalationNb(0), m_backoffNb(0)
+{
+	if( pConf != NULL ) {
+		m_conf = *pConf;
+	} else {
+		m_conf.MinIntervalUs = BRG_RXPUMP_DEFAULT_MIN_INTERVAL_US;
+		m_conf.MaxIntervalUs = BRG_RXPUMP_DEFAULT_MAX_INTERVAL_US;
+		m_conf.MinBatch = BRG_RXPUMP_DEFAULT_MIN_BATCH;
+		m_conf.MaxBatch = BRG_RXPUMP_DEFAULT_MAX_BATCH;
+		m_conf.QuietPollNb = BRG_RXPUMP_DEFAULT_QUIET_POLL_NB;
+	}
+	if( m_conf.MaxBatch > BRG_RXPUMP_MAX_BATCH ) {
+		m_conf.MaxBatch = BRG_RXPUMP_MAX_BATCH;
+	}
+	if( m_conf.MinBatch == 0 ) {
+		m_conf.MinBatch = 1;
+	}
+	if( m_conf.MaxBatch < m_conf.MinBatch ) {
+		m_conf.MaxBatch = m_conf.MinBatch;
+	}
+	if( m_conf.MaxIntervalUs < m_conf.MinIntervalUs ) {
+		m_conf.MaxIntervalUs = m_conf.MinIntervalUs;
+	}
+	m_pCanMsg = new Brg_CanRxMsgT[m_conf.MaxBatch];
+	m_pData = new uint8_t[m_conf.MaxBatch * 8];
+	m_pFrames = new Brg_RxFrameT[m_conf.MaxBatch];
+	// Least aggressive level until traffic shows up
+	m_intervalUs.store(m_conf.MaxIntervalUs);
+	m_batch.store(m_conf.MinBatch);
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgRxPump destructor: stops the pump thread.
+ */
+BrgRxPump::~BrgRxPump(void)
+{
+	Stop();
+	delete[] m_pCanMsg;
+	delete[] m_pData;
+	delete[] m_pFrames;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Start the pump thread.
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_PARAM_ERR If no callback
+ * @retval #BRG_CMD_NOT_ALLOWED If already started
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgRxPump::Start(void)
+{
+	if( m_brg.GetIsStlinkConnected() == false ) {
+		return BRG_NO_STLINK;
+	}
+	if( m_callback == NULL ) {
+		return BRG_PARAM_ERR;
+	}
+	if( m_bRunning.load() == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	m_bStopReq.store(false);
+	m_bRunning.store(true);
+	m_pump = std::thread(&BrgRxPump::PumpThread, this);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Stop the pump thread (messages still in the STLink are not read).
+ * @retval #BRG_NO_ERR If no error (also if not started)
+ */
+Brg_StatusT BrgRxPump::Stop(void)
+{
+	if( m_bRunning.load() == false ) {
+		return BRG_NO_ERR;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopReq.store(true);
+		m_wakeCond.notify_one();
+	}
+	if( m_pump.joinable() ) {
+		m_pump.join();
+	}
+	m_bRunning.store(false);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get the pump statistics and current drain level. Can be called from any thread.
+ * @param[out] pStats  Statistics.
+ */
+void BrgRxPump::GetStats(Brg_RxPumpStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	pStats->PollNb = m_pollNb.load(std::memory_order_relaxed);
+	pStats->FrameNb = m_frameNb.load(std::memory_order_relaxed);
+	pStats->FifoOverrunNb = m_fifoOverrunNb.load(std::memory_order_relaxed);
+	pStats->BuffOverrunNb = m_buffOverrunNb.load(std::memory_order_relaxed);
+	pStats->ErrorNb = m_errorNb.load(std::memory_order_relaxed);
+	pStats->EscalationNb = m_escalationNb.load(std::memory_order_relaxed);
+	pStats->BackoffNb = m_backoffNb.load(std::memory_order_relaxed);
+	pStats->IntervalUs = m_intervalUs.load(std::memory_order_relaxed);
+	pStats->Batch = m_batch.load(std::memory_order_relaxed);
+}
+
+// One step towards MinIntervalUs/MaxBatch
+void BrgRxPump::Escalate(void)
+{
+	uint32_t intervalUs = m_intervalUs.load(std::memory_order_relaxed);
+	uint32_t batch = m_batch.load(std::memory_order_relaxed);
+
+	if( (intervalUs == m_conf.MinIntervalUs) && (batch == m_conf.MaxBatch) ) {
+		return;
+	}
+	intervalUs /= 2;
+	if( intervalUs < m_conf.MinIntervalUs ) {
+		intervalUs = m_conf.MinIntervalUs;
+	}
+	batch *= 2;
+	if( batch > m_conf.MaxBatch ) {
+		batch = m_conf.MaxBatch;
+	}
+	m_intervalUs.store(intervalUs, std::memory_order_relaxed);
+	m_batch.store((uint16_t)batch, std::memory_order_relaxed);
+	m_escalationNb.fetch_add(1, std::memory_order_relaxed);
+}
+
+// One step towards MaxIntervalUs/MinBatch
+void BrgRxPump::BackOff(void)
+{
+	uint32_t intervalUs = m_intervalUs.load(std::memory_order_relaxed);
+	uint32_t batch = m_batch.load(std::memory_order_relaxed);
+
+	if( (intervalUs == m_conf.MaxIntervalUs) && (batch == m_conf.MinBatch) ) {
+		return;
+	}
+	intervalUs = (intervalUs == 0) ? 1 : (intervalUs * 2);
+	if( intervalUs > m_conf.MaxIntervalUs ) {
+		intervalUs = m_conf.MaxIntervalUs;
+	}
+	batch /= 2;
+	if( batch < m_conf.MinBatch ) {
+		batch = m_conf.MinBatch;
+	}
+	m_intervalUs.store(intervalUs, std::memory_order_relaxed);
+	m_batch.store((uint16_t)batch, std::memory_order_relaxed);
+	m_backoffNb.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Pump thread: poll, give the frames to the callback and adapt the drain rate
+ */
+void BrgRxPump::PumpThread(void)
+{
+	Brg_StatusT brgStat;
+	uint16_t pendingNb, readNb, dataSize, frameNb, batch;
+	uint32_t quietNb = 0;
+	bool bBuffOverrun;
+
+	while( m_bStopReq.load() == false ) {
+		batch = m_batch.load(std::memory_order_relaxed);
+		pendingNb = 0;
+		readNb = 0;
+		dataSize = 0;
+		{
+			std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+			brgStat = m_brg.GetRxMsgNbCAN(&pendingNb);
+			if( (brgStat == BRG_NO_ERR) && (pendingNb != 0) ) {
+				readNb = (pendingNb > batch) ? batch : pendingNb;
+				brgStat = m_brg.GetRxMsgCAN(m_pCanMsg, readNb, m_pData, readNb * 8, &dataSize);
+			}
+		}
+		m_pollNb.fetch_add(1, std::memory_order_relaxed);
+
+		bBuffOverrun = false;
+		if( (brgStat == BRG_NO_ERR) || (brgStat == BRG_OVERRUN_ERR) ) {
+			for( uint16_t i = 0; i < readNb; i++ ) {
+				if( m_pCanMsg[i].Overrun == CAN_RX_BUFF_OVERRUN ) {
+					m_buffOverrunNb.fetch_add(1, std::memory_order_relaxed);
+					bBuffOverrun = true;
+				} else if( m_pCanMsg[i].Overrun == CAN_RX_FIFO_OVERRUN ) {
+					m_fifoOverrunNb.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			if( readNb != 0 ) {
+				frameNb = BrgFramesFromCAN(m_pCanMsg, readNb, m_pData, dataSize, m_pFrames);
+				m_frameNb.fetch_add(frameNb, std::memory_order_relaxed);
+				m_callback(m_pContext, m_pFrames, frameNb);
+			}
+		} else {
+			m_errorNb.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Adapt the drain rate
+		if( (bBuffOverrun == true) || (pendingNb > readNb) ) {
+			Escalate();
+			quietNb = 0;
+		} else if( readNb < (batch + 3) / 4 ) {
+			quietNb++;
+			if( quietNb >= m_conf.QuietPollNb ) {
+				BackOff();
+				quietNb = 0;
+			}
+		} else {
+			quietNb = 0;
+		}
+		if( pendingNb > readNb ) {
+			continue; // backlog: poll again at once
+		}
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		if( m_bStopReq.load() == false ) {
+			m_wakeCond.wait_for(lock, std::chrono::microseconds(m_intervalUs.load(std::memory_order_relaxed)));
+		}
+	}
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,788 @@
+/**
+  ******************************************************************************
+  * @file    brg_shm_bus.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Shared-memory frame bus: frames published by the process owning the
+  *          STLink to local reader processes, transmit requests in return.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <stdio.h>
+#include <new>
+#include <mutex>
+#ifdef WIN32 //Defined for applications for Win32 and Win64.
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif // WIN32
+#include "brg_shm_bus.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+#define BRG_SHMBUS_MAGIC   0x42475242 // "BRGB"
+#define BRG_SHMBUS_VERSION 3 // 3: transmit cells confirmed by CAS before being filled
+
+/* Private macros ------------------------------------------------------------*/
+// Transmit cell Sequence for position pos: free (claimable), confirmed by its client and
+// being filled, ready for the owner. Read or skipped: free for pos + TxSlotNb.
+#define TX_FREE(pos)    (4*(uint64_t)(pos))
+#define TX_WRITING(pos) (4*(uint64_t)(pos) + 1)
+#define TX_READY(pos)   (4*(uint64_t)(pos) + 2)
+
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgShmBus constructor, Create() or Open() to be called before use.
+ */
+BrgShmBus::BrgShmBus(void):
+	m_pHeader(NULL), m_pRxSlots(NULL), m_pTxCells(NULL), m_rxMask(0), m_txMask(0), m_bOwner(false),
+	m_clientId(0), m_cursor(0), m_mapSize(0),
+#ifdef WIN32 //Defined for applications for Win32 and Win64.
+	m_hMapping(NULL),
+#else
+	m_ownerFd(-1),
+#endif
+	m_txStallPos(0), m_txStallUs(0),
+	m_readNb(0), m_lostNb(0), m_submittedNb(0), m_rejectedNb(0), m_txWrittenNb(0), m_txErrorNb(0),
+	m_txSkippedNb(0)
+{
+	m_name[0] = 0;
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgShmBus destructor: unmaps the bus (and removes it for the owner).
+ */
+BrgShmBus::~BrgShmBus(void)
+{
+	Close();
+}
+
+/**
+ * @ingroup CAN
+ * @brief Create the bus (owner process). The owner keeps the shared memory object locked
+ *        until Close(): a bus of the same name is replaced only if its lock is free (owner
+ *        exited without Close()), otherwise it is in use by a live owner. Where shared
+ *        memory objects cannot be locked an existing bus is never replaced. On Windows the
+ *        mapping disappears with the last process using it.
+ * @param[in]  pName     Bus name (letters, digits and '_', less than #BRG_SHMBUS_NAME_MAX_LEN).
+ * @param[in]  RxSlotNb  Frame ring size (rounded up to a power of 2): frames a reader may
+ *                       be late before losing some.
+ * @param[in]  TxSlotNb  Transmit request ring size (rounded up to a power of 2).
+ *
+ * @retval #BRG_PARAM_ERR If invalid name or size
+ * @retval #BRG_CMD_NOT_ALLOWED If this instance is already created or opened
+ * @retval #BRG_PERMISSION_ERR If a bus of this name is in use by another owner
+ * @retval #BRG_MEM_ALLOC_ERR If the shared memory could not be created
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::Create(const char *pName, uint32_t RxSlotNb, uint32_t TxSlotNb)
+{
+	Brg_StatusT brgStat;
+	uint64_t rxNb = 1, txNb = 1, totalSize, i;
+
+	if( (RxSlotNb == 0) || (TxSlotNb == 0) || (RxSlotNb > 0x1000000) || (TxSlotNb > 0x1000000) ) {
+		return BRG_PARAM_ERR;
+	}
+	while( rxNb < RxSlotNb ) {
+		rxNb <<= 1;
+	}
+	while( txNb < TxSlotNb ) {
+		txNb <<= 1;
+	}
+	totalSize = sizeof(ShmHeaderT) + rxNb*sizeof(RxSlotT) + txNb*sizeof(TxCellT);
+	if( totalSize > 0xFFFFFFFF ) {
+		return BRG_PARAM_ERR;
+	}
+	brgStat = Map(pName, true, (uint32_t)totalSize);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+
+	// Lay out the shared memory, Magic written last
+	m_pHeader = new (m_pHeader) ShmHeaderT;
+	m_pHeader->Version = BRG_SHMBUS_VERSION;
+	m_pHeader->TotalSize = (uint32_t)totalSize;
+	m_pHeader->RxSlotSize = sizeof(RxSlotT);
+	m_pHeader->TxCellSize = sizeof(TxCellT);
+	m_pHeader->RxSlotNb = (uint32_t)rxNb;
+	m_pHeader->TxSlotNb = (uint32_t)txNb;
+	m_pHeader->ClientNb.store(1);
+	m_pHeader->RxHead.store(0);
+	m_pHeader->TxEnqueuePos.store(0);
+	m_pHeader->TxDequeuePos.store(0);
+	m_pRxSlots = (RxSlotT*)(m_pHeader + 1);
+	m_pTxCells = (TxCellT*)(m_pRxSlots + rxNb);
+	for( i=0; i<rxNb; i++ ) {
+		new (&m_pRxSlots[i].Sequence) std::atomic<uint64_t>(0);
+	}
+	for( i=0; i<txNb; i++ ) {
+		new (&m_pTxCells[i].Sequence) std::atomic<uint64_t>(TX_FREE(i));
+	}
+	m_rxMask = rxNb - 1;
+	m_txMask = txNb - 1;
+	m_bOwner = true;
+	m_clientId = 0;
+	m_cursor = 0;
+	m_txStallUs = 0;
+	std::atomic_thread_fence(std::memory_order_release);
+	m_pHeader->Magic = BRG_SHMBUS_MAGIC;
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Open the bus created by the owner process, reading starts with the next frame
+ *        published.
+ * @param[in]  pName  Bus name given to Create().
+ *
+ * @retval #BRG_PARAM_ERR If invalid name
+ * @retval #BRG_CMD_NOT_ALLOWED If this instance is already created or opened
+ * @retval #BRG_NO_DEVICE If no bus of this name
+ * @retval #BRG_NOT_SUPPORTED If the bus was created by another library version or its
+ *         header is inconsistent
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::Open(const char *pName)
+{
+	Brg_StatusT brgStat;
+	uint32_t rxNb, txNb;
+
+	brgStat = Map(pName, false, 0);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	if( (m_pHeader->Magic != BRG_SHMBUS_MAGIC) || (m_pHeader->Version != BRG_SHMBUS_VERSION) ||
+	    (m_pHeader->RxSlotSize != sizeof(RxSlotT)) || (m_pHeader->TxCellSize != sizeof(TxCellT)) ) {
+		Close();
+		return BRG_NOT_SUPPORTED;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	// Ring sizes used as masks: powers of 2 filling exactly TotalSize, within the mapping
+	rxNb = m_pHeader->RxSlotNb;
+	txNb = m_pHeader->TxSlotNb;
+	if( (rxNb == 0) || ((rxNb & (rxNb - 1)) != 0) || (txNb == 0) || ((txNb & (txNb - 1)) != 0) ||
+	    ((uint64_t)m_pHeader->TotalSize != sizeof(ShmHeaderT) + (uint64_t)rxNb*sizeof(RxSlotT) +
+	                                        (uint64_t)txNb*sizeof(TxCellT)) ||
+	    (m_pHeader->TotalSize > m_mapSize) ) {
+		Close();
+		return BRG_NOT_SUPPORTED;
+	}
+	m_pRxSlots = (RxSlotT*)(m_pHeader + 1);
+	m_pTxCells = (TxCellT*)(m_pRxSlots + m_pHeader->RxSlotNb);
+	m_rxMask = m_pHeader->RxSlotNb - 1;
+	m_txMask = m_pHeader->TxSlotNb - 1;
+	m_bOwner = false;
+	m_clientId = m_pHeader->ClientNb.fetch_add(1);
+	m_cursor = m_pHeader->RxHead.load(std::memory_order_acquire);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Unmap the bus, the owner also removes its name (opened clients keep their
+ *        mapping until they close it).
+ */
+void BrgShmBus::Close(void)
+{
+	if( m_pHeader == NULL ) {
+		return;
+	}
+#ifdef WIN32 //Defined for applications for Win32 and Win64.
+	UnmapViewOfFile(m_pHeader);
+	CloseHandle((HANDLE)m_hMapping);
+	m_hMapping = NULL;
+#else
+	munmap(m_pHeader, m_mapSize);
+	if( m_ownerFd >= 0 ) {
+		// Name removed while the object is still locked: no creator can take it meanwhile
+		shm_unlink(m_name);
+		close(m_ownerFd);
+		m_ownerFd = -1;
+	}
+#endif
+	m_pHeader = NULL;
+	m_pRxSlots = NULL;
+	m_pTxCells = NULL;
+	m_bOwner = false;
+	m_mapSize = 0;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Publish frames on the bus (owner only), never waits for the readers.
+ * @param[in]  pFrames    Frames in reception (or write) order.
+ * @param[in]  FrameNb    Number of frames.
+ * @param[in]  Direction  Received frames or frames written by the owner.
+ * @param[in]  SourceId   #BRG_SHMBUS_TX: requester of the frames (0: owner).
+ *
+ * @retval #BRG_PARAM_ERR If NULL pointer
+ * @retval #BRG_CMD_NOT_ALLOWED If not the owner
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::Publish(const Brg_RxFrameT *pFrames, uint32_t FrameNb, Brg_ShmDirT Direction,
+                               uint32_t SourceId)
+{
+	RxSlotT *pSlot;
+	uint64_t pos;
+	uint32_t i;
+
+	if( (pFrames == NULL) && (FrameNb != 0) ) {
+		return BRG_PARAM_ERR;
+	}
+	if( (m_pHeader == NULL) || (m_bOwner == false) ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	pos = m_pHeader->RxHead.load(std::memory_order_relaxed);
+	for( i=0; i<FrameNb; i++, pos++ ) {
+		pSlot = &m_pRxSlots[pos & m_rxMask];
+		// Odd sequence: readers of the previous frame of this slot see it overwritten
+		pSlot->Sequence.store(2*pos + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		pSlot->Frame.Direction = Direction;
+		pSlot->Frame.SourceId = SourceId;
+		pSlot->Frame.Frame = pFrames[i];
+		pSlot->Sequence.store(2*pos + 2, std::memory_order_release);
+	}
+	m_pHeader->RxHead.store(pos, std::memory_order_release);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Write the pending transmit requests of the clients (owner only) and publish
+ *        them as #BRG_SHMBUS_TX frames. Holds Brg::GetTransactionLock() around each write.
+ * @param[in]  Bridge  Opened Brg, CAN or FDCAN initialized.
+ * @param[in]  MaxNb   Max number of requests written by this call.
+ * @retval Number of requests taken from the ring (written or failed, see GetStats()).
+ */
+uint32_t BrgShmBus::ServiceTx(Brg &Bridge, uint32_t MaxNb)
+{
+	Brg_StatusT brgStat;
+	Brg_TxFrameT txFrame;
+	Brg_RxFrameT frame;
+	uint32_t sourceId, nb = 0;
+
+	if( (m_pHeader == NULL) || (m_bOwner == false) ) {
+		return 0;
+	}
+	while( (nb < MaxNb) && (PopTx(&sourceId, &txFrame) == true) ) {
+		nb++;
+		{
+			std::lock_guard<std::recursive_mutex> lock(Bridge.GetTransactionLock());
+			if( txFrame.bIsFdcan == true ) {
+				brgStat = Bridge.WriteMsgFDCAN(&txFrame.FdcanMsg, txFrame.Data, txFrame.SizeInBytes);
+			} else {
+				brgStat = Bridge.WriteMsgCAN(&txFrame.CanMsg, txFrame.Data, txFrame.SizeInBytes);
+			}
+		}
+		if( brgStat != BRG_NO_ERR ) {
+			m_txErrorNb++;
+			continue;
+		}
+		m_txWrittenNb++;
+		memset(&frame, 0, sizeof(frame));
+		frame.bIsFdcan = txFrame.bIsFdcan;
+		if( txFrame.bIsFdcan == true ) {
+			frame.IDE = txFrame.FdcanMsg.IDE;
+			frame.ID = txFrame.FdcanMsg.ID;
+			frame.RTR = txFrame.FdcanMsg.RTR;
+			frame.DLC = txFrame.FdcanMsg.DLC;
+		} else {
+			frame.IDE = txFrame.CanMsg.IDE;
+			frame.ID = txFrame.CanMsg.ID;
+			frame.RTR = txFrame.CanMsg.RTR;
+			frame.DLC = (txFrame.CanMsg.RTR == CAN_DATA_FRAME) ? txFrame.SizeInBytes : txFrame.CanMsg.DLC;
+		}
+		frame.SizeInBytes = txFrame.SizeInBytes;
+		memcpy(frame.Data, txFrame.Data, txFrame.SizeInBytes);
+		frame.Overrun = CAN_RX_NO_OVERRUN;
+		frame.RxTimeUs = BrgGetMonotonicUs();
+		Publish(&frame, 1, BRG_SHMBUS_TX, sourceId);
+	}
+	return nb;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Next frame in the shared memory (zero-copy), valid until Release().
+ *        Frames overwritten before being read are skipped.
+ * @retval Frame, NULL if no new frame or bus not opened.
+ */
+const Brg_ShmFrameT* BrgShmBus::Peek(void)
+{
+	RxSlotT *pSlot;
+	uint64_t head;
+
+	if( m_pHeader == NULL ) {
+		return NULL;
+	}
+	for( ;; ) {
+		head = m_pHeader->RxHead.load(std::memory_order_acquire);
+		if( m_cursor >= head ) {
+			return NULL;
+		}
+		if( head - m_cursor > m_rxMask + 1 ) {
+			Resync(head);
+			continue;
+		}
+		pSlot = &m_pRxSlots[m_cursor & m_rxMask];
+		if( pSlot->Sequence.load(std::memory_order_acquire) == 2*m_cursor + 2 ) {
+			return &pSlot->Frame;
+		}
+		// Being overwritten by a newer frame
+		Resync(m_pHeader->RxHead.load(std::memory_order_acquire));
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Done with the frame given by Peek(), move to the next one.
+ * @retval true if the frame was not overwritten while in use, false if it was (its content
+ *         is unreliable, the reader is moved past the overwritten frames).
+ */
+bool BrgShmBus::Release(void)
+{
+	RxSlotT *pSlot;
+
+	if( (m_pHeader == NULL) || (m_cursor >= m_pHeader->RxHead.load(std::memory_order_acquire)) ) {
+		return false;
+	}
+	pSlot = &m_pRxSlots[m_cursor & m_rxMask];
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if( pSlot->Sequence.load(std::memory_order_relaxed) != 2*m_cursor + 2 ) {
+		Resync(m_pHeader->RxHead.load(std::memory_order_acquire));
+		return false;
+	}
+	m_cursor++;
+	m_readNb++;
+	return true;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Copy the next frames.
+ * @param[out] pFrames  Table of MaxNb frames.
+ * @param[in]  MaxNb    Max number of frames read.
+ * @param[out] pReadNb  Number of frames copied in pFrames.
+ *
+ * @retval #BRG_PARAM_ERR If NULL pointer
+ * @retval #BRG_CMD_NOT_ALLOWED If the bus is not opened
+ * @retval #BRG_OVERRUN_ERR If frames were lost since the previous read (frames still given)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::Read(Brg_ShmFrameT *pFrames, uint32_t MaxNb, uint32_t *pReadNb)
+{
+	const Brg_ShmFrameT *pFrame;
+	uint64_t lostNb;
+
+	if( (pFrames == NULL) || (pReadNb == NULL) ) {
+		return BRG_PARAM_ERR;
+	}
+	*pReadNb = 0;
+	if( m_pHeader == NULL ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	lostNb = m_lostNb;
+	while( (*pReadNb < MaxNb) && ((pFrame = Peek()) != NULL) ) {
+		pFrames[*pReadNb] = *pFrame;
+		if( Release() == true ) {
+			(*pReadNb)++;
+		}
+	}
+	return (m_lostNb != lostNb) ? BRG_OVERRUN_ERR : BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Queue a CAN message for the owner (Brg::WriteMsgCAN()), never waits.
+ * @param[in]  pCanMsg      CAN Tx message header (see Brg::WriteMsgCAN()).
+ * @param[in]  pBuffer      Data field.
+ * @param[in]  SizeInBytes  Data size, max 8.
+ *
+ * @retval #BRG_PARAM_ERR If NULL pointer or invalid size
+ * @retval #BRG_CMD_NOT_ALLOWED If the bus is not opened
+ * @retval #BRG_OVERRUN_ERR If the transmit ring is full (or the request was skipped by the
+ *         owner, see #BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::SubmitCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes)
+{
+	Brg_TxFrameT frame;
+
+	if( (pCanMsg == NULL) || (SizeInBytes > 8) || ((pBuffer == NULL) && (SizeInBytes != 0)) ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(&frame, 0, sizeof(frame));
+	frame.bIsFdcan = false;
+	frame.CanMsg = *pCanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	return Submit(&frame);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Queue an FDCAN message for the owner (Brg::WriteMsgFDCAN()), never waits.
+ * @param[in]  pFdcanMsg    FDCAN Tx message header (see Brg::WriteMsgFDCAN()).
+ * @param[in]  pBuffer      Data field.
+ * @param[in]  SizeInBytes  Data size, max #BRG_TXQ_MAX_DATA_SIZE.
+ *
+ * @retval #BRG_PARAM_ERR If NULL pointer or invalid size
+ * @retval #BRG_CMD_NOT_ALLOWED If the bus is not opened
+ * @retval #BRG_OVERRUN_ERR If the transmit ring is full (or the request was skipped by the
+ *         owner, see #BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgShmBus::SubmitFDCAN(const Brg_FdcanMsgT *pFdcanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes)
+{
+	Brg_TxFrameT frame;
+
+	if( (pFdcanMsg == NULL) || (SizeInBytes > BRG_TXQ_MAX_DATA_SIZE) ||
+	    ((pBuffer == NULL) && (SizeInBytes != 0)) ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(&frame, 0, sizeof(frame));
+	frame.bIsFdcan = true;
+	frame.FdcanMsg = *pFdcanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	return Submit(&frame);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get the bus and instance statistics.
+ * @param[out] pStats  Statistics.
+ */
+void BrgShmBus::GetStats(Brg_ShmBusStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	memset(pStats, 0, sizeof(*pStats));
+	if( m_pHeader != NULL ) {
+		pStats->PublishedNb = m_pHeader->RxHead.load(std::memory_order_relaxed);
+		pStats->ClientNb = m_pHeader->ClientNb.load(std::memory_order_relaxed);
+	}
+	pStats->ReadNb = m_readNb;
+	pStats->LostNb = m_lostNb;
+	pStats->SubmittedNb = m_submittedNb;
+	pStats->RejectedNb = m_rejectedNb;
+	pStats->TxWrittenNb = m_txWrittenNb;
+	pStats->TxErrorNb = m_txErrorNb;
+	pStats->TxSkippedNb = m_txSkippedNb;
+}
+
+/*
+ * Create or open the shared memory object and map it
+ */
+Brg_StatusT BrgShmBus::Map(const char *pName, bool bCreate, uint32_t TotalSize)
+{
+	size_t i, len;
+
+	if( pName == NULL ) {
+		return BRG_PARAM_ERR;
+	}
+	len = strlen(pName);
+	if( (len == 0) || (len + 2 > BRG_SHMBUS_NAME_MAX_LEN) ) {
+		return BRG_PARAM_ERR;
+	}
+	for( i=0; i<len; i++ ) {
+		if( !(((pName[i] >= 'a') && (pName[i] <= 'z')) || ((pName[i] >= 'A') && (pName[i] <= 'Z')) ||
+		      ((pName[i] >= '0') && (pName[i] <= '9')) || (pName[i] == '_')) ) {
+			return BRG_PARAM_ERR;
+		}
+	}
+	if( m_pHeader != NULL ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+#ifdef WIN32 //Defined for applications for Win32 and Win64.
+	char mappingName[BRG_SHMBUS_NAME_MAX_LEN + 8];
+	HANDLE hMapping;
+	void *pView;
+
+	snprintf(mappingName, sizeof(mappingName), "Local\\%s", pName);
+	if( bCreate == true ) {
+		// A stale mapping disappears with its last handle: an existing one is in use
+		hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, TotalSize, mappingName);
+		if( (hMapping != NULL) && (GetLastError() == ERROR_ALREADY_EXISTS) ) {
+			CloseHandle(hMapping);
+			return BRG_PERMISSION_ERR;
+		}
+	} else {
+		hMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName);
+	}
+	if( hMapping == NULL ) {
+		return (bCreate == true) ? BRG_MEM_ALLOC_ERR : BRG_NO_DEVICE;
+	}
+	pView = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if( pView == NULL ) {
+		CloseHandle(hMapping);
+		return BRG_MEM_ALLOC_ERR;
+	}
+	if( bCreate == true ) {
+		m_mapSize = TotalSize;
+	} else {
+		MEMORY_BASIC_INFORMATION memInfo;
+		VirtualQuery(pView, &memInfo, sizeof(memInfo));
+		m_mapSize = memInfo.RegionSize;
+	}
+	m_hMapping = hMapping;
+	m_pHeader = (ShmHeaderT*)pView;
+	snprintf(m_name, sizeof(m_name), "%s", pName);
+#else
+	struct stat shmStat;
+	void *pView;
+	int fd;
+
+	snprintf(m_name, sizeof(m_name), "/%s", pName);
+	if( bCreate == true ) {
+		Brg_StatusT brgStat = CreateObject(&fd);
+		if( brgStat != BRG_NO_ERR ) {
+			return brgStat;
+		}
+		if( ftruncate(fd, TotalSize) != 0 ) {
+			shm_unlink(m_name);
+			close(fd);
+			return BRG_MEM_ALLOC_ERR;
+		}
+	} else {
+		fd = shm_open(m_name, O_RDWR, 0);
+		if( fd < 0 ) {
+			return BRG_NO_DEVICE;
+		}
+	}
+	if( bCreate == false ) {
+		if( (fstat(fd, &shmStat) != 0) || ((size_t)shmStat.st_size < sizeof(ShmHeaderT)) ) {
+			close(fd);
+			return BRG_NOT_SUPPORTED;
+		}
+		TotalSize = (uint32_t)shmStat.st_size;
+	}
+	pView = mmap(NULL, TotalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if( pView == MAP_FAILED ) {
+		if( bCreate == true ) {
+			shm_unlink(m_name);
+		}
+		close(fd);
+		return BRG_MEM_ALLOC_ERR;
+	}
+	if( bCreate == true ) {
+		m_ownerFd = fd; // kept open: its lock marks the bus as in use
+	} else {
+		close(fd);
+	}
+	m_mapSize = TotalSize;
+	m_pHeader = (ShmHeaderT*)pView;
+#endif // WIN32
+	return BRG_NO_ERR;
+}
+
+#ifndef WIN32
+/*
+ * Create the shared memory object m_name (O_EXCL) locked for the owner. An existing object
+ * is removed first only if proven stale: its lock is free (released by the kernel when its
+ * owner exited) while the name still designates it.
+ */
+Brg_StatusT BrgShmBus::CreateObject(int *pFd)
+{
+	int fd, attempt;
+
+	for( attempt = 0; attempt < 2; attempt++ ) {
+		fd = shm_open(m_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+		if( fd >= 0 ) {
+			if( LockAsOwner(fd, true) == false ) {
+				// Removed by another creator that found it unlocked
+				close(fd);
+				return BRG_PERMISSION_ERR;
+			}
+			*pFd = fd;
+			return BRG_NO_ERR;
+		}
+		if( errno != EEXIST ) {
+			return BRG_MEM_ALLOC_ERR;
+		}
+		fd = shm_open(m_name, O_RDWR, 0);
+		if( fd < 0 ) {
+			continue; // removed meanwhile
+		}
+		if( LockAsOwner(fd, false) == false ) {
+			close(fd);
+			return BRG_PERMISSION_ERR; // live owner
+		}
+		shm_unlink(m_name); // lock held: the name cannot designate another object yet
+		close(fd);
+	}
+	return BRG_PERMISSION_ERR;
+}
+
+/*
+ * Lock Fd without waiting and check that m_name still designates it. If the system does
+ * not lock shared memory objects, a new object is taken as is and an existing one is
+ * never considered stale.
+ */
+bool BrgShmBus::LockAsOwner(int Fd, bool bNew)
+{
+	struct stat fdStat, nameStat;
+	int nameFd;
+	bool bSame;
+
+	if( flock(Fd, LOCK_EX | LOCK_NB) != 0 ) {
+		if( (bNew == false) || (errno == EWOULDBLOCK) ) {
+			return false;
+		}
+	}
+	nameFd = shm_open(m_name, O_RDWR, 0);
+	if( nameFd < 0 ) {
+		return false;
+	}
+	bSame = (fstat(Fd, &fdStat) == 0) && (fstat(nameFd, &nameStat) == 0) &&
+	        (fdStat.st_dev == nameStat.st_dev) && (fdStat.st_ino == nameStat.st_ino);
+	close(nameFd);
+	return bSame;
+}
+#endif // WIN32
+
+/*
+ * Consumer side of the transmit ring (owner only). A cell claimed by a client (TxEnqueuePos
+ * moved past it) but not confirmed within BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS is skipped: the
+ * client died or was descheduled between its claim and its confirmation. Skip and
+ * confirmation are both a CAS from TX_FREE(pos), so exactly one of them wins and a late
+ * client never writes the cell. A confirmed cell is never skipped.
+ */
+bool BrgShmBus::PopTx(uint32_t *pSourceId, Brg_TxFrameT *pFrame)
+{
+	TxCellT *pCell;
+	uint64_t pos, seq, nowUs;
+
+	pos = m_pHeader->TxDequeuePos.load(std::memory_order_relaxed);
+	pCell = &m_pTxCells[pos & m_txMask];
+	seq = pCell->Sequence.load(std::memory_order_acquire);
+	while( seq != TX_READY(pos) ) {
+		if( seq == TX_WRITING(pos) ) {
+			m_txStallUs = 0;
+			return false; // confirmed, client copying its request
+		}
+		if( (seq != TX_FREE(pos)) || (m_pHeader->TxEnqueuePos.load(std::memory_order_relaxed) <= pos) ) {
+			m_txStallUs = 0;
+			return false; // empty
+		}
+		// Claimed, not yet confirmed
+		nowUs = BrgGetMonotonicUs();
+		if( (m_txStallUs == 0) || (m_txStallPos != pos) ) {
+			m_txStallPos = pos;
+			m_txStallUs = nowUs;
+			return false;
+		}
+		if( nowUs - m_txStallUs < (uint64_t)BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS*1000 ) {
+			return false;
+		}
+		if( pCell->Sequence.compare_exchange_strong(seq, TX_FREE(pos + m_txMask + 1), std::memory_order_acq_rel) ) {
+			m_txSkippedNb++;
+			m_txStallUs = 0;
+			pos++;
+			m_pHeader->TxDequeuePos.store(pos, std::memory_order_relaxed);
+			pCell = &m_pTxCells[pos & m_txMask];
+			seq = pCell->Sequence.load(std::memory_order_acquire);
+		}
+		// else confirmed meanwhile: seq reloaded by the failed CAS
+	}
+	m_txStallUs = 0;
+	*pSourceId = pCell->SourceId;
+	*pFrame = pCell->Frame;
+	pCell->Sequence.store(TX_FREE(pos + m_txMask + 1), std::memory_order_release);
+	m_pHeader->TxDequeuePos.store(pos + 1, std::memory_order_relaxed);
+	return true;
+}
+
+/*
+ * Producer side of the transmit ring: claim a cell by CAS on TxEnqueuePos, confirm it by
+ * CAS of its Sequence to TX_WRITING (fails if the owner skipped it meanwhile), fill it
+ * from the request prepared beforehand and publish it as TX_READY.
+ */
+Brg_StatusT BrgShmBus::Submit(const Brg_TxFrameT *pFrame)
+{
+	TxCellT *pCell;
+	Brg_TxFrameT frame;
+	uint64_t pos, seq;
+	int64_t diff;
+
+	if( m_pHeader == NULL ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	frame = *pFrame;
+	frame.EnqueueTimeUs = BrgGetMonotonicUs();
+	pos = m_pHeader->TxEnqueuePos.load(std::memory_order_relaxed);
+	for( ;; ) {
+		pCell = &m_pTxCells[pos & m_txMask];
+		seq = pCell->Sequence.load(std::memory_order_acquire);
+		diff = (int64_t)seq - (int64_t)TX_FREE(pos);
+		if( diff == 0 ) {
+			if( m_pHeader->TxEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) {
+				break;
+			}
+		} else if( diff < 0 ) {
+			// Cell not yet released by the owner: ring full
+			m_rejectedNb++;
+			return BRG_OVERRUN_ERR;
+		} else {
+			pos = m_pHeader->TxEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	seq = TX_FREE(pos);
+	if( pCell->Sequence.compare_exchange_strong(seq, TX_WRITING(pos), std::memory_order_acq_rel,
+	                                            std::memory_order_relaxed) == false ) {
+		// Stalled more than BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS: cell skipped by the owner,
+		// possibly reused by another client already
+		m_rejectedNb++;
+		return BRG_OVERRUN_ERR;
+	}
+	pCell->SourceId = m_clientId;
+	pCell->Frame = frame;
+	pCell->Sequence.store(TX_READY(pos), std::memory_order_release);
+	m_submittedNb++;
+	return BRG_NO_ERR;
+}
+
+/*
+ * Reader overtaken by the producer: skip to the oldest frame still in the ring
+ */
+void BrgShmBus::Resync(uint64_t Head)
+{
+	uint64_t oldest;
+
+	oldest = (Head > m_rxMask + 1) ? (Head - m_rxMask) : 0;
+	// Keep one slot of margin: the slot of Head may be being written
+	if( oldest > m_cursor ) {
+		m_lostNb += oldest - m_cursor;
+		m_cursor = oldest;
+	} else {
+		m_lostNb++;
+		m_cursor++;
+	}
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,426 @@
+/**
+  ******************************************************************************
+  * @file    brg_spi_flash.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   SPI NOR flash programmer (probe, erase, program, verify) using the
+  *          SPI bridge.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include "brg_spi_flash.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+// JEDEC SPI NOR commands
+#define SPIFLASH_CMD_READ_ID     0x9F
+#define SPIFLASH_CMD_READ_SR     0x05
+#define SPIFLASH_CMD_WREN        0x06
+#define SPIFLASH_CMD_READ        0x03
+#define SPIFLASH_CMD_READ_4B     0x13
+#define SPIFLASH_CMD_PP          0x02
+#define SPIFLASH_CMD_PP_4B       0x12
+#define SPIFLASH_CMD_SE          0x20
+#define SPIFLASH_CMD_SE_4B       0x21
+
+#define SPIFLASH_SR_WIP          0x01 // Status register: write in progress
+
+#define SPIFLASH_3B_ADDR_MAX_SIZE 0x1000000 // 16 MBytes
+#define SPIFLASH_MAX_SIZE_LOG2    31        // Flash size kept in 32 bits
+#define SPIFLASH_SECTOR_ERASE_US  45000     // Typical sector erase time (poll sizing)
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup SPI
+ * @brief BrgSpiFlash constructor
+ * @param[in]  Bridge      Opened Brg, SPI initialized (master, 8-bit, #SPI_NSS_SOFT).
+ * @param[in]  SpiFreqKHz  SPI clock applied by Brg::InitSPI() (pFinalSpiFreqKHz of
+ *                         Brg::GetSPIbaudratePrescal()), used to size the status polls.
+ */
+BrgSpiFlash::BrgSpiFlash(Brg &Bridge, uint32_t SpiFreqKHz):
+	m_brg(Bridge), m_spiFreqKHz((SpiFreqKHz == 0) ? 1 : SpiFreqKHz), m_bProbed(false)
+{
+	memset(&m_info, 0, sizeof(m_info));
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.PageBusyUs = BRG_SPIFLASH_DEFAULT_PAGE_US;
+}
+
+/**
+ * @ingroup SPI
+ * @brief Read the JEDEC ID of the flash and deduce its size and address mode.
+ *        Capacity byte: 0x10 to 0x1F is log2 of the size in bytes, 0x20 to 0x22 is 64, 128
+ *        and 256 MBytes (e.g. 512 Mbit parts: xx xx 20), 0x32 to 0x3F is log2 + 0x20
+ *        (e.g. xx 25 3A: 512 Mbit).
+ * @param[out] pInfo  Flash identification (may be NULL).
+ * @retval #BRG_TARGET_CMD_ERR If no flash answers (ID 0x000000 or 0xFFFFFF) or unknown capacity
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg SPI errors
+ */
+Brg_StatusT BrgSpiFlash::Probe(Brg_SpiFlashInfoT *pInfo)
+{
+	Brg_StatusT brgStat;
+	uint8_t cmd = SPIFLASH_CMD_READ_ID;
+	uint8_t id[3];
+	uint8_t sizeLog2;
+
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	m_bProbed = false;
+	brgStat = Transfer(&cmd, 1, id, sizeof(id));
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	if( ((id[0] == 0x00) && (id[1] == 0x00) && (id[2] == 0x00)) ||
+	    ((id[0] == 0xFF) && (id[1] == 0xFF) && (id[2] == 0xFF)) ) {
+		return BRG_TARGET_CMD_ERR;
+	}
+	if( (id[2] >= 0x10) && (id[2] <= 0x1F) ) {
+		sizeLog2 = id[2];
+	} else if( (id[2] >= 0x20) && (id[2] <= 0x22) ) {
+		sizeLog2 = id[2] - 0x20 + 26;
+	} else if( (id[2] >= 0x32) && (id[2] <= 0x3F) ) {
+		sizeLog2 = id[2] - 0x20;
+	} else {
+		return BRG_TARGET_CMD_ERR;
+	}
+	if( sizeLog2 > SPIFLASH_MAX_SIZE_LOG2 ) {
+		return BRG_TARGET_CMD_ERR;
+	}
+	memcpy(m_info.JedecId, id, sizeof(id));
+	m_info.SizeInBytes = (uint32_t)1 << sizeLog2;
+	m_info.bAddr4Byte = (m_info.SizeInBytes > SPIFLASH_3B_ADDR_MAX_SIZE);
+	m_bProbed = true;
+	if( pInfo != NULL ) {
+		*pInfo = m_info;
+	}
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup SPI
+ * @brief Read the flash content in one streaming transfer (Brg::ReadStreamSPI()).
+ * @retval #BRG_COM_INIT_NOT_DONE If Probe() not successful
+ * @retval #BRG_PARAM_ERR If NULL pointer or range outside of the flash
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg SPI errors
+ */
+Brg_StatusT BrgSpiFlash::Read(uint32_t Addr, uint8_t *pBuffer, uint32_t SizeInBytes)
+{
+	uint8_t cmd[5];
+	uint8_t cmdSize;
+
+	if( m_bProbed == false ) {
+		return BRG_COM_INIT_NOT_DONE;
+	}
+	if( (pBuffer == NULL) || (Addr > m_info.SizeInBytes) || (SizeInBytes > m_info.SizeInBytes - Addr) ) {
+		return BRG_PARAM_ERR;
+	}
+	if( SizeInBytes == 0 ) {
+		return BRG_NO_ERR;
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	cmdSize = SetCmdAddr(cmd, SPIFLASH_CMD_READ, SPIFLASH_CMD_READ_4B, Addr);
+	return Transfer(cmd, cmdSize, pBuffer, SizeInBytes);
+}
+
+/**
+ * @ingroup SPI
+ * @brief Erase all the sectors (#BRG_SPIFLASH_SECTOR_SIZE) overlapping the given range (none if
+ *        SizeInBytes is 0).
+ * @retval #BRG_COM_INIT_NOT_DONE If Probe() not successful
+ * @retval #BRG_PARAM_ERR If range outside of the flash
+ * @retval #BRG_TARGET_CMD_TIMEOUT If an erase does not end within #BRG_SPIFLASH_ERASE_TIMEOUT_MS
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg SPI errors
+ */
+Brg_StatusT BrgSpiFlash::Erase(uint32_t Addr, uint32_t SizeInBytes)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t sectorAddr;
+
+	if( m_bProbed == false ) {
+		return BRG_COM_INIT_NOT_DONE;
+	}
+	if( (Addr > m_info.SizeInBytes) || (SizeInBytes > m_info.SizeInBytes - Addr) ) {
+		return BRG_PARAM_ERR;
+	}
+	if( SizeInBytes == 0 ) {
+		return BRG_NO_ERR; // no sector overlaps an empty range
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	sectorAddr = Addr - (Addr % BRG_SPIFLASH_SECTOR_SIZE);
+	while( (brgStat == BRG_NO_ERR) && (sectorAddr < Addr + SizeInBytes) ) {
+		brgStat = EraseSector(sectorAddr);
+		sectorAddr += BRG_SPIFLASH_SECTOR_SIZE;
+	}
+	return brgStat;
+}
+
+/**
+ * @ingroup SPI
+ * @brief Write pData at Addr, the rest of the sectors overlapping the range is kept.
+ *        Sectors are erased only when needed and pages already holding the data are skipped.
+ * @param[in]  Addr         Flash address (any alignment).
+ * @param[in]  pData        Data to write.
+ * @param[in]  SizeInBytes  Data size.
+ * @param[in]  bVerify      Read back each modified sector and compare.
+ * @retval #BRG_COM_INIT_NOT_DONE If Probe() not successful
+ * @retval #BRG_PARAM_ERR If NULL pointer or range outside of the flash
+ * @retval #BRG_TARGET_CMD_TIMEOUT If an erase or page program does not end in time
+ * @retval #BRG_VERIF_ERR If the read back data differ
+ * @retval #BRG_NO_ERR If no error
+ * @return Brg SPI errors
+ */
+Brg_StatusT BrgSpiFlash::Program(uint32_t Addr, const uint8_t *pData, uint32_t SizeInBytes, bool bVerify)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t sectorAddr, offset, size, doneSize = 0;
+	uint64_t startUs;
+
+	if( m_bProbed == false ) {
+		return BRG_COM_INIT_NOT_DONE;
+	}
+	if( (pData == NULL) || (Addr > m_info.SizeInBytes) || (SizeInBytes > m_info.SizeInBytes - Addr) ) {
+		return BRG_PARAM_ERR;
+	}
+	std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+	startUs = BrgGetMonotonicUs();
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		offset = (Addr + doneSize) % BRG_SPIFLASH_SECTOR_SIZE;
+		sectorAddr = Addr + doneSize - offset;
+		size = BRG_SPIFLASH_SECTOR_SIZE - offset;
+		if( size > SizeInBytes - doneSize ) {
+			size = SizeInBytes - doneSize;
+		}
+		// Current content, merged with the new data
+		brgStat = Read(sectorAddr, m_sector, BRG_SPIFLASH_SECTOR_SIZE);
+		if( brgStat == BRG_NO_ERR ) {
+			memcpy(m_newSector, m_sector, BRG_SPIFLASH_SECTOR_SIZE);
+			memcpy(&m_newSector[offset], &pData[doneSize], size);
+			brgStat = ProgramSector(sectorAddr, m_newSector, bVerify);
+		}
+		if( brgStat == BRG_NO_ERR ) {
+			doneSize += size;
+		}
+	}
+	m_stats.ProgBytes += doneSize;
+	m_stats.ProgTimeUs += BrgGetMonotonicUs() - startUs;
+	return brgStat;
+}
+
+/**
+ * @ingroup SPI
+ * @brief Get the programming statistics.
+ * @param[out] pStats  Statistics.
+ */
+void BrgSpiFlash::GetStats(Brg_SpiFlashStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	*pStats = m_stats;
+	pStats->BytesPerSec = 0;
+	if( m_stats.ProgTimeUs != 0 ) {
+		pStats->BytesPerSec = m_stats.ProgBytes * 1000000 / m_stats.ProgTimeUs;
+	}
+}
+
+/*
+ * One chip select frame: pTx written then RxSize bytes read, chip select released
+ * also in case of error
+ */
+Brg_StatusT BrgSpiFlash::Transfer(const uint8_t *pTx, uint32_t TxSize, uint8_t *pRx, uint32_t RxSize)
+{
+	Brg_StatusT brgStat, csStat;
+
+	brgStat = m_brg.SetSPIpinCS(SPI_NSS_LOW);
+	if( brgStat != BRG_NO_ERR ) {
+		return brgStat;
+	}
+	if( TxSize != 0 ) {
+		brgStat = m_brg.WriteStreamSPI(pTx, TxSize, NULL);
+	}
+	if( (brgStat == BRG_NO_ERR) && (RxSize != 0) ) {
+		brgStat = m_brg.ReadStreamSPI(pRx, RxSize, NULL);
+	}
+	csStat = m_brg.SetSPIpinCS(SPI_NSS_HIGH);
+	return (brgStat != BRG_NO_ERR) ? brgStat : csStat;
+}
+
+// Write enable latch, needed before each erase or page program
+Brg_StatusT BrgSpiFlash::WriteEnable(void)
+{
+	uint8_t cmd = SPIFLASH_CMD_WREN;
+
+	return Transfer(&cmd, 1, NULL, 0);
+}
+
+/*
+ * Poll the status register until WIP is cleared. The flash sends the status continuously
+ * while chip select is low: one read covers the expected remaining busy time, the bus
+ * keeps running and the end is seen at byte granularity. Long operations sleep first.
+ */
+Brg_StatusT BrgSpiFlash::WaitReady(uint32_t ExpectedUs, uint32_t TimeoutMs, uint32_t *pBusyUs)
+{
+	Brg_StatusT brgStat;
+	uint8_t cmd = SPIFLASH_CMD_READ_SR;
+	uint64_t startUs, pollStartUs, elapsedUs, remainUs, pollSize;
+	uint32_t maxPollUs;
+
+	startUs = BrgGetMonotonicUs();
+	maxPollUs = (uint32_t)((uint64_t)BRG_SPIFLASH_MAX_POLL_SIZE * 8000 / m_spiFreqKHz);
+	while( true ) {
+		elapsedUs = BrgGetMonotonicUs() - startUs;
+		remainUs = (ExpectedUs > elapsedUs) ? (ExpectedUs - elapsedUs) : 0;
+		if( remainUs > 2 * (uint64_t)maxPollUs ) {
+			// Nothing to learn before the end of the expected time
+			std::this_thread::sleep_for(std::chrono::microseconds(remainUs - maxPollUs));
+			remainUs = maxPollUs;
+		}
+		pollSize = remainUs * m_spiFreqKHz / 8000;
+		if( pollSize < 1 ) {
+			pollSize = 1;
+		} else if( pollSize > BRG_SPIFLASH_MAX_POLL_SIZE ) {
+			pollSize = BRG_SPIFLASH_MAX_POLL_SIZE;
+		}
+		pollStartUs = BrgGetMonotonicUs();
+		brgStat = Transfer(&cmd, 1, m_poll, (uint32_t)pollSize);
+		m_stats.PollNb++;
+		if( brgStat != BRG_NO_ERR ) {
+			return brgStat;
+		}
+		for( uint32_t i = 0; i < pollSize; i++ ) {
+			if( (m_poll[i] & SPIFLASH_SR_WIP) == 0 ) {
+				if( pBusyUs != NULL ) {
+					*pBusyUs = (uint32_t)(pollStartUs - startUs + (uint64_t)i * 8000 / m_spiFreqKHz);
+				}
+				return BRG_NO_ERR;
+			}
+		}
+		if( (BrgGetMonotonicUs() - startUs) > (uint64_t)TimeoutMs * 1000 ) {
+			return BRG_TARGET_CMD_TIMEOUT;
+		}
+	}
+}
+
+// Sector erase and wait for its end
+Brg_StatusT BrgSpiFlash::EraseSector(uint32_t Addr)
+{
+	Brg_StatusT brgStat;
+	uint8_t cmd[5];
+	uint8_t cmdSize;
+
+	brgStat = WriteEnable();
+	if( brgStat == BRG_NO_ERR ) {
+		cmdSize = SetCmdAddr(cmd, SPIFLASH_CMD_SE, SPIFLASH_CMD_SE_4B, Addr);
+		brgStat = Transfer(cmd, cmdSize, NULL, 0);
+	}
+	if( brgStat == BRG_NO_ERR ) {
+		brgStat = WaitReady(SPIFLASH_SECTOR_ERASE_US, BRG_SPIFLASH_ERASE_TIMEOUT_MS, NULL);
+	}
+	if( brgStat == BRG_NO_ERR ) {
+		m_stats.SectorEraseNb++;
+	}
+	return brgStat;
+}
+
+// Page program (command and data in one write) and wait for its end
+Brg_StatusT BrgSpiFlash::ProgramPage(uint32_t Addr, const uint8_t *pData)
+{
+	Brg_StatusT brgStat;
+	uint8_t cmdSize;
+	uint32_t busyUs;
+
+	brgStat = WriteEnable();
+	if( brgStat == BRG_NO_ERR ) {
+		cmdSize = SetCmdAddr(m_pageCmd, SPIFLASH_CMD_PP, SPIFLASH_CMD_PP_4B, Addr);
+		memcpy(&m_pageCmd[cmdSize], pData, BRG_SPIFLASH_PAGE_SIZE);
+		brgStat = Transfer(m_pageCmd, cmdSize + BRG_SPIFLASH_PAGE_SIZE, NULL, 0);
+	}
+	if( brgStat == BRG_NO_ERR ) {
+		brgStat = WaitReady(m_stats.PageBusyUs, BRG_SPIFLASH_PAGE_TIMEOUT_MS, &busyUs);
+	}
+	if( brgStat == BRG_NO_ERR ) {
+		m_stats.PageBusyUs = (m_stats.PageBusyUs + busyUs) / 2; // smoothed
+		m_stats.PageProgNb++;
+	}
+	return brgStat;
+}
+
+/*
+ * m_sector: current content of the sector, pNewData: wanted content.
+ * Erase only if a bit must be set, program only the pages that differ.
+ */
+Brg_StatusT BrgSpiFlash::ProgramSector(uint32_t SectorAddr, const uint8_t *pNewData, bool bVerify)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	bool bErase = false;
+	uint32_t pageOffset;
+
+	if( memcmp(m_sector, pNewData, BRG_SPIFLASH_SECTOR_SIZE) == 0 ) {
+		m_stats.SectorSkipNb++;
+		m_stats.PageSkipNb += BRG_SPIFLASH_SECTOR_SIZE / BRG_SPIFLASH_PAGE_SIZE;
+		return BRG_NO_ERR;
+	}
+	for( uint32_t i = 0; i < BRG_SPIFLASH_SECTOR_SIZE; i++ ) {
+		if( (m_sector[i] & pNewData[i]) != pNewData[i] ) {
+			bErase = true;
+			break;
+		}
+	}
+	if( bErase == true ) {
+		brgStat = EraseSector(SectorAddr);
+		memset(m_sector, 0xFF, BRG_SPIFLASH_SECTOR_SIZE);
+	} else {
+		m_stats.SectorSkipNb++;
+	}
+	for( pageOffset = 0; (brgStat == BRG_NO_ERR) && (pageOffset < BRG_SPIFLASH_SECTOR_SIZE);
+	     pageOffset += BRG_SPIFLASH_PAGE_SIZE ) {
+		if( memcmp(&m_sector[pageOffset], &pNewData[pageOffset], BRG_SPIFLASH_PAGE_SIZE) == 0 ) {
+			m_stats.PageSkipNb++;
+		} else {
+			brgStat = ProgramPage(SectorAddr + pageOffset, &pNewData[pageOffset]);
+		}
+	}
+	if( (brgStat == BRG_NO_ERR) && (bVerify == true) ) {
+		brgStat = Read(SectorAddr, m_sector, BRG_SPIFLASH_SECTOR_SIZE);
+		if( (brgStat == BRG_NO_ERR) && (memcmp(m_sector, pNewData, BRG_SPIFLASH_SECTOR_SIZE) != 0) ) {
+			brgStat = BRG_VERIF_ERR;
+		}
+	}
+	return brgStat;
+}
+
+// Command byte followed by the 3 or 4 byte address (MSB first), returns the command size
+uint8_t BrgSpiFlash::SetCmdAddr(uint8_t *pCmd, uint8_t Cmd3Byte, uint8_t Cmd4Byte, uint32_t Addr) const
+{
+	if( m_info.bAddr4Byte == true ) {
+		pCmd[0] = Cmd4Byte;
+		pCmd[1] = (uint8_t)(Addr >> 24);
+		pCmd[2] = (uint8_t)(Addr >> 16);
+		pCmd[3] = (uint8_t)(Addr >> 8);
+		pCmd[4] = (uint8_t)Addr;
+		return 5;
+	}
+	pCmd[0] = Cmd3Byte;
+	pCmd[1] = (uint8_t)(Addr >> 16);
+	pCmd[2] = (uint8_t)(Addr >> 8);
+	pCmd[3] = (uint8_t)Addr;
+	return 4;
+}
+
+/**********************************END OF FILE*********************************/
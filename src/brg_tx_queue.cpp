@@ -0,0 +1,482 @@
+/**
+  ******************************************************************************
+  * @file    brg_tx_queue.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   CAN/FDCAN transmit queue: bounded lock-free multi-producer rings
+  *          (one per priority class) drained in strict priority order by a
+  *          single writer thread calling Brg::WriteMsgCAN() or
+  *          Brg::WriteMsgFDCAN(), so that producers never block on USB latency.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include "brg_tx_queue.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+// Max time the idle writer sleeps before re-checking the ring (lost wake-up guard)
+#define BRG_TXQ_IDLE_WAIT_MS 1
+
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup CAN
+ * @brief BrgTxQueue constructor
+ * @param[in]  Bridge    Opened Brg instance used by the writer thread.
+ * @param[in]  Capacity  Max number of queued frames per priority class, rounded up to a power of 2.
+ */
+BrgTxQueue::BrgTxQueue(Brg &Bridge, uint32_t Capacity): m_brg(Bridge),
+	m_bRunning(false), m_bStopReq(false), m_bDrainOnStop(true), m_bWriterIdle(false)
+{
+	uint64_t size = 2;
+
+	while( size < Capacity ) {
+		size <<= 1;
+	}
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		TxRingT *pRing = &m_rings[prio];
+		pRing->Mask = size - 1;
+		pRing->pCells = new TxCellT[size];
+		for( uint64_t i = 0; i < size; i++ ) {
+			pRing->pCells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+		pRing->EnqueuePos.store(0);
+		pRing->DequeuePos.store(0);
+	}
+	ResetStats();
+}
+
+/**
+ * @ingroup CAN
+ * @brief BrgTxQueue destructor: stops the writer thread (queued frames are sent).
+ */
+BrgTxQueue::~BrgTxQueue(void)
+{
+	Stop(true);
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		delete[] m_rings[prio].pCells;
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Start the writer thread.
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_CMD_NOT_ALLOWED If already started
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgTxQueue::Start(void)
+{
+	if( m_brg.GetIsStlinkConnected() == false ) {
+		return BRG_NO_STLINK;
+	}
+	if( m_bRunning.load() == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	m_bStopReq.store(false);
+	m_bRunning.store(true);
+	m_writer = std::thread(&BrgTxQueue::WriterThread, this);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Stop the writer thread.
+ * @param[in]  bDrain  true: frames already queued are written before the thread exits.\n
+ *                     false: queued frames are discarded (counted in DiscardedNb).
+ * @retval #BRG_NO_ERR If no error (also if not started)
+ */
+Brg_StatusT BrgTxQueue::Stop(bool bDrain)
+{
+	Brg_TxFrameT frame;
+
+	if( m_bRunning.load() == false ) {
+		return BRG_NO_ERR;
+	}
+	m_bDrainOnStop.store(bDrain);
+	m_bStopReq.store(true);
+	WakeWriter();
+	if( m_writer.joinable() ) {
+		m_writer.join();
+	}
+	// Frames pushed after the writer exited (or not drained) are discarded
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		while( Pop(&m_rings[prio], &frame) == true ) {
+			m_rings[prio].DiscardedNb.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	m_bRunning.store(false);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Queue a CAN message for Brg::WriteMsgCAN(). Lock-free, never waits for USB.
+ * @param[in]  pCanMsg      CAN Tx message header (see Brg::WriteMsgCAN()).
+ * @param[in]  pBuffer      Data field (copied).
+ * @param[in]  SizeInBytes  Data field size (max 8).
+ * @param[in]  Priority     Priority class, see #Brg_TxPriorityT.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_OVERRUN_ERR If the queue of this class is full (frame dropped)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgTxQueue::PushCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+                                Brg_TxPriorityT Priority)
+{
+	Brg_TxFrameT frame;
+
+	if( (pCanMsg == NULL) || ((pBuffer == NULL) && (SizeInBytes != 0)) || (SizeInBytes > 8) ||
+	    (Priority >= BRG_TX_PRIO_NB) ) {
+		return BRG_PARAM_ERR;
+	}
+	frame.bIsFdcan = false;
+	frame.CanMsg = *pCanMsg;
+	memset(&frame.FdcanMsg, 0, sizeof(frame.FdcanMsg));
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	frame.Priority = Priority;
+	return Push(&frame);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Queue an FDCAN message for Brg::WriteMsgFDCAN(). Lock-free, never waits for USB.
+ * @param[in]  pFdcanMsg    FDCAN Tx message header (see Brg::WriteMsgFDCAN()).
+ * @param[in]  pBuffer      Data field (copied).
+ * @param[in]  SizeInBytes  Data field size (max 64).
+ * @param[in]  Priority     Priority class, see #Brg_TxPriorityT.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_OVERRUN_ERR If the queue of this class is full (frame dropped)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgTxQueue::PushFDCAN(const Brg_FdcanMsgT *pFdcanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes,
+                                  Brg_TxPriorityT Priority)
+{
+	Brg_TxFrameT frame;
+
+	if( (pFdcanMsg == NULL) || ((pBuffer == NULL) && (SizeInBytes != 0)) ||
+	    (SizeInBytes > BRG_TXQ_MAX_DATA_SIZE) || (Priority >= BRG_TX_PRIO_NB) ) {
+		return BRG_PARAM_ERR;
+	}
+	frame.bIsFdcan = true;
+	memset(&frame.CanMsg, 0, sizeof(frame.CanMsg));
+	frame.FdcanMsg = *pFdcanMsg;
+	if( SizeInBytes != 0 ) {
+		memcpy(frame.Data, pBuffer, SizeInBytes);
+	}
+	frame.SizeInBytes = SizeInBytes;
+	frame.Priority = Priority;
+	return Push(&frame);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Queue several prepared frames at once (e.g. all frames due in the same scheduler
+ *        tick): the writer thread is woken only once, after the last frame, and then
+ *        writes them back to back.
+ * @param[in]  pFrames    Frames to queue; Priority, bIsFdcan, headers and data must be set,
+ *                        EnqueueTimeUs is overwritten.
+ * @param[in]  FrameNb    Number of frames in pFrames.
+ * @param[out] pPushedNb  If not NULL, number of frames accepted.
+ * @retval #BRG_PARAM_ERR If wrong parameters
+ * @retval #BRG_OVERRUN_ERR If at least one frame was dropped (its class queue was full)
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgTxQueue::PushFrames(const Brg_TxFrameT *pFrames, uint32_t FrameNb, uint32_t *pPushedNb)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t pushedNb = 0;
+
+	if( (pFrames == NULL) && (FrameNb != 0) ) {
+		return BRG_PARAM_ERR;
+	}
+	for( uint32_t i = 0; i < FrameNb; i++ ) {
+		if( (pFrames[i].Priority >= BRG_TX_PRIO_NB) ||
+		    (pFrames[i].SizeInBytes > ((pFrames[i].bIsFdcan == true) ? BRG_TXQ_MAX_DATA_SIZE : 8)) ) {
+			brgStat = BRG_PARAM_ERR;
+			break;
+		}
+		if( Push(&pFrames[i], false) == BRG_NO_ERR ) {
+			pushedNb++;
+		} else {
+			brgStat = BRG_OVERRUN_ERR;
+		}
+	}
+	if( (pushedNb != 0) && (m_bWriterIdle.load(std::memory_order_acquire) == true) ) {
+		WakeWriter();
+	}
+	if( pPushedNb != NULL ) {
+		*pPushedNb = pushedNb;
+	}
+	return brgStat;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Adapt CAN init parameters so that the bus order follows the BrgTxQueue order.\n
+ *        Without transmit FIFO priority the CAN controller sends pending mailboxes by
+ *        identifier, so a bulk frame with a low ID could overtake a control frame
+ *        already handed over by the writer thread. To be called before Brg::InitCAN().
+ * @param[in,out]  pInitParams  CAN init parameters: bIsTxfpEn is set to true.
+ */
+void BrgTxQueue::SetHostOrderCAN(Brg_CanInitT *pInitParams)
+{
+	if( pInitParams != NULL ) {
+		pInitParams->bIsTxfpEn = true;
+	}
+}
+
+/*
+ * Producer side of the ring: claim a cell by CAS on EnqueuePos, fill it and
+ * publish it through its Sequence.
+ */
+Brg_StatusT BrgTxQueue::Push(const Brg_TxFrameT *pFrame, bool bWakeWriter)
+{
+	TxRingT *pRing = &m_rings[pFrame->Priority];
+	TxCellT *pCell;
+	uint64_t pos, seq;
+	uint32_t depth, maxDepth;
+	int64_t diff;
+
+	pos = pRing->EnqueuePos.load(std::memory_order_relaxed);
+	for( ;; ) {
+		pCell = &pRing->pCells[pos & pRing->Mask];
+		seq = pCell->Sequence.load(std::memory_order_acquire);
+		diff = (int64_t)seq - (int64_t)pos;
+		if( diff == 0 ) {
+			if( pRing->EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) {
+				break;
+			}
+		} else if( diff < 0 ) {
+			// Cell not yet released by the writer: queue full
+			pRing->DroppedFullNb.fetch_add(1, std::memory_order_relaxed);
+			return BRG_OVERRUN_ERR;
+		} else {
+			pos = pRing->EnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	pCell->Frame = *pFrame;
+	pCell->Frame.EnqueueTimeUs = BrgGetMonotonicUs();
+	pCell->Sequence.store(pos + 1, std::memory_order_release);
+
+	pRing->EnqueuedNb.fetch_add(1, std::memory_order_relaxed);
+	depth = (uint32_t)(pos + 1 - pRing->DequeuePos.load(std::memory_order_relaxed));
+	maxDepth = pRing->MaxDepth.load(std::memory_order_relaxed);
+	while( (depth > maxDepth) &&
+	       !pRing->MaxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed) ) {
+	}
+	depth = GetDepth();
+	maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+	while( (depth > maxDepth) &&
+	       !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed) ) {
+	}
+	if( (bWakeWriter == true) && (m_bWriterIdle.load(std::memory_order_acquire) == true) ) {
+		WakeWriter();
+	}
+	return BRG_NO_ERR;
+}
+
+/*
+ * Consumer side of a ring (writer thread only, or Stop() once the writer exited)
+ */
+bool BrgTxQueue::Pop(TxRingT *pRing, Brg_TxFrameT *pFrame)
+{
+	TxCellT *pCell;
+	uint64_t pos, seq;
+
+	pos = pRing->DequeuePos.load(std::memory_order_relaxed);
+	pCell = &pRing->pCells[pos & pRing->Mask];
+	seq = pCell->Sequence.load(std::memory_order_acquire);
+	if( seq != pos + 1 ) {
+		return false; // empty (or producer still copying)
+	}
+	*pFrame = pCell->Frame;
+	pCell->Sequence.store(pos + pRing->Mask + 1, std::memory_order_release);
+	pRing->DequeuePos.store(pos + 1, std::memory_order_relaxed);
+	return true;
+}
+
+/*
+ * Strict priority dequeue: rings are scanned from BRG_TX_PRIO_CONTROL on every frame
+ */
+bool BrgTxQueue::PopHighest(Brg_TxFrameT *pFrame)
+{
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		if( Pop(&m_rings[prio], pFrame) == true ) {
+			// Count frames overtaking lower class frames already waiting
+			for( int low = prio + 1; low < BRG_TX_PRIO_NB; low++ ) {
+				if( GetDepth((Brg_TxPriorityT)low) != 0 ) {
+					m_preemptedNb.fetch_add(1, std::memory_order_relaxed);
+					break;
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void BrgTxQueue::WakeWriter(void)
+{
+	std::lock_guard<std::mutex> lock(m_wakeMutex);
+	m_wakeCond.notify_one();
+}
+
+/*
+ * Writer thread: single consumer of the rings, owner of the Tx USB path
+ */
+void BrgTxQueue::WriterThread(void)
+{
+	Brg_TxFrameT frame;
+	Brg_StatusT brgStat;
+	TxRingT *pRing;
+	uint64_t latencyUs;
+
+	for( ;; ) {
+		if( (m_bStopReq.load() == true) && (m_bDrainOnStop.load() == false) ) {
+			break;
+		}
+		if( PopHighest(&frame) == true ) {
+			{
+				std::lock_guard<std::recursive_mutex> lock(m_brg.GetTransactionLock());
+				if( frame.bIsFdcan == true ) {
+					brgStat = m_brg.WriteMsgFDCAN(&frame.FdcanMsg, frame.Data, frame.SizeInBytes);
+				} else {
+					brgStat = m_brg.WriteMsgCAN(&frame.CanMsg, frame.Data, frame.SizeInBytes);
+				}
+			}
+			pRing = &m_rings[frame.Priority];
+			if( brgStat == BRG_NO_ERR ) {
+				latencyUs = BrgGetMonotonicUs() - frame.EnqueueTimeUs;
+				pRing->SentNb.fetch_add(1, std::memory_order_relaxed);
+				pRing->EnqueueToWire.Record(latencyUs);
+				m_enqueueToWire.Record(latencyUs);
+			} else {
+				pRing->WriteErrorNb.fetch_add(1, std::memory_order_relaxed);
+			}
+			continue;
+		}
+		// Queue empty
+		if( m_bStopReq.load() == true ) {
+			break;
+		}
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_bWriterIdle.store(true, std::memory_order_release);
+		if( (GetDepth() == 0) && (m_bStopReq.load() == false) ) {
+			m_wakeCond.wait_for(lock, std::chrono::milliseconds(BRG_TXQ_IDLE_WAIT_MS));
+		}
+		m_bWriterIdle.store(false, std::memory_order_release);
+	}
+}
+
+/**
+ * @ingroup CAN
+ * @brief Current number of queued frames, all classes (approximate while producers are active).
+ * @retval Queue depth.
+ */
+uint32_t BrgTxQueue::GetDepth(void) const
+{
+	uint32_t depth = 0;
+
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		depth += GetDepth((Brg_TxPriorityT)prio);
+	}
+	return depth;
+}
+
+/**
+ * @ingroup CAN
+ * @brief Current number of queued frames in one priority class.
+ * @param[in]  Priority  Priority class.
+ * @retval Queue depth (0 if wrong Priority).
+ */
+uint32_t BrgTxQueue::GetDepth(Brg_TxPriorityT Priority) const
+{
+	uint64_t enq, deq;
+
+	if( Priority >= BRG_TX_PRIO_NB ) {
+		return 0;
+	}
+	enq = m_rings[Priority].EnqueuePos.load(std::memory_order_relaxed);
+	deq = m_rings[Priority].DequeuePos.load(std::memory_order_relaxed);
+	return (enq > deq) ? (uint32_t)(enq - deq) : 0;
+}
+
+void BrgTxQueue::GetClassStats(const TxRingT *pRing, Brg_TxClassStatsT *pStats) const
+{
+	uint64_t enq = pRing->EnqueuePos.load(std::memory_order_relaxed);
+	uint64_t deq = pRing->DequeuePos.load(std::memory_order_relaxed);
+
+	pStats->EnqueuedNb = pRing->EnqueuedNb.load(std::memory_order_relaxed);
+	pStats->SentNb = pRing->SentNb.load(std::memory_order_relaxed);
+	pStats->DroppedFullNb = pRing->DroppedFullNb.load(std::memory_order_relaxed);
+	pStats->DiscardedNb = pRing->DiscardedNb.load(std::memory_order_relaxed);
+	pStats->WriteErrorNb = pRing->WriteErrorNb.load(std::memory_order_relaxed);
+	pStats->Depth = (enq > deq) ? (uint32_t)(enq - deq) : 0;
+	pStats->MaxDepth = pRing->MaxDepth.load(std::memory_order_relaxed);
+	pRing->EnqueueToWire.GetSummary(&pStats->EnqueueToWire);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Get queue counters and enqueue-to-wire latency percentiles, in total and per
+ *        priority class (e.g. Class[BRG_TX_PRIO_CONTROL] gives the control frame latency
+ *        while a bulk stream saturates the queue).
+ * @param[out] pStats  Filled with current statistics.
+ */
+void BrgTxQueue::GetStats(Brg_TxQueueStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	memset(&pStats->Total, 0, sizeof(pStats->Total));
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		GetClassStats(&m_rings[prio], &pStats->Class[prio]);
+		pStats->Total.EnqueuedNb += pStats->Class[prio].EnqueuedNb;
+		pStats->Total.SentNb += pStats->Class[prio].SentNb;
+		pStats->Total.DroppedFullNb += pStats->Class[prio].DroppedFullNb;
+		pStats->Total.DiscardedNb += pStats->Class[prio].DiscardedNb;
+		pStats->Total.WriteErrorNb += pStats->Class[prio].WriteErrorNb;
+		pStats->Total.Depth += pStats->Class[prio].Depth;
+	}
+	pStats->Total.MaxDepth = m_maxDepth.load(std::memory_order_relaxed);
+	m_enqueueToWire.GetSummary(&pStats->Total.EnqueueToWire);
+	pStats->PreemptedNb = m_preemptedNb.load(std::memory_order_relaxed);
+}
+
+/**
+ * @ingroup CAN
+ * @brief Clear counters, max depths and latency histograms.
+ */
+void BrgTxQueue::ResetStats(void)
+{
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		TxRingT *pRing = &m_rings[prio];
+		pRing->EnqueuedNb.store(0);
+		pRing->SentNb.store(0);
+		pRing->DroppedFullNb.store(0);
+		pRing->DiscardedNb.store(0);
+		pRing->WriteErrorNb.store(0);
+		pRing->MaxDepth.store(0);
+		pRing->EnqueueToWire.Reset();
+	}
+	m_maxDepth.store(0);
+	m_preemptedNb.store(0);
+	m_enqueueToWire.Reset();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,280 @@
+/**
+  ******************************************************************************
+  * @file    brg_voltage_sampler.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Background target voltage sampling in idle USB slots, rolling window
+  *          and brown-out detection.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "platform_include.h"
+#include <string.h>
+#include <chrono>
+#include "brg_voltage_sampler.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private defines -----------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Global variables ----------------------------------------------------------*/
+/* Class Functions Definition ------------------------------------------------*/
+
+/**
+ * @ingroup DEVICE
+ * @brief BrgVoltageSampler constructor
+ * @param[in]  Bridge    Opened Brg instance.
+ * @param[in]  pConf     Configuration, NULL for the BRG_VSAMPLER_DEFAULT_xxx values and
+ *                       no brown-out threshold (out of range values are corrected).
+ * @param[in]  Callback  Brown-out callback, may be NULL.
+ * @param[in]  pContext  User pointer given back to Callback.
+ */
+BrgVoltageSampler::BrgVoltageSampler(Brg &Bridge, const Brg_VoltageSamplerConfT *pConf,
+                                     Brg_VoltageEventCallbackT Callback, void *pContext):
+	m_brg(Bridge), m_callback(Callback), m_pContext(pContext), m_bRunning(false), m_bStopReq(false),
+	m_bFlashing(false), m_windowNb(0), m_windowNext(0), m_bBrownOut(false), m_bEventRaised(false)
+{
+	if( pConf != NULL ) {
+		m_conf = *pConf;
+	} else {
+		memset(&m_conf, 0, sizeof(m_conf));
+		m_conf.PeriodMs = BRG_VSAMPLER_DEFAULT_PERIOD_MS;
+		m_conf.WindowNb = BRG_VSAMPLER_DEFAULT_WINDOW_NB;
+		m_conf.IdleGapUs = BRG_VSAMPLER_DEFAULT_IDLE_GAP_US;
+	}
+	if( m_conf.PeriodMs == 0 ) {
+		m_conf.PeriodMs = 1;
+	}
+	if( m_conf.WindowNb == 0 ) {
+		m_conf.WindowNb = 1;
+	}
+	if( m_conf.WindowNb > BRG_VSAMPLER_MAX_WINDOW_NB ) {
+		m_conf.WindowNb = BRG_VSAMPLER_MAX_WINDOW_NB;
+	}
+	if( m_conf.MaxDeferMs == 0 ) {
+		m_conf.MaxDeferMs = m_conf.PeriodMs;
+	}
+	m_pWindow = new float[m_conf.WindowNb];
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief BrgVoltageSampler destructor: stops the sampler thread.
+ */
+BrgVoltageSampler::~BrgVoltageSampler(void)
+{
+	Stop();
+	delete[] m_pWindow;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Start the sampler thread, the first sample is taken in the first idle slot.
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_CMD_NOT_ALLOWED If already started
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT BrgVoltageSampler::Start(void)
+{
+	if( m_brg.GetIsStlinkConnected() == false ) {
+		return BRG_NO_STLINK;
+	}
+	if( m_bRunning.load() == true ) {
+		return BRG_CMD_NOT_ALLOWED;
+	}
+	m_bStopReq.store(false);
+	m_bRunning.store(true);
+	m_sampler = std::thread(&BrgVoltageSampler::SamplerThread, this);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Stop the sampler thread, the window is kept.
+ * @retval #BRG_NO_ERR If no error (also if not started)
+ */
+Brg_StatusT BrgVoltageSampler::Stop(void)
+{
+	if( m_bRunning.load() == false ) {
+		return BRG_NO_ERR;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopReq.store(true);
+		m_wakeCond.notify_one();
+	}
+	if( m_sampler.joinable() ) {
+		m_sampler.join();
+	}
+	m_bRunning.store(false);
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Flashing phase: brown-out events are raised only while bFlashing is true.
+ *        Can be called from any thread.
+ * @param[in]  bFlashing  true at the start of flashing, false at the end.
+ */
+void BrgVoltageSampler::SetFlashing(bool bFlashing)
+{
+	m_bFlashing.store(bFlashing);
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Get the statistics and the rolling window summary. Can be called from any thread.
+ * @param[out] pStats  Statistics (Min, Max and Mean 0 while the window is empty).
+ */
+void BrgVoltageSampler::GetStats(Brg_VoltageStatsT *pStats) const
+{
+	std::lock_guard<std::mutex> lock(m_dataMutex);
+	float sum = 0;
+	uint32_t i;
+
+	if( pStats == NULL ) {
+		return;
+	}
+	*pStats = m_stats;
+	pStats->WindowNb = m_windowNb;
+	pStats->Min = 0;
+	pStats->Max = 0;
+	pStats->Mean = 0;
+	for( i=0; i<m_windowNb; i++ ) {
+		if( (i == 0) || (m_pWindow[i] < pStats->Min) ) {
+			pStats->Min = m_pWindow[i];
+		}
+		if( (i == 0) || (m_pWindow[i] > pStats->Max) ) {
+			pStats->Max = m_pWindow[i];
+		}
+		sum += m_pWindow[i];
+	}
+	if( m_windowNb != 0 ) {
+		pStats->Mean = sum / (float)m_windowNb;
+	}
+}
+
+/*
+ * Sampler thread: one sample per period, taken in the first idle USB slot
+ */
+void BrgVoltageSampler::SamplerThread(void)
+{
+	uint64_t nextUs, nowUs;
+
+	nextUs = BrgGetMonotonicUs();
+	while( m_bStopReq.load() == false ) {
+		if( TakeSample(nextUs + (uint64_t)m_conf.MaxDeferMs*1000) == false ) {
+			break;
+		}
+		// Keep the sampling phase, periods lost to a long deferral are not caught up
+		nowUs = BrgGetMonotonicUs();
+		nextUs += (uint64_t)m_conf.PeriodMs*1000;
+		while( nextUs <= nowUs ) {
+			nextUs += (uint64_t)m_conf.PeriodMs*1000;
+		}
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		if( m_bStopReq.load() == false ) {
+			m_wakeCond.wait_for(lock, std::chrono::microseconds(nextUs - nowUs));
+		}
+	}
+}
+
+/*
+ * Wait for an idle USB slot until DeadlineUs and take a sample (skipped at DeadlineUs).
+ * Returns false if a stop is requested.
+ */
+bool BrgVoltageSampler::TakeSample(uint64_t DeadlineUs)
+{
+	std::recursive_mutex &transactionLock = m_brg.GetTransactionLock();
+	Brg_StatusT brgStat;
+	uint64_t startUs, nowUs, idleUs, waitUs;
+	float voltage = 0;
+
+	startUs = BrgGetMonotonicUs();
+	while( m_bStopReq.load() == false ) {
+		nowUs = BrgGetMonotonicUs();
+		idleUs = m_brg.GetLastCmdEndUs() + m_conf.IdleGapUs;
+		waitUs = BRG_VSAMPLER_RETRY_US;
+		if( nowUs >= idleUs ) {
+			if( transactionLock.try_lock() == true ) {
+				brgStat = m_brg.GetTargetVoltage(&voltage);
+				transactionLock.unlock();
+				{
+					std::lock_guard<std::mutex> lock(m_dataMutex);
+					if( nowUs - startUs > m_stats.MaxDeferUs ) {
+						m_stats.MaxDeferUs = (uint32_t)(nowUs - startUs);
+					}
+					if( brgStat != BRG_NO_ERR ) {
+						m_stats.ErrorNb++;
+					}
+				}
+				if( brgStat == BRG_NO_ERR ) {
+					AddSample(voltage, nowUs);
+				}
+				return true;
+			}
+		} else if( idleUs - nowUs < waitUs ) {
+			waitUs = idleUs - nowUs;
+		}
+		if( nowUs >= DeadlineUs ) {
+			std::lock_guard<std::mutex> lock(m_dataMutex);
+			m_stats.SkippedNb++;
+			return true;
+		}
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		if( m_bStopReq.load() == false ) {
+			m_wakeCond.wait_for(lock, std::chrono::microseconds(waitUs));
+		}
+	}
+	return false;
+}
+
+/*
+ * Store a sample in the window and detect the brown-out (callback called without lock)
+ */
+void BrgVoltageSampler::AddSample(float Voltage, uint64_t TimeUs)
+{
+	Brg_VoltageEventT event;
+	bool bEvent = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_dataMutex);
+		m_pWindow[m_windowNext] = Voltage;
+		m_windowNext = (m_windowNext + 1) % m_conf.WindowNb;
+		if( m_windowNb < m_conf.WindowNb ) {
+			m_windowNb++;
+		}
+		m_stats.SampleNb++;
+		m_stats.Last = Voltage;
+		if( (m_conf.BrownOutV > 0) && (Voltage < m_conf.BrownOutV) ) {
+			if( m_bBrownOut == false ) {
+				m_bBrownOut = true;
+				m_stats.BrownOutNb++;
+			}
+			// Also raised when flashing starts during a brown-out
+			if( (m_bFlashing.load() == true) && (m_bEventRaised == false) ) {
+				m_bEventRaised = true;
+				event.TimeUs = TimeUs;
+				event.Voltage = Voltage;
+				event.Threshold = m_conf.BrownOutV;
+				bEvent = true;
+			}
+		} else if( Voltage > m_conf.BrownOutV + m_conf.HysteresisV ) {
+			m_bBrownOut = false;
+			m_bEventRaised = false;
+		}
+	}
+	if( (bEvent == true) && (m_callback != NULL) ) {
+		m_callback(m_pContext, &event);
+	}
+}
+
+/**********************************END OF FILE*********************************/
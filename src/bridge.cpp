@@ -28,15 +28,9 @@
 #include "platform_include.h"
 #include <math.h>
 #include "bridge.h"
+#include "brg_chrome_trace.h"
 
 /* Private typedef -----------------------------------------------------------*/
-// I2C structure for timing calculation
-typedef struct {
-    int prescaler;
-    int SDLDEL;
-    int SCLDEL;
-    double resultat;
-} Brg_I2cModelT;
 
 /* Private defines -----------------------------------------------------------*/
 // Size in bytes of a USB bridge command
@@ -46,6 +40,9 @@ typedef struct {
 #define BRIDGE_RW_STATUS_LEN_WORD 4
 #define BRIDGE_RW_STATUS_LEN_BYTE 8
 
+// USB high speed bulk packet size (Brg::ReadStreamSPI()/Brg::WriteStreamSPI() chunks)
+#define BRG_USB_HS_PACKET_SIZE 512
+
 // I2C define for timing calculation
 #define SCLL_LENGTH    256
 #define SCLH_LENGTH    256
@@ -81,6 +78,12 @@ const double THIGH_MIN0 = (double)(4 / pow((double)10, 6));
 const double THIGH_MIN1 = (double)(0.6 / pow((double)10, 6));
 const double THIGH_MIN2 = (double)(0.26 / pow((double)10, 6));
 
+// Limits per mode (I2C_STANDARD, I2C_FAST, I2C_FAST_PLUS)
+static const double I2C_THDDAT_MAX[MODE_NUMBER] = {THDDAT_MAX_T0, THDDAT_MAX_T1, THDDAT_MAX_T2};
+static const double I2C_TSUDAT_MIN[MODE_NUMBER] = {TSUDAT_MIN_T0, TSUDAT_MIN_T1, TSUDAT_MIN_T2};
+static const double I2C_TLOW_MIN[MODE_NUMBER] = {TLOW_MIN0, TLOW_MIN1, TLOW_MIN2};
+static const double I2C_THIGH_MIN[MODE_NUMBER] = {THIGH_MIN0, THIGH_MIN1, THIGH_MIN2};
+
 /* Global variables ----------------------------------------------------------*/
 
 /* Class Functions Definition ------------------------------------------------*/
@@ -90,9 +93,16 @@ const double THIGH_MIN2 = (double)(0.26 / pow((double)10, 6));
  * @brief Brg constructor
  * @param[in]  StlinkIf  reference to USB STLink Bridge interface: STLinkInterface(STLINK_BRIDGE)
  */
-Brg::Brg(STLinkInterface &StlinkIf): StlinkDevice(StlinkIf), m_slaveAddrPartialI2cTrans(0)
+Brg::Brg(STLinkInterface &StlinkIf): StlinkDevice(StlinkIf), m_slaveAddrPartialI2cTrans(0),
+	m_pCmdStatsDumpFile(NULL), m_lastCmdEndUs(0), m_i2cTimingCacheNext(0)
 {
 	this->SetOpenModeExclusive(true);
+	for( int i = 0; i < BRG_CMD_STATS_OPCODE_NB; i++ ) {
+		m_pCmdStats[i].store(NULL, std::memory_order_relaxed);
+	}
+	ClearCanConfCache();
+	ResetRxOverrunStats();
+	ClearI2cTimingCache();
 }
 /**
  * @ingroup DEVICE
@@ -103,6 +113,12 @@ Brg::~Brg(void)
 	// Close device if necessary
 	CloseBridge(COM_UNDEF_ALL);
 	// Close STLink is done by ~StlinkDevice
+	if( m_pCmdStatsDumpFile != NULL ) {
+		DumpCmdStats(m_pCmdStatsDumpFile);
+	}
+	for( int i = 0; i < BRG_CMD_STATS_OPCODE_NB; i++ ) {
+		delete m_pCmdStats[i].load(std::memory_order_relaxed);
+	}
 }
 
 /**
@@ -194,9 +210,14 @@ bool Brg::IsOldBrgFwVersion(void) const {
  */
 Brg_StatusT Brg::OpenStlink(int StlinkInstId)
 {
+	BRG_TRACE_API();
 	STLinkIf_StatusT ifStatus = STLINKIF_NO_ERR;
 	Brg_StatusT brgStatus;
 
+	// New session: the CAN configuration and the I2C timings of the bridge are unknown
+	ClearCanConfCache();
+	m_fdcanTimeMap.Reset();
+	ClearI2cTimingCache();
 	ifStatus = StlinkDevice::OpenStlink(StlinkInstId);
 
 	brgStatus = ConvSTLinkIfToBrgStatus(ifStatus);
@@ -233,9 +254,14 @@ Brg_StatusT Brg::OpenStlink(int StlinkInstId)
  * @retval #BRG_NO_ERR If no error
  */
 Brg_StatusT Brg::OpenStlink(const char *pSerialNumber, bool bStrict) {
+	BRG_TRACE_API();
 	STLinkIf_StatusT ifStatus = STLINKIF_NO_ERR;
 	Brg_StatusT brgStatus;
 
+	// New session: the CAN configuration and the I2C timings of the bridge are unknown
+	ClearCanConfCache();
+	m_fdcanTimeMap.Reset();
+	ClearI2cTimingCache();
 	ifStatus = StlinkDevice::OpenStlink(pSerialNumber, bStrict, false);
 
 	brgStatus = ConvSTLinkIfToBrgStatus(ifStatus);
@@ -258,6 +284,10 @@ Brg_StatusT Brg::OpenStlink(const char *pSerialNumber, bool bStrict) {
  */
 Brg_StatusT Brg::CloseStlink(void)
 {
+	BRG_TRACE_API();
+	ClearCanConfCache();
+	m_fdcanTimeMap.Reset();
+	ClearI2cTimingCache();
 	StlinkDevice::CloseStlink();
 	return BRG_NO_ERR;
 }
@@ -273,6 +303,7 @@ Brg_StatusT Brg::CloseStlink(void)
  */
 Brg_StatusT Brg::CloseBridge(uint8_t BrgCom)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint32_t answer = 0;
@@ -295,6 +326,13 @@ Brg_StatusT Brg::CloseBridge(uint8_t BrgCom)
 	} else { // Close only the given interface
 		closeCom = BrgCom;
 	}
+	if ((BrgCom == COM_CAN) || (BrgCom == COM_UNDEF_ALL)) {
+		ClearCanConfCache();
+		m_fdcanTimeMap.Reset();
+	}
+	if ((BrgCom == COM_I2C) || (BrgCom == COM_UNDEF_ALL)) {
+		ClearI2cTimingCache();
+	}
 
 	pRq = new STLink_DeviceRequestT;
 	memset(pRq, 0, sizeof(STLink_DeviceRequestT));
@@ -326,6 +364,7 @@ Brg_StatusT Brg::CloseBridge(uint8_t BrgCom)
  */
 Brg_StatusT Brg::ST_GetVersionExt(Stlk_VersionExtT* pVersion)
 {
+	BRG_TRACE_API();
 	STLinkIf_StatusT ifStatus = STLINKIF_NO_ERR;
 	ifStatus = StlinkDevice::GetVersionExt(pVersion);
 	return ConvSTLinkIfToBrgStatus(ifStatus);
@@ -341,12 +380,15 @@ Brg_StatusT Brg::SendRequestAndAnalyzeStatus(STLink_DeviceRequestT *pDevReq,
 	Brg_StatusT brgStat = BRG_PARAM_ERR;
 	STLinkIf_StatusT ifStatus;
 
-	ifStatus = StlinkDevice::SendRequest(pDevReq, UsbTimeoutMs);
+	ifStatus = SendDeviceRequest(pDevReq, UsbTimeoutMs);
 	if( ifStatus != STLINKIF_NO_ERR) {
 		return BRG_USB_COMM_ERR;
 	}
 	// Analyse status
 	brgStat = AnalyzeStatus(pStatus);
+	if( brgStat != BRG_NO_ERR ) {
+		GetCmdStatsEntry(GetCmdStatsOpcode(pDevReq))->StatusErrNb.fetch_add(1, std::memory_order_relaxed);
+	}
 	if( brgStat == BRG_TARGET_CMD_ERR ) {
 		// Default error
 		// If useful, one can add some error codes in Brg_StatusT corresponding
@@ -364,6 +406,223 @@ Brg_StatusT Brg::SendRequestAndAnalyzeStatus(STLink_DeviceRequestT *pDevReq,
 
 	return brgStat;
 }
+/*
+ * Send a USB command (bridge or StlinkDevice command), record its statistics and
+ * Chrome trace span. Requires the STLink to be already connected.
+ */
+STLinkIf_StatusT Brg::SendDeviceRequest(STLink_DeviceRequestT *pDevReq, const uint16_t UsbTimeoutMs) const
+{
+	STLinkIf_StatusT ifStatus;
+	CmdStatsT *pCmdStats = NULL;
+	uint8_t opcode = 0;
+	uint64_t startUs = 0, endUs;
+
+	if( pDevReq != NULL ) {
+		opcode = GetCmdStatsOpcode(pDevReq);
+		pCmdStats = GetCmdStatsEntry(opcode);
+		startUs = BrgGetMonotonicUs();
+	}
+	ifStatus = StlinkDevice::SendRequest(pDevReq, UsbTimeoutMs);
+	endUs = BrgGetMonotonicUs();
+	m_lastCmdEndUs.store(endUs, std::memory_order_relaxed);
+	if( pCmdStats != NULL ) {
+		pCmdStats->Latency.Record(endUs - startUs);
+		if( BrgChromeTraceIsOn() == true ) {
+			BrgChromeTraceSpan(GetCmdName(opcode), BRG_TRACE_CAT_USB, startUs, endUs, pDevReq->BufferLength);
+		}
+		pCmdStats->CmdNb.fetch_add(1, std::memory_order_relaxed);
+		if( pDevReq->InputRequest == REQUEST_WRITE ) {
+			pCmdStats->TxBytes.fetch_add(pDevReq->BufferLength, std::memory_order_relaxed);
+		} else {
+			pCmdStats->RxBytes.fetch_add(pDevReq->BufferLength, std::memory_order_relaxed);
+		}
+		if( ifStatus != STLINKIF_NO_ERR ) {
+			pCmdStats->UsbErrNb.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	return ifStatus;
+}
+
+/*
+ * Statistics key of a request: the bridge opcode (CDBByte[1]) for bridge commands,
+ * else the STLink command code (CDBByte[0], e.g. ST_GETVERSION_EXT), distinct from
+ * the bridge opcodes
+ */
+uint8_t Brg::GetCmdStatsOpcode(const STLink_DeviceRequestT *pDevReq)
+{
+	if( pDevReq->CDBByte[0] == STLINK_BRIDGE_COMMAND ) {
+		return pDevReq->CDBByte[1];
+	}
+	return pDevReq->CDBByte[0];
+}
+
+/*
+ * Statistics entry of a command opcode, allocated at first use (lock-free)
+ */
+Brg::CmdStatsT* Brg::GetCmdStatsEntry(uint8_t Opcode) const
+{
+	CmdStatsT *pEntry = m_pCmdStats[Opcode].load(std::memory_order_acquire);
+	CmdStatsT *pExpected = NULL;
+
+	if( pEntry == NULL ) {
+		pEntry = new CmdStatsT;
+		pEntry->CmdNb.store(0, std::memory_order_relaxed);
+		pEntry->TxBytes.store(0, std::memory_order_relaxed);
+		pEntry->RxBytes.store(0, std::memory_order_relaxed);
+		pEntry->UsbErrNb.store(0, std::memory_order_relaxed);
+		pEntry->StatusErrNb.store(0, std::memory_order_relaxed);
+		if( m_pCmdStats[Opcode].compare_exchange_strong(pExpected, pEntry, std::memory_order_acq_rel) == false ) {
+			// Allocated by another thread meanwhile
+			delete pEntry;
+			pEntry = pExpected;
+		}
+	}
+	return pEntry;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Get the statistics of a bridge command (all the commands sent since the
+ *        Brg creation or the last ResetCmdStats()). Can be called from any thread.
+ * @param[in]  Opcode  Bridge command code (e.g. STLINK_BRIDGE_WRITE_MSG_CAN), or STLink command
+ *                     code of the StlinkDevice commands (e.g. STLINK_GET_TARGET_VOLTAGE).
+ * @param[out] pStats  Statistics, all 0 if the command was never sent.
+ * @retval #BRG_PARAM_ERR If NULL pointer
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT Brg::GetCmdStats(uint8_t Opcode, Brg_CmdStatsT *pStats) const
+{
+	const CmdStatsT *pEntry;
+
+	if( pStats == NULL ) {
+		return BRG_PARAM_ERR;
+	}
+	memset(pStats, 0, sizeof(Brg_CmdStatsT));
+	pEntry = m_pCmdStats[Opcode].load(std::memory_order_acquire);
+	if( pEntry != NULL ) {
+		pStats->CmdNb = pEntry->CmdNb.load(std::memory_order_relaxed);
+		pStats->TxBytes = pEntry->TxBytes.load(std::memory_order_relaxed);
+		pStats->RxBytes = pEntry->RxBytes.load(std::memory_order_relaxed);
+		pStats->UsbErrNb = pEntry->UsbErrNb.load(std::memory_order_relaxed);
+		pStats->StatusErrNb = pEntry->StatusErrNb.load(std::memory_order_relaxed);
+		pEntry->Latency.GetSummary(&pStats->Latency);
+	}
+	return BRG_NO_ERR;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Clear the statistics of all the bridge commands.
+ */
+void Brg::ResetCmdStats(void)
+{
+	CmdStatsT *pEntry;
+
+	for( int i = 0; i < BRG_CMD_STATS_OPCODE_NB; i++ ) {
+		pEntry = m_pCmdStats[i].load(std::memory_order_acquire);
+		if( pEntry != NULL ) {
+			pEntry->Latency.Reset();
+			pEntry->CmdNb.store(0, std::memory_order_relaxed);
+			pEntry->TxBytes.store(0, std::memory_order_relaxed);
+			pEntry->RxBytes.store(0, std::memory_order_relaxed);
+			pEntry->UsbErrNb.store(0, std::memory_order_relaxed);
+			pEntry->StatusErrNb.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Print one line per bridge command sent: count, bytes, errors and USB latency
+ *        percentiles (us).
+ * @param[in]  pFile  Output stream (e.g. stdout).
+ */
+void Brg::DumpCmdStats(FILE *pFile) const
+{
+	Brg_CmdStatsT stats;
+
+	if( pFile == NULL ) {
+		return;
+	}
+	fprintf(pFile, "%-24s %10s %10s %10s %6s %6s %8s %8s %8s %8s %8s %8s\n", "BRIDGE cmd", "count",
+	        "tx bytes", "rx bytes", "usbErr", "stsErr", "min us", "mean us", "p50 us", "p99 us",
+	        "p99.9 us", "max us");
+	for( int i = 0; i < BRG_CMD_STATS_OPCODE_NB; i++ ) {
+		GetCmdStats((uint8_t)i, &stats);
+		if( stats.CmdNb == 0 ) {
+			continue;
+		}
+		fprintf(pFile, "%-19s 0x%02X %10llu %10llu %10llu %6llu %6llu %8llu %8.1f %8llu %8llu %8llu %8llu\n",
+		        GetCmdName((uint8_t)i), i, (unsigned long long)stats.CmdNb,
+		        (unsigned long long)stats.TxBytes, (unsigned long long)stats.RxBytes,
+		        (unsigned long long)stats.UsbErrNb, (unsigned long long)stats.StatusErrNb,
+		        (unsigned long long)stats.Latency.MinUs, stats.Latency.MeanUs,
+		        (unsigned long long)stats.Latency.P50Us, (unsigned long long)stats.Latency.P99Us,
+		        (unsigned long long)stats.Latency.P999Us, (unsigned long long)stats.Latency.MaxUs);
+	}
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Dump the command statistics (DumpCmdStats()) when the Brg is destroyed.
+ * @param[in]  pFile  Output stream, NULL to disable (default).
+ */
+void Brg::SetCmdStatsDumpOnExit(FILE *pFile)
+{
+	m_pCmdStatsDumpFile = pFile;
+}
+
+/**
+ * @ingroup DEVICE
+ * @brief Name of a command for traces.
+ * @param[in]  Opcode  Bridge command code (CDBByte[1]) or STLink command code (e.g.
+ *                     ST_GETVERSION_EXT, CDBByte[0] of the StlinkDevice commands).
+ * @retval Constant string, "UNKNOWN" for codes not defined in stlink_fw_api_bridge.h
+ *         or stlink_fw_api_common.h.
+ */
+const char* Brg::GetCmdName(uint8_t Opcode)
+{
+	switch( Opcode ) {
+		case STLINK_BRIDGE_CLOSE: return "CLOSE";
+		case STLINK_BRIDGE_GET_RWCMD_STATUS: return "GET_RWCMD_STATUS";
+		case STLINK_BRIDGE_GET_CLOCK: return "GET_CLOCK";
+		case STLINK_BRIDGE_INIT_SPI: return "INIT_SPI";
+		case STLINK_BRIDGE_WRITE_SPI: return "WRITE_SPI";
+		case STLINK_BRIDGE_READ_SPI: return "READ_SPI";
+		case STLINK_BRIDGE_CS_SPI: return "CS_SPI";
+		case STLINK_BRIDGE_INIT_I2C: return "INIT_I2C";
+		case STLINK_BRIDGE_WRITE_I2C: return "WRITE_I2C";
+		case STLINK_BRIDGE_READ_I2C: return "READ_I2C";
+		case STLINK_BRIDGE_READ_NO_WAIT_I2C: return "READ_NO_WAIT_I2C";
+		case STLINK_BRIDGE_GET_READ_DATA_I2C: return "GET_READ_DATA_I2C";
+		case STLINK_BRIDGE_INIT_CAN: return "INIT_CAN";
+		case STLINK_BRIDGE_WRITE_MSG_CAN: return "WRITE_MSG_CAN";
+		case STLINK_BRIDGE_INIT_FILTER_CAN: return "INIT_FILTER_CAN";
+		case STLINK_BRIDGE_START_MSG_RECEPTION_CAN: return "START_MSG_RECEPTION_CAN";
+		case STLINK_BRIDGE_STOP_MSG_RECEPTION_CAN: return "STOP_MSG_RECEPTION_CAN";
+		case STLINK_BRIDGE_GET_NB_RXMSG_CAN: return "GET_NB_RXMSG_CAN";
+		case STLINK_BRIDGE_GET_RXMSG_CAN: return "GET_RXMSG_CAN";
+		case STLINK_BRIDGE_INIT_FDCAN: return "INIT_FDCAN";
+		case STLINK_BRIDGE_WRITE_MSG_FDCAN: return "WRITE_MSG_FDCAN";
+		case STLINK_BRIDGE_INIT_FILTER_FDCAN: return "INIT_FILTER_FDCAN";
+		case STLINK_BRIDGE_START_MSG_RECEPTION_FDCAN: return "START_MSG_RECEPTION_FDCAN";
+		case STLINK_BRIDGE_STOP_MSG_RECEPTION_FDCAN: return "STOP_MSG_RECEPTION_FDCAN";
+		case STLINK_BRIDGE_GET_NB_RXMSG_FDCAN: return "GET_NB_RXMSG_FDCAN";
+		case STLINK_BRIDGE_GET_RXMSG_FDCAN: return "GET_RXMSG_FDCAN";
+		case STLINK_BRIDGE_START_FDCAN: return "START_FDCAN";
+		case STLINK_BRIDGE_STOP_FDCAN: return "STOP_FDCAN";
+		case STLINK_BRIDGE_INIT_NBITTIME_FDCAN: return "INIT_NBITTIME_FDCAN";
+		case STLINK_BRIDGE_INIT_DBITTIME_FDCAN: return "INIT_DBITTIME_FDCAN";
+		case STLINK_BRIDGE_INIT_GPIO: return "INIT_GPIO";
+		case STLINK_BRIDGE_SET_RESET_GPIO: return "SET_RESET_GPIO";
+		case STLINK_BRIDGE_READ_GPIO: return "READ_GPIO";
+		case ST_RBC_CMD: return "GET_VERSION";
+		case ST_GETVERSION_EXT: return "GET_VERSION_EXT";
+		case STLINK_GET_TARGET_VOLTAGE: return "GET_TARGET_VOLTAGE";
+		default: return "UNKNOWN";
+	}
+}
+
 /*
  * Analyze the STLink returned status if pStatus!=NULL and convert it to Bridge status
  */
@@ -436,6 +695,7 @@ Brg_StatusT Brg::AnalyzeStatus(const uint16_t *pStatus)
  */
 Brg_StatusT Brg::GetClk(uint8_t BrgCom, uint32_t *pBrgInputClk, uint32_t *pStlHClk)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[12]={0,0,0,0,0,0,0,0,0,0,0,0};
@@ -494,6 +754,7 @@ Brg_StatusT Brg::GetClk(uint8_t BrgCom, uint32_t *pBrgInputClk, uint32_t *pStlHC
  */
 Brg_StatusT Brg::InitSPI(const Brg_SpiInitT *pInitParams)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -638,6 +899,7 @@ Brg_StatusT Brg::GetSPIbaudratePrescal(uint32_t ReqSpiFreqKHz, Brg_SpiBaudrateT
  */
 Brg_StatusT Brg::SetSPIpinCS(Brg_SpiNssLevelT NssLevel)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -681,7 +943,7 @@ Brg_StatusT Brg::SetSPIpinCS(Brg_SpiNssLevelT NssLevel)
  */
 Brg_StatusT Brg::ReadSPI(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
-	STLink_DeviceRequestT *pRq;
+	BRG_TRACE_API();
 	Brg_StatusT brgStat;
 
 	if( m_bStlinkConnected == false ) {
@@ -695,24 +957,7 @@ Brg_StatusT Brg::ReadSPI(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSize
 		return BRG_NO_ERR;
 	}
 
-	pRq = new STLink_DeviceRequestT;
-	memset(pRq, 0, sizeof(STLink_DeviceRequestT));
-
-	pRq->CDBByte[0] = STLINK_BRIDGE_COMMAND;
-	pRq->CDBByte[1] = STLINK_BRIDGE_READ_SPI;
-	pRq->CDBByte[2] = (uint8_t)SizeInBytes;
-	pRq->CDBByte[3] = (uint8_t)(SizeInBytes>>8);
-
-	pRq->CDBLength = STLINK_BRIDGE_CMD_SIZE_16;
-	pRq->BufferLength = SizeInBytes;
-	pRq->InputRequest = REQUEST_READ_1ST_EPIN;
-	pRq->Buffer = pBuffer;
-
-	pRq->SenseLength=DEFAULT_SENSE_LEN;
-
-	brgStat = SendRequestAndAnalyzeStatus(pRq, NULL);
-
-	delete pRq;
+	brgStat = ReadSPIcmd(pBuffer, SizeInBytes);
 
 	if( brgStat == BRG_NO_ERR )
 	{	// pErrorInfo currently unused
@@ -753,7 +998,7 @@ Brg_StatusT Brg::ReadSPI(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSize
  */
 Brg_StatusT Brg::WriteSPI(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
-	STLink_DeviceRequestT *pRq;
+	BRG_TRACE_API();
 	Brg_StatusT brgStat;
 
 	if( m_bStlinkConnected == false ) {
@@ -767,6 +1012,175 @@ Brg_StatusT Brg::WriteSPI(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t
 		return BRG_NO_ERR;
 	}
 
+	brgStat = WriteSPIcmd(pBuffer, SizeInBytes);
+
+	if( brgStat == BRG_NO_ERR )
+	{	// pErrorInfo currently unused
+		brgStat = GetLastReadWriteStatus(pSizeWritten,NULL);
+	}
+
+	if( brgStat != BRG_NO_ERR ) {
+		LogTrace("SPI Error (%d) in WriteSPI (%d bytes)", (int)brgStat,(int)SizeInBytes);
+		if( pSizeWritten != NULL ) {
+			LogTrace("SPI Only %d bytes written without error",(int)*pSizeWritten);
+		}
+	}
+	return brgStat;
+}
+/**
+ * @ingroup SPI
+ * @brief Same as Brg::ReadSPI() for any size: the transfer is split in chunks of whole USB
+ *        packets (up to 65024 bytes), chip select is not changed between chunks.
+ *        The status (Brg::GetLastReadWriteStatus()) of each chunk is checked before the next
+ *        one: the firmware keeps the status of the last command only. The commands are the
+ *        same as a Brg::ReadSPI() loop of ChunkSize bytes (no command is queued ahead).
+ * @param[out] pBuffer Pointer on data buffer filled with read data.
+ * @param[in]  SizeInBytes Data size to be read in bytes (even in #SPI_DATASIZE_16B).
+ * @param[out] pSizeRead If not NULL, number of bytes read and checked without error (the
+ *             failing chunk is not counted).
+ * @param[in]  ChunkSize Max bytes per command, rounded down to USB packets (512 bytes multiple).
+ *
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_PARAM_ERR If NULL pointer or ChunkSize less than 2
+ * @retval #BRG_COM_INIT_NOT_DONE If SPI is not initialized
+ * @retval #BRG_SPI_ERR In case of SPI read error
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT Brg::ReadStreamSPI(uint8_t *pBuffer, uint32_t SizeInBytes, uint32_t *pSizeRead,
+                               uint16_t ChunkSize)
+{
+	BRG_TRACE_API();
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t doneSize = 0;
+	uint16_t chunkSize, size;
+
+	if( pSizeRead != NULL ) {
+		*pSizeRead = 0;
+	}
+	if( m_bStlinkConnected == false ) {
+		// The function should be called at least after OpenStlink
+		return BRG_NO_STLINK;
+	}
+	if( (pBuffer == NULL) || (ChunkSize < 2) ) {
+		return BRG_PARAM_ERR;
+	}
+	chunkSize = GetStreamChunkSPI(ChunkSize, false);
+
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		size = (SizeInBytes - doneSize > chunkSize) ? chunkSize : (uint16_t)(SizeInBytes - doneSize);
+		brgStat = ReadSPIcmd(&pBuffer[doneSize], size);
+		if( brgStat == BRG_NO_ERR ) {
+			brgStat = GetLastReadWriteStatus(NULL, NULL);
+		}
+		if( brgStat == BRG_NO_ERR ) {
+			doneSize += size;
+		}
+	}
+	if( pSizeRead != NULL ) {
+		*pSizeRead = doneSize;
+	}
+	if( brgStat != BRG_NO_ERR ) {
+		LogTrace("SPI Error (%d) in ReadStreamSPI (%lu bytes, %lu read without error)", (int)brgStat,
+		         (unsigned long)SizeInBytes, (unsigned long)doneSize);
+	}
+	return brgStat;
+}
+/**
+ * @ingroup SPI
+ * @brief Same as Brg::WriteSPI() for any size: the transfer is split in chunks of 8 bytes
+ *        (sent in the command) plus whole USB packets (up to 65032 bytes), chip select is not
+ *        changed between chunks. The status (Brg::GetLastReadWriteStatus()) of each chunk is
+ *        checked before the next one: the firmware keeps the status of the last command only.
+ *        The commands are the same as a Brg::WriteSPI() loop of ChunkSize bytes.
+ * @param[in]  pBuffer Pointer on data buffer with data to be sent.
+ * @param[in]  SizeInBytes Data size to be sent in bytes (even in #SPI_DATASIZE_16B).
+ * @param[out] pSizeWritten If not NULL, number of bytes written and checked without error (the
+ *             failing chunk is not counted).
+ * @param[in]  ChunkSize Max bytes per command, rounded down to 8 + USB packets (512 bytes multiple).
+ *
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_PARAM_ERR If NULL pointer or ChunkSize less than 2
+ * @retval #BRG_COM_INIT_NOT_DONE If SPI is not initialized
+ * @retval #BRG_SPI_ERR In case of SPI write error
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT Brg::WriteStreamSPI(const uint8_t *pBuffer, uint32_t SizeInBytes, uint32_t *pSizeWritten,
+                                uint16_t ChunkSize)
+{
+	BRG_TRACE_API();
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t doneSize = 0;
+	uint16_t chunkSize, size;
+
+	if( pSizeWritten != NULL ) {
+		*pSizeWritten = 0;
+	}
+	if( m_bStlinkConnected == false ) {
+		// The function should be called at least after OpenStlink
+		return BRG_NO_STLINK;
+	}
+	if( (pBuffer == NULL) || (ChunkSize < 2) ) {
+		return BRG_PARAM_ERR;
+	}
+	chunkSize = GetStreamChunkSPI(ChunkSize, true);
+
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		size = (SizeInBytes - doneSize > chunkSize) ? chunkSize : (uint16_t)(SizeInBytes - doneSize);
+		brgStat = WriteSPIcmd(&pBuffer[doneSize], size);
+		if( brgStat == BRG_NO_ERR ) {
+			brgStat = GetLastReadWriteStatus(NULL, NULL);
+		}
+		if( brgStat == BRG_NO_ERR ) {
+			doneSize += size;
+		}
+	}
+	if( pSizeWritten != NULL ) {
+		*pSizeWritten = doneSize;
+	}
+	if( brgStat != BRG_NO_ERR ) {
+		LogTrace("SPI Error (%d) in WriteStreamSPI (%lu bytes, %lu written without error)", (int)brgStat,
+		         (unsigned long)SizeInBytes, (unsigned long)doneSize);
+	}
+	return brgStat;
+}
+/*
+ * private: STLINK_BRIDGE_READ_SPI command only (see Brg::ReadSPI), status not read
+ */
+Brg_StatusT Brg::ReadSPIcmd(uint8_t *pBuffer, uint16_t SizeInBytes)
+{
+	STLink_DeviceRequestT *pRq;
+	Brg_StatusT brgStat;
+
+	pRq = new STLink_DeviceRequestT;
+	memset(pRq, 0, sizeof(STLink_DeviceRequestT));
+
+	pRq->CDBByte[0] = STLINK_BRIDGE_COMMAND;
+	pRq->CDBByte[1] = STLINK_BRIDGE_READ_SPI;
+	pRq->CDBByte[2] = (uint8_t)SizeInBytes;
+	pRq->CDBByte[3] = (uint8_t)(SizeInBytes>>8);
+
+	pRq->CDBLength = STLINK_BRIDGE_CMD_SIZE_16;
+	pRq->BufferLength = SizeInBytes;
+	pRq->InputRequest = REQUEST_READ_1ST_EPIN;
+	pRq->Buffer = pBuffer;
+
+	pRq->SenseLength=DEFAULT_SENSE_LEN;
+
+	brgStat = SendRequestAndAnalyzeStatus(pRq, NULL);
+
+	delete pRq;
+	return brgStat;
+}
+/*
+ * private: STLINK_BRIDGE_WRITE_SPI command only (see Brg::WriteSPI), status not read
+ */
+Brg_StatusT Brg::WriteSPIcmd(const uint8_t *pBuffer, uint16_t SizeInBytes)
+{
+	STLink_DeviceRequestT *pRq;
+	Brg_StatusT brgStat;
+
 	pRq = new STLink_DeviceRequestT;
 	memset(pRq, 0, sizeof(STLink_DeviceRequestT));
 	pRq->CDBLength = STLINK_BRIDGE_CMD_SIZE_16;
@@ -799,19 +1213,20 @@ Brg_StatusT Brg::WriteSPI(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t
 	brgStat = SendRequestAndAnalyzeStatus(pRq, NULL);
 
 	delete pRq;
+	return brgStat;
+}
+/*
+ * private: stream chunk size, data phase rounded to full USB packets (the 8 first bytes
+ * of a write are sent in the command) and even for 16-bit SPI data
+ */
+uint16_t Brg::GetStreamChunkSPI(uint16_t ChunkSize, bool bIsWrite)
+{
+	uint16_t headSize = (bIsWrite == true) ? 8 : 0;
 
-	if( brgStat == BRG_NO_ERR )
-	{	// pErrorInfo currently unused
-		brgStat = GetLastReadWriteStatus(pSizeWritten,NULL);
-	}
-
-	if( brgStat != BRG_NO_ERR ) {
-		LogTrace("SPI Error (%d) in WriteSPI (%d bytes)", (int)brgStat,(int)SizeInBytes);
-		if( pSizeWritten != NULL ) {
-			LogTrace("SPI Only %d bytes written without error",(int)*pSizeWritten);
-		}
+	if( ChunkSize >= headSize + BRG_USB_HS_PACKET_SIZE ) {
+		return headSize + ((ChunkSize - headSize) / BRG_USB_HS_PACKET_SIZE) * BRG_USB_HS_PACKET_SIZE;
 	}
-	return brgStat;
+	return ChunkSize & ~((uint16_t)1);
 }
 /**
  * @ingroup I2C
@@ -826,6 +1241,7 @@ Brg_StatusT Brg::WriteSPI(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t
  */
 Brg_StatusT Brg::InitI2C(const Brg_I2cInitT *pInitParams)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -895,6 +1311,9 @@ Brg_StatusT Brg::InitI2C(const Brg_I2cInitT *pInitParams)
  * @param[in]  FallTime In ns, 0-300ns (STANDARD), 0-300ns (FAST), 0-120ns (FAST PLUS)
  * @param[in]  bAF  Use true for Analog Filter ON or false for Analog Filter OFF
  * @param[out] pTimingReg  Filled with timing parameter required by Brg::InitI2C().
+ * @note The I2C input clock is read at each call (it changes with an STLink frequency switch
+ *       done on the debug interface) and the last #BRG_I2C_TIMING_CACHE_NB results are kept
+ *       per clock: a repeated call costs one USB command but no calculation.
  *
  * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
  * @retval #BRG_PARAM_ERR Null pointer parameter
@@ -904,8 +1323,8 @@ Brg_StatusT Brg::GetI2cTiming(I2cModeT I2CSpeedMode, int SpeedFrequency, int DNF
                               int RiseTime, int FallTime, bool bAF, uint32_t *pTimingReg)
 {
 	Brg_StatusT brgStatus=BRG_NO_ERR;
-	double clockSource;
 	uint32_t stlHClkKHz, i2cInputClkKHz;
+	I2cTimingCacheT *pEntry;
 
 	if( pTimingReg == NULL ) {
 		return BRG_PARAM_ERR;
@@ -925,112 +1344,106 @@ Brg_StatusT Brg::GetI2cTiming(I2cModeT I2CSpeedMode, int SpeedFrequency, int DNF
 		return BRG_PARAM_ERR;
 	}
 
-	// Get the current I2C input Clk
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	// Get the I2C input Clk
 	brgStatus = GetClk(COM_I2C, &i2cInputClkKHz, &stlHClkKHz);
-	if( brgStatus == BRG_NO_ERR ) {
-		clockSource = (double)i2cInputClkKHz;
-		brgStatus = CalculateI2cTimingReg(I2CSpeedMode, SpeedFrequency, clockSource, DNFn,
-		                                  RiseTime, FallTime, bAF, pTimingReg);
+	if( brgStatus != BRG_NO_ERR ) {
+		return brgStatus;
+	}
+	for( int i = 0; i < BRG_I2C_TIMING_CACHE_NB; i++ ) {
+		pEntry = &m_i2cTimingCache[i];
+		if( (pEntry->bValid == true) && (pEntry->I2CSpeedMode == I2CSpeedMode) &&
+		    (pEntry->SpeedFrequency == SpeedFrequency) && (pEntry->DNFn == DNFn) &&
+		    (pEntry->RiseTime == RiseTime) && (pEntry->FallTime == FallTime) && (pEntry->bAF == bAF) &&
+		    (pEntry->ClockKHz == i2cInputClkKHz) ) {
+			*pTimingReg = pEntry->TimingReg;
+			return pEntry->Status;
+		}
 	}
+	brgStatus = CalculateI2cTimingReg(I2CSpeedMode, SpeedFrequency, (double)i2cInputClkKHz, DNFn,
+	                                  RiseTime, FallTime, bAF, pTimingReg);
+	pEntry = &m_i2cTimingCache[m_i2cTimingCacheNext];
+	m_i2cTimingCacheNext = (m_i2cTimingCacheNext + 1) % BRG_I2C_TIMING_CACHE_NB;
+	pEntry->bValid = true;
+	pEntry->I2CSpeedMode = I2CSpeedMode;
+	pEntry->SpeedFrequency = SpeedFrequency;
+	pEntry->DNFn = DNFn;
+	pEntry->RiseTime = RiseTime;
+	pEntry->FallTime = FallTime;
+	pEntry->bAF = bAF;
+	pEntry->ClockKHz = i2cInputClkKHz;
+	pEntry->Status = brgStatus;
+	pEntry->TimingReg = *pTimingReg;
 
 	return brgStatus;
 }
+/*
+ * Forget the GetI2cTiming() results: done by the constructor, Brg::OpenStlink(),
+ * Brg::CloseStlink() and Brg::CloseBridge(#COM_I2C)
+ */
+void Brg::ClearI2cTimingCache(void)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	for( int i = 0; i < BRG_I2C_TIMING_CACHE_NB; i++ ) {
+		m_i2cTimingCache[i].bValid = false;
+	}
+	m_i2cTimingCacheNext = 0;
+}
+/*
+ * SCL frequency for the given prescaled clock period, SCL low time (tsync included) and
+ * SCLH, tSclHigh returned in pTSclHigh. Same computation order as the reference search so
+ * that the results are identical.
+ */
+static double I2cSclSpeed(double Presc, double TSclLow, int Sclh, double Tsync, double RiseTime,
+                          double FallTime, double *pTSclHigh)
+{
+	double tSclHigh = (double)(Sclh + 1) * (double)Presc;
+
+	tSclHigh = (double)tSclHigh + (double)Tsync;
+	*pTSclHigh = tSclHigh;
+	return 1 / (double)((double)TSclLow + (double)tSclHigh + (double)RiseTime + (double)FallTime);
+}
 /*
  * Internal function used by GetI2cTiming()
+ * Selects the smallest prescaler, then the largest SCLL and SCLH giving the smallest
+ * frequency error (same result as an exhaustive PRESC/SCLL/SCLH search). The SCL frequency
+ * decreases with SCLL and SCLH: for each SCLL only the SCLH on both sides of the target
+ * frequency are candidates, and the SCLL loop stops once SCLH=0 is below the minimum.
  */
 Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency, double ClockSource, int DNFn,
                                        int RiseTime, int FallTime, bool bAF, uint32_t *pTimingReg)
 {
-#define MAX_I2C_MODEL_NB 40
 	Brg_StatusT brgStatus=BRG_NO_ERR;
 
 	if( (SpeedFrequency == 0) || (ClockSource == 0) || (pTimingReg == NULL) ) {
 		return BRG_PARAM_ERR;
 	}
 
-    // SCLL & SCLH  settings
-    int *pSCLL = new int[SCLL_LENGTH];
-    int *pSCLH = new int[SCLH_LENGTH];
-
-    //SCLDEL & SDLDEL settings
-    int *pSCLDEL = new int[SCLDEL_LENGTH];
-    int *pSDADEL = new int[SCLDEL_LENGTH];
-    // PRESC settings
-    int *pPRESC = new int[PRESC_LENGTH];
-    int *pPRESCvalid = new int[16];
-
-    // Variables for solution  (SCLDEL , SDLDEL  and PRESC)
-    Brg_I2cModelT *pPrescSDLDELSCLDELpossComb = new Brg_I2cModelT[MAX_I2C_MODEL_NB]; // possible combination table
-    int prescSDLDELSCLDELpossCombSize = 0;
-    int tabIndex = 0;
-
-    // Variables for Boundaries
-    double *pTFallMax = new double[MODE_NUMBER];
-    double *pTRiseMax = new double[MODE_NUMBER];
-    double *pTHdDatMax = new double[MODE_NUMBER];
-    double *pTSuDatMin = new double[MODE_NUMBER];
-    double *pTLowMin = new double[MODE_NUMBER];
-    double *pTHighMin = new double[MODE_NUMBER];
-
-    double targetFreqI2C;   // Target frequency
-    double targetPeriodI2C; // Target period of clock
-    double tmpSCLDEL;       // Calculate SCLDEL Time from  SCLDEL Bit
-    double tmpSDADEL;       // Calculate SDLDEL Time from  SDLDEL Bit
-    double clkMax;
-    double clkMin;
-    int idx=0;              // Get I2c mode speed
-    double clkI2C;          // Clock frequency
-    double clkPeriodI2C;    // Period of clock
-
-    double delayAF;
-    double delayDNF;
-    double delayFilter;
-    double riseTimeCalc;   // Rise time
-    double fallTimeCalc;   // Fall time
-    double tmpMinSDADEL;   // SDADEL range
-    double tmpMaxSDADEL;   // SDADEL range
-    double tmpMinSCLDEL;   // SCLDEL range
-    int nbValid;           // Number of valid solution
-    int tmpPRESC;          // Current prescaler
-
-	// Timing handling
-	int i;
-	for (i = 0; i < SCLL_LENGTH; i++) {
-		pSCLL[i] = i;//current SCLL value
-		pSCLH[i] = i;//cuirrent SCLH value
-	}
-	for (i = 0; i < SCLDEL_LENGTH; i++) {
-		pPRESC[i] = i;//current Presc value
-		pSCLDEL[i] = i;
-		pSDADEL[i] = i;
-		pPRESCvalid[i] = 99;
-	}
-	pTFallMax[0] = TFALL_MAX_T0;
-	pTFallMax[1] = TFALL_MAX_T1;
-	pTFallMax[2] = TFALL_MAX_T2;
-
-	pTRiseMax[0] = TRISE_MAX_T0;
-	pTRiseMax[1] = TRISE_MAX_T1;
-	pTRiseMax[2] = TRISE_MAX_T2;
-
-	pTHdDatMax[0] = THDDAT_MAX_T0;
-	pTHdDatMax[1] = THDDAT_MAX_T1;
-	pTHdDatMax[2] = THDDAT_MAX_T2;
-
-	pTSuDatMin[0] = TSUDAT_MIN_T0;
-	pTSuDatMin[1] = TSUDAT_MIN_T1;
-	pTSuDatMin[2] = TSUDAT_MIN_T2;
-
-	pTLowMin[0] = TLOW_MIN0;
-	pTLowMin[1] = TLOW_MIN1;
-	pTLowMin[2] = TLOW_MIN2;
-
-	pTHighMin[0] = THIGH_MIN0;
-	pTHighMin[1] = THIGH_MIN1;
-	pTHighMin[2] = THIGH_MIN2;
+	// Valid prescalers with their smallest SCLDEL and SDADEL
+	int prescValid[PRESC_LENGTH];
+	int scldelValid[PRESC_LENGTH];
+	int sdadelValid[PRESC_LENGTH];
+
+	double targetFreqI2C;   // Target frequency
+	double tmpSCLDEL;       // Calculate SCLDEL Time from  SCLDEL Bit
+	double tmpSDADEL;       // Calculate SDLDEL Time from  SDLDEL Bit
+	double clkMax;
+	double clkMin;
+	int idx=0;              // Get I2c mode speed
+	double clkI2C;          // Clock frequency
+	double clkPeriodI2C;    // Period of clock
+
+	double delayAF;
+	double delayDNF;
+	double delayFilter;
+	double riseTimeCalc;   // Rise time
+	double fallTimeCalc;   // Fall time
+	double tmpMinSDADEL;   // SDADEL range
+	double tmpMaxSDADEL;   // SDADEL range
+	double tmpMinSCLDEL;   // SCLDEL range
+	int nbValid;           // Number of valid solution
 
 	targetFreqI2C = SpeedFrequency * 1000;   // Speed frequency
-	targetPeriodI2C = (1 / (targetFreqI2C)); // Speed period
 
 	clkMax = targetFreqI2C + targetFreqI2C * 0.2;
 	clkMin = targetFreqI2C - targetFreqI2C * 0.2;
@@ -1061,7 +1474,7 @@ Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency
 
 	tmpMinSDADEL = (double)((double)fallTimeCalc - (50 / (double)pow((double)10, 9))
 	                - (double)((DNFn + 3) * clkPeriodI2C));
-	tmpMaxSDADEL = (double)((double)pTHdDatMax[idx] - riseTimeCalc - (1 * (260 / (double)pow((double)10, 9)))
+	tmpMaxSDADEL = (double)((double)I2C_THDDAT_MAX[idx] - riseTimeCalc - (1 * (260 / (double)pow((double)10, 9)))
 		            - (double)((DNFn + 4) * clkPeriodI2C));
 	if( tmpMaxSDADEL < 0 ) {
 		tmpMaxSDADEL = 0;
@@ -1070,118 +1483,107 @@ Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency
 		tmpMinSDADEL = 0;
 	}
 
-	tmpMinSCLDEL = (double)((double)riseTimeCalc + pTSuDatMin[idx]);
+	tmpMinSCLDEL = (double)((double)riseTimeCalc + I2C_TSUDAT_MIN[idx]);
 	if( tmpMinSCLDEL < 0 ) {
 		tmpMinSCLDEL = 0;
 	}
 
+	// SDLDEL and SCLDEL calculation: the first SCLDEL and SDADEL in range for each prescaler
 	nbValid = 0;
-
-	tmpPRESC = 99;
-	// End of timing handling
-
-	// SDLDEL and SCLDEL calculation
-	for( int i1 = 0; i1 < PRESC_LENGTH; i1++ ) {
-
-		for( int i3 = 0; i3 < SCLDEL_LENGTH; i3++ ) {
-			tmpSCLDEL = (double)((pSCLDEL[i3] + 1) * (double)((pPRESC[i1] + 1) * clkPeriodI2C));
-
-			for( int i2 = 0; i2 < SCLDEL_LENGTH; i2++ ) {
-				tmpSDADEL = (double)(pSDADEL[i2] * (double)((pPRESC[i1] + 1) * clkPeriodI2C));
-				if( (tmpSDADEL >= tmpMinSDADEL) && (tmpSDADEL <= tmpMaxSDADEL) && (tmpSCLDEL >= tmpMinSCLDEL) ) {
-					if( pPRESC[i1] != tmpPRESC ) {
-						pPRESCvalid[nbValid] = pPRESC[i1];
-						tmpPRESC = pPRESCvalid[nbValid];
-						nbValid = nbValid + 1;
-						if( tabIndex < MAX_I2C_MODEL_NB ) {
-							pPrescSDLDELSCLDELpossComb[tabIndex].prescaler = i1;
-							pPrescSDLDELSCLDELpossComb[tabIndex].SDLDEL=i2;
-							pPrescSDLDELSCLDELpossComb[tabIndex].SCLDEL=i3;
-							pPrescSDLDELSCLDELpossComb[tabIndex].resultat=1;
-							prescSDLDELSCLDELpossCombSize++;
-						}
-						// else MAX_I2C_MODEL_NB should be incremented or use dynamic memory
-						tabIndex++;
-					}
-				}
+	for( int presc = 0; presc < PRESC_LENGTH; presc++ ) {
+		int scldel, sdadel;
+		for( scldel = 0; scldel < SCLDEL_LENGTH; scldel++ ) {
+			tmpSCLDEL = (double)((scldel + 1) * (double)((presc + 1) * clkPeriodI2C));
+			if( tmpSCLDEL >= tmpMinSCLDEL ) {
+				break;
 			}
 		}
+		for( sdadel = 0; sdadel < SCLDEL_LENGTH; sdadel++ ) {
+			tmpSDADEL = (double)(sdadel * (double)((presc + 1) * clkPeriodI2C));
+			if( (tmpSDADEL >= tmpMinSDADEL) && (tmpSDADEL <= tmpMaxSDADEL) ) {
+				break;
+			}
+		}
+		if( (scldel < SCLDEL_LENGTH) && (sdadel < SCLDEL_LENGTH) ) {
+			prescValid[nbValid] = presc;
+			scldelValid[nbValid] = scldel;
+			sdadelValid[nbValid] = sdadel;
+			nbValid++;
+		}
 	}
 
 	// SCLL SCLH calculation
-	int l = 0;
 	double solution = 0;
 	double prescR = 99;
-	int sdadel = 0;
-	int scldel = 0;
 	int i1Sel = 0;
 	int i2Sel = 0;
 	int i3Sel = 0;
 	double errorTarget = 0.2;
 	double tsync = (double)delayFilter + (2 * clkPeriodI2C);
-	Brg_I2cModelT s;
-
-	if( nbValid != 0 ) {
-		for( int i3 = nbValid - 1; i3 >= 0; i3-- ) {
-			for( int i1 = 0; i1 < SCLL_LENGTH; i1++ ) {
-				for( int i2 = 0; i2 < SCLH_LENGTH; i2++ ) {
-					double presc = (double)(pPRESCvalid[i3] + 1) * (double)clkPeriodI2C;
-					double tSclLow = (double)(pSCLL[i1] + 1) * (double)presc;
-					double tSclHigh = (double)(pSCLH[i2] + 1) * (double)presc;
-
-					tSclLow = (double)tSclLow + (double)tsync;
-					tSclHigh = (double)tSclHigh + (double)tsync;
-					double tScl = (double)tSclLow + (double)tSclHigh + (double)riseTimeCalc + (double)fallTimeCalc;
-					double speed = 1 / (double)tScl;
-
-					if( (speed >= clkMin) && (speed <= clkMax) && (tSclLow >= pTLowMin[idx]) &&
-					    (tSclHigh >= pTHighMin[idx]) && (clkPeriodI2C < ((tSclLow - delayFilter) / 4)) &&
-					    (clkPeriodI2C < tSclHigh) ) {
-						double errorTmp = (double)(speed - targetFreqI2C) / (double)(targetFreqI2C);
-						if( errorTmp < 0 ) {
-							double x = (double)(0 - (double)errorTmp);
-							s.prescaler = i1;
-							s.SDLDEL=i2;
-							s.SCLDEL=i3;
-							s.resultat=x;
-						} else {
-							s.prescaler = i1;
-							s.SDLDEL=i2;
-							s.SCLDEL=i3;
-							s.resultat=errorTmp;
-						}
-					} else {
-						s.prescaler = i1;
-						s.SDLDEL=i2;
-						s.SCLDEL=i3;
-						s.resultat=1;
-					}
 
-					if( (s.resultat <= errorTarget) && (pPRESCvalid[i3] <= prescR) ) {
-						prescR = pPRESCvalid[i3];
-						solution = 1;
-						errorTarget = (double)s.resultat;
-						i1Sel = i1;
-						i2Sel = i2;
-						i3Sel = i3;
-					}
+	for( int i3 = nbValid - 1; i3 >= 0; i3-- ) {
+		double presc = (double)(prescValid[i3] + 1) * (double)clkPeriodI2C;
+		for( int i1 = 0; i1 < SCLL_LENGTH; i1++ ) {
+			double tSclLow = (double)(i1 + 1) * (double)presc;
+			double tSclHigh;
+			int cand[2];
+			int candNb = 0;
+			int i2;
+
+			tSclLow = (double)tSclLow + (double)tsync;
+			if( (tSclLow < I2C_TLOW_MIN[idx]) || (clkPeriodI2C >= ((tSclLow - delayFilter) / 4)) ) {
+				continue;
+			}
+			if( I2cSclSpeed(presc, tSclLow, 0, tsync, riseTimeCalc, fallTimeCalc, &tSclHigh) < clkMin ) {
+				// Too slow already with SCLH=0, and slower for the next SCLL
+				break;
+			}
+			// i2: last SCLH at or above the target frequency (-1 if none)
+			i2 = (int)floor((1 / targetFreqI2C - tSclLow - tsync - riseTimeCalc - fallTimeCalc) / presc) - 1;
+			if( i2 < -1 ) {
+				i2 = -1;
+			} else if( i2 > SCLH_LENGTH - 1 ) {
+				i2 = SCLH_LENGTH - 1;
+			}
+			while( (i2 < SCLH_LENGTH - 1) &&
+			       (I2cSclSpeed(presc, tSclLow, i2 + 1, tsync, riseTimeCalc, fallTimeCalc, &tSclHigh) >= targetFreqI2C) ) {
+				i2++;
+			}
+			while( (i2 >= 0) &&
+			       (I2cSclSpeed(presc, tSclLow, i2, tsync, riseTimeCalc, fallTimeCalc, &tSclHigh) < targetFreqI2C) ) {
+				i2--;
+			}
+			// Error decreasing up to i2 then increasing: candidates are i2 and the first valid SCLH above
+			if( i2 >= 0 ) {
+				double speed = I2cSclSpeed(presc, tSclLow, i2, tsync, riseTimeCalc, fallTimeCalc, &tSclHigh);
+				if( (speed >= clkMin) && (speed <= clkMax) && (tSclHigh >= I2C_THIGH_MIN[idx]) &&
+				    (clkPeriodI2C < tSclHigh) ) {
+					cand[candNb++] = i2;
 				}
 			}
-		}
-		int x = 0;
-		for( int i2 = 0; i2 < 16; i2++ ) {
-			for( int i3 = 0; i3 < 16; i3++ ) {
-				for( int j = 0; j < prescSDLDELSCLDELpossCombSize; j++ ) {
-					if( (pPrescSDLDELSCLDELpossComb[j].resultat == 1) &&
-					    (pPrescSDLDELSCLDELpossComb[j].prescaler == pPRESCvalid[i3Sel]) &&
-					    (pPrescSDLDELSCLDELpossComb[j].SDLDEL == i2) &&
-					    (pPrescSDLDELSCLDELpossComb[j].SCLDEL == i3) &&
-					    (x == 0) ) {
-						l = pPRESCvalid[i3Sel];
-						sdadel = i2;
-						scldel = i3;
-						x++;
-					}
+			for( i2 = i2 + 1; i2 < SCLH_LENGTH; i2++ ) {
+				double speed = I2cSclSpeed(presc, tSclLow, i2, tsync, riseTimeCalc, fallTimeCalc, &tSclHigh);
+				if( speed < clkMin ) {
+					break;
+				}
+				if( (speed <= clkMax) && (tSclHigh >= I2C_THIGH_MIN[idx]) && (clkPeriodI2C < tSclHigh) ) {
+					cand[candNb++] = i2;
+					break;
+				}
+			}
+			for( int c = 0; c < candNb; c++ ) {
+				double speed = I2cSclSpeed(presc, tSclLow, cand[c], tsync, riseTimeCalc, fallTimeCalc, &tSclHigh);
+				double errorTmp = (double)(speed - targetFreqI2C) / (double)(targetFreqI2C);
+				if( errorTmp < 0 ) {
+					errorTmp = (double)(0 - (double)errorTmp);
+				}
+				if( (errorTmp <= errorTarget) && (prescValid[i3] <= prescR) ) {
+					prescR = prescValid[i3];
+					solution = 1;
+					errorTarget = (double)errorTmp;
+					i1Sel = i1;
+					i2Sel = cand[c];
+					i3Sel = i3;
 				}
 			}
 		}
@@ -1189,10 +1591,10 @@ Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency
 	// Get results
 	*pTimingReg=0;
 	if( solution==1 ) {
-		*pTimingReg = (uint32_t) ((uint32_t)pPRESCvalid[i3Sel]<<28 | // Bits 31:28 PRESC[3:0]: Timing prescaler
-					(uint32_t)scldel<<20 | // Bits 27:24 Reserved, must be kept at reset value.
+		*pTimingReg = (uint32_t) ((uint32_t)prescValid[i3Sel]<<28 | // Bits 31:28 PRESC[3:0]: Timing prescaler
+					(uint32_t)scldelValid[i3Sel]<<20 | // Bits 27:24 Reserved, must be kept at reset value.
 		                                   // Bits 23:20 SCLDEL[3:0]: Data setup time
-					(uint32_t)sdadel<<16 | // Bits 19:16 SDADEL[3:0]: Data hold time
+					(uint32_t)sdadelValid[i3Sel]<<16 | // Bits 19:16 SDADEL[3:0]: Data hold time
 					(uint32_t)i2Sel<<8 | // Bits 15:8 SCLH[7:0]: SCL high period (master mode)
 					(uint32_t)i1Sel); // Bits 7:0 SCLL[7:0]: SCL low period (master mode)
 		brgStatus = BRG_NO_ERR;
@@ -1200,20 +1602,6 @@ Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency
 		brgStatus = BRG_PARAM_ERR;
 	}
 
-    delete [] pSCLL;
-    delete [] pSCLH;
-	delete [] pSCLDEL;
-    delete [] pSDADEL;
-    delete [] pPRESC;
-    delete [] pPRESCvalid;
-	delete [] pPrescSDLDELSCLDELpossComb;
-    delete [] pTFallMax;
-    delete [] pTRiseMax;
-    delete [] pTHdDatMax;
-    delete [] pTSuDatMin;
-    delete [] pTLowMin;
-    delete [] pTHighMin;
-
 	return brgStatus;
 }
 /**
@@ -1236,6 +1624,7 @@ Brg_StatusT Brg::CalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency
  */
 Brg_StatusT Brg::ReadI2C(uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	return ReadI2Ccmd(pBuffer, Addr, SizeInBytes, I2C_FULL_RW_TRANS, pSizeRead, NULL);
 }
 /**
@@ -1251,6 +1640,7 @@ Brg_StatusT Brg::ReadI2C(uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBytes,
 Brg_StatusT Brg::ReadI2C(uint8_t *pBuffer, uint16_t Addr, Brg_I2cAddrModeT AddrMode,
                          uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	 uint16_t slaveAddr = Addr; // default bit15=0 7b
 	 if( AddrMode == I2C_ADDR_10BIT ) {
 		slaveAddr = I2C_10B_ADDR(Addr); // set bit15 to 1 for 10b
@@ -1344,6 +1734,7 @@ Brg_StatusT Brg::ReadI2Ccmd(uint8_t *pBuffer, uint16_t Addr,
  */
 Brg_StatusT Brg::StartReadI2C(uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	m_slaveAddrPartialI2cTrans = Addr;
 	status = ReadI2Ccmd(pBuffer, Addr, SizeInBytes, I2C_START_RW_TRANS, pSizeRead, NULL);
@@ -1362,6 +1753,7 @@ Brg_StatusT Brg::StartReadI2C(uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBy
 Brg_StatusT Brg::StartReadI2C(uint8_t *pBuffer, uint16_t Addr, Brg_I2cAddrModeT AddrMode,
                               uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	 uint16_t slaveAddr = Addr; // default bit15=0 7b
 	 if( AddrMode == I2C_ADDR_10BIT ) {
 		slaveAddr = I2C_10B_ADDR(Addr); // set bit15 to 1 for 10b
@@ -1389,6 +1781,7 @@ Brg_StatusT Brg::StartReadI2C(uint8_t *pBuffer, uint16_t Addr, Brg_I2cAddrModeT
  */
 Brg_StatusT Brg::ContReadI2C(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	status = ReadI2Ccmd(pBuffer, m_slaveAddrPartialI2cTrans, SizeInBytes, I2C_CONT_RW_TRANS, pSizeRead, NULL);
 	return status;
@@ -1413,6 +1806,7 @@ Brg_StatusT Brg::ContReadI2C(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *p
  */
 Brg_StatusT Brg::StopReadI2C(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeRead)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	status = ReadI2Ccmd(pBuffer, m_slaveAddrPartialI2cTrans, SizeInBytes, I2C_STOP_RW_TRANS, pSizeRead, NULL);
 	return status;
@@ -1428,7 +1822,7 @@ Brg_StatusT Brg::StopReadI2C(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *p
  * - BUSY is returned in the status while I2C transaction at target side is not completed,
  * in BUSY state only Brg:GetLastReadWriteStatus() command can be sent to the firmware.
  * - Once status is no more BUSY, data can be retrieved using Brg:GetReadDataI2C().
- * - Data size limited to 512 bytes.
+ * - Data size limited to #I2C_NO_WAIT_MAX_SIZE (512) bytes.
  * @warning If other commands than STLINK_BRIDGE_GET_RWCMD_STATUS are sent to the STLink firmware
  *  while it is in BUSY state this can break the USB communication.
  *
@@ -1449,6 +1843,7 @@ Brg_StatusT Brg::StopReadI2C(uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *p
  */
 Brg_StatusT Brg::ReadNoWaitI2C(uint16_t Addr, uint16_t SizeInBytes, uint16_t *pSizeRead, uint16_t CmdTimeoutMs)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t targetCmdTimeout = 0; // Default timeout
@@ -1462,7 +1857,7 @@ Brg_StatusT Brg::ReadNoWaitI2C(uint16_t Addr, uint16_t SizeInBytes, uint16_t *pS
 		// Command supported starting firmware version B3
 		return BRG_CMD_NOT_SUPPORTED;
 	}
-	if( (SizeInBytes > 512) || (SizeInBytes==0) ) {
+	if( (SizeInBytes > I2C_NO_WAIT_MAX_SIZE) || (SizeInBytes==0) ) {
 		return BRG_PARAM_ERR;
 	}
 
@@ -1540,6 +1935,7 @@ Brg_StatusT Brg::ReadNoWaitI2C(uint16_t Addr, uint16_t SizeInBytes, uint16_t *pS
 Brg_StatusT Brg::ReadNoWaitI2C(uint16_t Addr, Brg_I2cAddrModeT AddrMode,
                                uint16_t SizeInBytes, uint16_t *pSizeRead, uint16_t CmdTimeoutMs)
 {
+	BRG_TRACE_API();
 	 uint16_t slaveAddr = Addr; // Default bit15=0 7b
 	 if( AddrMode == I2C_ADDR_10BIT ) {
 		slaveAddr = I2C_10B_ADDR(Addr); // Set bit15 to 1 for 10b
@@ -1564,6 +1960,7 @@ Brg_StatusT Brg::ReadNoWaitI2C(uint16_t Addr, Brg_I2cAddrModeT AddrMode,
 	 */
 Brg_StatusT Brg::GetReadDataI2C(uint8_t *pBuffer, uint16_t SizeInBytes)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 
@@ -1575,7 +1972,7 @@ Brg_StatusT Brg::GetReadDataI2C(uint8_t *pBuffer, uint16_t SizeInBytes)
 		// Command supported starting firmware version B3
 		return BRG_CMD_NOT_SUPPORTED;
 	}
-	if( (pBuffer == NULL) || (SizeInBytes > 512) ) {
+	if( (pBuffer == NULL) || (SizeInBytes > I2C_NO_WAIT_MAX_SIZE) ) {
 		return BRG_PARAM_ERR;
 	}
 	if( SizeInBytes==0 ) {
@@ -1642,6 +2039,7 @@ Brg_StatusT Brg::GetReadDataI2C(uint8_t *pBuffer, uint16_t SizeInBytes)
  */
 Brg_StatusT Brg::WriteI2C(const uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	return WriteI2Ccmd(pBuffer, Addr, SizeInBytes, I2C_FULL_RW_TRANS, pSizeWritten, NULL);
 }
 /**
@@ -1657,6 +2055,7 @@ Brg_StatusT Brg::WriteI2C(const uint8_t *pBuffer, uint16_t Addr, uint16_t SizeIn
 Brg_StatusT Brg::WriteI2C(const uint8_t *pBuffer, uint16_t Addr, Brg_I2cAddrModeT AddrMode,
 						  uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	 uint16_t slaveAddr = Addr; // default bit15=0 7b
 	 if( AddrMode == I2C_ADDR_10BIT ) {
 		slaveAddr = I2C_10B_ADDR(Addr); // set bit15 to 1 for 10b
@@ -1753,6 +2152,7 @@ Brg_StatusT Brg::WriteI2Ccmd(const uint8_t *pBuffer, uint16_t Addr,
  */
 Brg_StatusT Brg::StartWriteI2C(const uint8_t *pBuffer, uint16_t Addr, uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	m_slaveAddrPartialI2cTrans = Addr;
 	status = WriteI2Ccmd(pBuffer, Addr, SizeInBytes, I2C_START_RW_TRANS, pSizeWritten, NULL);
@@ -1771,6 +2171,7 @@ Brg_StatusT Brg::StartWriteI2C(const uint8_t *pBuffer, uint16_t Addr, uint16_t S
 Brg_StatusT Brg::StartWriteI2C(const uint8_t *pBuffer, uint16_t Addr, Brg_I2cAddrModeT AddrMode,
                             uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	 uint16_t slaveAddr = Addr; // default bit15=0 7b
 	 if( AddrMode == I2C_ADDR_10BIT ) {
 		slaveAddr = I2C_10B_ADDR(Addr); // set bit15 to 1 for 10b
@@ -1798,6 +2199,7 @@ Brg_StatusT Brg::StartWriteI2C(const uint8_t *pBuffer, uint16_t Addr, Brg_I2cAdd
  */
 Brg_StatusT Brg::ContWriteI2C(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	status = WriteI2Ccmd(pBuffer, m_slaveAddrPartialI2cTrans, SizeInBytes, I2C_CONT_RW_TRANS, pSizeWritten, NULL);
 	return status;
@@ -1822,6 +2224,7 @@ Brg_StatusT Brg::ContWriteI2C(const uint8_t *pBuffer, uint16_t SizeInBytes, uint
  */
 Brg_StatusT Brg::StopWriteI2C(const uint8_t *pBuffer, uint16_t SizeInBytes, uint16_t *pSizeWritten)
 {
+	BRG_TRACE_API();
 	Brg_StatusT status;
 	status = WriteI2Ccmd(pBuffer, m_slaveAddrPartialI2cTrans, SizeInBytes, I2C_STOP_RW_TRANS, pSizeWritten, NULL);
 	return status;
@@ -1839,6 +2242,99 @@ Brg_StatusT Brg::CheckBitTimeClassicCAN(const Brg_CanBitTimeConfT* pBitTimeConf)
 	}
 	return BRG_NO_ERR;
 }
+/*
+ * private function used by Brg::FindCANbitTiming() and Brg::FindFDCANbitTiming()
+ * Exhaustive search of N (1 + BS1 + BS2 time quanta) and prescaler giving exactly ReqBaudrate
+ * (CanClkHz = Prescaler x N x ReqBaudrate) within pLimits. For each N the BS2 closest to the
+ * requested sample point is kept; candidates are ranked by sample point error then by larger N
+ * (finer resynchronization), the best first.
+ */
+Brg_StatusT Brg::SolveBitTiming(uint32_t CanClkHz, uint32_t ReqBaudrate, uint16_t SamplePointPermil,
+                                const BitTimeLimitsT *pLimits, Brg_CanBitTimingT *pCandidates,
+                                uint8_t MaxCandidateNb, uint8_t *pCandidateNb)
+{
+	uint32_t n, nMax, prescal, bs1, bs2, bs2Min, bs2Max, bestBs2, pos;
+	uint32_t err, bestErr, candErr, candN;
+	uint8_t candNb = 0;
+	Brg_CanBitTimingT cand;
+
+	nMax = 1 + pLimits->Bs1Max + pLimits->Bs2Max;
+	for( n = 4; n <= nMax; n++ ) { // BS1 >= 2 (PROP_SEG and PHASE_SEG1 >= 1), BS2 >= 1
+		if( (CanClkHz % n) != 0 ) {
+			continue;
+		}
+		if( ((CanClkHz / n) % ReqBaudrate) != 0 ) {
+			continue;
+		}
+		prescal = CanClkHz / n / ReqBaudrate;
+		if( (prescal < 1) || (prescal > pLimits->PrescalerMax) ) {
+			continue;
+		}
+		// BS2 range for this N: 2 <= BS1 = N - 1 - BS2 <= Bs1Max
+		bs2Min = (n - 1 > pLimits->Bs1Max) ? (n - 1 - pLimits->Bs1Max) : 1;
+		bs2Max = n - 3;
+		if( bs2Max > pLimits->Bs2Max ) {
+			bs2Max = pLimits->Bs2Max;
+		}
+		if( bs2Min > bs2Max ) {
+			continue;
+		}
+		bestBs2 = bs2Min;
+		bestErr = 0xFFFFFFFF;
+		for( bs2 = bs2Min; bs2 <= bs2Max; bs2++ ) {
+			// |(N - BS2)/N - SamplePoint| in 1/1000 x N
+			err = ((n - bs2) * 1000 > SamplePointPermil * n) ? ((n - bs2) * 1000 - SamplePointPermil * n) :
+			                                                   (SamplePointPermil * n - (n - bs2) * 1000);
+			if( err < bestErr ) {
+				bestErr = err;
+				bestBs2 = bs2;
+			}
+		}
+		bs1 = n - 1 - bestBs2;
+		cand.Prescaler = prescal;
+		cand.BitTimeConf.PropSegInTq = (uint8_t)(bs1 / 2);
+		cand.BitTimeConf.PhaseSeg1InTq = (uint8_t)(bs1 - bs1 / 2);
+		if( cand.BitTimeConf.PhaseSeg1InTq > pLimits->SegMax ) {
+			continue;
+		}
+		cand.BitTimeConf.PhaseSeg2InTq = (uint8_t)bestBs2;
+		// SJW = min(SjwMax, PHASE_SEG1, PHASE_SEG2)
+		cand.BitTimeConf.SjwInTq = (uint8_t)((bestBs2 < pLimits->SjwMax) ? bestBs2 : pLimits->SjwMax);
+		if( cand.BitTimeConf.SjwInTq > cand.BitTimeConf.PhaseSeg1InTq ) {
+			cand.BitTimeConf.SjwInTq = cand.BitTimeConf.PhaseSeg1InTq;
+		}
+		cand.SamplePointPermil = (uint16_t)(((n - bestBs2) * 1000 + n / 2) / n);
+
+		// Insert in ranked list (sample point error, then larger N)
+		for( pos = candNb; pos > 0; pos-- ) {
+			candN = 1 + pCandidates[pos-1].BitTimeConf.PropSegInTq + pCandidates[pos-1].BitTimeConf.PhaseSeg1InTq +
+			        pCandidates[pos-1].BitTimeConf.PhaseSeg2InTq;
+			candErr = (pCandidates[pos-1].SamplePointPermil > SamplePointPermil) ?
+			          (pCandidates[pos-1].SamplePointPermil - SamplePointPermil) :
+			          (SamplePointPermil - pCandidates[pos-1].SamplePointPermil);
+			err = (cand.SamplePointPermil > SamplePointPermil) ? (cand.SamplePointPermil - SamplePointPermil) :
+			                                                     (SamplePointPermil - cand.SamplePointPermil);
+			if( (candErr < err) || ((candErr == err) && (candN >= n)) ) {
+				break;
+			}
+			if( pos < MaxCandidateNb ) {
+				pCandidates[pos] = pCandidates[pos-1];
+			}
+		}
+		if( pos < MaxCandidateNb ) {
+			pCandidates[pos] = cand;
+			if( candNb < MaxCandidateNb ) {
+				candNb++;
+			}
+		}
+	}
+
+	*pCandidateNb = candNb;
+	if( candNb == 0 ) {
+		return BRG_COM_FREQ_NOT_SUPPORTED;
+	}
+	return BRG_NO_ERR;
+}
 /**
  * @ingroup CAN
  * @brief This routine initializes the CAN according to init parameters.\n
@@ -1849,6 +2345,10 @@ Brg_StatusT Brg::CheckBitTimeClassicCAN(const Brg_CanBitTimeConfT* pBitTimeConf)
  * @param[in]  pInitParams CAN initialization parameters see #Brg_CanInitT and \ref LIMITATION
  * @param[in]  InitType  #BRG_INIT_FULL for normal case (CLK, reset, Filter deactivated) or \n
  *                       #BRG_REINIT for configuration change only.
+ * @note The configuration applied last in this session is remembered: the same configuration is not sent
+ *       again (CAN filters and received messages are kept) and a #BRG_INIT_FULL changing only the
+ *       prescaler and bit time is sent as #BRG_REINIT (CAN filters kept). Call Brg::CloseBridge(#COM_CAN)
+ *       or Brg::ClearCanConfCache() before to force a full initialization.
  *
  * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
  * @retval #BRG_PARAM_ERR Null pointer parameter
@@ -1857,6 +2357,7 @@ Brg_StatusT Brg::CheckBitTimeClassicCAN(const Brg_CanBitTimeConfT* pBitTimeConf)
  */
 Brg_StatusT Brg::InitCAN(const Brg_CanInitT *pInitParams, Brg_InitTypeT InitType)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -1924,6 +2425,19 @@ Brg_StatusT Brg::InitCAN(const Brg_CanInitT *pInitParams, Brg_InitTypeT InitType
 	// BaudRate Prescaler
 	pRq->CDBByte[6] = (uint8_t) (pInitParams->Prescaler)&0xFF;
 	pRq->CDBByte[7] = (uint8_t) (pInitParams->Prescaler>>8)&0xFF;
+
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	if( m_canInitCache.bValid == true ) {
+		if( memcmp(m_canInitCache.Conf, &pRq->CDBByte[2], sizeof(m_canInitCache.Conf)) == 0 ) {
+			// Already applied in this session
+			delete pRq;
+			return BRG_NO_ERR;
+		}
+		if( (m_canInitCache.Conf[0] == pRq->CDBByte[2]) && (m_canInitCache.Conf[3] == pRq->CDBByte[5]) ) {
+			// Same mode and configuration bits: only bit timing to change, keep the filters
+			InitType = BRG_REINIT;
+		}
+	}
 	// Init Type
 	pRq->CDBByte[8] = (uint8_t) InitType;
 
@@ -1933,6 +2447,18 @@ Brg_StatusT Brg::InitCAN(const Brg_CanInitT *pInitParams, Brg_InitTypeT InitType
 	pRq->SenseLength=DEFAULT_SENSE_LEN;
 
 	brgStat = SendRequestAndAnalyzeStatus(pRq, &status);
+	if( brgStat == BRG_NO_ERR ) {
+		memcpy(m_canInitCache.Conf, &pRq->CDBByte[2], sizeof(m_canInitCache.Conf));
+		m_canInitCache.bValid = true;
+		if( InitType == BRG_INIT_FULL ) {
+			// Filters deactivated by the full initialization
+			for( int i = 0; i < BRG_CAN_FILTER_BANK_NB; i++ ) {
+				m_canFilterCache[i].bValid = false;
+			}
+		}
+	} else {
+		ClearCanConfCache();
+	}
 	delete pRq;
 
 	return brgStat;
@@ -2048,6 +2574,53 @@ Brg_StatusT Brg::GetCANbaudratePrescal(const Brg_CanBitTimeConfT *pBitTimeConf,
 	*pPrescal = calcPrescal;
 	return brgStat;
 }
+/**
+ * @ingroup CAN
+ * @brief This routine searches all the bit time configurations and prescalers allowed by Brg::InitCAN()
+ *        giving exactly the required CAN bitrate with the current CAN input clock, and returns the ones
+ *        with the sample point closest to SamplePointPermil (then with the most time quanta) first.\n
+ * Unlike Brg::GetCANbaudratePrescal() no bit time configuration has to be chosen by the caller.
+ * @warning Prescaler is valid while STLink frequency is not changed on debug interface
+ *          by using STLINK_SWITCH_STLINK_FREQ.
+ * @param[in]  ReqBaudrate  Requested baudRate (max 1000000 1Mbps).
+ * @param[in]  SamplePointPermil  Target sample point in 1/1000 of the bit time (e.g. 875 for 87.5%), 500 to 950.
+ * @param[out] pCandidates  Array of MaxCandidateNb entries filled with the best candidates, best first.
+ * @param[in]  MaxCandidateNb  Size of pCandidates (1 for the best only).
+ * @param[out] pCandidateNb  Number of pCandidates entries filled.
+ *
+ * @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+ * @retval #BRG_PARAM_ERR If null pointer or incorrect parameter
+ * @retval #BRG_COM_FREQ_NOT_SUPPORTED If ReqBaudrate cannot be obtained exactly (use Brg::GetCANbaudratePrescal())
+ * @retval #BRG_NO_ERR If no error
+ */
+Brg_StatusT Brg::FindCANbitTiming(uint32_t ReqBaudrate, uint16_t SamplePointPermil, Brg_CanBitTimingT *pCandidates,
+                                  uint8_t MaxCandidateNb, uint8_t *pCandidateNb)
+{
+	Brg_StatusT brgStat;
+	uint32_t canInputClkKHz=0;
+	uint32_t stlHClkKHz=0;
+	// CheckBitTimeClassicCAN() and InitCAN() limits
+	const BitTimeLimitsT limits = {16, 8, 8, 4, 1024};
+
+	if (m_bStlinkConnected == false) {
+		// The function should be called at least after OpenStlink
+		return BRG_NO_STLINK;
+	}
+	if ((pCandidates == NULL) || (pCandidateNb == NULL) || (MaxCandidateNb == 0)) {
+		return BRG_PARAM_ERR;
+	}
+	*pCandidateNb = 0;
+	if ((ReqBaudrate < 1) || (ReqBaudrate > 1000000) || (SamplePointPermil < 500) || (SamplePointPermil > 950)) {
+		return BRG_PARAM_ERR;
+	}
+	// Get the current CAN input Clk
+	brgStat = GetClk(COM_CAN, &canInputClkKHz, &stlHClkKHz);
+	if (brgStat == BRG_NO_ERR) {
+		brgStat = SolveBitTiming(canInputClkKHz * 1000, ReqBaudrate, SamplePointPermil, &limits,
+		                         pCandidates, MaxCandidateNb, pCandidateNb);
+	}
+	return brgStat;
+}
 /*
  * Internal: Fill Filter or Mask Id pOutConf[3:0] according to pInConf as follow
  * 32bit Standard ID: [31:21] = Id[10:0], [20:3]=0, [2]=IDE (=0), [1]=RTR (=0), [0]=0
@@ -2126,6 +2699,7 @@ Brg_StatusT Brg::FormatFilter16bitCAN(const Brg_FilterBitsT *pInConf, uint8_t *p
  */
 Brg_StatusT Brg::InitFilterCAN(const Brg_CanFilterConfT *pInitParams)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -2237,12 +2811,26 @@ Brg_StatusT Brg::InitFilterCAN(const Brg_CanFilterConfT *pInitParams)
 	// Filter Bank number
 	pRq->CDBByte[11] = pInitParams->FilterBankNb;
 
+	CanFilterCacheT *pCache = &m_canFilterCache[pInitParams->FilterBankNb];
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	if( (pCache->bValid == true) && (memcmp(pCache->Conf, &pRq->CDBByte[2], sizeof(pCache->Conf)) == 0) ) {
+		// Already applied in this session
+		delete pRq;
+		return BRG_NO_ERR;
+	}
+
 	pRq->InputRequest = REQUEST_READ_1ST_EPIN;
 	pRq->Buffer = &status;
 	pRq->BufferLength = 2;
 	pRq->SenseLength=DEFAULT_SENSE_LEN;
 
 	brgStat = SendRequestAndAnalyzeStatus(pRq, &status);
+	if( brgStat == BRG_NO_ERR ) {
+		memcpy(pCache->Conf, &pRq->CDBByte[2], sizeof(pCache->Conf));
+		pCache->bValid = true;
+	} else {
+		pCache->bValid = false;
+	}
 	delete pRq;
 
 	return brgStat;
@@ -2263,6 +2851,7 @@ Brg_StatusT Brg::InitFilterCAN(const Brg_CanFilterConfT *pInitParams)
  */
 Brg_StatusT Brg::StartMsgReceptionCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[4];
@@ -2316,6 +2905,7 @@ Brg_StatusT Brg::StartMsgReceptionCAN(void)
  */
 Brg_StatusT Brg::StopMsgReceptionCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -2362,6 +2952,7 @@ Brg_StatusT Brg::StopMsgReceptionCAN(void)
  */
 Brg_StatusT Brg::GetRxMsgNbCAN(uint16_t *pMsgNb)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[8];
@@ -2432,12 +3023,14 @@ Brg_StatusT Brg::GetRxMsgNbCAN(uint16_t *pMsgNb)
 Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pBuffer,
                              uint16_t BufSizeInBytes, uint16_t *pDataSizeInBytes)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t *pAnswer;
 	uint8_t *pReadCanMsg;
 	uint16_t msgDataSize, buffDataSize, buffDataOffset;
 	uint32_t answerSize, firstErrMsgNb;
+	uint64_t readUs;
 
 	if( m_bStlinkConnected == false ) {
 		// The function should be called at least after OpenStlink
@@ -2472,6 +3065,8 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
 
 	pRq->SenseLength=DEFAULT_SENSE_LEN;
 
+	// The messages are in the bridge before the request: its start bounds their reception time
+	readUs = BrgGetMonotonicUs();
 	brgStat = SendRequestAndAnalyzeStatus(pRq, NULL);
 
 	delete pRq;
@@ -2481,6 +3076,7 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
 	// interpreted answer
 	if( brgStat == BRG_NO_ERR ) {
 		uint8_t overrunErr;
+		m_rxMsgNb.fetch_add(MsgNb, std::memory_order_relaxed);
 		pReadCanMsg = &pAnswer[0]; //First received message
 		buffDataSize = BufSizeInBytes;
 		buffDataOffset = 0;
@@ -2507,6 +3103,7 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
 				} else { // Buffer overrun error (2)
 					pCanMsg[j].Overrun = CAN_RX_BUFF_OVERRUN;
 				}
+				RecordRxOverrun(pCanMsg[j].Overrun);
 				if( brgStat == BRG_NO_ERR ) {
 					brgStat = BRG_OVERRUN_ERR;
 					firstErrMsgNb = j;
@@ -2536,6 +3133,7 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
 			}
 			// Byte6-7: Message time stamp unused
 			pCanMsg[j].TimeStamp = 0;
+			pCanMsg[j].HostTimeUs = readUs;
 			// Byte 8 to 15: 0 to 8 data bytes
 			for( int i=0; i<msgDataSize; i++ ) {
 				pBuffer[buffDataOffset+i] = pReadCanMsg[CAN_READ_MSG_HEADER_SIZE_V1+i];
@@ -2566,6 +3164,56 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
 	delete [] pAnswer;
 	return brgStat;
 }
+/**
+ * @ingroup CAN
+ * @brief Get the Rx overrun accounting of Brg::GetRxMsgCAN() and Brg::GetRxMsgFDCAN() since
+ *        the Brg creation or the last ResetRxOverrunStats(). Can be called from any thread.\n
+ * No message was lost while FifoOverrunNb and BuffOverrunNb are 0.
+ * @param[out] pStats  Overrun counters and timestamps.
+ */
+void Brg::GetRxOverrunStats(Brg_RxOverrunStatsT *pStats) const
+{
+	if( pStats == NULL ) {
+		return;
+	}
+	pStats->RxMsgNb = m_rxMsgNb.load(std::memory_order_relaxed);
+	pStats->FifoOverrunNb = m_fifoOverrunNb.load(std::memory_order_relaxed);
+	pStats->BuffOverrunNb = m_buffOverrunNb.load(std::memory_order_relaxed);
+	pStats->FirstOverrunUs = m_firstOverrunUs.load(std::memory_order_relaxed);
+	pStats->LastFifoOverrunUs = m_lastFifoOverrunUs.load(std::memory_order_relaxed);
+	pStats->LastBuffOverrunUs = m_lastBuffOverrunUs.load(std::memory_order_relaxed);
+}
+/**
+ * @ingroup CAN
+ * @brief Clear the Rx overrun accounting, e.g. at the start of a flashing session.
+ */
+void Brg::ResetRxOverrunStats(void)
+{
+	m_rxMsgNb.store(0, std::memory_order_relaxed);
+	m_fifoOverrunNb.store(0, std::memory_order_relaxed);
+	m_buffOverrunNb.store(0, std::memory_order_relaxed);
+	m_firstOverrunUs.store(0, std::memory_order_relaxed);
+	m_lastFifoOverrunUs.store(0, std::memory_order_relaxed);
+	m_lastBuffOverrunUs.store(0, std::memory_order_relaxed);
+}
+/*
+ * private function used by Brg::GetRxMsgCAN() and Brg::GetRxMsgFDCAN() for each message
+ * flagged with an overrun
+ */
+void Brg::RecordRxOverrun(Brg_CanRxOverrunT Overrun)
+{
+	uint64_t nowUs = BrgGetMonotonicUs();
+	uint64_t noTime = 0;
+
+	if( Overrun == CAN_RX_FIFO_OVERRUN ) {
+		m_fifoOverrunNb.fetch_add(1, std::memory_order_relaxed);
+		m_lastFifoOverrunUs.store(nowUs, std::memory_order_relaxed);
+	} else {
+		m_buffOverrunNb.fetch_add(1, std::memory_order_relaxed);
+		m_lastBuffOverrunUs.store(nowUs, std::memory_order_relaxed);
+	}
+	m_firstOverrunUs.compare_exchange_strong(noTime, nowUs, std::memory_order_relaxed);
+}
 /**
  * @ingroup CAN
  * @brief This routine allows to send a message on CAN bus through the CAN interface,
@@ -2582,6 +3230,7 @@ Brg_StatusT Brg::GetRxMsgCAN(Brg_CanRxMsgT *pCanMsg, uint16_t MsgNb, uint8_t *pB
  */
 Brg_StatusT Brg::WriteMsgCAN(const Brg_CanTxMsgT *pCanMsg, const uint8_t *pBuffer, uint8_t SizeInBytes)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t msgType, msgDLC;
@@ -2777,6 +3426,21 @@ Brg_StatusT Brg::InitBitTimeFDCAN(const Brg_CanBitTimeConfT* pBitTimeConf, const
 	return brgStat;
 }
 
+/**
+ * @ingroup CAN
+ * @brief Forget the CAN configuration applied in this session: next Brg::InitCAN() and
+ *        Brg::InitFilterCAN() are sent even if identical to the previous ones.\n
+ * Done by Brg::OpenStlink(), Brg::CloseStlink() and Brg::CloseBridge(#COM_CAN), to be called if
+ * the bridge CAN state may have been changed otherwise (e.g. STLink frequency switch).
+ */
+void Brg::ClearCanConfCache(void)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_transactionLock);
+	m_canInitCache.bValid = false;
+	for( int i = 0; i < BRG_CAN_FILTER_BANK_NB; i++ ) {
+		m_canFilterCache[i].bValid = false;
+	}
+}
 /**
  * @ingroup FDCAN
  * @brief This routine initializes the FDCAN according to init parameters.\n
@@ -2796,6 +3460,7 @@ Brg_StatusT Brg::InitBitTimeFDCAN(const Brg_CanBitTimeConfT* pBitTimeConf, const
  */
 Brg_StatusT Brg::InitFDCAN(const Brg_FdcanInitT* pInitParams, Brg_InitTypeT InitType, bool bStartBus)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -2885,6 +3550,8 @@ Brg_StatusT Brg::InitFDCAN(const Brg_FdcanInitT* pInitParams, Brg_InitTypeT Init
 		delete pRq;
 	}
 
+	// The timestamp counter restarts and its rate may have changed
+	m_fdcanTimeMap.Reset();
 	if ((brgStat == BRG_NO_ERR) && (bStartBus==true)) {
 		// Finalize initialisation by connecting to the BUS
 		// Send STLINK_BRIDGE_START_FDCAN command.
@@ -2911,6 +3578,7 @@ Brg_StatusT Brg::InitFDCAN(const Brg_FdcanInitT* pInitParams, Brg_InitTypeT Init
 */
 Brg_StatusT Brg::StartFDCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -2958,6 +3626,7 @@ Brg_StatusT Brg::StartFDCAN(void)
 */
 Brg_StatusT Brg::StopFDCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -3116,6 +3785,65 @@ Brg_StatusT Brg::GetFDCANbaudratePrescal(const Brg_CanBitTimeConfT* pBitTimeConf
 	return brgStat;
 }
 
+/**
+* @ingroup FDCAN
+* @brief Same as Brg::FindCANbitTiming() for FDCAN: searches all the bit time configurations and prescalers
+*        allowed by Brg::InitFDCAN() for the Nominal or Data bit time giving exactly the required bitrate
+*        with the current FDCAN input clock, best sample point first.
+* @param[in]  ReqBaudrate  Nominal or Data requested baudrate: max 1000000 1Mbps for Nominal baudrate and 8000000 8Mbps for Data baudrate.
+* @param[in]  SamplePointPermil  Target sample point in 1/1000 of the bit time (e.g. 800 for 80%), 500 to 950.
+* @param[in]  FrameMode    Frame mode initialised in #Brg_FdcanInitT (default should be #FDCAN_FRAME_FD_BRS)
+* @param[in]  bIsNomBitTime Nominal (true) or Data (false) bit time.
+* @param[out] pCandidates  Array of MaxCandidateNb entries filled with the best candidates, best first.
+* @param[in]  MaxCandidateNb  Size of pCandidates (1 for the best only).
+* @param[out] pCandidateNb  Number of pCandidates entries filled.
+*
+* @retval #BRG_NO_STLINK If Brg::OpenStlink() not called before
+* @retval #BRG_PARAM_ERR If null pointer or incorrect parameter
+* @retval #BRG_COM_FREQ_NOT_SUPPORTED If ReqBaudrate cannot be obtained exactly (use Brg::GetFDCANbaudratePrescal())
+* @retval #BRG_NO_ERR If no error
+*/
+Brg_StatusT Brg::FindFDCANbitTiming(uint32_t ReqBaudrate, uint16_t SamplePointPermil, const Brg_FdcanFrameModeT FrameMode,
+                                    const bool bIsNomBitTime, Brg_CanBitTimingT* pCandidates, uint8_t MaxCandidateNb,
+                                    uint8_t* pCandidateNb)
+{
+	Brg_StatusT brgStat;
+	uint32_t canInputClkKHz=0;
+	uint32_t stlHClkKHz=0;
+	// CheckBitTimeFDCAN() and InitFDCAN() limits (PROP_SEG and PHASE_SEG1 are uint8_t)
+	const BitTimeLimitsT classicLimits = {16, 8, 8, 4, 512};
+	const BitTimeLimitsT nomLimits = {256, 255, 128, 128, 512};
+	const BitTimeLimitsT dataLimits = {32, 32, 16, 16, 32};
+	const BitTimeLimitsT *pLimits;
+
+	if (m_bStlinkConnected == false) {
+		// The function should be called at least after OpenStlink
+		return BRG_NO_STLINK;
+	}
+	if ((pCandidates == NULL) || (pCandidateNb == NULL) || (MaxCandidateNb == 0)) {
+		return BRG_PARAM_ERR;
+	}
+	*pCandidateNb = 0;
+	if ((ReqBaudrate < 1) || ((bIsNomBitTime==true)&&(ReqBaudrate > 1000000)) ||
+	    ((bIsNomBitTime==false)&&(ReqBaudrate > 8000000)) ||
+	    (SamplePointPermil < 500) || (SamplePointPermil > 950)) {
+		return BRG_PARAM_ERR;
+	}
+	if (FrameMode == FDCAN_FRAME_CLASSIC) {
+		pLimits = &classicLimits;
+	} else if (bIsNomBitTime == true) {
+		pLimits = &nomLimits;
+	} else {
+		pLimits = &dataLimits;
+	}
+	// Get the current FDCAN input Clk
+	brgStat = GetClk(COM_FDCAN, &canInputClkKHz, &stlHClkKHz);
+	if (brgStat == BRG_NO_ERR) {
+		brgStat = SolveBitTiming(canInputClkKHz * 1000, ReqBaudrate, SamplePointPermil, pLimits,
+		                         pCandidates, MaxCandidateNb, pCandidateNb);
+	}
+	return brgStat;
+}
 /**
  * @ingroup FDCAN
  * @brief This routine initializes the FDCAN Filters according to init parameters.\n
@@ -3131,6 +3859,7 @@ Brg_StatusT Brg::GetFDCANbaudratePrescal(const Brg_CanBitTimeConfT* pBitTimeConf
  */
 Brg_StatusT Brg::InitFilterFDCAN(const Brg_FdcanFilterConfT* pInitParams)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -3227,6 +3956,7 @@ Brg_StatusT Brg::InitFilterFDCAN(const Brg_FdcanFilterConfT* pInitParams)
  */
 Brg_StatusT Brg::StartMsgReceptionFDCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[4];
@@ -3280,6 +4010,7 @@ Brg_StatusT Brg::StartMsgReceptionFDCAN(void)
  */
 Brg_StatusT Brg::StopMsgReceptionFDCAN(void)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -3328,6 +4059,7 @@ Brg_StatusT Brg::StopMsgReceptionFDCAN(void)
  */
 Brg_StatusT Brg::GetRxMsgNbFDCAN(uint16_t* pMsgNb, const Brg_CanRxFifoT FifoNb)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[8];
@@ -3400,12 +4132,14 @@ Brg_StatusT Brg::GetRxMsgNbFDCAN(uint16_t* pMsgNb, const Brg_CanRxFifoT FifoNb)
 Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8_t* pBuffer,
 	uint16_t BufSizeInBytes, uint16_t* pDataSizeInBytes, const Brg_CanRxFifoT FifoNb)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint8_t* pAnswer;
 	uint8_t* pReadMsg;
 	uint16_t msgDataSize, buffDataSize, buffDataOffset;
 	uint32_t answerSize, firstErrMsgNb;
+	uint64_t readUs;
 
 	if (m_bStlinkConnected == false) {
 		// The function should be called at least after OpenStlink
@@ -3441,6 +4175,8 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
 
 	pRq->SenseLength = DEFAULT_SENSE_LEN;
 
+	// The messages are in the bridge before the request: its start bounds their reception time
+	readUs = BrgGetMonotonicUs();
 	brgStat = SendRequestAndAnalyzeStatus(pRq, NULL);
 
 	delete pRq;
@@ -3450,6 +4186,7 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
 	// interpreted answer
 	if (brgStat == BRG_NO_ERR) {
 		uint8_t overrunErr;
+		m_rxMsgNb.fetch_add(MsgNb, std::memory_order_relaxed);
 		pReadMsg = &pAnswer[0]; //First received message
 		buffDataSize = BufSizeInBytes;
 		buffDataOffset = 0;
@@ -3501,6 +4238,7 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
 			}
 			// Byte6-7: Message time stamp
 			pFdcanMsg[j].TimeStamp = (uint16_t)pReadMsg[6] | (((uint16_t)pReadMsg[7]) << 8);
+			pFdcanMsg[j].HostTimeUs = m_fdcanTimeMap.Map(pFdcanMsg[j].TimeStamp, readUs);
 			// Byte8: matching filter index
 			pFdcanMsg[j].FilterNb = pReadMsg[8];
 			// Byte9: Message status (Bit1-0 Overrun, Bit7-2 unused)
@@ -3513,6 +4251,7 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
 				else { // Buffer overrun error (2)
 					pFdcanMsg[j].Overrun = CAN_RX_BUFF_OVERRUN;
 				}
+				RecordRxOverrun(pFdcanMsg[j].Overrun);
 				if (brgStat == BRG_NO_ERR) {
 					brgStat = BRG_OVERRUN_ERR;
 					firstErrMsgNb = j;
@@ -3555,6 +4294,16 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
 	return brgStat;
 }
 
+/**
+* @ingroup FDCAN
+* @brief Get the state of the mapping of the FDCAN Rx timestamps onto the host time
+*        (Brg_FdcanRxMsgT::HostTimeUs), restarted by Brg::InitFDCAN().
+* @param[out] pState  Estimated tick period, unwrapped ticks and wraps.
+*/
+void Brg::GetRxTimeStateFDCAN(Brg_HwTimeStateT* pState) const
+{
+	m_fdcanTimeMap.GetState(pState);
+}
 /**
  * @ingroup FDCAN
  * @brief This routine allows to send a message on FDCAN bus through the FDCAN interface,
@@ -3573,6 +4322,7 @@ Brg_StatusT Brg::GetRxMsgFDCAN(Brg_FdcanRxMsgT* pFdcanMsg, uint16_t MsgNb, uint8
  */
 Brg_StatusT Brg::WriteMsgFDCAN(const Brg_FdcanMsgT* pFdcanMsg, const uint8_t* pBuffer, uint8_t SizeInBytes)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT* pRq;
 	Brg_StatusT brgStat;
 	uint8_t msgType, msgDLC;
@@ -3689,6 +4439,7 @@ Brg_StatusT Brg::WriteMsgFDCAN(const Brg_FdcanMsgT* pFdcanMsg, const uint8_t* pB
  */
 Brg_StatusT Brg::GetLastReadWriteStatus(uint16_t *pBytesWithoutError, uint32_t *pErrorInfo)
 {
+	BRG_TRACE_API();
 	uint16_t answer[BRIDGE_RW_STATUS_LEN_WORD]={0,0,0,0};
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
@@ -3745,6 +4496,7 @@ uint8_t Brg::GpioConfField(Brg_GpioConfT GpioConfParam)
  */
 Brg_StatusT Brg::InitGPIO(const Brg_GpioInitT *pInitParams)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint16_t status;
@@ -3809,6 +4561,7 @@ Brg_StatusT Brg::InitGPIO(const Brg_GpioInitT *pInitParams)
  */
 Brg_StatusT Brg::ReadGPIO(uint8_t GpioMask, Brg_GpioValT *pGpioVal, uint8_t *pGpioErrorMask)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[8]={0,0,0,0,0,0,0,0};
@@ -3873,6 +4626,7 @@ Brg_StatusT Brg::ReadGPIO(uint8_t GpioMask, Brg_GpioValT *pGpioVal, uint8_t *pGp
  */
 Brg_StatusT Brg::SetResetGPIO(uint8_t GpioMask, const Brg_GpioValT *pGpioVal, uint8_t *pGpioErrorMask)
 {
+	BRG_TRACE_API();
 	STLink_DeviceRequestT *pRq;
 	Brg_StatusT brgStat;
 	uint8_t answer[8]={0,0,0,0,0,0,0,0};
@@ -3936,6 +4690,7 @@ Brg_StatusT Brg::SetResetGPIO(uint8_t GpioMask, const Brg_GpioValT *pGpioVal, ui
  */
 Brg_StatusT Brg::GetTargetVoltage(float *pVoltage)
 {
+	BRG_TRACE_API();
 	return ConvSTLinkIfToBrgStatus(StlinkDevice::GetTargetVoltage(pVoltage));
 }
 
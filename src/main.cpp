@@ -26,9 +26,19 @@
 #endif
 #include <stdio.h>
 #include "bridge.h"
+#include "brg_chrome_trace.h"
+#include "brg_boot_seq.h"
+#include "brg_voltage_sampler.h"
 #include <tchar.h>
 
 #define TEST_BUF_SIZE 3000
+#define MAX_PHASE_NB 16 // Startup phases timed by cBrgExample::EndPhase()
+#define LAST_SN_FILE_NAME "bridge_last_sn.txt" // Serial number of the last STLink opened successfully
+// GPIO reset into bootloader (--gpio-reset option), times in us
+#define BOOT_RESET_PULSE_US 1000  // Target reset assertion
+#define BOOT_FRAME_DELAY_US 5000  // Start frame after the reset release (target startup)
+#define BOOT_STRAP_HOLD_US 20000  // Boot strap held after the reset release
+#define VMON_PERIOD_MS 10         // Target voltage sampling period (--vmon option)
 
 class cBrgExample
 {
@@ -37,11 +47,13 @@ public:
 	~cBrgExample();
 
 	Brg_StatusT SelectSTLink(STLinkInterface *pStlinkIf, int *pFirstDevNotInUse);
-	Brg_StatusT Connect(Brg* pBrg, int deviceNb);
+	Brg_StatusT Connect(Brg* pBrg, int deviceNb, const char *pSerialNumber=NULL);
 	void Disconnect(void);
+	const char* GetSerialNumber(void) const { return m_serialNumber; }
 
     Brg_StatusT SendCanBootloaderStart(int moduleId);
     Brg_StatusT CanInit(void);
+	void SetBootGpios(uint8_t resetGpioMask, uint8_t bootGpioMask);
 
 	// CAN
 	Brg_StatusT CanTest(void);
@@ -50,14 +62,30 @@ public:
 	Brg_StatusT CanFilterDisable(Brg_CanFilterConfT* pFilterConf, uint8_t filterNb, Brg_CanMsgIdT filterIde);
 	Brg_StatusT CanMsgTxRxVerif(Brg_CanTxMsgT *pCanTxMsg, uint8_t *pDataTx, Brg_CanRxMsgT *pCanRxMsg, uint8_t *pDataRx, Brg_CanRxFifoT rxFifo, uint8_t size);
 
+	// Startup phase timing
+	void EndPhase(const char *pName, uint64_t StartUs);
+	void PrintPhases(bool bCsv);
+
 protected:
 private:
 	Brg* m_pBrg;
 	char m_serialNumber[SERIAL_NUM_STR_MAX_LEN];
+	uint8_t m_resetGpioMask; // 0: CAN start frame only
+	uint8_t m_bootGpioMask;
+
+	typedef struct {
+		const char *pName;
+		uint64_t StartUs; // from cBrgExample creation
+		uint64_t DurationUs;
+	} PhaseTimeT;
+	PhaseTimeT m_phases[MAX_PHASE_NB];
+	int m_phaseNb;
+	uint64_t m_originUs;
 };
 
-cBrgExample::cBrgExample() : m_pBrg(NULL)
+cBrgExample::cBrgExample() : m_pBrg(NULL), m_resetGpioMask(0), m_bootGpioMask(0), m_phaseNb(0)
 {
+	m_originUs = BrgGetMonotonicUs();
 	for (int i=0; i<SERIAL_NUM_STR_MAX_LEN; i++) {
 		m_serialNumber[i] = 0;
 	}
@@ -67,6 +95,45 @@ cBrgExample::~cBrgExample()
 {
 }
 
+/*****************************************************************************/
+// Startup phase timing
+/*****************************************************************************/
+// Record the phase started at StartUs (BrgGetMonotonicUs()) and ending now
+void cBrgExample::EndPhase(const char *pName, uint64_t StartUs)
+{
+	uint64_t endUs = BrgGetMonotonicUs();
+
+	BrgChromeTraceSpan(pName, BRG_TRACE_CAT_PHASE, StartUs, endUs);
+	if (m_phaseNb < MAX_PHASE_NB) {
+		m_phases[m_phaseNb].pName = pName;
+		m_phases[m_phaseNb].StartUs = StartUs - m_originUs;
+		m_phases[m_phaseNb].DurationUs = endUs - StartUs;
+		m_phaseNb++;
+	}
+}
+
+// Print the phases: table for operators or CSV (phase,start_us,duration_us) for scripts
+void cBrgExample::PrintPhases(bool bCsv)
+{
+	uint64_t totalUs = BrgGetMonotonicUs() - m_originUs;
+
+	if (bCsv == true) {
+		printf("phase,start_us,duration_us\n");
+		for (int i = 0; i < m_phaseNb; i++) {
+			printf("%s,%llu,%llu\n", m_phases[i].pName, (unsigned long long)m_phases[i].StartUs,
+			       (unsigned long long)m_phases[i].DurationUs);
+		}
+		printf("Total,0,%llu\n", (unsigned long long)totalUs);
+	} else {
+		printf("Startup phases:\n");
+		for (int i = 0; i < m_phaseNb; i++) {
+			printf("  %-22s %9.3f ms (at %9.3f ms)\n", m_phases[i].pName, (double)m_phases[i].DurationUs / 1000.0,
+			       (double)m_phases[i].StartUs / 1000.0);
+		}
+		printf("  %-22s %9.3f ms\n", "Total", (double)totalUs / 1000.0);
+	}
+}
+
 /*****************************************************************************/
 // STLINK USB management
 /*****************************************************************************/
@@ -76,6 +143,7 @@ Brg_StatusT cBrgExample::SelectSTLink(STLinkInterface* pStlinkIf, int* pFirstDev
 	TDeviceInfo2 devInfo2;
 	STLinkIf_StatusT ifStatus = STLINKIF_NO_ERR;
 	STLink_EnumStlinkInterfaceT stlinkIfId;
+	uint64_t phaseStartUs;
 
 	if ((pStlinkIf == NULL) || (pFirstDevNotInUse == NULL)) {
 		printf("Internal parameter error in SelectSTLink\n");
@@ -87,11 +155,14 @@ Brg_StatusT cBrgExample::SelectSTLink(STLinkInterface* pStlinkIf, int* pFirstDev
 		return BRG_PARAM_ERR;
 	}
 
+	phaseStartUs = BrgGetMonotonicUs();
 	ifStatus = pStlinkIf->EnumDevices(&numDevices, FALSE);
+	EndPhase("EnumDevices", phaseStartUs);
 	// Choose the first STLink Bridge available
 	if ((ifStatus == STLINKIF_NO_ERR) || (ifStatus == STLINKIF_PERMISSION_ERR)) {
 		printf("%d BRIDGE device found\n", (int)numDevices);
 
+		phaseStartUs = BrgGetMonotonicUs();
 		for( i=0; i<numDevices; i++ ) {
 			ifStatus = pStlinkIf->GetDeviceInfo2(i, &devInfo2, sizeof(devInfo2));
 			printf("Bridge %d PID: 0X%04hx SN:%s\n", (int)i, (unsigned short)devInfo2.ProductId, devInfo2.EnumUniqueId);
@@ -102,6 +173,7 @@ Brg_StatusT cBrgExample::SelectSTLink(STLinkInterface* pStlinkIf, int* pFirstDev
 				printf("SELECTED BRIDGE Stlink SN:%s\n\n", m_serialNumber);
 			}
 		}
+		EndPhase("GetDeviceInfo2 loop", phaseStartUs);
 	} else if (ifStatus == STLINKIF_CONNECT_ERR) {
 		printf("No STLink BRIDGE device detected\n");
 	} else {
@@ -114,7 +186,9 @@ Brg_StatusT cBrgExample::SelectSTLink(STLinkInterface* pStlinkIf, int* pFirstDev
 	return Brg::ConvSTLinkIfToBrgStatus(ifStatus);
 }
 
-Brg_StatusT cBrgExample::Connect(Brg* pBrg, int deviceNb)
+// Open deviceNb (from SelectSTLink()), or if pSerialNumber is not NULL open this STLink
+// directly: no device info loop, only the enumeration done by the USB driver
+Brg_StatusT cBrgExample::Connect(Brg* pBrg, int deviceNb, const char *pSerialNumber)
 {
 	// The firmware may not be the very last one, but it may be OK like that (just inform)
 	bool bOldFirmwareWarning=false;
@@ -125,9 +199,17 @@ Brg_StatusT cBrgExample::Connect(Brg* pBrg, int deviceNb)
 	m_pBrg = pBrg;
 	// Open the STLink connection
 	if (brgStat == BRG_NO_ERR) {
+		uint64_t phaseStartUs = BrgGetMonotonicUs();
 		m_pBrg->SetOpenModeExclusive(true);
 
-		brgStat = m_pBrg->OpenStlink(deviceNb);
+		if (pSerialNumber != NULL) {
+			strncpy(m_serialNumber, pSerialNumber, SERIAL_NUM_STR_MAX_LEN-1);
+			brgStat = m_pBrg->OpenStlink(pSerialNumber, true);
+			EndPhase("OpenStlink by SN", phaseStartUs);
+		} else {
+			brgStat = m_pBrg->OpenStlink(deviceNb);
+			EndPhase("OpenStlink", phaseStartUs);
+		}
 
 		if (brgStat == BRG_NOT_SUPPORTED) {
 			printf("BRIDGE not supported SN:%s\n", m_serialNumber);
@@ -187,7 +269,12 @@ Brg_StatusT cBrgExample::SendCanBootloaderStart(int moduleId)
 		return BRG_CONNECT_ERR;
 	}
 
-    brgStat = CanInit();
+	// Brg calls below hold the transaction lock: the --vmon sampler thread samples
+	// only when it is free (BrgBootSequencer::Run() takes it itself)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_pBrg->GetTransactionLock());
+		brgStat = CanInit();
+	}
 	if( brgStat != BRG_NO_ERR ) {
 		printf("CAN init error \n");
 	}
@@ -202,9 +289,39 @@ Brg_StatusT cBrgExample::SendCanBootloaderStart(int moduleId)
 
     dataTx[0] = moduleId;
 
-    if( brgStat == BRG_NO_ERR ) {
+    if( (brgStat == BRG_NO_ERR) && (m_resetGpioMask != 0) ) {
+		// Reset the target into its bootloader, start frame sent in the bootloader window
+		BrgBootSequencer bootSeq(*m_pBrg);
+		Brg_BootSeqStepT steps[4];
+		Brg_BootSeqResultT result;
+		Brg_CanExchangeT startFrame;
+		uint8_t stepNb;
+
+		memset(&result, 0, sizeof(result));
+		memset(&startFrame, 0, sizeof(startFrame));
+		startFrame.Msg = canTxMsg;
+		memcpy(startFrame.Data, dataTx, 8);
+		startFrame.Size = 8;
+		stepNb = BrgBootSequencer::MakeResetIntoBoot(steps, m_resetGpioMask, m_bootGpioMask, GPIO_SET,
+		                                            BOOT_RESET_PULSE_US, BOOT_FRAME_DELAY_US, BOOT_STRAP_HOLD_US);
+		printf("Resetting target into GCAN Bootloader with module ID: %d\n", moduleId);
+		uint64_t phaseStartUs = BrgGetMonotonicUs();
+		brgStat = bootSeq.Run(steps, stepNb, &startFrame, &result);
+		EndPhase("Boot sequence", phaseStartUs);
+		if (brgStat != BRG_NO_ERR) {
+			printf("Boot sequence error (step %d)\n", (int)result.StepNb);
+		} else {
+			printf("Start frame sent %d us after reset assertion (max step lateness %d us)\n",
+			       (int)result.FrameSentUs, (int)result.MaxLateUs);
+		}
+	} else if( brgStat == BRG_NO_ERR ) {
         printf("Starting GCAN Bootloader on target with module ID: %d\n", moduleId);
-		brgStat = m_pBrg->WriteMsgCAN(&canTxMsg, dataTx, 8);
+		uint64_t phaseStartUs = BrgGetMonotonicUs();
+		{
+			std::lock_guard<std::recursive_mutex> lock(m_pBrg->GetTransactionLock());
+			brgStat = m_pBrg->WriteMsgCAN(&canTxMsg, dataTx, 8);
+		}
+		EndPhase("WriteMsgCAN", phaseStartUs);
 
 		if( brgStat != BRG_NO_ERR ) {
 			printf("CAN Write Message error\n");
@@ -212,11 +329,20 @@ Brg_StatusT cBrgExample::SendCanBootloaderStart(int moduleId)
 	}
 
     // Close Bridge CAN COM, even in case of error
-	m_pBrg->CloseBridge(COM_CAN);
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_pBrg->GetTransactionLock());
+		m_pBrg->CloseBridge(COM_CAN);
+	}
 
     return brgStat;
 }
 
+void cBrgExample::SetBootGpios(uint8_t resetGpioMask, uint8_t bootGpioMask)
+{
+	m_resetGpioMask = resetGpioMask;
+	m_bootGpioMask = bootGpioMask;
+}
+
 Brg_StatusT cBrgExample::CanInit(void)
 {
     Brg_StatusT brgStat = BRG_NO_ERR;
@@ -224,14 +350,26 @@ Brg_StatusT cBrgExample::CanInit(void)
 	uint32_t reqBaudrate = 1000000; //1 Mbaud
 	uint32_t finalBaudrate = 0;
 	Brg_CanInitT canParam;
+	Brg_CanBitTimingT bitTiming;
+	uint8_t candidateNb;
+	uint64_t phaseStartUs;
 
-	// Set baudrate to 1 Mbaud
-	canParam.BitTimeConf.PropSegInTq = 1;
-	canParam.BitTimeConf.PhaseSeg1InTq = 5;
-	canParam.BitTimeConf.PhaseSeg2InTq = 1;
-	canParam.BitTimeConf.SjwInTq = 4; //min (4, PhaseSeg1InTq)
-
-	brgStat = m_pBrg->GetCANbaudratePrescal(&canParam.BitTimeConf, reqBaudrate, (uint32_t*)&prescal, (uint32_t*)&finalBaudrate);
+	// Set baudrate to exactly 1 Mbaud with a 87.5% sample point if the CAN clock allows it
+	phaseStartUs = BrgGetMonotonicUs();
+	brgStat = m_pBrg->FindCANbitTiming(reqBaudrate, 875, &bitTiming, 1, &candidateNb);
+	if( brgStat == BRG_NO_ERR ) {
+		canParam.BitTimeConf = bitTiming.BitTimeConf;
+		prescal = bitTiming.Prescaler;
+		finalBaudrate = reqBaudrate;
+	} else {
+		// Nearest baudrate with a fixed Bit Time
+		canParam.BitTimeConf.PropSegInTq = 1;
+		canParam.BitTimeConf.PhaseSeg1InTq = 5;
+		canParam.BitTimeConf.PhaseSeg2InTq = 1;
+		canParam.BitTimeConf.SjwInTq = 4; //min (4, PhaseSeg1InTq)
+		brgStat = m_pBrg->GetCANbaudratePrescal(&canParam.BitTimeConf, reqBaudrate, (uint32_t*)&prescal, (uint32_t*)&finalBaudrate);
+	}
+	EndPhase("CAN bit timing", phaseStartUs);
 	if( brgStat == BRG_COM_FREQ_MODIFIED ) {
 		brgStat = BRG_NO_ERR;
 		printf("WARNING Bridge CAN init baudrate asked %d bps but applied %d bps \n", (int)reqBaudrate, (int)finalBaudrate);
@@ -246,7 +384,9 @@ Brg_StatusT cBrgExample::CanInit(void)
 		canParam.bIsNartEn = false;
 		canParam.bIsAwumEn = false;
 		canParam.bIsAbomEn = false;
+		phaseStartUs = BrgGetMonotonicUs();
 		brgStat = m_pBrg->InitCAN(&canParam, BRG_INIT_FULL);
+		EndPhase("InitCAN", phaseStartUs);
 	} else if( brgStat == BRG_COM_FREQ_NOT_SUPPORTED ) {
 		printf("ERROR Bridge CAN init baudrate %d bps not possible (invalid prescaler: %d) change Bit Time or baudrate settings. \n", (int)reqBaudrate, (int)prescal);
 	}
@@ -514,6 +654,26 @@ Brg_StatusT cBrgExample::CanMsgTxRxVerif(Brg_CanTxMsgT *pCanTxMsg, uint8_t *pDat
 
 /*****************************************************************************/
 // Main example
+// Brown-out during the bootloader start (--vmon option)
+static void VoltageBrownOut(void *pContext, const Brg_VoltageEventT *pEvent)
+{
+	(void)pContext;
+	printf("WARNING target brown-out: %.2f V < %.2f V\n", (double)pEvent->Voltage, (double)pEvent->Threshold);
+}
+
+// --gpio-reset=/--gpio-boot= value: bridge GPIO number 0 to BRG_GPIO_MAX_NB-1 (0 if invalid)
+static uint8_t ParseGpioMask(const char *pOption, const char *pValue)
+{
+	char *pEnd = NULL;
+	long gpioNb = strtol(pValue, &pEnd, 10);
+
+	if ((pEnd == pValue) || (*pEnd != '\0') || (gpioNb < 0) || (gpioNb >= BRG_GPIO_MAX_NB)) {
+		printf("GPIO option ignored (GPIO 0 to %d expected): %s\n", BRG_GPIO_MAX_NB-1, pOption);
+		return 0;
+	}
+	return (uint8_t)(1 << gpioNb);
+}
+
 /*****************************************************************************/
 
 // main() Defines the entry point for the console application.
@@ -536,8 +696,66 @@ int main(int argc, char** argv)
 	int firstDevNotInUse=-1;
 	Brg* pBrg = NULL;
 	STLinkInterface *m_pStlinkIf = NULL;
+	bool bCmdStats = false;
+	bool bTiming = false;
+	bool bTimingCsv = false;
+	bool bSnCache = true;
+	char serialNumber[SERIAL_NUM_STR_MAX_LEN] = "";
+	char snFileName[MAX_PATH];
+	FILE *pSnFile;
+	uint8_t resetGpioMask = 0;
+	uint8_t bootGpioMask = 0;
+	bool bVmon = false;
+	float brownOutV = 0;
+
+	// Options after module ID: --cmd-stats prints USB command statistics on exit,
+	// --chrome-trace=<file> records USB commands, Brg calls and phases as a Chrome trace,
+	// --timing prints the startup phase durations (--timing=csv: machine readable),
+	// --sn=<serial> opens this STLink without the device info loop (default: serial of
+	// the last successful run, see LAST_SN_FILE_NAME), --no-sn-cache always enumerates,
+	// --gpio-reset=<0-3> resets the target into its bootloader with this bridge GPIO
+	// (active low) before the start frame, --gpio-boot=<0-3> also drives its boot strap high,
+	// --vmon[=<volt>] samples the target voltage (T_VCC) in the background during the start,
+	// with a brown-out warning below <volt>
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--cmd-stats") == 0) {
+			bCmdStats = true;
+		} else if (strcmp(argv[i], "--timing") == 0) {
+			bTiming = true;
+		} else if (strcmp(argv[i], "--timing=csv") == 0) {
+			bTiming = true;
+			bTimingCsv = true;
+		} else if (strncmp(argv[i], "--sn=", 5) == 0) {
+			strncpy(serialNumber, &argv[i][5], SERIAL_NUM_STR_MAX_LEN-1);
+		} else if (strcmp(argv[i], "--no-sn-cache") == 0) {
+			bSnCache = false;
+		} else if (strncmp(argv[i], "--chrome-trace=", 15) == 0) {
+			if (BrgChromeTraceStart(&argv[i][15]) != BRG_NO_ERR) {
+				printf("Chrome trace option ignored: %s\n", argv[i]);
+			}
+		} else if (strncmp(argv[i], "--gpio-reset=", 13) == 0) {
+			resetGpioMask = ParseGpioMask(argv[i], &argv[i][13]);
+		} else if (strncmp(argv[i], "--gpio-boot=", 12) == 0) {
+			bootGpioMask = ParseGpioMask(argv[i], &argv[i][12]);
+		} else if (strcmp(argv[i], "--vmon") == 0) {
+			bVmon = true;
+		} else if (strncmp(argv[i], "--vmon=", 7) == 0) {
+			bVmon = true;
+			brownOutV = (float)atof(&argv[i][7]);
+		}
+	}
+	if ((resetGpioMask != 0) && (resetGpioMask == bootGpioMask)) {
+		printf("GPIO reset disabled: --gpio-reset and --gpio-boot use the same GPIO\n");
+		resetGpioMask = 0;
+		bootGpioMask = 0;
+	}
+	brgTest.SetBootGpios(resetGpioMask, bootGpioMask);
 
-	// Note: cErrLog g_ErrLog; to be instanciated and initialized if used with USING_ERRORLOG
+#ifdef USING_ERRORLOG
+	// Binary trace rings formatted into the file by the cErrLog dumper thread
+	cErrLog g_ErrLog;
+	g_ErrLog.Init("bridge_trace.log", true);
+#endif
 
 	// In case previously used, close the previous connection (not the case here)
 	if (pBrg!=NULL) {
@@ -575,24 +793,65 @@ int main(int argc, char** argv)
 	// In this example STLinkUSBdriver (dll on windows) must be copied near test executable
 	// Copy last STLinkUSBDriver dll from  STSW-LINK007 package (STLINK firmware upgrade application),
 	// choose correct library according to your project architecture
+	uint64_t phaseStartUs = BrgGetMonotonicUs();
 	ifStat = m_pStlinkIf->LoadStlinkLibrary(path);
+	brgTest.EndPhase("LoadStlinkLibrary", phaseStartUs);
 	if( ifStat!=STLINKIF_NO_ERR ) {
 		printf("STLinkUSBDriver library (dll) issue \n");
 	}
 
-	// Enumerate the STLink Bridge instance, and choose the first one in the list
-	brgStat = brgTest.SelectSTLink(m_pStlinkIf, &firstDevNotInUse);
-
 	// USB Connection to a given device done with Brg
-	if (brgStat == BRG_NO_ERR) {
-		pBrg = new Brg(*m_pStlinkIf);
+	pBrg = new Brg(*m_pStlinkIf);
 #ifdef USING_ERRORLOG
-		m_pBrg->BindErrLog(&g_ErrLog);
+	pBrg->BindErrLog(&g_ErrLog);
 #endif
+	if (bCmdStats == true) {
+		pBrg->SetCmdStatsDumpOnExit(stdout);
 	}
-	// Connect to the selected STLink
-	if (brgStat == BRG_NO_ERR) {
-		brgStat = brgTest.Connect(pBrg, firstDevNotInUse);
+
+	// Fast path: open the known STLink by serial number
+	snprintf(snFileName, MAX_PATH, "%s%s", path, LAST_SN_FILE_NAME);
+	if ((serialNumber[0] == 0) && (bSnCache == true)) {
+		pSnFile = fopen(snFileName, "r");
+		if (pSnFile != NULL) {
+			if (fscanf(pSnFile, "%31s", serialNumber) != 1) {
+				serialNumber[0] = 0;
+			}
+			fclose(pSnFile);
+		}
+	}
+	brgStat = BRG_STLINK_SN_NOT_FOUND;
+	if (serialNumber[0] != 0) {
+		BRG_TRACE_SCOPE("Connect by SN", BRG_TRACE_CAT_PHASE);
+		brgStat = brgTest.Connect(pBrg, -1, serialNumber);
+		if (brgStat != BRG_NO_ERR) {
+			printf("BRIDGE SN:%s not opened (error %d), enumerating\n", serialNumber, (int)brgStat);
+			pBrg->CloseStlink();
+		} else {
+			printf("SELECTED BRIDGE Stlink SN:%s\n\n", serialNumber);
+		}
+	}
+
+	if (brgStat != BRG_NO_ERR) {
+		// Enumerate the STLink Bridge instance, and choose the first one in the list
+		{
+			BRG_TRACE_SCOPE("SelectSTLink", BRG_TRACE_CAT_PHASE);
+			brgStat = brgTest.SelectSTLink(m_pStlinkIf, &firstDevNotInUse);
+		}
+		// Connect to the selected STLink
+		if (brgStat == BRG_NO_ERR) {
+			BRG_TRACE_SCOPE("Connect", BRG_TRACE_CAT_PHASE);
+			brgStat = brgTest.Connect(pBrg, firstDevNotInUse);
+		}
+	}
+
+	// Remember the STLink for the fast path of the next run
+	if ((brgStat == BRG_NO_ERR) && (bSnCache == true)) {
+		pSnFile = fopen(snFileName, "w");
+		if (pSnFile != NULL) {
+			fprintf(pSnFile, "%s\n", brgTest.GetSerialNumber());
+			fclose(pSnFile);
+		}
 	}
 
     // Check for module ID
@@ -605,7 +864,27 @@ int main(int argc, char** argv)
     {
         // Send CAN message to start CAN bootloader over GCAN
         int moduleId = atoi(argv[1]);
-        brgStat = brgTest.SendCanBootloaderStart(moduleId);
+        BrgVoltageSampler *pVmon = NULL;
+        if ((bVmon == true) && (brgStat == BRG_NO_ERR)) {
+            Brg_VoltageSamplerConfT vmonConf = { VMON_PERIOD_MS, BRG_VSAMPLER_DEFAULT_WINDOW_NB,
+                                                 BRG_VSAMPLER_DEFAULT_IDLE_GAP_US, 0, brownOutV, 0.05f };
+            pVmon = new BrgVoltageSampler(*pBrg, &vmonConf, VoltageBrownOut, NULL);
+            pVmon->SetFlashing(true);
+            pVmon->Start();
+        }
+        {
+            BRG_TRACE_SCOPE("SendCanBootloaderStart", BRG_TRACE_CAT_PHASE);
+            brgStat = brgTest.SendCanBootloaderStart(moduleId);
+        }
+        if (pVmon != NULL) {
+            Brg_VoltageStatsT vmonStats;
+            pVmon->Stop();
+            pVmon->GetStats(&vmonStats);
+            printf("Target voltage: min %.2f V, max %.2f V, mean %.2f V (%d samples, %d skipped)\n",
+                   (double)vmonStats.Min, (double)vmonStats.Max, (double)vmonStats.Mean,
+                   (int)vmonStats.SampleNb, (int)vmonStats.SkippedNb);
+            delete pVmon;
+        }
     }
 
 	// test disconnect
@@ -624,6 +903,12 @@ int main(int argc, char** argv)
 		delete m_pStlinkIf;
 		m_pStlinkIf = NULL;
 	}
+	// Written at shutdown, ignored if --chrome-trace not given
+	BrgChromeTraceStop();
+
+	if (bTiming == true) {
+		brgTest.PrintPhases(bTimingCsv);
+	}
 
 	if (brgStat == BRG_NO_ERR) 	{
 		printf("CAN Bootloader Start SUCCESS \n");
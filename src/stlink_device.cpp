@@ -269,8 +269,9 @@ STLinkIf_StatusT StlinkDevice::StGetVersion(Stlk_VersionExtT* pVersion)
 	pRq->SenseLength = DEFAULT_SENSE_LEN;
 
 	// StGetVersion is called after m_bStlinkConnected=true, so we can call SendRequest
-	// (preferable for semaphore management and status code analysis)
-	ifStatus = SendRequest(pRq);
+	// (preferable for semaphore management and status code analysis),
+	// through SendDeviceRequest() so that derived classes can instrument it
+	ifStatus = SendDeviceRequest(pRq);
 	delete pRq;
 
 	if (ifStatus == STLINKIF_NO_ERR) {
@@ -317,8 +318,9 @@ STLinkIf_StatusT StlinkDevice::GetVersionExt(Stlk_VersionExtT* pVersion)
 	pRq->SenseLength=DEFAULT_SENSE_LEN;
 
 	// GetVersionExt is called after m_bStlinkConnected=true, so we can call SendRequest
-	// (preferable for semaphore management and status code analysis)
-	ifStatus = SendRequest(pRq);
+	// (preferable for semaphore management and status code analysis),
+	// through SendDeviceRequest() so that derived classes can instrument it
+	ifStatus = SendDeviceRequest(pRq);
 	delete pRq;
 
 	if( ifStatus == STLINKIF_NO_ERR ) {
@@ -377,6 +379,17 @@ STLinkIf_StatusT StlinkDevice::SendRequest(STLink_DeviceRequestT *pDevReq,
 	return ifStatus;
 }
 
+/*
+ * @brief Send a request of the StlinkDevice commands (version, target voltage).
+ *        Same as StlinkDevice::SendRequest(), virtual so that derived classes can
+ *        instrument these commands as their own ones.
+ */
+STLinkIf_StatusT StlinkDevice::SendDeviceRequest(STLink_DeviceRequestT *pDevReq,
+                                                 const uint16_t UsbTimeoutMs) const
+{
+	return SendRequest(pDevReq, UsbTimeoutMs);
+}
+
 /**
  * @brief This routine gets target voltage in V, computed from STLink VREFINT value (typically
  * 1.2V at 25C).
@@ -410,7 +423,7 @@ STLinkIf_StatusT StlinkDevice::GetTargetVoltage(float *pVoltage) const
 	pRq->Buffer = adcMeasures;
 	pRq->SenseLength=DEFAULT_SENSE_LEN;
 
-	ifStatus = SendRequest(pRq);
+	ifStatus = SendDeviceRequest(pRq);
 
 	delete pRq;
 
@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    brg_test.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Minimal check macros and bridge setup shared by the host tests.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_TEST_H
+#define _BRG_TEST_H
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "bridge.h"
+#include "brg_sim_driver.h"
+
+/* Exported macros -----------------------------------------------------------*/
+// Each test program returns the number of failed checks (0: passed)
+#define BRG_TEST_CHECK(cond) \
+	do { \
+		if( !(cond) ) { \
+			printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			g_brgTestFailNb++; \
+		} \
+	} while( 0 )
+
+#define BRG_TEST_CHECK_EQ(a, b) \
+	do { \
+		long long _a = (long long)(a), _b = (long long)(b); \
+		if( _a != _b ) { \
+			printf("FAILED %s:%d: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+			g_brgTestFailNb++; \
+		} \
+	} while( 0 )
+
+#define BRG_TEST_RESULT() \
+	(printf("%s: %s (%d failed checks)\n", __FILE__, (g_brgTestFailNb == 0) ? "PASSED" : "FAILED", \
+	        g_brgTestFailNb), g_brgTestFailNb)
+
+/* Exported variables --------------------------------------------------------*/
+static int g_brgTestFailNb = 0;
+
+/* Exported functions --------------------------------------------------------*/
+// Open the simulated bridge
+static inline Brg_StatusT BrgTestOpen(STLinkInterface &StlinkIf, Brg &Bridge)
+{
+	uint32_t devNb = 0;
+
+	BrgSimReset();
+	if( StlinkIf.LoadStlinkLibrary("") != STLINKIF_NO_ERR ) {
+		return BRG_DLL_ERR;
+	}
+	if( StlinkIf.EnumDevices(&devNb, false) != STLINKIF_NO_ERR ) {
+		return BRG_NO_DEVICE;
+	}
+	return Bridge.OpenStlink(0);
+}
+
+#endif //_BRG_TEST_H
+/**********************************END OF FILE*********************************/
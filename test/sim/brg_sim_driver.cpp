@@ -0,0 +1,559 @@
+/**
+  ******************************************************************************
+  * @file    brg_sim_driver.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Simulated STLinkUSBDriver library for the host tests: one STLink-V3
+  *          bridge answering the bridge commands, with a configurable round trip
+  *          per command (direct USB or stand-in stlink-server).
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "stlink_fw_api_common.h"
+#include "stlink_fw_api_bridge.h"
+#include "brg_sim_driver.h"
+
+/* Private typedef -----------------------------------------------------------*/
+// Received CAN message, GET_RXMSG_CAN format (16 bytes)
+typedef struct {
+	uint8_t Raw[16];
+} SimCanMsgT;
+
+/* Private defines -----------------------------------------------------------*/
+#define SIM_STLINK_USB_ID   0x5157   // stand-in stlink-server device cookie
+#define SIM_COM_NB          8
+#define SIM_CAN_RX_MAX_NB   4096
+#define SIM_DEFAULT_CLK_KHZ 48000
+#define SIM_HCLK_KHZ        280000
+#define SIM_I2C_NO_WAIT_MAX 512      // READ_NO_WAIT_I2C data kept by the bridge
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_simMutex;
+static uint32_t g_usbUs = 0;
+static uint32_t g_tcpUs = 0;
+static uint32_t g_usbBytesPerMs = 0; // data phase rate, 0: no data phase time
+static BrgSimHookT g_hook = NULL;
+static uint64_t g_cmdNb[256];
+static uint64_t g_tcpCmdNb = 0;
+static uint8_t g_failOpcode = 0;
+static uint32_t g_failCountdown = 0;
+static uint8_t g_failStatus = STLINK_BRIDGE_OK;
+static uint8_t g_rwStatus = STLINK_BRIDGE_OK; // status of the last read/write command
+static uint16_t g_rwSize = 0;                  // bytes done without error by the last failed one
+static uint32_t g_clkKHz[SIM_COM_NB];
+static bool g_bCanLoopback = true;
+static std::deque<SimCanMsgT> g_canRx;
+static uint8_t g_canRxOverrun = 0; // overrun flag of the next stored message (GET_RXMSG_CAN byte4 bit3-4)
+static BrgSimSpiDevice *g_pSpiDevice = NULL;
+static BrgSimI2cDevice *g_pI2cDevice = NULL;
+static uint32_t g_i2cBytesPerMs = 0;
+static std::chrono::steady_clock::time_point g_i2cBusyEnd; // end of the READ_NO_WAIT_I2C transaction
+static uint8_t g_i2cData[SIM_I2C_NO_WAIT_MAX];
+static uint8_t g_i2cWrite[0x10000];                        // WRITE_I2C data (command bytes and buffer)
+static uint8_t g_gpioInitMask = 0; // GPIOs configured by INIT_GPIO
+static uint8_t g_gpioSetMask = 0;  // their level (1: high)
+
+/* Private functions ---------------------------------------------------------*/
+/*
+ * Round trip of one command: spin for short ones (sleep granularity is too coarse)
+ */
+static void SimWait(uint32_t DelayUs)
+{
+	std::chrono::steady_clock::time_point end;
+
+	if( DelayUs == 0 ) {
+		return;
+	}
+	end = std::chrono::steady_clock::now() + std::chrono::microseconds(DelayUs);
+	if( DelayUs > 2000 ) {
+		std::this_thread::sleep_for(std::chrono::microseconds(DelayUs - 1000));
+	}
+	while( std::chrono::steady_clock::now() < end ) {
+	}
+}
+
+/*
+ * I2C bus time of a transaction of Size data bytes (simulator lock held)
+ */
+static uint32_t SimI2cUs(uint32_t Size)
+{
+	if( g_i2cBytesPerMs == 0 ) {
+		return 0;
+	}
+	return (uint32_t)(((uint64_t)(Size + 1) * 1000) / g_i2cBytesPerMs);
+}
+
+/*
+ * Data phase time of the command, and I2C bus time of the blocking I2C commands
+ * (simulator lock held)
+ */
+static uint32_t SimDataUs(const STLink_DeviceRequestT *pRq)
+{
+	uint32_t dataUs = 0;
+
+	if( g_usbBytesPerMs != 0 ) {
+		dataUs = (uint32_t)(((uint64_t)pRq->BufferLength * 1000) / g_usbBytesPerMs);
+	}
+	if( (pRq->CDBByte[0] == STLINK_BRIDGE_COMMAND) &&
+	    ((pRq->CDBByte[1] == STLINK_BRIDGE_READ_I2C) || (pRq->CDBByte[1] == STLINK_BRIDGE_WRITE_I2C)) ) {
+		dataUs += SimI2cUs(pRq->CDBByte[2] | ((uint32_t)pRq->CDBByte[3] << 8));
+	}
+	return dataUs;
+}
+
+/*
+ * Status of the command: OK or the injected failure (simulator lock held)
+ */
+static uint8_t SimCmdStatus(uint8_t Opcode)
+{
+	if( (g_failCountdown != 0) && (Opcode == g_failOpcode) ) {
+		g_failCountdown--;
+		if( g_failCountdown == 0 ) {
+			return g_failStatus;
+		}
+	}
+	return STLINK_BRIDGE_OK;
+}
+
+/*
+ * Bridge command (CDBByte[0] == STLINK_BRIDGE_COMMAND), simulator lock held
+ */
+static void SimBridgeCommand(STLink_DeviceRequestT *pRq)
+{
+	uint8_t *pAnswer = (uint8_t*)pRq->Buffer;
+	uint8_t opcode = pRq->CDBByte[1];
+	uint8_t status = SimCmdStatus(opcode);
+	uint32_t i, nb;
+	SimCanMsgT msg;
+
+	g_cmdNb[opcode]++;
+	if( (pRq->InputRequest != REQUEST_WRITE) && (pAnswer != NULL) && (pRq->BufferLength != 0) ) {
+		memset(pAnswer, 0, pRq->BufferLength);
+	} else {
+		pAnswer = NULL;
+	}
+	switch( opcode ) {
+		case STLINK_BRIDGE_GET_RWCMD_STATUS:
+			status = g_rwStatus;
+			if( std::chrono::steady_clock::now() < g_i2cBusyEnd ) {
+				status = STLINK_BRIDGE_CMD_BUSY;
+			} else if( (pAnswer != NULL) && (pRq->BufferLength >= 4) && (status != STLINK_BRIDGE_OK) ) {
+				pAnswer[2] = (uint8_t)g_rwSize;
+				pAnswer[3] = (uint8_t)(g_rwSize >> 8);
+			}
+			break;
+		case STLINK_BRIDGE_WRITE_MSG_CAN:
+			g_rwStatus = status;
+			if( (status != STLINK_BRIDGE_OK) || (g_bCanLoopback == false) ) {
+				break;
+			}
+			if( g_canRx.size() >= SIM_CAN_RX_MAX_NB ) {
+				g_canRxOverrun = 2; // Rx buffer overrun, reported with the next stored message
+			} else {
+				memset(&msg, 0, sizeof(msg));
+				memcpy(&msg.Raw[0], &pRq->CDBByte[2], 4); // ID
+				msg.Raw[4] = pRq->CDBByte[6] | (uint8_t)(g_canRxOverrun << 3); // IDE, RTR, overrun
+				msg.Raw[5] = pRq->CDBByte[7];             // DLC
+				memcpy(&msg.Raw[8], &pRq->CDBByte[8], 4);
+				if( (pRq->InputRequest == REQUEST_WRITE) && (pRq->Buffer != NULL) && (pRq->BufferLength <= 4) ) {
+					memcpy(&msg.Raw[12], pRq->Buffer, pRq->BufferLength);
+				}
+				g_canRx.push_back(msg);
+				g_canRxOverrun = 0;
+			}
+			break;
+		case STLINK_BRIDGE_CS_SPI:
+			if( g_pSpiDevice != NULL ) {
+				g_pSpiDevice->Select(pRq->CDBByte[2] == 0);
+			}
+			break;
+		case STLINK_BRIDGE_WRITE_SPI:
+			g_rwStatus = status;
+			if( g_pSpiDevice != NULL ) {
+				nb = pRq->CDBByte[2] | ((uint32_t)pRq->CDBByte[3] << 8);
+				g_pSpiDevice->Write(&pRq->CDBByte[4], (nb > 8) ? 8 : nb);
+				if( (nb > 8) && (pRq->Buffer != NULL) ) {
+					g_pSpiDevice->Write((const uint8_t*)pRq->Buffer, nb - 8);
+				}
+			}
+			break;
+		case STLINK_BRIDGE_READ_SPI:
+			g_rwStatus = status;
+			if( (g_pSpiDevice != NULL) && (pAnswer != NULL) ) {
+				g_pSpiDevice->Read(pAnswer, pRq->BufferLength);
+			}
+			break;
+		case STLINK_BRIDGE_WRITE_MSG_FDCAN:
+			g_rwStatus = status;
+			break;
+		case STLINK_BRIDGE_WRITE_I2C:
+			g_rwStatus = status;
+			g_rwSize = 0;
+			if( (status == STLINK_BRIDGE_OK) && (g_pI2cDevice != NULL) ) {
+				nb = pRq->CDBByte[2] | ((uint32_t)pRq->CDBByte[3] << 8);
+				memcpy(g_i2cWrite, &pRq->CDBByte[8], (nb > 4) ? 4 : nb);
+				if( (nb > 4) && (pRq->Buffer != NULL) ) {
+					memcpy(&g_i2cWrite[4], pRq->Buffer, nb - 4);
+				}
+				if( g_pI2cDevice->Write(pRq->CDBByte[4] | ((uint16_t)pRq->CDBByte[5] << 8), g_i2cWrite, nb) == false ) {
+					g_rwStatus = STLINK_BRIDGE_I2C_ERROR;
+				}
+			}
+			break;
+		case STLINK_BRIDGE_READ_I2C:
+			g_rwStatus = status;
+			g_rwSize = 0;
+			if( (status == STLINK_BRIDGE_OK) && (g_pI2cDevice != NULL) && (pAnswer != NULL) ) {
+				if( g_pI2cDevice->Read(pRq->CDBByte[4] | ((uint16_t)pRq->CDBByte[5] << 8), pAnswer,
+				                       pRq->BufferLength) == false ) {
+					g_rwStatus = STLINK_BRIDGE_I2C_ERROR;
+				}
+			}
+			break;
+		case STLINK_BRIDGE_READ_NO_WAIT_I2C:
+			// Data read at once, kept for GET_READ_DATA_I2C, BUSY for the bus time
+			g_rwStatus = status;
+			g_rwSize = 0;
+			nb = pRq->CDBByte[2] | ((uint32_t)pRq->CDBByte[3] << 8);
+			memset(g_i2cData, 0, sizeof(g_i2cData));
+			if( (status == STLINK_BRIDGE_OK) && (g_pI2cDevice != NULL) ) {
+				if( g_pI2cDevice->Read(pRq->CDBByte[4] | ((uint16_t)pRq->CDBByte[5] << 8), g_i2cData,
+				                       (nb > SIM_I2C_NO_WAIT_MAX) ? SIM_I2C_NO_WAIT_MAX : nb) == false ) {
+					g_rwStatus = STLINK_BRIDGE_I2C_ERROR;
+				}
+			}
+			if( status == STLINK_BRIDGE_OK ) {
+				g_i2cBusyEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(SimI2cUs(nb));
+				status = (SimI2cUs(nb) != 0) ? STLINK_BRIDGE_CMD_BUSY : g_rwStatus;
+			}
+			break;
+		case STLINK_BRIDGE_GET_READ_DATA_I2C:
+			if( pAnswer != NULL ) {
+				memcpy(pAnswer, g_i2cData, (pRq->BufferLength > SIM_I2C_NO_WAIT_MAX) ? SIM_I2C_NO_WAIT_MAX :
+				                                                                       pRq->BufferLength);
+			}
+			return; // raw data, no status bytes
+		case STLINK_BRIDGE_START_MSG_RECEPTION_CAN:
+			if( (pAnswer != NULL) && (pRq->BufferLength >= 3) ) {
+				pAnswer[2] = CAN_MSG_FORMAT_V1;
+			}
+			break;
+		case STLINK_BRIDGE_GET_NB_RXMSG_CAN:
+			if( (pAnswer != NULL) && (pRq->BufferLength >= 5) ) {
+				nb = (uint32_t)g_canRx.size();
+				pAnswer[2] = (uint8_t)nb;
+				pAnswer[3] = (uint8_t)(nb >> 8);
+				pAnswer[4] = CAN_MSG_FORMAT_V1;
+			}
+			break;
+		case STLINK_BRIDGE_GET_RXMSG_CAN:
+			nb = pRq->CDBByte[2] | ((uint32_t)pRq->CDBByte[3] << 8);
+			for( i = 0; (i < nb) && (g_canRx.empty() == false) && (pAnswer != NULL) &&
+			            (16*(i+1) <= pRq->BufferLength); i++ ) {
+				memcpy(&pAnswer[16*i], g_canRx.front().Raw, 16);
+				g_canRx.pop_front();
+			}
+			return; // raw messages, no status bytes
+		case STLINK_BRIDGE_INIT_GPIO:
+			if( status == STLINK_BRIDGE_OK ) {
+				g_gpioInitMask |= pRq->CDBByte[2] & 0xF;
+			}
+			break;
+		case STLINK_BRIDGE_SET_RESET_GPIO:
+			// GPIOs not configured by INIT_GPIO are reported in the error mask
+			if( status == STLINK_BRIDGE_OK ) {
+				nb = pRq->CDBByte[2] & g_gpioInitMask;
+				g_gpioSetMask = (uint8_t)((g_gpioSetMask & ~nb) | (pRq->CDBByte[3] & nb));
+			}
+			if( (pAnswer != NULL) && (pRq->BufferLength >= 3) ) {
+				pAnswer[2] = pRq->CDBByte[2] & (uint8_t)~g_gpioInitMask & 0xF;
+			}
+			break;
+		case STLINK_BRIDGE_READ_GPIO:
+			if( (pAnswer != NULL) && (pRq->BufferLength >= 4) ) {
+				pAnswer[2] = pRq->CDBByte[2] & (uint8_t)~g_gpioInitMask & 0xF;
+				pAnswer[3] = g_gpioSetMask & g_gpioInitMask;
+			}
+			break;
+		case STLINK_BRIDGE_GET_CLOCK:
+			if( (pAnswer != NULL) && (pRq->BufferLength >= 12) ) {
+				uint32_t clk = g_clkKHz[pRq->CDBByte[2] % SIM_COM_NB], hclk = SIM_HCLK_KHZ;
+				memcpy(&pAnswer[4], &clk, 4);
+				memcpy(&pAnswer[8], &hclk, 4);
+			}
+			break;
+		default:
+			break;
+	}
+	if( (pAnswer != NULL) && (pRq->BufferLength >= 2) &&
+	    (opcode != STLINK_BRIDGE_READ_SPI) && (opcode != STLINK_BRIDGE_READ_I2C) ) {
+		pAnswer[0] = status;
+	}
+}
+
+/*
+ * One simulated command, any interface
+ */
+static uint32_t SimCommand(STLink_DeviceRequestT *pRq, uint32_t DelayUs)
+{
+	uint8_t *pAnswer = (uint8_t*)pRq->Buffer;
+	BrgSimHookT hook;
+
+	{
+		std::lock_guard<std::mutex> lock(g_simMutex);
+		hook = g_hook;
+	}
+	if( hook != NULL ) {
+		hook(pRq);
+	}
+	SimWait(DelayUs);
+
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	if( pRq->CDBByte[0] == STLINK_BRIDGE_COMMAND ) {
+		SimBridgeCommand(pRq);
+		return SS_OK;
+	}
+	if( (pRq->InputRequest == REQUEST_WRITE) || (pAnswer == NULL) ) {
+		return SS_OK;
+	}
+	memset(pAnswer, 0, pRq->BufferLength);
+	if( pRq->CDBByte[0] == ST_RBC_CMD ) {
+		pAnswer[0] = 0x30; // STLink-V3
+	} else if( (pRq->CDBByte[0] == ST_GETVERSION_EXT) && (pRq->BufferLength >= 12) ) {
+		pAnswer[0] = 3;    // STLink-V3
+		pAnswer[4] = 5;    // bridge version
+		pAnswer[8] = 0x83; // VID 0x0483
+		pAnswer[9] = 0x04;
+		pAnswer[10] = 0x4F; // PID 0x374F
+		pAnswer[11] = 0x37;
+	} else if( (pRq->CDBByte[0] == STLINK_GET_TARGET_VOLTAGE) && (pRq->BufferLength >= 8) ) {
+		uint32_t adc[2] = { 1000, 1375 }; // 3.3V
+		memcpy(pAnswer, adc, sizeof(adc));
+	}
+	return SS_OK;
+}
+
+/* Simulator control ---------------------------------------------------------*/
+void BrgSimReset(void)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_usbUs = 0;
+	g_tcpUs = 0;
+	g_usbBytesPerMs = 0;
+	g_hook = NULL;
+	memset(g_cmdNb, 0, sizeof(g_cmdNb));
+	g_tcpCmdNb = 0;
+	g_failCountdown = 0;
+	g_rwStatus = STLINK_BRIDGE_OK;
+	g_rwSize = 0;
+	for( int i = 0; i < SIM_COM_NB; i++ ) {
+		g_clkKHz[i] = SIM_DEFAULT_CLK_KHZ;
+	}
+	g_bCanLoopback = true;
+	g_canRx.clear();
+	g_canRxOverrun = 0;
+	g_pSpiDevice = NULL;
+	g_pI2cDevice = NULL;
+	g_i2cBytesPerMs = 0;
+	g_i2cBusyEnd = std::chrono::steady_clock::time_point();
+	g_gpioInitMask = 0;
+	g_gpioSetMask = 0;
+}
+
+void BrgSimSetLatency(uint32_t UsbUs, uint32_t TcpUs)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_usbUs = UsbUs;
+	g_tcpUs = TcpUs;
+}
+
+void BrgSimSetUsbRate(uint32_t BytesPerMs)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_usbBytesPerMs = BytesPerMs;
+}
+
+void BrgSimSetHook(BrgSimHookT Hook)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_hook = Hook;
+}
+
+uint64_t BrgSimGetCmdNb(uint8_t Opcode)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	return g_cmdNb[Opcode];
+}
+
+uint64_t BrgSimGetTcpCmdNb(void)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	return g_tcpCmdNb;
+}
+
+void BrgSimFailCmd(uint8_t Opcode, uint32_t Nth, uint8_t Status)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_failOpcode = Opcode;
+	g_failCountdown = Nth;
+	g_failStatus = Status;
+}
+
+void BrgSimSetClock(uint8_t BrgCom, uint32_t ClkKHz)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_clkKHz[BrgCom % SIM_COM_NB] = ClkKHz;
+}
+
+void BrgSimSetCanLoopback(bool bLoopback)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_bCanLoopback = bLoopback;
+}
+
+void BrgSimSetCanRxOverrun(uint8_t Overrun)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_canRxOverrun = Overrun & 0x3;
+}
+
+void BrgSimSetSpiDevice(BrgSimSpiDevice *pDevice)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_pSpiDevice = pDevice;
+}
+
+void BrgSimSetI2cDevice(BrgSimI2cDevice *pDevice)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_pI2cDevice = pDevice;
+}
+
+void BrgSimSetI2cRate(uint32_t BytesPerMs)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	g_i2cBytesPerMs = BytesPerMs;
+}
+
+uint8_t BrgSimGetGpio(void)
+{
+	std::lock_guard<std::mutex> lock(g_simMutex);
+	return g_gpioSetMask & g_gpioInitMask;
+}
+
+/* Simulated STLinkUSBDriver API ---------------------------------------------*/
+uint32_t STLink_GetLibApiVer(void)
+{
+	return 4;
+}
+
+uint32_t STLink_Reenumerate(TEnumStlinkInterface, uint8_t)
+{
+	return SS_OK;
+}
+
+uint32_t STLink_GetNbDevices(TEnumStlinkInterface)
+{
+	return 1;
+}
+
+uint32_t STLink_GetDeviceInfo(TEnumStlinkInterface, uint8_t, TDeviceInfo *pInfo, uint32_t)
+{
+	memset(pInfo, 0, sizeof(*pInfo));
+	snprintf(pInfo->EnumUniqueId, sizeof(pInfo->EnumUniqueId), "SIM0000000000000000000001");
+	return SS_OK;
+}
+
+uint32_t STLink_GetDeviceInfo2(TEnumStlinkInterface, uint8_t, TDeviceInfo2 *pInfo, uint32_t)
+{
+	memset(pInfo, 0, sizeof(*pInfo));
+	pInfo->StLinkUsbId = SIM_STLINK_USB_ID;
+	snprintf(pInfo->EnumUniqueId, sizeof(pInfo->EnumUniqueId), "SIM0000000000000000000001");
+	pInfo->VendorId = 0x0483;
+	pInfo->ProductId = 0x374F;
+	return SS_OK;
+}
+
+uint32_t STLink_OpenDevice(TEnumStlinkInterface, uint8_t, uint8_t, void **ppHandle)
+{
+	*ppHandle = (void*)&g_simMutex;
+	return SS_OK;
+}
+
+uint32_t STLink_CloseDevice(void*)
+{
+	return SS_OK;
+}
+
+uint32_t STLink_SendCommand(void*, PDeviceRequest pRequest, uint32_t)
+{
+	uint32_t delayUs;
+
+	{
+		std::lock_guard<std::mutex> lock(g_simMutex);
+		delayUs = g_usbUs + SimDataUs(pRequest);
+	}
+	return SimCommand(pRequest, delayUs);
+}
+
+// Stand-in stlink-server: same bridge, one TCP round trip more per command
+uint32_t STLink_ReenumerateTcp(TEnumStlinkInterface, uint8_t, char*, char*)
+{
+	return SS_OK;
+}
+
+uint32_t STLink_OpenDeviceTcp(TEnumStlinkInterface, uint32_t, uint8_t)
+{
+	return SS_OK;
+}
+
+uint32_t STLink_CloseDeviceTcp(uint32_t, uint8_t)
+{
+	return SS_OK;
+}
+
+uint32_t STLink_SendCommandTcp(uint32_t StLinkUsbId, PDeviceRequest pRequest, uint32_t)
+{
+	uint32_t delayUs;
+
+	if( StLinkUsbId != SIM_STLINK_USB_ID ) {
+		return SS_TCP_ERROR;
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_simMutex);
+		delayUs = g_usbUs + g_tcpUs + SimDataUs(pRequest);
+		g_tcpCmdNb++;
+	}
+	return SimCommand(pRequest, delayUs);
+}
+
+uint32_t STLink_GetNumOfDeviceClientsTcp(uint32_t)
+{
+	return 1;
+}
+
+uint32_t STLink_GetServerVersion(STLink_ServerVersionT *pServerVersion)
+{
+	memset(pServerVersion, 0, sizeof(*pServerVersion));
+	return SS_OK;
+}
+
+uint32_t STLink_FreeLibrary(void)
+{
+	return SS_OK;
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file    brg_sim_driver.h
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Header for brg_sim_driver.cpp: simulated STLinkUSBDriver library for
+  *          the host tests (one STLink-V3 bridge, no hardware).
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _BRG_SIM_DRIVER_H
+#define _BRG_SIM_DRIVER_H
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "STLinkUSBDriver.h"
+
+/* Exported types and constants ----------------------------------------------*/
+/// Called at the start of each simulated command (simulator lock not held)
+typedef void (*BrgSimHookT)(const STLink_DeviceRequestT *pRequest);
+
+/// Device on the simulated SPI bus, called with the simulator lock held
+class BrgSimSpiDevice
+{
+public:
+	virtual ~BrgSimSpiDevice(void) {}
+	virtual void Select(bool bSelected) = 0;                   // CS_SPI (NSS low: selected)
+	virtual void Write(const uint8_t *pData, uint32_t Size) = 0; // WRITE_SPI
+	virtual void Read(uint8_t *pData, uint32_t Size) = 0;        // READ_SPI
+};
+
+/// Device on the simulated I2C bus (full transactions), called with the simulator lock
+/// held: false if the address is not acknowledged (STLINK_BRIDGE_I2C_ERROR, 0 byte done)
+class BrgSimI2cDevice
+{
+public:
+	virtual ~BrgSimI2cDevice(void) {}
+	virtual bool Write(uint16_t Addr, const uint8_t *pData, uint32_t Size) = 0; // WRITE_I2C
+	virtual bool Read(uint16_t Addr, uint8_t *pData, uint32_t Size) = 0;        // READ_I2C, READ_NO_WAIT_I2C
+};
+
+/* Exported functions --------------------------------------------------------*/
+// Back to the initial state: no latency, no hook, no failure, counters cleared
+void BrgSimReset(void);
+// Round trip of each command: direct USB (STLink_SendCommand()) and through the
+// stand-in stlink-server (STLink_SendCommandTcp())
+void BrgSimSetLatency(uint32_t UsbUs, uint32_t TcpUs);
+// Data phase rate added to the round trip of each command (0: none, the default)
+void BrgSimSetUsbRate(uint32_t BytesPerMs);
+void BrgSimSetHook(BrgSimHookT Hook);
+// Bridge commands (CDBByte[1]) received, all interfaces
+uint64_t BrgSimGetCmdNb(uint8_t Opcode);
+// Commands received by the stand-in stlink-server
+uint64_t BrgSimGetTcpCmdNb(void);
+// The Nth next bridge command Opcode (1: next one) fails with the bridge status Status,
+// reported by its GET_RWCMD_STATUS or in its answer (only the last read/write command
+// status is kept, as in the firmware)
+void BrgSimFailCmd(uint8_t Opcode, uint32_t Nth, uint8_t Status);
+// Input clock of a bridge com (GET_CLOCK)
+void BrgSimSetClock(uint8_t BrgCom, uint32_t ClkKHz);
+// Frames written with WRITE_MSG_CAN are received back (default true)
+void BrgSimSetCanLoopback(bool bLoopback);
+// The next frame stored in the Rx buffer is flagged with the overrun Overrun (1: CAN fifo,
+// 2: Rx buffer, as in GET_RXMSG_CAN). A looped back frame dropped because the Rx buffer
+// is full flags the next stored one with 2.
+void BrgSimSetCanRxOverrun(uint8_t Overrun);
+// Device answering the SPI commands (NULL: none, reads return 0)
+void BrgSimSetSpiDevice(BrgSimSpiDevice *pDevice);
+// Device answering the I2C commands (NULL: none, reads return 0, writes acknowledged)
+void BrgSimSetI2cDevice(BrgSimI2cDevice *pDevice);
+// I2C bus time of each byte (address and data): added to the round trip of READ_I2C and
+// WRITE_I2C, READ_NO_WAIT_I2C is BUSY until it elapses (0: none, the default)
+void BrgSimSetI2cRate(uint32_t BytesPerMs);
+// Level of the GPIOs configured by INIT_GPIO (bit i: GPIOi high), as driven by
+// SET_RESET_GPIO; the others read 0 and are reported in the GPIO error mask
+uint8_t BrgSimGetGpio(void);
+
+#endif //_BRG_SIM_DRIVER_H
+/**********************************END OF FILE*********************************/
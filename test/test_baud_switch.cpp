@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file    test_baud_switch.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgCanBaudSwitch on the simulated bridge (CAN loopback): no BrgTxQueue
+  *          frame sent between the negotiation and the end of the probe or revert,
+  *          fast session statistics.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "brg_test.h"
+#include "brg_baud_switch.h"
+#include "brg_tx_queue.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_NOMINAL_BAUD    125000
+#define TEST_FAST_BAUD       1000000
+#define TEST_USB_US          100
+#define TEST_TRAFFIC_ID      0x700  // BrgTxQueue frames of another thread
+#define TEST_NEGOTIATE_ID    0x050
+#define TEST_PROBE_ID        0x051
+
+/* Private typedef -----------------------------------------------------------*/
+// CAN command seen by the simulated bridge: INIT_CAN (Id 0) or WRITE_MSG_CAN
+typedef struct {
+	uint8_t Opcode;
+	uint32_t Id;
+} TestCanCmdT;
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_cmdMutex;
+static std::vector<TestCanCmdT> g_cmds;
+
+/* Private functions ---------------------------------------------------------*/
+static void RecordCmd(const STLink_DeviceRequestT *pRequest)
+{
+	TestCanCmdT cmd;
+
+	if( pRequest->CDBByte[0] != STLINK_BRIDGE_COMMAND ) {
+		return;
+	}
+	cmd.Opcode = pRequest->CDBByte[1];
+	cmd.Id = 0;
+	if( cmd.Opcode == STLINK_BRIDGE_WRITE_MSG_CAN ) {
+		memcpy(&cmd.Id, &pRequest->CDBByte[2], 4);
+	} else if( cmd.Opcode != STLINK_BRIDGE_INIT_CAN ) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	g_cmds.push_back(cmd);
+}
+
+static void SetExchange(Brg_CanExchangeT *pExchange, uint32_t Id, uint32_t ResponseId, uint32_t TimeoutMs)
+{
+	memset(pExchange, 0, sizeof(*pExchange));
+	pExchange->Msg.IDE = CAN_ID_STANDARD;
+	pExchange->Msg.ID = Id;
+	pExchange->Msg.RTR = CAN_DATA_FRAME;
+	pExchange->Msg.DLC = 1;
+	pExchange->Data[0] = 0x5A;
+	pExchange->Size = 1;
+	pExchange->Response.IDE = CAN_ID_STANDARD;
+	pExchange->Response.ID = ResponseId;
+	pExchange->TimeoutMs = TimeoutMs;
+}
+
+// Probe without answer while another thread sends through BrgTxQueue: reverted, and
+// none of its frames between the negotiation and the revert
+static void TestFailedProbeUnderTraffic(Brg &Bridge, const Brg_CanInitT *pNominalInit)
+{
+	BrgCanBaudSwitch baudSwitch(Bridge, pNominalInit, TEST_NOMINAL_BAUD);
+	BrgTxQueue queue(Bridge);
+	Brg_CanExchangeT negotiate, probe;
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, TEST_TRAFFIC_ID, CAN_DATA_FRAME, 0 };
+	Brg_BaudSwitchStatsT stats;
+	std::atomic<bool> bRun(true);
+	size_t start = 0, end = 0, trafficIn = 0, trafficBefore = 0, trafficAfter = 0, initNb = 0;
+
+	SetExchange(&negotiate, TEST_NEGOTIATE_ID, TEST_NEGOTIATE_ID, 50);
+	SetExchange(&probe, TEST_PROBE_ID, TEST_PROBE_ID + 1, 30); // never answered
+	BrgSimSetLatency(TEST_USB_US, 0);
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	std::thread traffic([&queue, &msg, &bRun]() {
+		while( bRun.load() == true ) {
+			queue.PushCAN(&msg, NULL, 0);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	{
+		std::lock_guard<std::mutex> lock(g_cmdMutex);
+		for( size_t i = 0; i < g_cmds.size(); i++ ) {
+			trafficBefore += (g_cmds[i].Id == TEST_TRAFFIC_ID) ? 1 : 0;
+		}
+		g_cmds.clear();
+	}
+	BRG_TEST_CHECK_EQ(baudSwitch.SwitchUp(TEST_FAST_BAUD, 750, &negotiate, &probe), BRG_TARGET_CMD_TIMEOUT);
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	bRun.store(false);
+	traffic.join();
+	queue.Stop(false);
+	BrgSimSetLatency(0, 0);
+
+	BRG_TEST_CHECK_EQ(baudSwitch.IsFast(), false);
+	baudSwitch.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.FailedSwitchNb, 1);
+	BRG_TEST_CHECK_EQ(stats.SwitchNb, 0);
+
+	// Window: negotiation frame to the last INIT_CAN (revert to the nominal rate)
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	for( size_t i = 0; i < g_cmds.size(); i++ ) {
+		if( (g_cmds[i].Opcode == STLINK_BRIDGE_WRITE_MSG_CAN) && (g_cmds[i].Id == TEST_NEGOTIATE_ID) ) {
+			start = i;
+		}
+		if( g_cmds[i].Opcode == STLINK_BRIDGE_INIT_CAN ) {
+			end = i;
+			initNb++;
+		}
+	}
+	for( size_t i = 0; i < g_cmds.size(); i++ ) {
+		if( (g_cmds[i].Id != TEST_TRAFFIC_ID) || (i < start) ) {
+			continue; // write already in progress when SwitchUp() was called
+		}
+		if( i > end ) {
+			trafficAfter++;
+		} else {
+			trafficIn++;
+		}
+	}
+	BRG_TEST_CHECK_EQ(initNb, 2); // fast rate, then back to nominal
+	BRG_TEST_CHECK(start < end);
+	BRG_TEST_CHECK(trafficBefore > 0);
+	BRG_TEST_CHECK(trafficAfter > 0); // the queue went on after the switch
+	BRG_TEST_CHECK_EQ(trafficIn, 0);
+}
+
+// Answered probe: fast session, frames counted, revert back to the nominal rate
+static void TestFastSession(Brg &Bridge, const Brg_CanInitT *pNominalInit)
+{
+	BrgCanBaudSwitch baudSwitch(Bridge, pNominalInit, TEST_NOMINAL_BAUD);
+	Brg_CanExchangeT negotiate, probe;
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0x123, CAN_DATA_FRAME, 8 };
+	uint8_t data[8] = { 0 };
+	Brg_BaudSwitchStatsT stats;
+	size_t initNb = 0;
+
+	SetExchange(&negotiate, TEST_NEGOTIATE_ID, TEST_NEGOTIATE_ID, 50);
+	SetExchange(&probe, TEST_PROBE_ID, TEST_PROBE_ID, 50);
+	{
+		std::lock_guard<std::mutex> lock(g_cmdMutex);
+		g_cmds.clear();
+	}
+	BRG_TEST_CHECK_EQ(baudSwitch.SwitchUp(TEST_FAST_BAUD, 750, &negotiate, &probe), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(baudSwitch.IsFast(), true);
+	BRG_TEST_CHECK_EQ(baudSwitch.SwitchUp(TEST_FAST_BAUD, 750, NULL, NULL), BRG_CMD_NOT_ALLOWED);
+	for( int i = 0; i < 10; i++ ) {
+		BRG_TEST_CHECK_EQ(baudSwitch.WriteMsgCAN(&msg, data, 8), BRG_NO_ERR);
+	}
+	BRG_TEST_CHECK_EQ(baudSwitch.Revert(NULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(baudSwitch.IsFast(), false);
+
+	baudSwitch.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.SwitchNb, 1);
+	BRG_TEST_CHECK_EQ(stats.FastBaudrate, TEST_FAST_BAUD);
+	BRG_TEST_CHECK_EQ(stats.FastFrameNb, 10);
+	BRG_TEST_CHECK_EQ(stats.FastBitNb, 10 * (47 + 64));
+	BRG_TEST_CHECK(stats.SavedUs > 0);
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	for( size_t i = 0; i < g_cmds.size(); i++ ) {
+		if( g_cmds[i].Opcode == STLINK_BRIDGE_INIT_CAN ) {
+			initNb++;
+		}
+	}
+	BRG_TEST_CHECK_EQ(initNb, 2);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	Brg_CanBitTimingT bitTiming;
+	Brg_CanInitT nominalInit;
+	uint8_t candidateNb = 0;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.FindCANbitTiming(TEST_NOMINAL_BAUD, 875, &bitTiming, 1, &candidateNb), BRG_NO_ERR);
+	memset(&nominalInit, 0, sizeof(nominalInit));
+	nominalInit.BitTimeConf = bitTiming.BitTimeConf;
+	nominalInit.Prescaler = bitTiming.Prescaler;
+	nominalInit.Mode = CAN_MODE_NORMAL;
+	BRG_TEST_CHECK_EQ(bridge.InitCAN(&nominalInit, BRG_INIT_FULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.StartMsgReceptionCAN(), BRG_NO_ERR);
+	BrgSimSetHook(RecordCmd);
+	TestFailedProbeUnderTraffic(bridge, &nominalInit);
+	TestFastSession(bridge, &nominalInit);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
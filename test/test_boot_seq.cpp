@@ -0,0 +1,252 @@
+/**
+  ******************************************************************************
+  * @file    test_boot_seq.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgBootSequencer on the simulated bridge (CAN loopback): reset into
+  *          bootloader step order and timing, result filled on error.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include "brg_test.h"
+#include "brg_boot_seq.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_BAUD           125000
+#define TEST_USB_US         300   // round trip of one USB command
+#define TEST_RESET_MASK     BRG_GPIO_0
+#define TEST_BOOT_MASK      BRG_GPIO_1
+#define TEST_RESET_PULSE_US 2000
+#define TEST_FRAME_DELAY_US 3000
+#define TEST_BOOT_HOLD_US   1000
+#define TEST_START_ID       0x079
+#define TEST_LATE_MAX_US    1000  // step start tolerance (single CPU, sleep then spin)
+
+/* Private typedef -----------------------------------------------------------*/
+// GPIO or CAN command seen by the simulated bridge
+typedef struct {
+	uint8_t Opcode;
+	uint8_t GpioMask;     // SET_RESET_GPIO: GPIOs driven
+	uint8_t GpioSetMask;  // SET_RESET_GPIO: GPIOs driven high
+	uint64_t Us;          // command start
+} TestCmdT;
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_cmdMutex;
+static std::vector<TestCmdT> g_cmds;
+
+/* Private functions ---------------------------------------------------------*/
+static void RecordCmd(const STLink_DeviceRequestT *pRequest)
+{
+	TestCmdT cmd;
+
+	if( (pRequest->CDBByte[0] != STLINK_BRIDGE_COMMAND) ||
+	    ((pRequest->CDBByte[1] != STLINK_BRIDGE_INIT_GPIO) && (pRequest->CDBByte[1] != STLINK_BRIDGE_SET_RESET_GPIO) &&
+	     (pRequest->CDBByte[1] != STLINK_BRIDGE_WRITE_MSG_CAN)) ) {
+		return;
+	}
+	cmd.Opcode = pRequest->CDBByte[1];
+	cmd.GpioMask = (cmd.Opcode == STLINK_BRIDGE_SET_RESET_GPIO) ? pRequest->CDBByte[2] : 0;
+	cmd.GpioSetMask = (cmd.Opcode == STLINK_BRIDGE_SET_RESET_GPIO) ? pRequest->CDBByte[3] : 0;
+	cmd.Us = BrgGetMonotonicUs();
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	g_cmds.push_back(cmd);
+}
+
+static void ClearCmds(void)
+{
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	g_cmds.clear();
+}
+
+static void SetStartFrame(Brg_CanExchangeT *pFrame, uint32_t ResponseId, uint32_t TimeoutMs)
+{
+	memset(pFrame, 0, sizeof(*pFrame));
+	pFrame->Msg.IDE = CAN_ID_STANDARD;
+	pFrame->Msg.ID = TEST_START_ID;
+	pFrame->Msg.RTR = CAN_DATA_FRAME;
+	pFrame->Msg.DLC = 1;
+	pFrame->Data[0] = 0x7F;
+	pFrame->Size = 1;
+	pFrame->Response.IDE = CAN_ID_STANDARD;
+	pFrame->Response.ID = ResponseId;
+	pFrame->TimeoutMs = TimeoutMs;
+}
+
+// Reset into bootloader steps: strap and reset together, release, strap release before
+// the frame (shorter hold than frame delay), frame
+static uint8_t MakeSteps(Brg_BootSeqStepT *pSteps)
+{
+	return BrgBootSequencer::MakeResetIntoBoot(pSteps, TEST_RESET_MASK, TEST_BOOT_MASK, GPIO_SET,
+	                                           TEST_RESET_PULSE_US, TEST_FRAME_DELAY_US, TEST_BOOT_HOLD_US);
+}
+
+static void TestMakeResetIntoBoot(void)
+{
+	Brg_BootSeqStepT steps[4];
+
+	BRG_TEST_CHECK_EQ(MakeSteps(steps), 4);
+	BRG_TEST_CHECK_EQ(steps[0].Action, BRG_BOOTSEQ_GPIO);
+	BRG_TEST_CHECK_EQ(steps[0].GpioMask, TEST_RESET_MASK | TEST_BOOT_MASK);
+	BRG_TEST_CHECK_EQ(steps[0].GpioSetMask, TEST_BOOT_MASK);
+	BRG_TEST_CHECK_EQ(steps[0].AtUs, 0);
+	BRG_TEST_CHECK_EQ(steps[1].GpioSetMask, TEST_RESET_MASK | TEST_BOOT_MASK);
+	BRG_TEST_CHECK_EQ(steps[1].AtUs, TEST_RESET_PULSE_US);
+	BRG_TEST_CHECK_EQ(steps[2].Action, BRG_BOOTSEQ_GPIO);
+	BRG_TEST_CHECK_EQ(steps[2].GpioMask, TEST_BOOT_MASK);
+	BRG_TEST_CHECK_EQ(steps[2].GpioSetMask, 0);
+	BRG_TEST_CHECK_EQ(steps[2].AtUs, TEST_RESET_PULSE_US + TEST_BOOT_HOLD_US);
+	BRG_TEST_CHECK_EQ(steps[3].Action, BRG_BOOTSEQ_CAN_START);
+	BRG_TEST_CHECK_EQ(steps[3].AtUs, TEST_RESET_PULSE_US + TEST_FRAME_DELAY_US);
+
+	// No boot strap: 3 steps; reset and strap on the same GPIO: invalid
+	BRG_TEST_CHECK_EQ(BrgBootSequencer::MakeResetIntoBoot(steps, TEST_RESET_MASK, 0, GPIO_SET,
+	                                                      TEST_RESET_PULSE_US, TEST_FRAME_DELAY_US, 0), 3);
+	BRG_TEST_CHECK_EQ(steps[2].Action, BRG_BOOTSEQ_CAN_START);
+	BRG_TEST_CHECK_EQ(BrgBootSequencer::MakeResetIntoBoot(steps, TEST_RESET_MASK, TEST_RESET_MASK, GPIO_SET,
+	                                                      TEST_RESET_PULSE_US, TEST_FRAME_DELAY_US, 0), 0);
+}
+
+// Commands in step order, each started at its planned time from the first one whatever
+// the USB latency, GPIO levels at the end, bootloader response time
+static void TestStepOrderAndTiming(Brg &Bridge)
+{
+	BrgBootSequencer sequencer(Bridge);
+	Brg_BootSeqStepT steps[4];
+	Brg_CanExchangeT startFrame;
+	Brg_BootSeqResultT result;
+	uint32_t maxLateUs = 0;
+	uint8_t stepNb = MakeSteps(steps);
+
+	SetStartFrame(&startFrame, TEST_START_ID, 50); // looped back: answered at once
+	BrgSimSetLatency(TEST_USB_US, 0);
+	// A preemption of the test host can delay a step by a few ms: best of 3
+	for( int run = 0; run < 3; run++ ) {
+		ClearCmds();
+		BRG_TEST_CHECK_EQ(sequencer.Run(steps, stepNb, &startFrame, &result), BRG_NO_ERR);
+		if( result.MaxLateUs < TEST_LATE_MAX_US ) {
+			break;
+		}
+	}
+	BrgSimSetLatency(0, 0);
+
+	BRG_TEST_CHECK_EQ(result.StepNb, stepNb);
+	for( uint8_t i = 0; i < stepNb; i++ ) {
+		BRG_TEST_CHECK(result.StepLateUs[i] < TEST_LATE_MAX_US);
+		BRG_TEST_CHECK(result.StepCmdUs[i] >= TEST_USB_US);
+		maxLateUs = (result.StepLateUs[i] > maxLateUs) ? result.StepLateUs[i] : maxLateUs;
+	}
+	BRG_TEST_CHECK_EQ(result.MaxLateUs, maxLateUs);
+	BRG_TEST_CHECK(result.FrameSentUs >= steps[3].AtUs + TEST_USB_US);
+	BRG_TEST_CHECK(result.ReadyUs >= result.FrameSentUs);
+	BRG_TEST_CHECK_EQ(BrgSimGetGpio() & (TEST_RESET_MASK | TEST_BOOT_MASK), TEST_RESET_MASK);
+
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	BRG_TEST_CHECK_EQ(g_cmds.size(), 1 + stepNb);
+	if( g_cmds.size() != 1u + stepNb ) {
+		return;
+	}
+	BRG_TEST_CHECK_EQ(g_cmds[0].Opcode, STLINK_BRIDGE_INIT_GPIO);
+	for( uint8_t i = 0; i < stepNb; i++ ) {
+		const TestCmdT &cmd = g_cmds[1 + i];
+		if( steps[i].Action == BRG_BOOTSEQ_CAN_START ) {
+			BRG_TEST_CHECK_EQ(cmd.Opcode, STLINK_BRIDGE_WRITE_MSG_CAN);
+		} else {
+			BRG_TEST_CHECK_EQ(cmd.Opcode, STLINK_BRIDGE_SET_RESET_GPIO);
+			BRG_TEST_CHECK_EQ(cmd.GpioMask, steps[i].GpioMask);
+			BRG_TEST_CHECK_EQ(cmd.GpioSetMask, steps[i].GpioSetMask);
+		}
+		// Latency of the previous commands not accumulated
+		BRG_TEST_CHECK(cmd.Us - g_cmds[1].Us + 100 >= steps[i].AtUs);
+		BRG_TEST_CHECK(cmd.Us - g_cmds[1].Us <= steps[i].AtUs + TEST_LATE_MAX_US);
+	}
+}
+
+// Errors: the steps done before are reported, nothing for invalid parameters
+static void TestResultOnError(Brg &Bridge)
+{
+	BrgBootSequencer sequencer(Bridge);
+	Brg_BootSeqStepT steps[4];
+	Brg_CanExchangeT startFrame;
+	Brg_BootSeqResultT result;
+	uint8_t stepNb = MakeSteps(steps);
+
+	// Start frame write failure (step 4): 4 steps, frame time, no response
+	SetStartFrame(&startFrame, TEST_START_ID, 50);
+	BrgSimFailCmd(STLINK_BRIDGE_WRITE_MSG_CAN, 1, STLINK_BRIDGE_CAN_ERROR);
+	memset(&result, 0xFF, sizeof(result));
+	BRG_TEST_CHECK(sequencer.Run(steps, stepNb, &startFrame, &result) != BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(result.StepNb, 4);
+	BRG_TEST_CHECK(result.MaxLateUs != 0xFFFFFFFF);
+	BRG_TEST_CHECK(result.StepLateUs[3] <= result.MaxLateUs);
+	BRG_TEST_CHECK(result.FrameSentUs >= steps[3].AtUs);
+	BRG_TEST_CHECK_EQ(result.ReadyUs, 0);
+
+	// Reset release failure (step 2): steps 1 and 2 reported, reset still asserted
+	BrgSimFailCmd(STLINK_BRIDGE_SET_RESET_GPIO, 2, STLINK_BRIDGE_INTERNAL_ERR);
+	memset(&result, 0xFF, sizeof(result));
+	BRG_TEST_CHECK(sequencer.Run(steps, stepNb, &startFrame, &result) != BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(result.StepNb, 2);
+	BRG_TEST_CHECK(result.MaxLateUs != 0xFFFFFFFF);
+	BRG_TEST_CHECK(result.StepLateUs[1] <= result.MaxLateUs);
+	BRG_TEST_CHECK_EQ(result.StepLateUs[2], 0);
+	BRG_TEST_CHECK_EQ(result.StepCmdUs[2], 0);
+	BRG_TEST_CHECK_EQ(result.FrameSentUs, 0);
+	BRG_TEST_CHECK_EQ(BrgSimGetGpio() & (TEST_RESET_MASK | TEST_BOOT_MASK), TEST_BOOT_MASK);
+
+	// No bootloader response: all the steps reported, no ready time
+	SetStartFrame(&startFrame, TEST_START_ID + 1, 20);
+	memset(&result, 0xFF, sizeof(result));
+	BRG_TEST_CHECK_EQ(sequencer.Run(steps, stepNb, &startFrame, &result), BRG_TARGET_CMD_TIMEOUT);
+	BRG_TEST_CHECK_EQ(result.StepNb, 4);
+	BRG_TEST_CHECK(result.FrameSentUs >= steps[3].AtUs);
+	BRG_TEST_CHECK_EQ(result.ReadyUs, 0);
+
+	// Steps out of time order: nothing done, zero result
+	steps[1].AtUs = 0;
+	steps[0].AtUs = 10;
+	ClearCmds();
+	memset(&result, 0xFF, sizeof(result));
+	BRG_TEST_CHECK_EQ(sequencer.Run(steps, stepNb, &startFrame, &result), BRG_PARAM_ERR);
+	BRG_TEST_CHECK_EQ(result.StepNb, 0);
+	BRG_TEST_CHECK_EQ(result.MaxLateUs, 0);
+	BRG_TEST_CHECK_EQ(result.FrameSentUs, 0);
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	BRG_TEST_CHECK_EQ(g_cmds.size(), 0);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	Brg_CanBitTimingT bitTiming;
+	Brg_CanInitT canInit;
+	uint8_t candidateNb = 0;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.FindCANbitTiming(TEST_BAUD, 875, &bitTiming, 1, &candidateNb), BRG_NO_ERR);
+	memset(&canInit, 0, sizeof(canInit));
+	canInit.BitTimeConf = bitTiming.BitTimeConf;
+	canInit.Prescaler = bitTiming.Prescaler;
+	canInit.Mode = CAN_MODE_NORMAL;
+	BRG_TEST_CHECK_EQ(bridge.InitCAN(&canInit, BRG_INIT_FULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.StartMsgReceptionCAN(), BRG_NO_ERR);
+	BrgSimSetHook(RecordCmd);
+	TestMakeResetIntoBoot();
+	TestStepOrderAndTiming(bridge);
+	TestResultOnError(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
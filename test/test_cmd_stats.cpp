@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file    test_cmd_stats.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Brg command statistics: bridge commands and StlinkDevice commands
+  *          (version, target voltage) are all recorded.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "brg_test.h"
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	Brg_CmdStatsT stats;
+	float voltage = 0;
+	uint64_t endUs;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	// OpenStlink() reads the version with ST_GETVERSION_EXT (ST_RBC_CMD not used on the
+	// bridge interface)
+	BRG_TEST_CHECK_EQ(bridge.GetCmdStats(ST_RBC_CMD, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 0);
+	BRG_TEST_CHECK_EQ(bridge.GetCmdStats(ST_GETVERSION_EXT, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(stats.RxBytes, 12);
+	BRG_TEST_CHECK_EQ(stats.Latency.Count, 1);
+	BRG_TEST_CHECK(strcmp(Brg::GetCmdName(ST_GETVERSION_EXT), "GET_VERSION_EXT") == 0);
+
+	// Target voltage: counted and seen as USB activity
+	endUs = bridge.GetLastCmdEndUs();
+	BRG_TEST_CHECK_EQ(bridge.GetTargetVoltage(&voltage), BRG_NO_ERR);
+	BRG_TEST_CHECK(bridge.GetLastCmdEndUs() > endUs);
+	BRG_TEST_CHECK_EQ(bridge.GetTargetVoltage(&voltage), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.GetCmdStats(STLINK_GET_TARGET_VOLTAGE, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 2);
+	BRG_TEST_CHECK_EQ(stats.RxBytes, 16);
+
+	// Bridge commands keyed by their bridge opcode
+	BRG_TEST_CHECK_EQ(bridge.StartMsgReceptionCAN(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.GetCmdStats(STLINK_BRIDGE_START_MSG_RECEPTION_CAN, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(stats.StatusErrNb, 0);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
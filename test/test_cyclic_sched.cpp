@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file    test_cyclic_sched.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgCyclicScheduler: every tick is processed, periodic entries are
+  *          released once per period.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <thread>
+#include <chrono>
+#include "brg_test.h"
+#include "brg_cyclic_sched.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_TICK_US   1000
+#define TEST_RUN_MS    500
+
+/* Private functions ---------------------------------------------------------*/
+/*
+ * Periodic entries of PeriodTicks ticks over TEST_RUN_MS: each period gives one release,
+ * or one missed occurrence if the tick thread was more than one period late
+ */
+static void TestPeriodicReleases(Brg &Bridge, uint32_t PeriodTicks)
+{
+	BrgTxQueue txQueue(Bridge);
+	BrgCyclicScheduler sched(txQueue, TEST_TICK_US);
+	Brg_CanTxMsgT canMsg = { CAN_ID_STANDARD, 0x100, CAN_DATA_FRAME, 8 };
+	uint8_t data[8] = { 0 };
+	Brg_CyclicStatsT stats;
+	uint32_t handle;
+	uint64_t startUs, runUs, expectedNb;
+
+	BRG_TEST_CHECK_EQ(txQueue.Start(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(sched.AddPeriodicCAN(&canMsg, data, 8, PeriodTicks*TEST_TICK_US, &handle), BRG_NO_ERR);
+	startUs = BrgGetMonotonicUs();
+	BRG_TEST_CHECK_EQ(sched.Start(), BRG_NO_ERR);
+	std::this_thread::sleep_for(std::chrono::milliseconds(TEST_RUN_MS));
+	BRG_TEST_CHECK_EQ(sched.Stop(), BRG_NO_ERR);
+	runUs = BrgGetMonotonicUs() - startUs;
+	txQueue.Stop(true);
+
+	sched.GetStats(&stats);
+	expectedNb = runUs / (PeriodTicks*TEST_TICK_US);
+	printf("period %u ticks: %llu us, released %llu, missed %llu, late ticks %llu (expected ~%llu)\n",
+	       (unsigned)PeriodTicks, (unsigned long long)runUs, (unsigned long long)stats.ReleasedNb,
+	       (unsigned long long)stats.MissedNb, (unsigned long long)stats.LateTickNb,
+	       (unsigned long long)expectedNb);
+	// Every period accounted for, released or missed (2 periods margin at start and stop)
+	BRG_TEST_CHECK(stats.ReleasedNb + stats.MissedNb + 2 >= expectedNb);
+	BRG_TEST_CHECK(stats.ReleasedNb + stats.MissedNb <= expectedNb + 2);
+	// A missed occurrence needs a tick thread more than one period late
+	BRG_TEST_CHECK(stats.MissedNb <= stats.LateTickNb);
+	BRG_TEST_CHECK(stats.ReleasedNb * 4 >= expectedNb * 3);
+	BRG_TEST_CHECK_EQ(stats.TxDroppedNb, 0);
+}
+
+/*
+ * One-shot frames due in consecutive ticks next to a 1-tick periodic entry: none waits
+ * for the next wheel turn
+ */
+static void TestOneShotNextToPeriodic(Brg &Bridge)
+{
+	BrgTxQueue txQueue(Bridge);
+	BrgCyclicScheduler sched(txQueue, TEST_TICK_US);
+	Brg_CanTxMsgT canMsg = { CAN_ID_STANDARD, 0x200, CAN_DATA_FRAME, 1 };
+	uint8_t data[1] = { 0 };
+	Brg_CyclicStatsT stats;
+	uint32_t handle;
+
+	BRG_TEST_CHECK_EQ(txQueue.Start(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(sched.AddPeriodicCAN(&canMsg, data, 1, TEST_TICK_US, &handle), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(sched.Start(), BRG_NO_ERR);
+	for( uint32_t i = 1; i <= 20; i++ ) {
+		BRG_TEST_CHECK_EQ(sched.AddOneShotCAN(&canMsg, data, 1, 10*TEST_TICK_US + i*TEST_TICK_US, &handle), BRG_NO_ERR);
+	}
+	// Wheel turn: BRG_CYC_WHEEL_SLOTS ticks, far more than the 30 ms needed
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	sched.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.ActiveNb, 1); // only the periodic entry left
+	BRG_TEST_CHECK_EQ(sched.Stop(), BRG_NO_ERR);
+	txQueue.Stop(true);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BrgSimSetCanLoopback(false);
+	TestPeriodicReleases(bridge, 1);
+	TestPeriodicReleases(bridge, 2);
+	TestOneShotNextToPeriodic(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
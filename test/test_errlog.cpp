@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file    test_errlog.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   cErrLog: records with many arguments are complete, the ring of an
+  *          exited thread is freed once dumped.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include "brg_test.h"
+#include "ErrLog.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_LOG_FILE  "test_errlog.log"
+
+/* Private functions ---------------------------------------------------------*/
+// Last line of the log file
+static void ReadLastLine(char *pLine, size_t LineSize)
+{
+	char line[512];
+	FILE *pFile = fopen(TEST_LOG_FILE, "r");
+
+	pLine[0] = 0;
+	if( pFile == NULL ) {
+		return;
+	}
+	while( fgets(line, sizeof(line), pFile) != NULL ) {
+		strncpy(pLine, line, LineSize - 1);
+		pLine[LineSize - 1] = 0;
+	}
+	fclose(pFile);
+}
+
+// Same format and argument count as the BRIDGE error trace of SendRequestAndAnalyzeStatus()
+static void TestElevenArgs(void)
+{
+	cErrLog errLog;
+	char line[512];
+
+	errLog.Init(TEST_LOG_FILE, true);
+	errLog.LogTrace("BRIDGE Error (0x%hx) after BRIDGE cmd %02hX %02hX %02hX %02hX %02hX %02hX %02hX %02hX %02hX %02hX",
+	                (unsigned short)0x0D, (unsigned short)0xFC, (unsigned short)0x41, (unsigned short)2,
+	                (unsigned short)3, (unsigned short)4, (unsigned short)5, (unsigned short)6,
+	                (unsigned short)7, (unsigned short)8, (unsigned short)9);
+	errLog.Dump();
+	ReadLastLine(line, sizeof(line));
+	BRG_TEST_CHECK(strstr(line, "BRIDGE Error (0xd) after BRIDGE cmd FC 41 02 03 04 05 06 07 08 09") != NULL);
+	BRG_TEST_CHECK(strstr(line, "<?>") == NULL);
+}
+
+// Short-lived threads: their rings are freed by the dump following their exit
+static void TestThreadRingRelease(void)
+{
+	cErrLog errLog;
+	std::thread threads[8];
+
+	errLog.LogTrace("main thread %d", 1);
+	for( int round = 0; round < 4; round++ ) {
+		for( int i = 0; i < 8; i++ ) {
+			threads[i] = std::thread([&errLog, i]() { errLog.LogTrace("worker %d", i); });
+		}
+		for( int i = 0; i < 8; i++ ) {
+			threads[i].join();
+		}
+		BRG_TEST_CHECK_EQ(errLog.GetRingNb(), 9);
+		errLog.Dump();
+		BRG_TEST_CHECK_EQ(errLog.GetRingNb(), 1); // main thread ring only
+	}
+	BRG_TEST_CHECK_EQ(errLog.GetDroppedNb(), 0);
+}
+
+// A thread exiting after the destruction of the cErrLog it used
+static void TestThreadOutlivesLog(void)
+{
+	cErrLog *pErrLog = new cErrLog;
+	std::atomic<bool> bTraced(false), bLogDeleted(false);
+	std::thread thread;
+
+	thread = std::thread([pErrLog, &bTraced, &bLogDeleted]() {
+		pErrLog->LogTrace("worker %d", 99); // not 0: would select the va_list overload
+		bTraced.store(true);
+		while( bLogDeleted.load() == false ) {
+			std::this_thread::yield();
+		}
+	});
+	while( bTraced.load() == false ) {
+		std::this_thread::yield();
+	}
+	delete pErrLog;
+	bLogDeleted.store(true);
+	thread.join();
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	TestElevenArgs();
+	TestThreadRingRelease();
+	TestThreadOutlivesLog();
+	remove(TEST_LOG_FILE);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file    test_event_loop.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgEventLoop: the brg_event_loop.h example compiled and run against
+  *          the simulated bridge in CAN loopback, plus delay, timeout and write
+  *          error completions.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "brg_test.h"
+#include "brg_event_loop.h"
+
+/* Private classes -----------------------------------------------------------*/
+// Example of brg_event_loop.h: bootloader start frame then one data frame per answer
+class ModuleSession : public BrgAsyncTask {
+public:
+	ModuleSession(uint8_t ModuleId, int FrameNb): m_answerNb(0), m_lastStatus(BRG_NO_ERR),
+	                                              m_id(ModuleId), m_frameNb(FrameNb), m_sent(0) {}
+	bool Resume(BrgEventLoop &Loop, const Brg_AsyncResultT *pResult) {
+		Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0, CAN_DATA_FRAME, 8 };
+		Brg_CorrMatchT match = { CAN_ID_STANDARD, 0, 1, { m_id } };
+		uint8_t data[8] = { m_id };
+		if( pResult != NULL ) {
+			m_lastStatus = pResult->Status;
+			if( pResult->Status != BRG_NO_ERR ) {
+				return false; // write error or no answer: session aborted
+			}
+			m_answerNb++;
+		}
+		switch( m_state ) {
+		case 0: // bootloader start frame
+			msg.ID = 0x069; match.ID = 0x069;
+			m_state = 1;
+			Loop.NextFrameAsync(this, &match, 100, &msg, data, 8); // write + wait answer
+			return true;
+		case 1: // one data frame per answer
+			if( m_sent == m_frameNb ) {
+				return false; // done
+			}
+			msg.ID = 0x100 + m_id; match.ID = 0x100 + m_id;
+			data[1] = (uint8_t)m_sent++;
+			Loop.NextFrameAsync(this, &match, 100, &msg, data, 8);
+			return true;
+		}
+		return false;
+	}
+	int m_answerNb;
+	Brg_StatusT m_lastStatus;
+private:
+	uint8_t m_id; int m_frameNb; int m_sent;
+};
+
+// Waits DelayUs then ends
+class DelayTask : public BrgAsyncTask {
+public:
+	DelayTask(uint32_t DelayUs): m_delayUs(DelayUs), m_startUs(0), m_elapsedUs(0) {}
+	bool Resume(BrgEventLoop &Loop, const Brg_AsyncResultT *pResult) {
+		if( pResult == NULL ) {
+			m_startUs = BrgGetMonotonicUs();
+			Loop.DelayAsync(this, m_delayUs);
+			return true;
+		}
+		m_elapsedUs = BrgGetMonotonicUs() - m_startUs;
+		return false;
+	}
+	uint32_t m_delayUs;
+	uint64_t m_startUs;
+	uint64_t m_elapsedUs;
+};
+
+/* Private functions ---------------------------------------------------------*/
+// Three sessions interleaved on one thread: every frame answered, Rx polls shared
+static void TestConcurrentSessions(Brg &Bridge)
+{
+	BrgEventLoop loop(Bridge);
+	ModuleSession s1(1, 64), s2(2, 64), s3(3, 64);
+	Brg_EventLoopStatsT stats;
+
+	BrgSimSetCanLoopback(true);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s2), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s3), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Run(5000), BRG_NO_ERR);
+
+	loop.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(s1.m_answerNb, 65); // start frame + 64 data frames
+	BRG_TEST_CHECK_EQ(s2.m_answerNb, 65);
+	BRG_TEST_CHECK_EQ(s3.m_answerNb, 65);
+	BRG_TEST_CHECK_EQ(stats.ActiveTaskNb, 0);
+	BRG_TEST_CHECK_EQ(stats.WriteNb, 3*65);
+	// The three sessions wait at the same time: fewer polls than frames
+	BRG_TEST_CHECK(stats.RxPollNb < stats.WriteNb);
+}
+
+// No answer: the task is resumed with BRG_TARGET_CMD_TIMEOUT
+static void TestNoAnswerTimeout(Brg &Bridge)
+{
+	BrgEventLoop loop(Bridge);
+	ModuleSession s1(1, 4);
+
+	BrgSimSetCanLoopback(false);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Run(2000), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(s1.m_answerNb, 0);
+	BRG_TEST_CHECK_EQ(s1.m_lastStatus, BRG_TARGET_CMD_TIMEOUT);
+	BrgSimSetCanLoopback(true);
+}
+
+// Write failure: the task is resumed with the write error, not a timeout
+static void TestWriteError(Brg &Bridge)
+{
+	BrgEventLoop loop(Bridge);
+	ModuleSession s1(1, 4);
+
+	BrgSimFailCmd(STLINK_BRIDGE_WRITE_MSG_CAN, 3, STLINK_BRIDGE_CAN_ERROR);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Run(2000), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(s1.m_answerNb, 2);
+	BRG_TEST_CHECK(s1.m_lastStatus != BRG_NO_ERR);
+	BRG_TEST_CHECK(s1.m_lastStatus != BRG_TARGET_CMD_TIMEOUT);
+}
+
+// Delays served from the timer heap, next to a running session
+static void TestDelay(Brg &Bridge)
+{
+	BrgEventLoop loop(Bridge);
+	DelayTask d1(20000), d2(5000);
+	ModuleSession s1(1, 16);
+
+	BRG_TEST_CHECK_EQ(loop.Spawn(&d1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&d2), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Spawn(&s1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(loop.Run(2000), BRG_NO_ERR);
+	BRG_TEST_CHECK(d1.m_elapsedUs >= 20000);
+	BRG_TEST_CHECK(d2.m_elapsedUs >= 5000);
+	BRG_TEST_CHECK(d2.m_elapsedUs < d1.m_elapsedUs);
+	BRG_TEST_CHECK_EQ(s1.m_answerNb, 17);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.StartMsgReceptionCAN(), BRG_NO_ERR);
+	TestConcurrentSessions(bridge);
+	TestNoAnswerTimeout(bridge);
+	TestWriteError(bridge);
+	TestDelay(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
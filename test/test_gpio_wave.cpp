@@ -0,0 +1,243 @@
+/**
+  ******************************************************************************
+  * @file    test_gpio_wave.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgGpioWave on the simulated bridge: steps merged into one command,
+  *          steps skipped when the GPIOs are already at the level, commands
+  *          started half their duration ahead of the planned time.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <mutex>
+#include <vector>
+#include "brg_test.h"
+#include "brg_gpio_wave.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_WAVE_MASK   (BRG_GPIO_0 | BRG_GPIO_1 | BRG_GPIO_2) // BRG_GPIO_3 never initialized
+#define TEST_USB_US      400   // SetResetGPIO() duration of the merge and skip tests
+#define TEST_LEAD_USB_US 4000  // SetResetGPIO() duration of the lead time test
+#define TEST_PULSE_US    10000
+#define TEST_LATE_MAX_US 1000  // a quarter of TEST_LEAD_USB_US
+
+/* Private typedef -----------------------------------------------------------*/
+// SET_RESET_GPIO command seen by the simulated bridge
+typedef struct {
+	uint8_t GpioMask;
+	uint8_t GpioSetMask;
+	uint64_t Us;          // command start
+} TestGpioCmdT;
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_cmdMutex;
+static std::vector<TestGpioCmdT> g_cmds;
+
+/* Private functions ---------------------------------------------------------*/
+static void RecordCmd(const STLink_DeviceRequestT *pRequest)
+{
+	TestGpioCmdT cmd;
+
+	if( (pRequest->CDBByte[0] != STLINK_BRIDGE_COMMAND) || (pRequest->CDBByte[1] != STLINK_BRIDGE_SET_RESET_GPIO) ) {
+		return;
+	}
+	cmd.GpioMask = pRequest->CDBByte[2];
+	cmd.GpioSetMask = pRequest->CDBByte[3];
+	cmd.Us = BrgGetMonotonicUs();
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	g_cmds.push_back(cmd);
+}
+
+static std::vector<TestGpioCmdT> TakeCmds(void)
+{
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	std::vector<TestGpioCmdT> cmds;
+
+	cmds.swap(g_cmds);
+	return cmds;
+}
+
+// Steps of other GPIOs less than half a command apart share a command, a GPIO changed
+// twice takes two commands
+static void TestMerge(BrgGpioWave &Wave)
+{
+	const Brg_GpioWaveStepT steps[3] = {
+		{ BRG_GPIO_0, BRG_GPIO_0, 50 },
+		{ BRG_GPIO_1, BRG_GPIO_1, 5000 },
+		{ BRG_GPIO_0, 0, 0 } };
+	const Brg_GpioWaveStepT pulse[2] = {
+		{ BRG_GPIO_2, BRG_GPIO_2, 10 },
+		{ BRG_GPIO_2, 0, 0 } };
+	Brg_GpioWaveStepResultT results[3];
+	Brg_GpioWaveStatsT stats;
+	std::vector<TestGpioCmdT> cmds;
+
+	TakeCmds();
+	BRG_TEST_CHECK_EQ(Wave.Run(steps, 3, results, &stats), BRG_NO_ERR);
+	cmds = TakeCmds();
+	BRG_TEST_CHECK_EQ(stats.StepNb, 3);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 2);
+	BRG_TEST_CHECK_EQ(stats.MergedNb, 1);
+	BRG_TEST_CHECK_EQ(stats.SkippedNb, 0);
+	BRG_TEST_CHECK_EQ(results[0].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(results[1].State, BRG_GPIOWAVE_MERGED);
+	BRG_TEST_CHECK_EQ(results[2].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(results[1].PlannedUs, results[0].PlannedUs + 50);
+	BRG_TEST_CHECK_EQ(results[2].PlannedUs, results[1].PlannedUs + 5000);
+	BRG_TEST_CHECK_EQ(results[1].CmdStartUs, results[0].CmdStartUs);
+	BRG_TEST_CHECK(results[2].CmdStartUs >= results[0].CmdEndUs);
+	BRG_TEST_CHECK_EQ(cmds.size(), 2);
+	if( cmds.size() == 2 ) {
+		BRG_TEST_CHECK_EQ(cmds[0].GpioMask, BRG_GPIO_0 | BRG_GPIO_1);
+		BRG_TEST_CHECK_EQ(cmds[0].GpioSetMask, BRG_GPIO_0 | BRG_GPIO_1);
+		BRG_TEST_CHECK_EQ(cmds[1].GpioMask, BRG_GPIO_0);
+		BRG_TEST_CHECK_EQ(cmds[1].GpioSetMask, 0);
+	}
+	BRG_TEST_CHECK_EQ(BrgSimGetGpio() & TEST_WAVE_MASK, BRG_GPIO_1);
+
+	// 10 us pulse: not merged, so that it is not lost
+	BRG_TEST_CHECK_EQ(Wave.Run(pulse, 2, results, &stats), BRG_NO_ERR);
+	cmds = TakeCmds();
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 2);
+	BRG_TEST_CHECK_EQ(stats.MergedNb, 0);
+	BRG_TEST_CHECK_EQ(results[0].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(results[1].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(cmds.size(), 2);
+	if( cmds.size() == 2 ) {
+		BRG_TEST_CHECK_EQ(cmds[0].GpioSetMask, BRG_GPIO_2);
+		BRG_TEST_CHECK_EQ(cmds[1].GpioSetMask, 0);
+	}
+	BRG_TEST_CHECK_EQ(BrgSimGetGpio() & TEST_WAVE_MASK, BRG_GPIO_1);
+}
+
+// Levels known from the previous runs (GPIO1 high, GPIO0 and GPIO2 low): only the
+// GPIOs changing are written, Init() and a failed command forget the levels
+static void TestSkip(BrgGpioWave &Wave)
+{
+	const Brg_GpioWaveStepT same[2] = {
+		{ BRG_GPIO_1, BRG_GPIO_1, 100 },
+		{ BRG_GPIO_0, 0, 0 } };
+	const Brg_GpioWaveStepT partial[2] = {
+		{ BRG_GPIO_0, BRG_GPIO_0, 100 },
+		{ BRG_GPIO_1, BRG_GPIO_1, 0 } };
+	const Brg_GpioWaveStepT unconfigured[1] = {
+		{ BRG_GPIO_3, BRG_GPIO_3, 0 } };
+	Brg_GpioWaveStepResultT results[2];
+	Brg_GpioWaveStatsT stats;
+	std::vector<TestGpioCmdT> cmds;
+
+	TakeCmds();
+	BRG_TEST_CHECK_EQ(Wave.Run(same, 2, results, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 0);
+	BRG_TEST_CHECK_EQ(stats.SkippedNb, 2);
+	BRG_TEST_CHECK_EQ(results[0].State, BRG_GPIOWAVE_SKIPPED);
+	BRG_TEST_CHECK_EQ(results[1].State, BRG_GPIOWAVE_SKIPPED);
+	BRG_TEST_CHECK_EQ(results[0].LateUs, 0);
+	BRG_TEST_CHECK_EQ(TakeCmds().size(), 0);
+
+	// Merged steps: GPIO0 written alone, GPIO1 step skipped
+	BRG_TEST_CHECK_EQ(Wave.Run(partial, 2, results, &stats), BRG_NO_ERR);
+	cmds = TakeCmds();
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(stats.SkippedNb, 1);
+	BRG_TEST_CHECK_EQ(stats.MergedNb, 0);
+	BRG_TEST_CHECK_EQ(results[0].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(results[1].State, BRG_GPIOWAVE_SKIPPED);
+	BRG_TEST_CHECK_EQ(cmds.size(), 1);
+	if( cmds.size() == 1 ) {
+		BRG_TEST_CHECK_EQ(cmds[0].GpioMask, BRG_GPIO_0);
+		BRG_TEST_CHECK_EQ(cmds[0].GpioSetMask, BRG_GPIO_0);
+	}
+	BRG_TEST_CHECK_EQ(BrgSimGetGpio() & TEST_WAVE_MASK, BRG_GPIO_0 | BRG_GPIO_1);
+
+	// Level forgotten by Init(): written again
+	BRG_TEST_CHECK_EQ(Wave.Init(BRG_GPIO_1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(Wave.Run(&same[0], 1, results, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(results[0].State, BRG_GPIOWAVE_SENT);
+	BRG_TEST_CHECK_EQ(TakeCmds().size(), 1);
+
+	// GPIO error (not initialized): its level stays unknown, written at the next run
+	BRG_TEST_CHECK_EQ(Wave.Run(unconfigured, 1, results, &stats), BRG_GPIO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(Wave.Run(unconfigured, 1, results, &stats), BRG_GPIO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 1);
+	BRG_TEST_CHECK_EQ(TakeCmds().size(), 2);
+
+	BRG_TEST_CHECK_EQ(Wave.Run(NULL, 1, results, &stats), BRG_PARAM_ERR);
+	BRG_TEST_CHECK_EQ(Wave.Run(unconfigured, 0, results, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, 0);
+}
+
+// Commands started half their measured duration ahead: the GPIOs change around the
+// planned times and the pulse width is kept
+static void TestLeadTime(BrgGpioWave &Wave)
+{
+	const Brg_GpioWaveStepT pulse[2] = {
+		{ BRG_GPIO_2, BRG_GPIO_2, TEST_PULSE_US },
+		{ BRG_GPIO_2, 0, 0 } };
+	Brg_GpioWaveStepResultT results[2];
+	Brg_GpioWaveStatsT stats;
+	std::vector<TestGpioCmdT> cmds;
+
+	// Duration estimate smoothed over 8 commands: converged after 40
+	BrgSimSetLatency(TEST_LEAD_USB_US, 0);
+	for( int i = 0; i < 20; i++ ) {
+		BRG_TEST_CHECK_EQ(Wave.Run(pulse, 2, NULL, NULL), BRG_NO_ERR);
+	}
+	// A preemption of the test host delays a command and lengthens the estimate: best of 5
+	for( int run = 0; run < 5; run++ ) {
+		TakeCmds();
+		BRG_TEST_CHECK_EQ(Wave.Run(pulse, 2, results, &stats), BRG_NO_ERR);
+		if( stats.MaxLateUs < TEST_LATE_MAX_US ) {
+			break;
+		}
+	}
+	cmds = TakeCmds();
+	BrgSimSetLatency(TEST_USB_US, 0);
+
+	printf("Lead time: command %u us, steps late %d us and %d us\n", stats.CmdUs, results[0].LateUs,
+	       results[1].LateUs);
+	BRG_TEST_CHECK(stats.CmdUs >= TEST_LEAD_USB_US);
+	BRG_TEST_CHECK(stats.CmdUs < 2 * TEST_LEAD_USB_US);
+	BRG_TEST_CHECK(results[0].PlannedUs >= TEST_LEAD_USB_US / 2);
+	BRG_TEST_CHECK_EQ(results[1].PlannedUs, results[0].PlannedUs + TEST_PULSE_US);
+	// Started about half a command before the planned time, instead of a command late
+	BRG_TEST_CHECK(results[1].CmdStartUs + TEST_LEAD_USB_US / 4 <= results[1].PlannedUs);
+	BRG_TEST_CHECK(results[0].LateUs < TEST_LATE_MAX_US);
+	BRG_TEST_CHECK(results[0].LateUs > -TEST_LATE_MAX_US);
+	BRG_TEST_CHECK(results[1].LateUs < TEST_LATE_MAX_US);
+	BRG_TEST_CHECK(results[1].LateUs > -TEST_LATE_MAX_US);
+	BRG_TEST_CHECK_EQ(stats.TotalUs, results[1].CmdEndUs);
+	BRG_TEST_CHECK_EQ(cmds.size(), 2);
+	if( cmds.size() == 2 ) {
+		BRG_TEST_CHECK(cmds[1].Us - cmds[0].Us + 2 * TEST_LATE_MAX_US >= TEST_PULSE_US);
+		BRG_TEST_CHECK(cmds[1].Us - cmds[0].Us <= TEST_PULSE_US + 2 * TEST_LATE_MAX_US);
+	}
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	BrgGpioWave wave(bridge);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(wave.Init(TEST_WAVE_MASK), BRG_NO_ERR);
+	BrgSimSetHook(RecordCmd);
+	BrgSimSetLatency(TEST_USB_US, 0);
+	TestMerge(wave);
+	TestSkip(wave);
+	TestLeadTime(wave);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    test_hw_time.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgHwTimeMap: wraps, older FIFO messages before and after the tick
+  *          period is known, wraps lost between two reads.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "brg_test.h"
+#include "brg_hw_time.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_START_US  1000000
+
+/* Private functions ---------------------------------------------------------*/
+// Older message of the other FIFO before the period is known: no wrap counted
+static void TestOlderMessageBeforePeriod(void)
+{
+	BrgHwTimeMap timeMap;
+	Brg_HwTimeStateT state;
+
+	timeMap.Map(1000, TEST_START_US);
+	timeMap.Map(1500, TEST_START_US + 1000);
+	timeMap.Map(1200, TEST_START_US + 1000); // FIFO1, received before the previous one
+	timeMap.GetState(&state);
+	BRG_TEST_CHECK_EQ(state.bTickKnown, false);
+	BRG_TEST_CHECK_EQ(state.WrapNb, 0);
+	BRG_TEST_CHECK_EQ(state.TickNb, 500);
+	// Following messages continue from the latest one
+	timeMap.Map(2000, TEST_START_US + 2000);
+	timeMap.GetState(&state);
+	BRG_TEST_CHECK_EQ(state.TickNb, 1000);
+}
+
+// 1 us tick: the counter wraps every 65.536 ms, the wraps are counted before and after
+// the period is known, the estimated period stays at 1 us
+static void TestWrapsAndPeriod(void)
+{
+	BrgHwTimeMap timeMap;
+	Brg_HwTimeStateT state;
+	uint64_t readUs, hostUs = 0;
+
+	for( uint64_t us = 0; us <= 400000; us += 5000 ) {
+		readUs = TEST_START_US + us + 50; // read 50 us after the reception
+		hostUs = timeMap.Map((uint16_t)us, readUs);
+		// FIFO1 message 300 ticks older in the same read
+		if( us >= 1000 ) {
+			timeMap.Map((uint16_t)(us - 300), readUs);
+		}
+	}
+	timeMap.GetState(&state);
+	BRG_TEST_CHECK_EQ(state.bTickKnown, true);
+	BRG_TEST_CHECK_EQ(state.WrapNb, 400000 / 65536);
+	BRG_TEST_CHECK_EQ(state.TickNb, 400000);
+	BRG_TEST_CHECK(state.TickUs > 0.999);
+	BRG_TEST_CHECK(state.TickUs < 1.001);
+	BRG_TEST_CHECK(hostUs <= TEST_START_US + 400000 + 50);
+	BRG_TEST_CHECK(hostUs + 500 >= TEST_START_US + 400000);
+}
+
+// No read during 3 counter periods: the wraps are recovered from the host time
+static void TestLostWraps(void)
+{
+	BrgHwTimeMap timeMap;
+	Brg_HwTimeStateT state;
+	uint64_t us;
+
+	for( us = 0; us <= 200000; us += 10000 ) {
+		timeMap.Map((uint16_t)us, TEST_START_US + us);
+	}
+	us = 200000 + 3*65536 + 1000;
+	timeMap.Map((uint16_t)us, TEST_START_US + us);
+	timeMap.GetState(&state);
+	BRG_TEST_CHECK_EQ(state.LostWrapNb, 3);
+	BRG_TEST_CHECK_EQ(state.TickNb, us);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	TestOlderMessageBeforePeriod();
+	TestWrapsAndPeriod();
+	TestLostWraps();
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
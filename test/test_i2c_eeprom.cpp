@@ -0,0 +1,249 @@
+/**
+  ******************************************************************************
+  * @file    test_i2c_eeprom.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgI2cEeprom on a simulated 24Cxx EEPROM (400 kHz bus): page boundary
+  *          split, acknowledge polling of the write cycle, write throughput and
+  *          statistics of failed writes.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "brg_test.h"
+#include "brg_i2c_eeprom.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_DEV_ADDR      0x50
+#define TEST_USB_US        125   // round trip of one USB command
+#define TEST_I2C_RATE      44    // 400 kHz bus, 9 bits per byte: bytes per ms
+#define TEST_WRITE_CYCLE_US 5000
+
+/* Private typedef -----------------------------------------------------------*/
+// Page write transaction accepted by the EEPROM
+typedef struct {
+	uint32_t Addr;
+	uint32_t Size;
+} TestPageWriteT;
+
+/* Private classes -----------------------------------------------------------*/
+// 24Cxx EEPROM: page writes wrapping inside the page, address not acknowledged during
+// the write cycle (started at the stop condition), sequential reads from the current address.
+// Called at the end of the transaction (bus time elapsed, TEST_I2C_RATE when BusRate).
+class SimI2cEeprom : public BrgSimI2cDevice
+{
+public:
+	SimI2cEeprom(const Brg_I2cEepromConfT &Conf, uint32_t WriteCycleUs, bool bBusRate):
+		m_mem(Conf.SizeInBytes, 0xFF), m_nackNb(0), m_conf(Conf), m_writeCycleUs(WriteCycleUs),
+		m_bBusRate(bBusRate), m_addr(0) {}
+	bool Write(uint16_t Addr, const uint8_t *pData, uint32_t Size) {
+		uint32_t page;
+
+		if( Acknowledge(Addr, Size) == false ) {
+			return false;
+		}
+		m_addr = Block(Addr);
+		for( uint32_t i = 0; (i < m_conf.AddrBytes) && (i < Size); i++ ) {
+			m_addr |= (uint32_t)pData[i] << (8 * (m_conf.AddrBytes - 1 - i));
+		}
+		if( Size <= m_conf.AddrBytes ) {
+			return true; // address set only (read or acknowledge polling)
+		}
+		page = m_addr - (m_addr % m_conf.PageSize);
+		for( uint32_t i = 0; i < Size - m_conf.AddrBytes; i++ ) {
+			m_mem[page + ((m_addr - page + i) % m_conf.PageSize)] = pData[m_conf.AddrBytes + i];
+		}
+		m_pages.push_back(TestPageWriteT{ m_addr, Size - m_conf.AddrBytes });
+		m_busyEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(m_writeCycleUs);
+		return true;
+	}
+	bool Read(uint16_t Addr, uint8_t *pData, uint32_t Size) {
+		if( Acknowledge(Addr, Size) == false ) {
+			return false;
+		}
+		for( uint32_t i = 0; i < Size; i++ ) {
+			pData[i] = m_mem[m_addr];
+			m_addr = (m_addr + 1) % m_conf.SizeInBytes;
+		}
+		return true;
+	}
+	std::vector<TestPageWriteT> m_pages;
+	std::vector<uint8_t> m_mem;
+	uint32_t m_nackNb;  // transactions refused during a write cycle
+
+private:
+	// Device address (TEST_DEV_ADDR and, with 1 address byte, the block select bits) sent
+	// at the start of a transaction of Size data bytes
+	bool Acknowledge(uint16_t Addr, uint32_t Size) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if( (Addr & ~0x7) != TEST_DEV_ADDR ) {
+			return false;
+		}
+		if( m_bBusRate == true ) {
+			start -= std::chrono::microseconds((Size + 1) * 1000 / TEST_I2C_RATE);
+		}
+		if( start < m_busyEnd ) {
+			m_nackNb++;
+			return false;
+		}
+		return true;
+	}
+	uint32_t Block(uint16_t Addr) const {
+		return (uint32_t)(Addr & 0x7) << (8 * m_conf.AddrBytes);
+	}
+
+	Brg_I2cEepromConfT m_conf;
+	uint32_t m_writeCycleUs;
+	bool m_bBusRate;
+	uint32_t m_addr;
+	std::chrono::steady_clock::time_point m_busyEnd;
+};
+
+/* Private functions ---------------------------------------------------------*/
+static void FillData(std::vector<uint8_t> &Data, uint8_t Seed)
+{
+	for( size_t i = 0; i < Data.size(); i++ ) {
+		Data[i] = (uint8_t)(i * 31 + Seed);
+	}
+}
+
+// Unaligned write on a 24C32 (32-byte pages): split on page boundaries, never wrapped
+static void TestPageSplit(Brg &Bridge)
+{
+	Brg_I2cEepromConfT conf = { TEST_DEV_ADDR, 4096, 32, 2 };
+	SimI2cEeprom eeprom(conf, 0, false);
+	BrgI2cEeprom i2cEeprom(Bridge, conf);
+	std::vector<uint8_t> data(100), readBack(100);
+	Brg_I2cEepromStatsT stats;
+	const TestPageWriteT expected[] = { { 20, 12 }, { 32, 32 }, { 64, 32 }, { 96, 24 } };
+
+	FillData(data, 1);
+	BrgSimSetI2cDevice(&eeprom);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Write(20, data.data(), (uint32_t)data.size()), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(eeprom.m_pages.size(), 4);
+	for( size_t i = 0; (i < 4) && (i < eeprom.m_pages.size()); i++ ) {
+		BRG_TEST_CHECK_EQ(eeprom.m_pages[i].Addr, expected[i].Addr);
+		BRG_TEST_CHECK_EQ(eeprom.m_pages[i].Size, expected[i].Size);
+	}
+	BRG_TEST_CHECK(memcmp(&eeprom.m_mem[20], data.data(), data.size()) == 0);
+	BRG_TEST_CHECK_EQ(eeprom.m_mem[19], 0xFF);
+	BRG_TEST_CHECK_EQ(eeprom.m_mem[120], 0xFF);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Read(20, readBack.data(), (uint32_t)readBack.size()), BRG_NO_ERR);
+	BRG_TEST_CHECK(readBack == data);
+	i2cEeprom.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.PageWriteNb, 4);
+	BRG_TEST_CHECK_EQ(stats.WriteBytes, data.size());
+	BrgSimSetI2cDevice(NULL);
+}
+
+// 24C16 (1 address byte): the block select bits go to the device address
+static void TestBlockSelect(Brg &Bridge)
+{
+	Brg_I2cEepromConfT conf = { TEST_DEV_ADDR, 2048, 16, 1 };
+	SimI2cEeprom eeprom(conf, 0, false);
+	BrgI2cEeprom i2cEeprom(Bridge, conf);
+	std::vector<uint8_t> data(40), readBack(40);
+
+	FillData(data, 2);
+	BrgSimSetI2cDevice(&eeprom);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Write(0x2F0, data.data(), (uint32_t)data.size()), BRG_NO_ERR); // blocks 2 and 3
+	BRG_TEST_CHECK(memcmp(&eeprom.m_mem[0x2F0], data.data(), data.size()) == 0);
+	BRG_TEST_CHECK_EQ(eeprom.m_pages.size(), 3);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Read(0x2F0, readBack.data(), (uint32_t)readBack.size()), BRG_NO_ERR);
+	BRG_TEST_CHECK(readBack == data);
+	BrgSimSetI2cDevice(NULL);
+}
+
+// Write cycle on a 400 kHz bus: acknowledge polling until the EEPROM answers, cycle time
+// learned, few refused attempts once learned, throughput close to the page write limit
+static void TestWriteCycle(Brg &Bridge)
+{
+	Brg_I2cEepromConfT conf = { TEST_DEV_ADDR, 4096, 32, 2 };
+	SimI2cEeprom eeprom(conf, TEST_WRITE_CYCLE_US, true);
+	BrgI2cEeprom i2cEeprom(Bridge, conf);
+	std::vector<uint8_t> data(1024);
+	Brg_I2cEepromStatsT stats;
+	uint32_t pageNb = 1024 / 32;
+	double busUs, limitBytesPerSec;
+
+	FillData(data, 3);
+	BrgSimSetI2cDevice(&eeprom);
+	BrgSimSetLatency(TEST_USB_US, 0);
+	BrgSimSetI2cRate(TEST_I2C_RATE);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Write(0, data.data(), (uint32_t)data.size(), false), BRG_NO_ERR);
+	BrgSimSetLatency(0, 0);
+	BrgSimSetI2cRate(0);
+	BRG_TEST_CHECK(memcmp(eeprom.m_mem.data(), data.data(), data.size()) == 0);
+
+	i2cEeprom.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.PageWriteNb, pageNb);
+	BRG_TEST_CHECK_EQ(stats.NackNb, eeprom.m_nackNb); // every refused attempt retried
+	BRG_TEST_CHECK(stats.NackNb > 0);                 // the first cycle is polled
+	BRG_TEST_CHECK(stats.NackNb < 2 * pageNb);        // then mostly waited for
+	BRG_TEST_CHECK(stats.WriteCycleUs > TEST_WRITE_CYCLE_US / 2);
+	BRG_TEST_CHECK(stats.WriteCycleUs < 2 * TEST_WRITE_CYCLE_US);
+	BRG_TEST_CHECK(stats.WriteTimeUs >= (uint64_t)(pageNb - 1) * TEST_WRITE_CYCLE_US);
+	// Limit: each page transaction (device address, 2 address bytes, 32 data bytes) on the
+	// bus, and the write cycle between two pages
+	busUs = (1 + 2 + 32) * 1000.0 / TEST_I2C_RATE;
+	limitBytesPerSec = data.size() * 1000000.0 / ((pageNb - 1) * TEST_WRITE_CYCLE_US + pageNb * busUs);
+	printf("EEPROM write: %llu bytes/s (limit %.0f), %u pages, %u refused, write cycle %u us\n",
+	       (unsigned long long)stats.BytesPerSec, limitBytesPerSec, (unsigned)stats.PageWriteNb,
+	       (unsigned)stats.NackNb, (unsigned)stats.WriteCycleUs);
+	BRG_TEST_CHECK(stats.BytesPerSec > 0.7 * limitBytesPerSec);
+	BRG_TEST_CHECK(stats.BytesPerSec <= limitBytesPerSec);
+	BrgSimSetI2cDevice(NULL);
+}
+
+// Failed writes are not counted in WriteBytes/WriteTimeUs
+static void TestFailedWrite(Brg &Bridge)
+{
+	Brg_I2cEepromConfT conf = { TEST_DEV_ADDR, 4096, 32, 2 };
+	Brg_I2cEepromConfT absentConf = { TEST_DEV_ADDR + 8, 4096, 32, 2 };
+	SimI2cEeprom eeprom(conf, 100000, false); // write cycle longer than BRG_I2CEEPROM_WRITE_TIMEOUT_MS
+	BrgI2cEeprom i2cEeprom(Bridge, conf), absent(Bridge, absentConf);
+	std::vector<uint8_t> data(64);
+	Brg_I2cEepromStatsT stats;
+
+	FillData(data, 4);
+	BrgSimSetI2cDevice(&eeprom);
+	BRG_TEST_CHECK_EQ(absent.Write(0, data.data(), (uint32_t)data.size()), BRG_I2C_ERR);
+	absent.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.WriteBytes, 0);
+	BRG_TEST_CHECK_EQ(stats.WriteTimeUs, 0);
+	BRG_TEST_CHECK_EQ(stats.BytesPerSec, 0);
+
+	BRG_TEST_CHECK_EQ(i2cEeprom.Write(0, data.data(), 32, false), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(i2cEeprom.Write(32, data.data(), 32, false), BRG_TARGET_CMD_TIMEOUT);
+	i2cEeprom.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.WriteBytes, 32);
+	BRG_TEST_CHECK_EQ(stats.PageWriteNb, 1);
+	BRG_TEST_CHECK(stats.NackNb > 0);
+	BrgSimSetI2cDevice(NULL);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestPageSplit(bridge);
+	TestBlockSelect(bridge);
+	TestWriteCycle(bridge);
+	TestFailedWrite(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
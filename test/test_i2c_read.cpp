@@ -0,0 +1,192 @@
+/**
+  ******************************************************************************
+  * @file    test_i2c_read.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Bulk I2C read benchmark on the simulated bridge (400 kHz bus): one
+  *          Brg::ReadI2C() transaction, a loop of 512-byte Brg::ReadI2C(), and
+  *          the declined segmented read (Brg::ReadNoWaitI2C() segments polled
+  *          with Brg::GetLastReadWriteStatus()).
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "brg_test.h"
+#include "brg_latency.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_DEV_ADDR      0x50
+#define TEST_SIZE          8192
+#define TEST_USB_US        125   // round trip of one USB command
+#define TEST_I2C_RATE      44    // 400 kHz bus, 9 bits per byte: bytes per ms
+#define TEST_SEGMENT_SIZE  I2C_NO_WAIT_MAX_SIZE
+
+/* Private classes -----------------------------------------------------------*/
+// Memory read sequentially from a current address (2-byte address write sets it)
+class SimI2cMemory : public BrgSimI2cDevice
+{
+public:
+	SimI2cMemory(void): m_addr(0) {}
+	bool Write(uint16_t Addr, const uint8_t *pData, uint32_t Size) {
+		if( Addr != TEST_DEV_ADDR ) {
+			return false;
+		}
+		if( Size >= 2 ) {
+			m_addr = ((uint16_t)pData[0] << 8) | pData[1];
+		}
+		return true;
+	}
+	bool Read(uint16_t Addr, uint8_t *pData, uint32_t Size) {
+		if( Addr != TEST_DEV_ADDR ) {
+			return false;
+		}
+		for( uint32_t i = 0; i < Size; i++ ) {
+			pData[i] = Byte(m_addr++);
+		}
+		return true;
+	}
+	static uint8_t Byte(uint16_t Addr) { return (uint8_t)((Addr * 13) ^ (Addr >> 8)); }
+
+private:
+	uint16_t m_addr;
+};
+
+/* Private functions ---------------------------------------------------------*/
+// Bridge commands of any I2C read method
+static uint64_t GetI2cCmdNb(void)
+{
+	return BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_I2C) + BrgSimGetCmdNb(STLINK_BRIDGE_READ_I2C) +
+	       BrgSimGetCmdNb(STLINK_BRIDGE_READ_NO_WAIT_I2C) + BrgSimGetCmdNb(STLINK_BRIDGE_GET_READ_DATA_I2C) +
+	       BrgSimGetCmdNb(STLINK_BRIDGE_GET_RWCMD_STATUS);
+}
+
+/*
+ * Declined segmented read: successive ReadNoWaitI2C() transactions of I2C_NO_WAIT_MAX_SIZE
+ * bytes. The first status poll is delayed to the end of the segment expected from the
+ * segment time already measured; only the status command is allowed while BUSY and the
+ * bridge keeps one segment, so the next one starts after GetReadDataI2C().
+ */
+static Brg_StatusT ReadSegmented(Brg &Bridge, uint8_t *pBuffer, uint32_t SizeInBytes)
+{
+	Brg_StatusT brgStat = BRG_NO_ERR;
+	uint32_t doneSize = 0;
+	uint16_t size, sizeRead;
+	uint64_t startUs, pollUs, elapsedUs, expectedUs;
+	double byteUs = 0;     // measured segment time per byte (0: not yet known)
+	uint64_t statusUs = 0; // measured status round trip
+
+	while( (brgStat == BRG_NO_ERR) && (doneSize < SizeInBytes) ) {
+		size = (SizeInBytes - doneSize > TEST_SEGMENT_SIZE) ? TEST_SEGMENT_SIZE : (uint16_t)(SizeInBytes - doneSize);
+		startUs = BrgGetMonotonicUs();
+		brgStat = Bridge.ReadNoWaitI2C(TEST_DEV_ADDR, size, &sizeRead, 0);
+		if( (brgStat == BRG_CMD_BUSY) && (byteUs != 0) ) {
+			expectedUs = (uint64_t)(byteUs * size);
+			expectedUs = (expectedUs > statusUs / 2) ? (expectedUs - statusUs / 2) : 0;
+			elapsedUs = BrgGetMonotonicUs() - startUs;
+			if( expectedUs > elapsedUs ) {
+				std::this_thread::sleep_for(std::chrono::microseconds(expectedUs - elapsedUs));
+			}
+		}
+		while( brgStat == BRG_CMD_BUSY ) {
+			pollUs = BrgGetMonotonicUs();
+			brgStat = Bridge.GetLastReadWriteStatus(&sizeRead, NULL);
+			statusUs = BrgGetMonotonicUs() - pollUs;
+		}
+		if( brgStat == BRG_NO_ERR ) {
+			elapsedUs = BrgGetMonotonicUs() - startUs;
+			if( (size == TEST_SEGMENT_SIZE) && ((byteUs == 0) || ((double)elapsedUs / size < byteUs)) ) {
+				byteUs = (double)elapsedUs / size;
+			}
+			brgStat = Bridge.GetReadDataI2C(&pBuffer[doneSize], size);
+		}
+		if( brgStat == BRG_NO_ERR ) {
+			doneSize += size;
+		}
+	}
+	return brgStat;
+}
+
+// One method: memory address 0 set, TEST_SIZE bytes read, KB/s and commands returned
+template<typename ReadT>
+static double MeasureRead(Brg &Bridge, ReadT Read, uint64_t *pCmdNb)
+{
+	std::vector<uint8_t> buffer(TEST_SIZE, 0);
+	uint8_t addr[2] = { 0, 0 };
+	std::chrono::steady_clock::time_point start;
+	double us;
+	bool bDataOk = true;
+
+	BRG_TEST_CHECK_EQ(Bridge.WriteI2C(addr, TEST_DEV_ADDR, 2, NULL), BRG_NO_ERR);
+	*pCmdNb = GetI2cCmdNb();
+	start = std::chrono::steady_clock::now();
+	BRG_TEST_CHECK_EQ(Read(buffer.data()), BRG_NO_ERR);
+	us = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	*pCmdNb = GetI2cCmdNb() - *pCmdNb;
+	for( uint32_t i = 0; i < TEST_SIZE; i++ ) {
+		bDataOk = bDataOk && (buffer[i] == SimI2cMemory::Byte((uint16_t)i));
+	}
+	BRG_TEST_CHECK(bDataOk);
+	return (double)TEST_SIZE * 1000 / us;
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	SimI2cMemory memory;
+	uint64_t singleCmdNb, loopCmdNb, segmentedCmdNb;
+	double single, loop, segmented;
+	uint16_t sizeRead = 0;
+	uint8_t data = 0;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BrgSimSetI2cDevice(&memory);
+	BrgSimSetLatency(TEST_USB_US, 0);
+	BrgSimSetI2cRate(TEST_I2C_RATE);
+
+	single = MeasureRead(bridge, [&](uint8_t *pBuffer) {
+		return bridge.ReadI2C(pBuffer, TEST_DEV_ADDR, TEST_SIZE, NULL);
+	}, &singleCmdNb);
+	loop = MeasureRead(bridge, [&](uint8_t *pBuffer) {
+		Brg_StatusT brgStat = BRG_NO_ERR;
+		for( uint32_t i = 0; (brgStat == BRG_NO_ERR) && (i < TEST_SIZE); i += TEST_SEGMENT_SIZE ) {
+			brgStat = bridge.ReadI2C(&pBuffer[i], TEST_DEV_ADDR, TEST_SEGMENT_SIZE, NULL);
+		}
+		return brgStat;
+	}, &loopCmdNb);
+	segmented = MeasureRead(bridge, [&](uint8_t *pBuffer) {
+		return ReadSegmented(bridge, pBuffer, TEST_SIZE);
+	}, &segmentedCmdNb);
+
+	printf("I2C read of %d bytes at 400 kHz, KB/s (bridge commands): ReadI2C %.1f (%llu), "
+	       "ReadI2C %d loop %.1f (%llu), segmented ReadNoWaitI2C %.1f (%llu)\n", TEST_SIZE,
+	       single, (unsigned long long)singleCmdNb, TEST_SEGMENT_SIZE, loop, (unsigned long long)loopCmdNb,
+	       segmented, (unsigned long long)segmentedCmdNb);
+	// The bus is the bottleneck: segmenting adds commands and gains nothing
+	BRG_TEST_CHECK_EQ(singleCmdNb, 2);
+	BRG_TEST_CHECK_EQ(loopCmdNb, 2 * (TEST_SIZE / TEST_SEGMENT_SIZE));
+	BRG_TEST_CHECK(segmentedCmdNb >= 3 * (TEST_SIZE / TEST_SEGMENT_SIZE));
+	BRG_TEST_CHECK(single >= 0.95 * segmented);
+	BRG_TEST_CHECK(single >= 0.95 * loop);
+
+	// Not acknowledged address: I2C error, nothing read
+	BrgSimSetLatency(0, 0);
+	BrgSimSetI2cRate(0);
+	BRG_TEST_CHECK_EQ(bridge.ReadI2C(&data, TEST_DEV_ADDR + 1, 1, &sizeRead), BRG_I2C_ERR);
+	BRG_TEST_CHECK_EQ(sizeRead, 0);
+	BrgSimSetI2cDevice(NULL);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,505 @@
+/**
+  ******************************************************************************
+  * @file    test_i2c_timing.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Brg::GetI2cTiming(): same TimingReg as the original exhaustive search
+  *          on 7488 combinations, cache follows the I2C input clock, timings and
+  *          per-call cost.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include "brg_test.h"
+
+/* Private typedef -----------------------------------------------------------*/
+// I2C structure for timing calculation
+typedef struct {
+    int prescaler;
+    int SDLDEL;
+    int SCLDEL;
+    double resultat;
+} Brg_I2cModelT;
+
+/* Private defines -----------------------------------------------------------*/
+// Original I2C timing search, kept as the reference (library before the rework)
+// I2C define for timing calculation
+#define SCLL_LENGTH    256
+#define SCLH_LENGTH    256
+#define SCLDEL_LENGTH  16
+#define SCLDEL_LENGTH  16
+#define PRESC_LENGTH   16
+#define MODE_NUMBER    3
+#define TEST_USB_US    125   // round trip of one USB command (per-call cost)
+#define TEST_CALL_NB   100
+
+/* Private variables ---------------------------------------------------------*/
+// I2C constants for timing calculation
+const double TFALL_MAX_T0 = (double)(300 / pow((double)10, 9));
+const double TFALL_MAX_T1 = (double)(300 / pow((double)10, 9));
+const double TFALL_MAX_T2 = (double)(120 / pow((double)10, 9));
+
+const double TRISE_MAX_T0 = (double)(1000 / pow((double)10, 9));
+const double TRISE_MAX_T1 = (double)(300 / pow((double)10, 9));
+const double TRISE_MAX_T2 = (double)(120 / pow((double)10, 9));
+
+const double THDDAT_MAX_T0 = (double)(3450 / pow((double)10, 9));
+const double THDDAT_MAX_T1 = (double)(900 / pow((double)10, 9));
+const double THDDAT_MAX_T2 = (double)(450 / pow((double)10, 9));
+
+const double TSUDAT_MIN_T0 = (double)(250 / pow((double)10, 9));
+const double TSUDAT_MIN_T1 = (double)(100 / pow((double)10, 9));
+const double TSUDAT_MIN_T2 = (double)(50 / pow((double)10, 9));
+
+const double TLOW_MIN0 = (double)(4.7 / pow((double)10, 6));
+const double TLOW_MIN1 = (double)(1.3 / pow((double)10, 6));
+const double TLOW_MIN2 = (double)(0.5 / pow((double)10, 6));
+
+const double THIGH_MIN0 = (double)(4 / pow((double)10, 6));
+const double THIGH_MIN1 = (double)(0.6 / pow((double)10, 6));
+const double THIGH_MIN2 = (double)(0.26 / pow((double)10, 6));
+
+/* Private functions ---------------------------------------------------------*/
+static Brg_StatusT RefCalculateI2cTimingReg(I2cModeT I2CSpeedMode, int SpeedFrequency, double ClockSource, int DNFn,
+                                        int RiseTime, int FallTime, bool bAF, uint32_t *pTimingReg)
+{
+#define MAX_I2C_MODEL_NB 40
+	Brg_StatusT brgStatus=BRG_NO_ERR;
+
+	if( (SpeedFrequency == 0) || (ClockSource == 0) || (pTimingReg == NULL) ) {
+		return BRG_PARAM_ERR;
+	}
+
+    // SCLL & SCLH  settings
+    int *pSCLL = new int[SCLL_LENGTH];
+    int *pSCLH = new int[SCLH_LENGTH];
+
+    //SCLDEL & SDLDEL settings
+    int *pSCLDEL = new int[SCLDEL_LENGTH];
+    int *pSDADEL = new int[SCLDEL_LENGTH];
+    // PRESC settings
+    int *pPRESC = new int[PRESC_LENGTH];
+    int *pPRESCvalid = new int[16];
+
+    // Variables for solution  (SCLDEL , SDLDEL  and PRESC)
+    Brg_I2cModelT *pPrescSDLDELSCLDELpossComb = new Brg_I2cModelT[MAX_I2C_MODEL_NB]; // possible combination table
+    int prescSDLDELSCLDELpossCombSize = 0;
+    int tabIndex = 0;
+
+    // Variables for Boundaries
+    double *pTFallMax = new double[MODE_NUMBER];
+    double *pTRiseMax = new double[MODE_NUMBER];
+    double *pTHdDatMax = new double[MODE_NUMBER];
+    double *pTSuDatMin = new double[MODE_NUMBER];
+    double *pTLowMin = new double[MODE_NUMBER];
+    double *pTHighMin = new double[MODE_NUMBER];
+
+    double targetFreqI2C;   // Target frequency
+    double tmpSCLDEL;       // Calculate SCLDEL Time from  SCLDEL Bit
+    double tmpSDADEL;       // Calculate SDLDEL Time from  SDLDEL Bit
+    double clkMax;
+    double clkMin;
+    int idx=0;              // Get I2c mode speed
+    double clkI2C;          // Clock frequency
+    double clkPeriodI2C;    // Period of clock
+
+    double delayAF;
+    double delayDNF;
+    double delayFilter;
+    double riseTimeCalc;   // Rise time
+    double fallTimeCalc;   // Fall time
+    double tmpMinSDADEL;   // SDADEL range
+    double tmpMaxSDADEL;   // SDADEL range
+    double tmpMinSCLDEL;   // SCLDEL range
+    int nbValid;           // Number of valid solution
+    int tmpPRESC;          // Current prescaler
+
+	// Timing handling
+	int i;
+	for (i = 0; i < SCLL_LENGTH; i++) {
+		pSCLL[i] = i;//current SCLL value
+		pSCLH[i] = i;//cuirrent SCLH value
+	}
+	for (i = 0; i < SCLDEL_LENGTH; i++) {
+		pPRESC[i] = i;//current Presc value
+		pSCLDEL[i] = i;
+		pSDADEL[i] = i;
+		pPRESCvalid[i] = 99;
+	}
+	pTFallMax[0] = TFALL_MAX_T0;
+	pTFallMax[1] = TFALL_MAX_T1;
+	pTFallMax[2] = TFALL_MAX_T2;
+
+	pTRiseMax[0] = TRISE_MAX_T0;
+	pTRiseMax[1] = TRISE_MAX_T1;
+	pTRiseMax[2] = TRISE_MAX_T2;
+
+	pTHdDatMax[0] = THDDAT_MAX_T0;
+	pTHdDatMax[1] = THDDAT_MAX_T1;
+	pTHdDatMax[2] = THDDAT_MAX_T2;
+
+	pTSuDatMin[0] = TSUDAT_MIN_T0;
+	pTSuDatMin[1] = TSUDAT_MIN_T1;
+	pTSuDatMin[2] = TSUDAT_MIN_T2;
+
+	pTLowMin[0] = TLOW_MIN0;
+	pTLowMin[1] = TLOW_MIN1;
+	pTLowMin[2] = TLOW_MIN2;
+
+	pTHighMin[0] = THIGH_MIN0;
+	pTHighMin[1] = THIGH_MIN1;
+	pTHighMin[2] = THIGH_MIN2;
+
+	targetFreqI2C = SpeedFrequency * 1000;   // Speed frequency
+
+	clkMax = targetFreqI2C + targetFreqI2C * 0.2;
+	clkMin = targetFreqI2C - targetFreqI2C * 0.2;
+
+	clkI2C = ClockSource;
+	clkPeriodI2C = (double)(1 / (double)(clkI2C * 1000));  // Clock period
+
+	if( I2CSpeedMode == I2C_STANDARD ) {
+		idx = 0;
+	}
+	if( I2CSpeedMode == I2C_FAST ) {
+		idx = 1;
+	}
+	if( I2CSpeedMode == I2C_FAST_PLUS ) {
+		idx = 2;
+	}
+	if( bAF == true ) {
+		delayAF = (50 / (double)pow((double)10, 9)) * 1;
+	} else {
+		delayAF = 0; // (50 / (double)pow((double)10, 9)) * 0;
+	}
+
+	delayDNF = (DNFn * clkPeriodI2C);
+	delayFilter = delayAF + delayDNF;
+
+	riseTimeCalc = (double)(RiseTime / (double)pow((double)10, 9));
+	fallTimeCalc = (double)(FallTime / (double)pow((double)10, 9));
+
+	tmpMinSDADEL = (double)((double)fallTimeCalc - (50 / (double)pow((double)10, 9))
+	                - (double)((DNFn + 3) * clkPeriodI2C));
+	tmpMaxSDADEL = (double)((double)pTHdDatMax[idx] - riseTimeCalc - (1 * (260 / (double)pow((double)10, 9)))
+		            - (double)((DNFn + 4) * clkPeriodI2C));
+	if( tmpMaxSDADEL < 0 ) {
+		tmpMaxSDADEL = 0;
+	}
+	if( tmpMinSDADEL < 0 ) {
+		tmpMinSDADEL = 0;
+	}
+
+	tmpMinSCLDEL = (double)((double)riseTimeCalc + pTSuDatMin[idx]);
+	if( tmpMinSCLDEL < 0 ) {
+		tmpMinSCLDEL = 0;
+	}
+
+	nbValid = 0;
+
+	tmpPRESC = 99;
+	// End of timing handling
+
+	// SDLDEL and SCLDEL calculation
+	for( int i1 = 0; i1 < PRESC_LENGTH; i1++ ) {
+
+		for( int i3 = 0; i3 < SCLDEL_LENGTH; i3++ ) {
+			tmpSCLDEL = (double)((pSCLDEL[i3] + 1) * (double)((pPRESC[i1] + 1) * clkPeriodI2C));
+
+			for( int i2 = 0; i2 < SCLDEL_LENGTH; i2++ ) {
+				tmpSDADEL = (double)(pSDADEL[i2] * (double)((pPRESC[i1] + 1) * clkPeriodI2C));
+				if( (tmpSDADEL >= tmpMinSDADEL) && (tmpSDADEL <= tmpMaxSDADEL) && (tmpSCLDEL >= tmpMinSCLDEL) ) {
+					if( pPRESC[i1] != tmpPRESC ) {
+						pPRESCvalid[nbValid] = pPRESC[i1];
+						tmpPRESC = pPRESCvalid[nbValid];
+						nbValid = nbValid + 1;
+						if( tabIndex < MAX_I2C_MODEL_NB ) {
+							pPrescSDLDELSCLDELpossComb[tabIndex].prescaler = i1;
+							pPrescSDLDELSCLDELpossComb[tabIndex].SDLDEL=i2;
+							pPrescSDLDELSCLDELpossComb[tabIndex].SCLDEL=i3;
+							pPrescSDLDELSCLDELpossComb[tabIndex].resultat=1;
+							prescSDLDELSCLDELpossCombSize++;
+						}
+						// else MAX_I2C_MODEL_NB should be incremented or use dynamic memory
+						tabIndex++;
+					}
+				}
+			}
+		}
+	}
+
+	// SCLL SCLH calculation
+	double solution = 0;
+	double prescR = 99;
+	int sdadel = 0;
+	int scldel = 0;
+	int i1Sel = 0;
+	int i2Sel = 0;
+	int i3Sel = 0;
+	double errorTarget = 0.2;
+	double tsync = (double)delayFilter + (2 * clkPeriodI2C);
+	Brg_I2cModelT s;
+
+	if( nbValid != 0 ) {
+		for( int i3 = nbValid - 1; i3 >= 0; i3-- ) {
+			for( int i1 = 0; i1 < SCLL_LENGTH; i1++ ) {
+				for( int i2 = 0; i2 < SCLH_LENGTH; i2++ ) {
+					double presc = (double)(pPRESCvalid[i3] + 1) * (double)clkPeriodI2C;
+					double tSclLow = (double)(pSCLL[i1] + 1) * (double)presc;
+					double tSclHigh = (double)(pSCLH[i2] + 1) * (double)presc;
+
+					tSclLow = (double)tSclLow + (double)tsync;
+					tSclHigh = (double)tSclHigh + (double)tsync;
+					double tScl = (double)tSclLow + (double)tSclHigh + (double)riseTimeCalc + (double)fallTimeCalc;
+					double speed = 1 / (double)tScl;
+
+					if( (speed >= clkMin) && (speed <= clkMax) && (tSclLow >= pTLowMin[idx]) &&
+					    (tSclHigh >= pTHighMin[idx]) && (clkPeriodI2C < ((tSclLow - delayFilter) / 4)) &&
+					    (clkPeriodI2C < tSclHigh) ) {
+						double errorTmp = (double)(speed - targetFreqI2C) / (double)(targetFreqI2C);
+						if( errorTmp < 0 ) {
+							double x = (double)(0 - (double)errorTmp);
+							s.prescaler = i1;
+							s.SDLDEL=i2;
+							s.SCLDEL=i3;
+							s.resultat=x;
+						} else {
+							s.prescaler = i1;
+							s.SDLDEL=i2;
+							s.SCLDEL=i3;
+							s.resultat=errorTmp;
+						}
+					} else {
+						s.prescaler = i1;
+						s.SDLDEL=i2;
+						s.SCLDEL=i3;
+						s.resultat=1;
+					}
+
+					if( (s.resultat <= errorTarget) && (pPRESCvalid[i3] <= prescR) ) {
+						prescR = pPRESCvalid[i3];
+						solution = 1;
+						errorTarget = (double)s.resultat;
+						i1Sel = i1;
+						i2Sel = i2;
+						i3Sel = i3;
+					}
+				}
+			}
+		}
+		int x = 0;
+		for( int i2 = 0; i2 < 16; i2++ ) {
+			for( int i3 = 0; i3 < 16; i3++ ) {
+				for( int j = 0; j < prescSDLDELSCLDELpossCombSize; j++ ) {
+					if( (pPrescSDLDELSCLDELpossComb[j].resultat == 1) &&
+					    (pPrescSDLDELSCLDELpossComb[j].prescaler == pPRESCvalid[i3Sel]) &&
+					    (pPrescSDLDELSCLDELpossComb[j].SDLDEL == i2) &&
+					    (pPrescSDLDELSCLDELpossComb[j].SCLDEL == i3) &&
+					    (x == 0) ) {
+						sdadel = i2;
+						scldel = i3;
+						x++;
+					}
+				}
+			}
+		}
+	}
+	// Get results
+	*pTimingReg=0;
+	if( solution==1 ) {
+		*pTimingReg = (uint32_t) ((uint32_t)pPRESCvalid[i3Sel]<<28 | // Bits 31:28 PRESC[3:0]: Timing prescaler
+					(uint32_t)scldel<<20 | // Bits 27:24 Reserved, must be kept at reset value.
+		                                   // Bits 23:20 SCLDEL[3:0]: Data setup time
+					(uint32_t)sdadel<<16 | // Bits 19:16 SDADEL[3:0]: Data hold time
+					(uint32_t)i2Sel<<8 | // Bits 15:8 SCLH[7:0]: SCL high period (master mode)
+					(uint32_t)i1Sel); // Bits 7:0 SCLL[7:0]: SCL low period (master mode)
+		brgStatus = BRG_NO_ERR;
+	} else {
+		brgStatus = BRG_PARAM_ERR;
+	}
+
+    delete [] pSCLL;
+    delete [] pSCLH;
+	delete [] pSCLDEL;
+    delete [] pSDADEL;
+    delete [] pPRESC;
+    delete [] pPRESCvalid;
+	delete [] pPrescSDLDELSCLDELpossComb;
+    delete [] pTFallMax;
+    delete [] pTRiseMax;
+    delete [] pTHdDatMax;
+    delete [] pTSuDatMin;
+    delete [] pTLowMin;
+    delete [] pTHighMin;
+
+	return brgStatus;
+}
+
+
+// Same TimingReg and status as the reference on every combination
+static void TestEquivalence(Brg &Bridge)
+{
+	static const uint32_t clocksKHz[] = { 16000, 32000, 48000, 64000, 80000, 120000, 192000, 280000 };
+	static const int freqsKHz[] = { 1, 10, 50, 75, 100, 150, 200, 333, 400, 500, 800, 1000 };
+	static const int dnfs[] = { 0, 2, 15 };
+	static const struct {
+		I2cModeT Mode;
+		int FreqMax;
+		int RiseMax;
+		int FallMax;
+	} modes[] = { { I2C_STANDARD, 100, 1000, 300 }, { I2C_FAST, 400, 300, 300 }, { I2C_FAST_PLUS, 1000, 120, 120 } };
+	Brg_StatusT refStat, stat;
+	uint32_t refReg, reg;
+	int combNb = 0, diffNb = 0;
+	double refUs = 0, newUs = 0;
+	uint64_t startUs;
+
+	for( size_t m = 0; m < sizeof(modes)/sizeof(modes[0]); m++ ) {
+		for( size_t c = 0; c < sizeof(clocksKHz)/sizeof(clocksKHz[0]); c++ ) {
+			BrgSimSetClock(COM_I2C, clocksKHz[c]);
+			for( size_t f = 0; f < sizeof(freqsKHz)/sizeof(freqsKHz[0]); f++ ) {
+				if( freqsKHz[f] > modes[m].FreqMax ) {
+					continue;
+				}
+				for( size_t d = 0; d < sizeof(dnfs)/sizeof(dnfs[0]); d++ ) {
+					const int rises[] = { 0, modes[m].RiseMax/2, modes[m].RiseMax };
+					for( int r = 0; r < 3; r++ ) {
+						const int falls[] = { 0, modes[m].FallMax };
+						for( int fa = 0; fa < 2; fa++ ) {
+							for( int af = 0; af < 2; af++ ) {
+								refReg = 0;
+								startUs = BrgGetMonotonicUs();
+								refStat = RefCalculateI2cTimingReg(modes[m].Mode, freqsKHz[f], (double)clocksKHz[c], dnfs[d],
+								                                   rises[r], falls[fa], (af != 0), &refReg);
+								refUs += (double)(BrgGetMonotonicUs() - startUs);
+								startUs = BrgGetMonotonicUs();
+								stat = Bridge.GetI2cTiming(modes[m].Mode, freqsKHz[f], dnfs[d], rises[r], falls[fa], (af != 0), &reg);
+								newUs += (double)(BrgGetMonotonicUs() - startUs);
+								if( (stat != refStat) || (reg != refReg) ) {
+									if( diffNb < 10 ) {
+										printf("mode %d %d kHz clock %lu kHz DNF %d rise %d fall %d AF %d: 0x%08lx (%d) instead of 0x%08lx (%d)\n",
+										       (int)modes[m].Mode, freqsKHz[f], (unsigned long)clocksKHz[c], dnfs[d], rises[r],
+										       falls[fa], af, (unsigned long)reg, (int)stat, (unsigned long)refReg, (int)refStat);
+									}
+									diffNb++;
+								}
+								combNb++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	printf("%d combinations, %d differences, average %.0f us (original) / %.1f us (GetI2cTiming)\n",
+	       combNb, diffNb, refUs / combNb, newUs / combNb);
+	BRG_TEST_CHECK_EQ(combNb, 7488);
+	BRG_TEST_CHECK_EQ(diffNb, 0);
+}
+
+// Cached result per clock: a clock switch between two calls gives the new clock timing
+static void TestClockSwitch(Brg &Bridge)
+{
+	uint32_t reg48, reg64, refReg, reg;
+	unsigned long clockCmdNb;
+
+	BrgSimSetClock(COM_I2C, 48000);
+	BRG_TEST_CHECK_EQ(Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg48), BRG_NO_ERR);
+	BrgSimSetClock(COM_I2C, 64000);
+	BRG_TEST_CHECK_EQ(Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg64), BRG_NO_ERR);
+	RefCalculateI2cTimingReg(I2C_FAST, 400, 64000, 0, 300, 300, true, &refReg);
+	BRG_TEST_CHECK_EQ(reg64, refReg);
+	BRG_TEST_CHECK(reg64 != reg48);
+
+	// Back to 48 MHz: cached entry of that clock, one clock read per call
+	BrgSimSetClock(COM_I2C, 48000);
+	clockCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_GET_CLOCK);
+	BRG_TEST_CHECK_EQ(Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(reg, reg48);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_GET_CLOCK) - clockCmdNb, 1);
+
+	// CloseBridge(COM_I2C) forgets the results, still the same timing
+	BRG_TEST_CHECK_EQ(Bridge.CloseBridge(COM_I2C), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(reg, reg48);
+}
+
+// Standard modes at 48 MHz: original search, first and repeated GetI2cTiming() calls
+static void Benchmark(Brg &Bridge)
+{
+	static const struct {
+		const char *pName;
+		I2cModeT Mode;
+		int FreqKHz;
+		int Rise;
+		int Fall;
+	} cases[] = { { "SM 100 kHz", I2C_STANDARD, 100, 1000, 300 }, { "FM 400 kHz", I2C_FAST, 400, 300, 300 },
+	              { "FM+ 1 MHz", I2C_FAST_PLUS, 1000, 120, 120 } };
+	uint32_t reg;
+	uint64_t startUs, refUs, firstUs, repeatUs;
+
+	BrgSimSetClock(COM_I2C, 48000);
+	BRG_TEST_CHECK_EQ(Bridge.CloseBridge(COM_I2C), BRG_NO_ERR);
+	for( size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++ ) {
+		startUs = BrgGetMonotonicUs();
+		RefCalculateI2cTimingReg(cases[i].Mode, cases[i].FreqKHz, 48000, 0, cases[i].Rise, cases[i].Fall, true, &reg);
+		refUs = BrgGetMonotonicUs() - startUs;
+		startUs = BrgGetMonotonicUs();
+		Bridge.GetI2cTiming(cases[i].Mode, cases[i].FreqKHz, 0, cases[i].Rise, cases[i].Fall, true, &reg);
+		firstUs = BrgGetMonotonicUs() - startUs;
+		startUs = BrgGetMonotonicUs();
+		for( int j = 0; j < 1000; j++ ) {
+			Bridge.GetI2cTiming(cases[i].Mode, cases[i].FreqKHz, 0, cases[i].Rise, cases[i].Fall, true, &reg);
+		}
+		repeatUs = BrgGetMonotonicUs() - startUs;
+		printf("%-10s original %6lu us, GetI2cTiming first %5lu us, repeated %.2f us\n", cases[i].pName,
+		       (unsigned long)refUs, (unsigned long)firstUs, (double)repeatUs / 1000);
+	}
+}
+
+// Per-call cost with a USB round trip: each call reads the I2C input clock (GET_CLOCK) so
+// that a clock switch is never missed, a cached call costs that one round trip
+static void TestPerCallCost(Brg &Bridge)
+{
+	uint32_t reg;
+	uint64_t startUs, callUs;
+	unsigned long clockCmdNb;
+
+	BrgSimSetClock(COM_I2C, 48000);
+	BRG_TEST_CHECK_EQ(Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg), BRG_NO_ERR);
+	BrgSimSetLatency(TEST_USB_US, 0);
+	clockCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_GET_CLOCK);
+	startUs = BrgGetMonotonicUs();
+	for( int i = 0; i < TEST_CALL_NB; i++ ) {
+		Bridge.GetI2cTiming(I2C_FAST, 400, 0, 300, 300, true, &reg);
+	}
+	callUs = (BrgGetMonotonicUs() - startUs) / TEST_CALL_NB;
+	BrgSimSetLatency(0, 0);
+	printf("GetI2cTiming cached call with a %d us USB round trip: %lu us\n", TEST_USB_US, (unsigned long)callUs);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_GET_CLOCK) - clockCmdNb, TEST_CALL_NB);
+	BRG_TEST_CHECK(callUs >= TEST_USB_US);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestEquivalence(bridge);
+	TestClockSwitch(bridge);
+	Benchmark(bridge);
+	TestPerCallCost(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,256 @@
+/**
+  ******************************************************************************
+  * @file    test_rx_pump.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Rx overrun accounting of Brg::GetRxMsgCAN() (per type counters,
+  *          first/last timestamps) and BrgRxPump drain rate: escalation on a
+  *          buffer overrun or a backlog, back-off on a quiet bus.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "brg_test.h"
+#include "brg_latency.h"
+#include "brg_rx_pump.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_BAUD            125000
+#define TEST_MIN_INTERVAL_US 1000
+#define TEST_MAX_INTERVAL_US 16000
+#define TEST_MIN_BATCH       4
+#define TEST_MAX_BATCH       64
+#define TEST_QUIET_POLL_NB   3
+#define TEST_BACKLOG_NB      200
+#define TEST_WAIT_MS         2000  // give up waiting for the pump
+
+/* Private functions ---------------------------------------------------------*/
+static void WriteFrames(Brg &Bridge, uint32_t Id, int Nb)
+{
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, Id, CAN_DATA_FRAME, 1 };
+	uint8_t data = 0;
+
+	for( int i = 0; i < Nb; i++ ) {
+		data = (uint8_t)i;
+		BRG_TEST_CHECK_EQ(Bridge.WriteMsgCAN(&msg, &data, 1), BRG_NO_ERR);
+	}
+}
+
+static void IgnoreFrames(void *pContext, const Brg_RxFrameT *pFrames, uint16_t FrameNb)
+{
+	(void)pContext;
+	(void)pFrames;
+	(void)FrameNb;
+}
+
+// Wait until the pump statistics satisfy Done (false on timeout)
+template<typename DoneT>
+static bool WaitStats(const BrgRxPump &Pump, Brg_RxPumpStatsT *pStats, DoneT Done)
+{
+	std::chrono::steady_clock::time_point end;
+
+	end = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_WAIT_MS);
+	do {
+		Pump.GetStats(pStats);
+		if( Done(*pStats) ) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	} while( std::chrono::steady_clock::now() < end );
+	return false;
+}
+
+// Overruns flagged by the bridge: message flags, GetRxMsgCAN() status, counters and timestamps
+static void TestOverrunStats(Brg &Bridge)
+{
+	Brg_CanRxMsgT msgs[4];
+	uint8_t data[4 * 8];
+	uint16_t dataSize = 0, rxNb = 0;
+	Brg_RxOverrunStatsT stats;
+	uint64_t startUs, firstUs;
+
+	Bridge.ResetRxOverrunStats();
+	startUs = BrgGetMonotonicUs();
+	WriteFrames(Bridge, 0x100, 1);
+	BrgSimSetCanRxOverrun(CAN_RX_FIFO_OVERRUN);
+	WriteFrames(Bridge, 0x101, 1);
+	BrgSimSetCanRxOverrun(CAN_RX_BUFF_OVERRUN);
+	WriteFrames(Bridge, 0x102, 1);
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgCAN(msgs, 3, data, sizeof(data), &dataSize), BRG_OVERRUN_ERR);
+	BRG_TEST_CHECK_EQ(dataSize, 3);
+	BRG_TEST_CHECK_EQ(msgs[0].Overrun, CAN_RX_NO_OVERRUN);
+	BRG_TEST_CHECK_EQ(msgs[1].Overrun, CAN_RX_FIFO_OVERRUN);
+	BRG_TEST_CHECK_EQ(msgs[2].Overrun, CAN_RX_BUFF_OVERRUN);
+	BRG_TEST_CHECK_EQ(msgs[2].ID, 0x102);
+
+	Bridge.GetRxOverrunStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.RxMsgNb, 3);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 1);
+	BRG_TEST_CHECK(stats.FirstOverrunUs >= startUs);
+	BRG_TEST_CHECK(stats.FirstOverrunUs <= stats.LastFifoOverrunUs);
+	BRG_TEST_CHECK(stats.LastFifoOverrunUs <= stats.LastBuffOverrunUs);
+	BRG_TEST_CHECK(stats.LastBuffOverrunUs <= BrgGetMonotonicUs());
+	firstUs = stats.FirstOverrunUs;
+
+	// A later fifo overrun: last fifo time moves, first time and buffer counters do not
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	BrgSimSetCanRxOverrun(CAN_RX_FIFO_OVERRUN);
+	WriteFrames(Bridge, 0x103, 1);
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgCAN(msgs, 1, data, sizeof(data), &dataSize), BRG_OVERRUN_ERR);
+	Bridge.GetRxOverrunStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.RxMsgNb, 4);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 2);
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(stats.FirstOverrunUs, firstUs);
+	BRG_TEST_CHECK(stats.LastFifoOverrunUs >= firstUs + 2000);
+	BRG_TEST_CHECK(stats.LastBuffOverrunUs < stats.LastFifoOverrunUs);
+
+	// No overrun: plain read, only the message counter moves
+	WriteFrames(Bridge, 0x104, 1);
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgCAN(msgs, 1, data, sizeof(data), &dataSize), BRG_NO_ERR);
+	Bridge.GetRxOverrunStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.RxMsgNb, 5);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 2);
+
+	Bridge.ResetRxOverrunStats();
+	Bridge.GetRxOverrunStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.RxMsgNb, 0);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 0);
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 0);
+	BRG_TEST_CHECK_EQ(stats.FirstOverrunUs, 0);
+	BRG_TEST_CHECK_EQ(stats.LastFifoOverrunUs, 0);
+	BRG_TEST_CHECK_EQ(stats.LastBuffOverrunUs, 0);
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgNbCAN(&rxNb), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(rxNb, 0);
+}
+
+// Frames dropped by a full simulated Rx buffer: the next one read is flagged buffer overrun
+static void TestRxBufferFull(Brg &Bridge)
+{
+	Brg_CanRxMsgT msgs[TEST_MAX_BATCH];
+	uint8_t data[TEST_MAX_BATCH * 8];
+	uint16_t dataSize = 0, rxNb = 0;
+	Brg_RxOverrunStatsT stats;
+	int readNb = 0;
+
+	Bridge.ResetRxOverrunStats();
+	WriteFrames(Bridge, 0x200, 4096 + 10); // 10 dropped
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgNbCAN(&rxNb), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(rxNb, 4096);
+	while( readNb < 4096 ) {
+		BRG_TEST_CHECK_EQ(Bridge.GetRxMsgCAN(msgs, TEST_MAX_BATCH, data, sizeof(data), &dataSize), BRG_NO_ERR);
+		readNb += TEST_MAX_BATCH;
+	}
+	WriteFrames(Bridge, 0x201, 1);
+	BRG_TEST_CHECK_EQ(Bridge.GetRxMsgCAN(msgs, 1, data, sizeof(data), &dataSize), BRG_OVERRUN_ERR);
+	BRG_TEST_CHECK_EQ(msgs[0].ID, 0x201);
+	BRG_TEST_CHECK_EQ(msgs[0].Overrun, CAN_RX_BUFF_OVERRUN);
+	Bridge.GetRxOverrunStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.RxMsgNb, 4096 + 1);
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 0);
+}
+
+// Pump drain rate: one step up per buffer overrun or backlog poll, one step down
+// every TEST_QUIET_POLL_NB quiet polls, both bounded by the configuration
+static void TestPumpDrainRate(Brg &Bridge)
+{
+	Brg_RxPumpConfT conf = { TEST_MIN_INTERVAL_US, TEST_MAX_INTERVAL_US, TEST_MIN_BATCH, TEST_MAX_BATCH,
+	                         TEST_QUIET_POLL_NB };
+	BrgRxPump pump(Bridge, IgnoreFrames, NULL, &conf);
+	Brg_RxPumpStatsT stats;
+	Brg_RxOverrunStatsT brgStats;
+	std::chrono::steady_clock::time_point escalationTime;
+	long long backoffUs;
+
+	Bridge.ResetRxOverrunStats();
+	pump.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.IntervalUs, TEST_MAX_INTERVAL_US);
+	BRG_TEST_CHECK_EQ(stats.Batch, TEST_MIN_BATCH);
+	BRG_TEST_CHECK_EQ(pump.Start(), BRG_NO_ERR);
+
+	// Buffer overrun on a single frame: one step up
+	BrgSimSetCanRxOverrun(CAN_RX_BUFF_OVERRUN);
+	WriteFrames(Bridge, 0x300, 1);
+	BRG_TEST_CHECK(WaitStats(pump, &stats, [](const Brg_RxPumpStatsT &S) { return S.EscalationNb == 1; }));
+	escalationTime = std::chrono::steady_clock::now();
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 0);
+	BRG_TEST_CHECK_EQ(stats.IntervalUs, TEST_MAX_INTERVAL_US / 2);
+	BRG_TEST_CHECK_EQ(stats.Batch, TEST_MIN_BATCH * 2);
+
+	// Quiet bus: back to the least aggressive level after TEST_QUIET_POLL_NB polls at the new interval
+	BRG_TEST_CHECK(WaitStats(pump, &stats, [](const Brg_RxPumpStatsT &S) { return S.BackoffNb == 1; }));
+	backoffUs = (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+	                std::chrono::steady_clock::now() - escalationTime).count();
+	BRG_TEST_CHECK(backoffUs >= (TEST_QUIET_POLL_NB - 1) * (TEST_MAX_INTERVAL_US / 2));
+	BRG_TEST_CHECK_EQ(stats.IntervalUs, TEST_MAX_INTERVAL_US);
+	BRG_TEST_CHECK_EQ(stats.Batch, TEST_MIN_BATCH);
+
+	// Backlog found by one poll (the pump waits on the transaction lock): full batches
+	// escalate up to the limits (4 steps from 16000us/4 to 1000us/64), a fifo overrun does not
+	{
+		std::lock_guard<std::recursive_mutex> lock(Bridge.GetTransactionLock());
+		BrgSimSetCanRxOverrun(CAN_RX_FIFO_OVERRUN);
+		WriteFrames(Bridge, 0x301, TEST_BACKLOG_NB);
+	}
+	BRG_TEST_CHECK(WaitStats(pump, &stats, [](const Brg_RxPumpStatsT &S) { return S.FrameNb == 1 + TEST_BACKLOG_NB; }));
+	BRG_TEST_CHECK_EQ(stats.EscalationNb, 1 + 4);
+	BRG_TEST_CHECK_EQ(stats.IntervalUs, TEST_MIN_INTERVAL_US);
+	BRG_TEST_CHECK_EQ(stats.Batch, TEST_MAX_BATCH);
+	BRG_TEST_CHECK_EQ(stats.FifoOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(stats.BuffOverrunNb, 1);
+
+	// Quiet again: 4 steps back to the least aggressive level, no more
+	BRG_TEST_CHECK(WaitStats(pump, &stats, [](const Brg_RxPumpStatsT &S) { return S.BackoffNb == 1 + 4; }));
+	BRG_TEST_CHECK_EQ(stats.IntervalUs, TEST_MAX_INTERVAL_US);
+	BRG_TEST_CHECK_EQ(stats.Batch, TEST_MIN_BATCH);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5 * TEST_QUIET_POLL_NB * TEST_MAX_INTERVAL_US / 1000));
+	BRG_TEST_CHECK_EQ(pump.Stop(), BRG_NO_ERR);
+	pump.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.BackoffNb, 1 + 4);
+	BRG_TEST_CHECK_EQ(stats.EscalationNb, 1 + 4);
+	BRG_TEST_CHECK_EQ(stats.ErrorNb, 0);
+
+	// The pump reads through GetRxMsgCAN(): the bridge counted the same overruns
+	Bridge.GetRxOverrunStats(&brgStats);
+	BRG_TEST_CHECK_EQ(brgStats.RxMsgNb, 1 + TEST_BACKLOG_NB);
+	BRG_TEST_CHECK_EQ(brgStats.FifoOverrunNb, 1);
+	BRG_TEST_CHECK_EQ(brgStats.BuffOverrunNb, 1);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	Brg_CanBitTimingT bitTiming;
+	Brg_CanInitT init;
+	uint8_t candidateNb = 0;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.FindCANbitTiming(TEST_BAUD, 875, &bitTiming, 1, &candidateNb), BRG_NO_ERR);
+	memset(&init, 0, sizeof(init));
+	init.BitTimeConf = bitTiming.BitTimeConf;
+	init.Prescaler = bitTiming.Prescaler;
+	init.Mode = CAN_MODE_NORMAL;
+	BRG_TEST_CHECK_EQ(bridge.InitCAN(&init, BRG_INIT_FULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(bridge.StartMsgReceptionCAN(), BRG_NO_ERR);
+	TestOverrunStats(bridge);
+	TestRxBufferFull(bridge);
+	TestPumpDrainRate(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file    test_shared_mode.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   CAN writes through the stand-in stlink-server (STLINK_TCP shared mode)
+  *          and in direct USB mode: each write reports its own error, round trips
+  *          and time per write in both modes.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "brg_test.h"
+#include "brg_latency.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_SIM_SERIAL    "SIM0000000000000000000001"
+#define TEST_WRITE_NB      5
+#define TEST_FAIL_NTH      3     // failing write, followed by successful ones
+#define TEST_BENCH_NB      200
+#define TEST_USB_US        100   // round trip of one USB command
+#define TEST_TCP_US        400   // added by the stlink-server exchange
+
+/* Private functions ---------------------------------------------------------*/
+// Shared mode: the stlink-server device cookie comes from the serial number lookup
+static Brg_StatusT TestOpenShared(STLinkInterface &StlinkIf, Brg &Bridge)
+{
+	uint32_t devNb = 0;
+
+	if( StlinkIf.LoadStlinkLibrary("") != STLINKIF_NO_ERR ) {
+		return BRG_DLL_ERR;
+	}
+	if( StlinkIf.EnumDevices(&devNb, false) != STLINKIF_NO_ERR ) {
+		return BRG_NO_DEVICE;
+	}
+	return Bridge.OpenStlink(TEST_SIM_SERIAL, true);
+}
+
+// A write failing between successful ones is reported by its own call, whatever the mode
+static void TestWriteStatus(Brg &Bridge, bool bShared)
+{
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0x123, CAN_DATA_FRAME, 8 };
+	uint8_t data[8] = { 0 };
+	uint64_t statusNb, tcpNb;
+
+	BrgSimSetCanLoopback(false);
+	statusNb = BrgSimGetCmdNb(STLINK_BRIDGE_GET_RWCMD_STATUS);
+	tcpNb = BrgSimGetTcpCmdNb();
+	BrgSimFailCmd(STLINK_BRIDGE_WRITE_MSG_CAN, TEST_FAIL_NTH, STLINK_BRIDGE_CAN_ERROR);
+	for( int i = 1; i <= TEST_WRITE_NB; i++ ) {
+		data[0] = (uint8_t)i;
+		BRG_TEST_CHECK_EQ(Bridge.WriteMsgCAN(&msg, data, 8), (i == TEST_FAIL_NTH) ? BRG_CAN_ERR : BRG_NO_ERR);
+	}
+	// Write + GET_RWCMD_STATUS for each frame, all through the server in shared mode
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_GET_RWCMD_STATUS) - statusNb, TEST_WRITE_NB);
+	BRG_TEST_CHECK_EQ(BrgSimGetTcpCmdNb() - tcpNb, bShared ? 2*TEST_WRITE_NB : 0);
+}
+
+// Time per write with the given command latencies, in us
+static double TestWriteTime(Brg &Bridge)
+{
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0x321, CAN_DATA_FRAME, 8 };
+	uint8_t data[8] = { 0 };
+	uint64_t startUs;
+
+	BrgSimSetLatency(TEST_USB_US, TEST_TCP_US);
+	startUs = BrgGetMonotonicUs();
+	for( int i = 0; i < TEST_BENCH_NB; i++ ) {
+		BRG_TEST_CHECK_EQ(Bridge.WriteMsgCAN(&msg, data, 8), BRG_NO_ERR);
+	}
+	BrgSimSetLatency(0, 0);
+	return (double)(BrgGetMonotonicUs() - startUs) / TEST_BENCH_NB;
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface usbIf(STLINK_BRIDGE), tcpIf(STLINK_TCP);
+	Brg usbBridge(usbIf), tcpBridge(tcpIf);
+	Brg_CmdStatsT stats;
+	double usbUs, tcpUs;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(usbIf, usbBridge), BRG_NO_ERR);
+	TestWriteStatus(usbBridge, false);
+	usbUs = TestWriteTime(usbBridge);
+	usbBridge.CloseStlink();
+
+	BRG_TEST_CHECK_EQ(TestOpenShared(tcpIf, tcpBridge), BRG_NO_ERR);
+	TestWriteStatus(tcpBridge, true);
+	tcpBridge.ResetCmdStats();
+	tcpUs = TestWriteTime(tcpBridge);
+	BRG_TEST_CHECK_EQ(tcpBridge.GetCmdStats(STLINK_BRIDGE_WRITE_MSG_CAN, &stats), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(stats.CmdNb, TEST_BENCH_NB);
+	BRG_TEST_CHECK(tcpUs > usbUs);
+	tcpBridge.CloseStlink();
+
+	printf("CAN write, %d us per USB command, +%d us per server exchange:\n", TEST_USB_US, TEST_TCP_US);
+	printf("  direct USB:  %.0f us/write\n", usbUs);
+	printf("  shared mode: %.0f us/write (%.0f us overhead)\n", tcpUs, tcpUs - usbUs);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
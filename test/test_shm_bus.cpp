@@ -0,0 +1,308 @@
+/**
+  ******************************************************************************
+  * @file    test_shm_bus.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgShmBus: live and stale owners, header checks at Open(), transmit
+  *          cell claimed by a client that died before filling it, or by a client
+  *          stalled past the claim timeout.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "brg_test.h"
+#include "brg_shm_bus.h"
+
+/* Private defines -----------------------------------------------------------*/
+// Shared memory header offsets (BrgShmBus::ShmHeaderT)
+#define TEST_HDR_TOTAL_SIZE    8
+#define TEST_HDR_RX_SLOT_NB    20
+#define TEST_HDR_TX_ENQUEUE    128
+#define TEST_HDR_SIZE          256
+
+/* Private variables ---------------------------------------------------------*/
+static char g_busName[32];
+// Client writer stalled on a write protected page (TestDelayedClient)
+static uint8_t *g_pProtected;
+static size_t g_protectedSize;
+static std::atomic<bool> g_bFaulted(false);
+static std::atomic<bool> g_bResume(false);
+
+/* Private functions ---------------------------------------------------------*/
+// Raw mapping of the bus header, as another process would see it
+static uint8_t* MapHeader(void)
+{
+	char shmName[40];
+	void *pView;
+	int fd;
+
+	snprintf(shmName, sizeof(shmName), "/%s", g_busName);
+	fd = shm_open(shmName, O_RDWR, 0);
+	if( fd < 0 ) {
+		return NULL;
+	}
+	pView = mmap(NULL, TEST_HDR_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	return (pView == MAP_FAILED) ? NULL : (uint8_t*)pView;
+}
+
+// Write to the protected cells: the writer waits for g_bResume, then its write is retried
+static void StallWriter(int Signal)
+{
+	struct timespec delay = { 0, 1000000 };
+
+	(void)Signal;
+	g_bFaulted.store(true);
+	while( g_bResume.load() == false ) {
+		nanosleep(&delay, NULL);
+	}
+	mprotect(g_pProtected, g_protectedSize, PROT_READ | PROT_WRITE);
+}
+
+static Brg_RxFrameT MakeFrame(uint32_t Id)
+{
+	Brg_RxFrameT frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.IDE = CAN_ID_STANDARD;
+	frame.ID = Id;
+	frame.RTR = CAN_DATA_FRAME;
+	frame.DLC = 0;
+	return frame;
+}
+
+// A second owner is refused while the first one is alive, the first one keeps working
+static void TestLiveOwner(void)
+{
+	BrgShmBus owner, other, client;
+	Brg_RxFrameT frame = MakeFrame(0x123);
+	Brg_ShmFrameT readFrame;
+	uint32_t readNb = 0;
+
+	BRG_TEST_CHECK_EQ(owner.Create(g_busName, 16, 4), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(other.Create(g_busName, 16, 4), BRG_PERMISSION_ERR);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(owner.Publish(&frame, 1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(client.Read(&readFrame, 1, &readNb), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(readNb, 1);
+	BRG_TEST_CHECK_EQ(readFrame.Frame.ID, 0x123);
+}
+
+// Owner process exited without Close(): its bus is replaced
+static void TestStaleOwner(void)
+{
+	BrgShmBus owner, client;
+	Brg_ShmBusStatsT stats;
+	pid_t pid;
+	int status = -1;
+
+	pid = fork();
+	if( pid == 0 ) {
+		BrgShmBus crashed;
+		_exit((crashed.Create(g_busName, 16, 4) == BRG_NO_ERR) ? 0 : 1); // no destructor
+	}
+	BRG_TEST_CHECK(pid > 0);
+	waitpid(pid, &status, 0);
+	BRG_TEST_CHECK_EQ(status, 0);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NO_ERR); // left behind
+	client.Close();
+	BRG_TEST_CHECK_EQ(owner.Create(g_busName, 16, 4), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NO_ERR);
+	client.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.ClientNb, 2); // new bus: owner + this client
+}
+
+// Ring sizes and total size checked before being used as masks
+static void TestOpenChecks(void)
+{
+	BrgShmBus owner, client;
+	uint8_t *pHeader;
+	uint32_t rxSlotNb, totalSize, value;
+
+	BRG_TEST_CHECK_EQ(owner.Create(g_busName, 16, 4), BRG_NO_ERR);
+	pHeader = MapHeader();
+	BRG_TEST_CHECK(pHeader != NULL);
+	if( pHeader == NULL ) {
+		return;
+	}
+	memcpy(&rxSlotNb, &pHeader[TEST_HDR_RX_SLOT_NB], 4);
+	memcpy(&totalSize, &pHeader[TEST_HDR_TOTAL_SIZE], 4);
+	BRG_TEST_CHECK_EQ(rxSlotNb, 16);
+
+	value = 12; // not a power of 2
+	memcpy(&pHeader[TEST_HDR_RX_SLOT_NB], &value, 4);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NOT_SUPPORTED);
+	value = 32; // power of 2 beyond TotalSize
+	memcpy(&pHeader[TEST_HDR_RX_SLOT_NB], &value, 4);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NOT_SUPPORTED);
+	memcpy(&pHeader[TEST_HDR_RX_SLOT_NB], &rxSlotNb, 4);
+	value = totalSize + 64;
+	memcpy(&pHeader[TEST_HDR_TOTAL_SIZE], &value, 4);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NOT_SUPPORTED);
+	memcpy(&pHeader[TEST_HDR_TOTAL_SIZE], &totalSize, 4);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NO_ERR);
+	munmap(pHeader, TEST_HDR_SIZE);
+}
+
+// Transmit cell claimed by a client that died: skipped, the next requests are written
+static void TestDeadClient(Brg &Bridge)
+{
+	BrgShmBus owner, client;
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, 0x321, CAN_DATA_FRAME, 2 };
+	uint8_t data[2] = { 1, 2 };
+	Brg_ShmBusStatsT stats;
+	uint8_t *pHeader;
+	unsigned long writeNb;
+
+	BRG_TEST_CHECK_EQ(owner.Create(g_busName, 16, 4), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(client.Open(g_busName), BRG_NO_ERR);
+	pHeader = MapHeader();
+	BRG_TEST_CHECK(pHeader != NULL);
+	if( pHeader == NULL ) {
+		return;
+	}
+	// Claim of cell 0 (TxEnqueuePos moved), its Sequence never published
+	((std::atomic<uint64_t>*)&pHeader[TEST_HDR_TX_ENQUEUE])->fetch_add(1);
+	munmap(pHeader, TEST_HDR_SIZE);
+
+	BRG_TEST_CHECK_EQ(client.SubmitCAN(&msg, data, 2), BRG_NO_ERR);
+	writeNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_MSG_CAN);
+	BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS / 2));
+	BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(BRG_SHMBUS_TX_CLAIM_TIMEOUT_MS));
+	BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 1);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_MSG_CAN) - writeNb, 1);
+	owner.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.TxSkippedNb, 1);
+	BRG_TEST_CHECK_EQ(stats.TxWrittenNb, 1);
+
+	// Ring usable all the way round after the skip
+	for( int i = 0; i < 8; i++ ) {
+		BRG_TEST_CHECK_EQ(client.SubmitCAN(&msg, data, 2), BRG_NO_ERR);
+		BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 1);
+	}
+	owner.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.TxWrittenNb, 9);
+}
+
+// Transmit cell claimed by a client descheduled past the claim timeout: the cell is
+// skipped then reused by another client, the late client gets BRG_OVERRUN_ERR and its
+// request is never written in place of the other one
+static void TestDelayedClient(Brg &Bridge)
+{
+	BrgShmBus owner, late, other;
+	Brg_CanTxMsgT lateMsg = { CAN_ID_STANDARD, 0x0A0, CAN_DATA_FRAME, 0 };
+	Brg_CanTxMsgT otherMsg = { CAN_ID_STANDARD, 0x0B0, CAN_DATA_FRAME, 0 };
+	Brg_RxFrameT frame = MakeFrame(0x123);
+	Brg_ShmFrameT readFrames[4];
+	Brg_ShmBusStatsT stats;
+	struct sigaction action, oldSegv, oldBus;
+	struct stat shmStat;
+	Brg_StatusT lateStat = BRG_NO_ERR;
+	uint32_t readNb = 0, i;
+	uint64_t writeNb;
+	char shmName[40];
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	int fd;
+
+	BRG_TEST_CHECK_EQ(owner.Create(g_busName, 256, 2), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(late.Open(g_busName), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(other.Open(g_busName), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(owner.Publish(&frame, 1), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(other.Read(readFrames, 4, &readNb), BRG_NO_ERR);
+
+	// Mapping of the late client: frame slot 0 in its first page, the transmit cells after
+	// the frame ring, beyond it
+	snprintf(shmName, sizeof(shmName), "/%s", g_busName);
+	fd = shm_open(shmName, O_RDWR, 0);
+	BRG_TEST_CHECK(fd >= 0);
+	BRG_TEST_CHECK(fstat(fd, &shmStat) == 0);
+	close(fd);
+	BRG_TEST_CHECK(late.Peek() != NULL);
+	g_pProtected = (uint8_t*)((uintptr_t)late.Peek() & ~(uintptr_t)(pageSize - 1)) + pageSize;
+	g_protectedSize = (size_t)shmStat.st_size - pageSize;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = StallWriter;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGSEGV, &action, &oldSegv);
+	sigaction(SIGBUS, &action, &oldBus);
+	BRG_TEST_CHECK(mprotect(g_pProtected, g_protectedSize, PROT_READ) == 0);
+
+	// Late client stalled after its claim of cell 0, skipped by the owner
+	std::thread writer([&late, &lateMsg, &lateStat]() {
+		lateStat = late.SubmitCAN(&lateMsg, NULL, 0);
+	});
+	while( g_bFaulted.load() == false ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	writeNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_MSG_CAN);
+	do {
+		BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 0);
+		owner.GetStats(&stats);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	} while( stats.TxSkippedNb == 0 );
+
+	// Cells 1 then 0 reused by the other client, then the late client resumes
+	BRG_TEST_CHECK_EQ(other.SubmitCAN(&otherMsg, NULL, 0), BRG_NO_ERR);
+	otherMsg.ID++;
+	BRG_TEST_CHECK_EQ(other.SubmitCAN(&otherMsg, NULL, 0), BRG_NO_ERR);
+	g_bResume.store(true);
+	writer.join();
+	sigaction(SIGSEGV, &oldSegv, NULL);
+	sigaction(SIGBUS, &oldBus, NULL);
+
+	BRG_TEST_CHECK_EQ(lateStat, BRG_OVERRUN_ERR);
+	late.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.SubmittedNb, 0);
+	BRG_TEST_CHECK_EQ(stats.RejectedNb, 1);
+	BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 2);
+	BRG_TEST_CHECK_EQ(owner.ServiceTx(Bridge), 0);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_MSG_CAN) - writeNb, 2);
+	BRG_TEST_CHECK_EQ(other.Read(readFrames, 4, &readNb), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(readNb, 2);
+	for( i = 0; i < readNb; i++ ) {
+		BRG_TEST_CHECK_EQ(readFrames[i].Direction, BRG_SHMBUS_TX);
+		BRG_TEST_CHECK_EQ(readFrames[i].SourceId, other.GetClientId());
+		BRG_TEST_CHECK_EQ(readFrames[i].Frame.ID, 0x0B0 + i);
+	}
+	owner.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.TxSkippedNb, 1);
+	BRG_TEST_CHECK_EQ(stats.TxWrittenNb, 2);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	snprintf(g_busName, sizeof(g_busName), "brg_test_%d", (int)getpid());
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestLiveOwner();
+	TestStaleOwner();
+	TestOpenChecks();
+	TestDeadClient(bridge);
+	TestDelayedClient(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
@@ -0,0 +1,251 @@
+/**
+  ******************************************************************************
+  * @file    test_spi_flash.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgSpiFlash on a simulated SPI NOR flash: capacity decoding, 4-byte
+  *          addressing, programming statistics after a failure.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <map>
+#include <vector>
+#include "brg_test.h"
+#include "brg_spi_flash.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_SPI_KHZ       12000
+#define TEST_BUSY_BYTES    40    // status bytes read with WIP set after a program/erase
+
+/* Private classes -----------------------------------------------------------*/
+// JEDEC SPI NOR flash: 3 or 4-byte address commands, sparse content (4 KB sectors)
+class SimSpiFlash : public BrgSimSpiDevice
+{
+public:
+	SimSpiFlash(uint8_t Manuf, uint8_t Type, uint8_t Capacity):
+		m_pageProgNb(0), m_bSelected(false), m_bWel(false), m_busyBytes(0), m_readAddr(0), m_statusNb(0),
+		m_ignoredPageNb(0)
+	{
+		m_id[0] = Manuf; m_id[1] = Type; m_id[2] = Capacity;
+	}
+	void Select(bool bSelected) {
+		if( (m_bSelected == true) && (bSelected == false) ) {
+			EndFrame();
+		}
+		if( bSelected == true ) {
+			m_frame.clear();
+			m_statusNb = 0;
+		}
+		m_bSelected = bSelected;
+	}
+	void Write(const uint8_t *pData, uint32_t Size) {
+		if( m_bSelected == true ) {
+			m_frame.insert(m_frame.end(), pData, pData + Size);
+		}
+	}
+	void Read(uint8_t *pData, uint32_t Size) {
+		uint8_t cmd = (m_frame.empty() == true) ? 0 : m_frame[0];
+
+		for( uint32_t i = 0; i < Size; i++ ) {
+			if( cmd == 0x9F ) {
+				pData[i] = (m_statusNb < 3) ? m_id[m_statusNb] : 0;
+				m_statusNb++;
+			} else if( cmd == 0x05 ) {
+				pData[i] = (m_busyBytes != 0) ? 0x03 : (m_bWel ? 0x02 : 0x00);
+				if( m_busyBytes != 0 ) {
+					m_busyBytes--;
+				}
+			} else if( (cmd == 0x03) || (cmd == 0x13) ) {
+				if( m_statusNb == 0 ) {
+					m_readAddr = Addr(cmd == 0x13);
+				}
+				pData[i] = Byte(m_readAddr + m_statusNb);
+				m_statusNb++;
+			} else {
+				pData[i] = 0xFF;
+			}
+		}
+	}
+	// Next PageNb page programs are ignored (flash wear-out)
+	void IgnorePagePrograms(uint32_t PageNb) { m_ignoredPageNb = PageNb; }
+	uint8_t Byte(uint32_t Addr) {
+		std::map<uint32_t, std::vector<uint8_t> >::iterator it = m_sectors.find(Addr / 4096);
+		return (it == m_sectors.end()) ? 0xFF : it->second[Addr % 4096];
+	}
+	uint32_t m_pageProgNb;
+
+private:
+	uint32_t Addr(bool b4Byte) const {
+		if( b4Byte == true ) {
+			return ((uint32_t)m_frame[1] << 24) | ((uint32_t)m_frame[2] << 16) | ((uint32_t)m_frame[3] << 8) | m_frame[4];
+		}
+		return ((uint32_t)m_frame[1] << 16) | ((uint32_t)m_frame[2] << 8) | m_frame[3];
+	}
+	std::vector<uint8_t>& Sector(uint32_t Addr) {
+		std::vector<uint8_t> &sector = m_sectors[Addr / 4096];
+		if( sector.empty() == true ) {
+			sector.assign(4096, 0xFF);
+		}
+		return sector;
+	}
+	void EndFrame(void) {
+		bool b4Byte;
+		uint32_t addr, hdr;
+
+		if( m_frame.empty() == true ) {
+			return;
+		}
+		b4Byte = (m_frame[0] == 0x12) || (m_frame[0] == 0x21);
+		hdr = b4Byte ? 5 : 4;
+		if( m_frame[0] == 0x06 ) {
+			m_bWel = true;
+		} else if( ((m_frame[0] == 0x02) || (m_frame[0] == 0x12)) && m_bWel && (m_frame.size() > hdr) ) {
+			addr = Addr(b4Byte);
+			m_pageProgNb++;
+			if( m_ignoredPageNb != 0 ) {
+				m_ignoredPageNb--;
+			} else {
+				std::vector<uint8_t> &sector = Sector(addr);
+				for( uint32_t i = 0; i < m_frame.size() - hdr; i++ ) {
+					// Wraps within the 256-byte page, bits only cleared
+					sector[(addr & 0xF00) + ((addr + i) & 0xFF)] &= m_frame[hdr + i];
+				}
+			}
+			m_bWel = false;
+			m_busyBytes = TEST_BUSY_BYTES;
+		} else if( ((m_frame[0] == 0x20) || (m_frame[0] == 0x21)) && m_bWel && (m_frame.size() >= hdr) ) {
+			Sector(Addr(b4Byte)).assign(4096, 0xFF);
+			m_bWel = false;
+			m_busyBytes = TEST_BUSY_BYTES;
+		}
+	}
+
+	uint8_t m_id[3];
+	bool m_bSelected;
+	bool m_bWel;
+	uint32_t m_busyBytes;
+	uint32_t m_readAddr;
+	uint32_t m_statusNb;   // bytes read in the current frame
+	uint32_t m_ignoredPageNb;
+	std::vector<uint8_t> m_frame;
+	std::map<uint32_t, std::vector<uint8_t> > m_sectors;
+};
+
+/* Private functions ---------------------------------------------------------*/
+static void TestProbe(Brg &Bridge, uint8_t Manuf, uint8_t Type, uint8_t Capacity,
+                      Brg_StatusT ExpectedStat, uint32_t ExpectedSize, bool bExpected4Byte)
+{
+	SimSpiFlash flash(Manuf, Type, Capacity);
+	BrgSpiFlash spiFlash(Bridge, TEST_SPI_KHZ);
+	Brg_SpiFlashInfoT info;
+
+	memset(&info, 0, sizeof(info));
+	BrgSimSetSpiDevice(&flash);
+	BRG_TEST_CHECK_EQ(spiFlash.Probe(&info), ExpectedStat);
+	if( ExpectedStat == BRG_NO_ERR ) {
+		BRG_TEST_CHECK_EQ(info.SizeInBytes, ExpectedSize);
+		BRG_TEST_CHECK_EQ(info.bAddr4Byte, bExpected4Byte);
+	}
+	BrgSimSetSpiDevice(NULL);
+}
+
+// 512 Mbit part: programmed above 16 MBytes with the 4-byte address commands
+static void TestProgram4Byte(Brg &Bridge)
+{
+	SimSpiFlash flash(0x20, 0xBA, 0x20);
+	BrgSpiFlash spiFlash(Bridge, TEST_SPI_KHZ);
+	std::vector<uint8_t> data(3*4096 + 100), readBack(data.size());
+	uint32_t addr = 0x02000000 + 50;
+	Brg_SpiFlashStatsT stats;
+
+	for( size_t i = 0; i < data.size(); i++ ) {
+		data[i] = (uint8_t)(i * 7 + 1);
+	}
+	BrgSimSetSpiDevice(&flash);
+	BRG_TEST_CHECK_EQ(spiFlash.Probe(NULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(spiFlash.Program(addr, data.data(), (uint32_t)data.size()), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(spiFlash.Read(addr, readBack.data(), (uint32_t)readBack.size()), BRG_NO_ERR);
+	BRG_TEST_CHECK(memcmp(readBack.data(), data.data(), data.size()) == 0);
+	BRG_TEST_CHECK_EQ(flash.Byte(addr), data[0]);       // really at the 4-byte address
+	BRG_TEST_CHECK_EQ(flash.Byte(addr - 0x02000000), 0xFF);
+	spiFlash.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.ProgBytes, data.size());
+	BRG_TEST_CHECK_EQ(stats.SectorEraseNb, 0); // blank flash
+	BrgSimSetSpiDevice(NULL);
+}
+
+// A page program lost in the second sector: only the first sector counts as programmed
+static void TestProgBytesOnFailure(Brg &Bridge)
+{
+	SimSpiFlash flash(0xEF, 0x40, 0x18);
+	BrgSpiFlash spiFlash(Bridge, TEST_SPI_KHZ);
+	std::vector<uint8_t> data(3*4096, 0x5A);
+	Brg_SpiFlashStatsT stats;
+
+	BrgSimSetSpiDevice(&flash);
+	BRG_TEST_CHECK_EQ(spiFlash.Probe(NULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(spiFlash.Program(0, data.data(), 4096), BRG_NO_ERR);
+	flash.IgnorePagePrograms(1); // first page of the second sector
+	BRG_TEST_CHECK_EQ(spiFlash.Program(4096, data.data(), 2*4096), BRG_VERIF_ERR);
+	spiFlash.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.ProgBytes, 4096);
+	BRG_TEST_CHECK_EQ(flash.m_pageProgNb, 2*16); // stopped after the failing sector
+	BrgSimSetSpiDevice(NULL);
+}
+
+// Empty range at an unaligned address: nothing erased, a 1-byte range erases its sector
+static void TestEraseEmptyRange(Brg &Bridge)
+{
+	SimSpiFlash flash(0xEF, 0x40, 0x18);
+	BrgSpiFlash spiFlash(Bridge, TEST_SPI_KHZ);
+	std::vector<uint8_t> data(4096, 0x5A);
+	Brg_SpiFlashStatsT stats;
+
+	BrgSimSetSpiDevice(&flash);
+	BRG_TEST_CHECK_EQ(spiFlash.Probe(NULL), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(spiFlash.Program(4096, data.data(), 4096), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(spiFlash.Erase(4096 + 100, 0), BRG_NO_ERR);
+	spiFlash.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.SectorEraseNb, 0);
+	BRG_TEST_CHECK_EQ(flash.Byte(4096), 0x5A);
+	BRG_TEST_CHECK_EQ(flash.Byte(4096 + 100), 0x5A);
+	BRG_TEST_CHECK_EQ(spiFlash.Erase(4096 + 100, 1), BRG_NO_ERR);
+	spiFlash.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.SectorEraseNb, 1);
+	BRG_TEST_CHECK_EQ(flash.Byte(4096), 0xFF);
+	BRG_TEST_CHECK_EQ(flash.Byte(8191), 0xFF);
+	BrgSimSetSpiDevice(NULL);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestProbe(bridge, 0xEF, 0x40, 0x18, BRG_NO_ERR, 16*1024*1024, false);     // 128 Mbit
+	TestProbe(bridge, 0xEF, 0x40, 0x19, BRG_NO_ERR, 32*1024*1024, true);      // 256 Mbit
+	TestProbe(bridge, 0x20, 0xBA, 0x20, BRG_NO_ERR, 64*1024*1024, true);      // 512 Mbit
+	TestProbe(bridge, 0x01, 0x02, 0x20, BRG_NO_ERR, 64*1024*1024, true);      // 512 Mbit
+	TestProbe(bridge, 0x20, 0xBA, 0x22, BRG_NO_ERR, 256*1024*1024, true);     // 2 Gbit
+	TestProbe(bridge, 0xC2, 0x25, 0x3A, BRG_NO_ERR, 64*1024*1024, true);      // 512 Mbit
+	TestProbe(bridge, 0xC2, 0x25, 0x37, BRG_NO_ERR, 8*1024*1024, false);      // 64 Mbit
+	TestProbe(bridge, 0xEF, 0x40, 0x0F, BRG_TARGET_CMD_ERR, 0, false);
+	TestProbe(bridge, 0xEF, 0x40, 0x23, BRG_TARGET_CMD_ERR, 0, false);
+	TestProbe(bridge, 0xFF, 0xFF, 0xFF, BRG_TARGET_CMD_ERR, 0, false);
+	TestProgram4Byte(bridge);
+	TestProgBytesOnFailure(bridge);
+	TestEraseEmptyRange(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
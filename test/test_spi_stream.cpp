@@ -0,0 +1,173 @@
+/**
+  ******************************************************************************
+  * @file    test_spi_stream.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   Brg::ReadStreamSPI()/WriteStreamSPI(): an error in any chunk is reported
+  *          and only the chunks checked without error are counted; throughput
+  *          against ReadSPI()/WriteSPI() loops.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <chrono>
+#include <vector>
+#include "brg_test.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_CHUNK_SIZE   4096
+#define TEST_CHUNK_NB     10
+#define TEST_SIZE         (TEST_CHUNK_SIZE * TEST_CHUNK_NB)
+#define TEST_RATE_SIZE    (2 * 1024 * 1024)
+#define TEST_RATE_RUN_NB  3      // best of, the host load only slows a run down
+#define TEST_USB_US       125    // round trip of one USB command
+#define TEST_USB_RATE     40000  // USB high speed data phase, bytes per ms
+
+/* Private functions ---------------------------------------------------------*/
+// Error in chunk FailChunk (1: first) followed by successful chunks
+static void TestReadError(Brg &Bridge, uint32_t FailChunk)
+{
+	std::vector<uint8_t> buffer(TEST_SIZE);
+	uint32_t sizeRead = 0xFFFFFFFF;
+
+	BrgSimFailCmd(STLINK_BRIDGE_READ_SPI, FailChunk, STLINK_BRIDGE_SPI_ERROR);
+	BRG_TEST_CHECK_EQ(Bridge.ReadStreamSPI(buffer.data(), TEST_SIZE, &sizeRead, TEST_CHUNK_SIZE), BRG_SPI_ERR);
+	BRG_TEST_CHECK_EQ(sizeRead, (FailChunk - 1) * TEST_CHUNK_SIZE);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI), FailChunk); // stopped at the error
+}
+
+static void TestWriteError(Brg &Bridge, uint32_t FailChunk)
+{
+	std::vector<uint8_t> buffer(TEST_SIZE);
+	uint32_t sizeWritten = 0xFFFFFFFF;
+	uint32_t chunkSize = 8 + TEST_CHUNK_SIZE; // rounded to 8 + USB packets
+
+	BrgSimFailCmd(STLINK_BRIDGE_WRITE_SPI, FailChunk, STLINK_BRIDGE_SPI_ERROR);
+	BRG_TEST_CHECK_EQ(Bridge.WriteStreamSPI(buffer.data(), TEST_SIZE, &sizeWritten, (uint16_t)chunkSize), BRG_SPI_ERR);
+	BRG_TEST_CHECK_EQ(sizeWritten, (FailChunk - 1) * chunkSize);
+}
+
+// Best MB/s of Transfer over TEST_RATE_SIZE bytes
+template<typename TransferT>
+static double MeasureRate(TransferT Transfer)
+{
+	std::chrono::steady_clock::time_point start;
+	double us, rate = 0;
+
+	for( int i = 0; i < TEST_RATE_RUN_NB; i++ ) {
+		start = std::chrono::steady_clock::now();
+		Transfer();
+		us = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		if( (double)TEST_RATE_SIZE / us > rate ) {
+			rate = (double)TEST_RATE_SIZE / us;
+		}
+	}
+	return rate;
+}
+
+// ReadSPI()/WriteSPI() loop of ChunkSize bytes
+static void ReadLoop(Brg &Bridge, uint8_t *pBuffer, uint16_t ChunkSize)
+{
+	uint16_t sizeRead = 0;
+
+	for( uint32_t done = 0; done < TEST_RATE_SIZE; done += ChunkSize ) {
+		uint16_t size = (TEST_RATE_SIZE - done > ChunkSize) ? ChunkSize : (uint16_t)(TEST_RATE_SIZE - done);
+		BRG_TEST_CHECK_EQ(Bridge.ReadSPI(&pBuffer[done], size, &sizeRead), BRG_NO_ERR);
+	}
+}
+
+static void WriteLoop(Brg &Bridge, const uint8_t *pBuffer, uint16_t ChunkSize)
+{
+	uint16_t sizeWritten = 0;
+
+	for( uint32_t done = 0; done < TEST_RATE_SIZE; done += ChunkSize ) {
+		uint16_t size = (TEST_RATE_SIZE - done > ChunkSize) ? ChunkSize : (uint16_t)(TEST_RATE_SIZE - done);
+		BRG_TEST_CHECK_EQ(Bridge.WriteSPI(&pBuffer[done], size, &sizeWritten), BRG_NO_ERR);
+	}
+}
+
+// Streams against ReadSPI()/WriteSPI() loops of 4 KiB and of the stream chunk size: the
+// status round trip after each chunk is kept, so a stream is as fast as the large chunk
+// loop (same commands), not faster
+static void TestThroughput(Brg &Bridge)
+{
+	std::vector<uint8_t> buffer(TEST_RATE_SIZE);
+	uint32_t size = 0;
+	uint64_t loopCmdNb, streamCmdNb;
+	double read4k, readLoop, readStream, write4k, writeLoop, writeStream;
+
+	BrgSimSetLatency(TEST_USB_US, 0);
+	BrgSimSetUsbRate(TEST_USB_RATE);
+	read4k = MeasureRate([&]() { ReadLoop(Bridge, buffer.data(), 4096); });
+	loopCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI);
+	readLoop = MeasureRate([&]() { ReadLoop(Bridge, buffer.data(), BRG_SPI_STREAM_CHUNK_SIZE - 8); });
+	loopCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI) - loopCmdNb;
+	streamCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI);
+	readStream = MeasureRate([&]() {
+		BRG_TEST_CHECK_EQ(Bridge.ReadStreamSPI(buffer.data(), TEST_RATE_SIZE, &size), BRG_NO_ERR);
+	});
+	streamCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI) - streamCmdNb;
+	BRG_TEST_CHECK_EQ(size, TEST_RATE_SIZE);
+	BRG_TEST_CHECK_EQ(streamCmdNb, loopCmdNb);
+
+	write4k = MeasureRate([&]() { WriteLoop(Bridge, buffer.data(), 4096); });
+	loopCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_SPI);
+	writeLoop = MeasureRate([&]() { WriteLoop(Bridge, buffer.data(), BRG_SPI_STREAM_CHUNK_SIZE); });
+	loopCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_SPI) - loopCmdNb;
+	streamCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_SPI);
+	writeStream = MeasureRate([&]() {
+		BRG_TEST_CHECK_EQ(Bridge.WriteStreamSPI(buffer.data(), TEST_RATE_SIZE, &size), BRG_NO_ERR);
+	});
+	streamCmdNb = BrgSimGetCmdNb(STLINK_BRIDGE_WRITE_SPI) - streamCmdNb;
+	BRG_TEST_CHECK_EQ(size, TEST_RATE_SIZE);
+	BRG_TEST_CHECK_EQ(streamCmdNb, loopCmdNb);
+	BrgSimSetLatency(0, 0);
+	BrgSimSetUsbRate(0);
+
+	printf("SPI read  MB/s: ReadSPI 4 KiB %.1f, ReadSPI %d %.1f, ReadStreamSPI %.1f\n",
+	       read4k, BRG_SPI_STREAM_CHUNK_SIZE - 8, readLoop, readStream);
+	printf("SPI write MB/s: WriteSPI 4 KiB %.1f, WriteSPI %d %.1f, WriteStreamSPI %.1f\n",
+	       write4k, BRG_SPI_STREAM_CHUNK_SIZE, writeLoop, writeStream);
+	// Same commands as the large chunk loop (checked above): the rates only catch a gross
+	// regression, the host load moves them
+	BRG_TEST_CHECK(readStream > 1.5 * read4k);
+	BRG_TEST_CHECK(readStream > 0.6 * readLoop);
+	BRG_TEST_CHECK(writeStream > 1.5 * write4k);
+	BRG_TEST_CHECK(writeStream > 0.6 * writeLoop);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	std::vector<uint8_t> buffer(TEST_SIZE);
+	uint32_t size = 0;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	// No error: one status check per chunk
+	BRG_TEST_CHECK_EQ(bridge.ReadStreamSPI(buffer.data(), TEST_SIZE, &size, TEST_CHUNK_SIZE), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(size, TEST_SIZE);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_READ_SPI), TEST_CHUNK_NB);
+	BRG_TEST_CHECK_EQ(BrgSimGetCmdNb(STLINK_BRIDGE_GET_RWCMD_STATUS), TEST_CHUNK_NB);
+
+	// Error in the first chunk, in the middle and in the last one: never masked by the
+	// following successful chunks
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestReadError(bridge, 1);
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestReadError(bridge, 3);
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	TestReadError(bridge, TEST_CHUNK_NB);
+	TestWriteError(bridge, 2);
+	TestThroughput(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
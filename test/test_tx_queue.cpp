@@ -0,0 +1,306 @@
+/**
+  ******************************************************************************
+  * @file    test_tx_queue.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgTxQueue: per-producer order with concurrent producers, full ring
+  *          (overrun) counting, drain and discard at Stop(), strict priority
+  *          order and control frame latency behind a bulk backlog.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "brg_test.h"
+#include "brg_tx_queue.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_PRODUCER_NB     4
+#define TEST_FRAME_NB        2000  // per producer
+#define TEST_USB_US          150   // round trip of one USB command
+#define TEST_BULK_BACKLOG    3000  // bulk frames kept queued
+#define TEST_BULK_RUN_MS     1500
+#define TEST_CONTROL_MS      10    // control frame period
+
+/* Private typedef -----------------------------------------------------------*/
+// Frame seen on the wire: CAN ID and first two data bytes (frame number)
+typedef struct {
+	uint32_t Id;
+	uint16_t Nb;
+} TestWireFrameT;
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_wireMutex;
+static std::vector<TestWireFrameT> g_wire;
+
+/* Private functions ---------------------------------------------------------*/
+// Simulator hook: records the WRITE_MSG_CAN commands in bus order
+static void RecordWrite(const STLink_DeviceRequestT *pRequest)
+{
+	TestWireFrameT frame;
+
+	if( (pRequest->CDBByte[0] != STLINK_BRIDGE_COMMAND) || (pRequest->CDBByte[1] != STLINK_BRIDGE_WRITE_MSG_CAN) ) {
+		return;
+	}
+	memcpy(&frame.Id, &pRequest->CDBByte[2], 4);
+	frame.Nb = (uint16_t)(pRequest->CDBByte[8] | (pRequest->CDBByte[9] << 8));
+	std::lock_guard<std::mutex> lock(g_wireMutex);
+	g_wire.push_back(frame);
+}
+
+static void ClearWire(void)
+{
+	std::lock_guard<std::mutex> lock(g_wireMutex);
+	g_wire.clear();
+}
+
+static Brg_StatusT PushNb(BrgTxQueue &Queue, uint32_t Id, uint16_t Nb, Brg_TxPriorityT Priority)
+{
+	Brg_CanTxMsgT msg = { CAN_ID_STANDARD, Id, CAN_DATA_FRAME, 2 };
+	uint8_t data[2] = { (uint8_t)Nb, (uint8_t)(Nb >> 8) };
+
+	return Queue.PushCAN(&msg, data, 2, Priority);
+}
+
+// Producers pushing at the same time: every frame written once, in its producer's order
+static void TestProducerOrder(Brg &Bridge)
+{
+	BrgTxQueue queue(Bridge, TEST_PRODUCER_NB * TEST_FRAME_NB);
+	std::vector<std::thread> producers;
+	int pushErrNb[TEST_PRODUCER_NB] = { 0 };
+	uint32_t nextNb[TEST_PRODUCER_NB] = { 0 };
+	Brg_TxQueueStatsT stats;
+	bool bOrdered = true;
+
+	ClearWire();
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	for( int p = 0; p < TEST_PRODUCER_NB; p++ ) {
+		producers.push_back(std::thread([&queue, &pushErrNb, p]() {
+			for( int i = 0; i < TEST_FRAME_NB; i++ ) {
+				if( PushNb(queue, 0x100 + p, (uint16_t)i, BRG_TX_PRIO_NORMAL) != BRG_NO_ERR ) {
+					pushErrNb[p]++;
+				}
+			}
+		}));
+	}
+	for( size_t p = 0; p < producers.size(); p++ ) {
+		producers[p].join();
+	}
+	BRG_TEST_CHECK_EQ(queue.Stop(true), BRG_NO_ERR);
+
+	std::lock_guard<std::mutex> lock(g_wireMutex);
+	BRG_TEST_CHECK_EQ(g_wire.size(), TEST_PRODUCER_NB * TEST_FRAME_NB);
+	for( size_t i = 0; i < g_wire.size(); i++ ) {
+		uint32_t p = g_wire[i].Id - 0x100;
+		if( (p >= TEST_PRODUCER_NB) || (g_wire[i].Nb != nextNb[p]) ) {
+			bOrdered = false;
+			break;
+		}
+		nextNb[p]++;
+	}
+	BRG_TEST_CHECK(bOrdered);
+	for( int p = 0; p < TEST_PRODUCER_NB; p++ ) {
+		BRG_TEST_CHECK_EQ(pushErrNb[p], 0);
+	}
+	queue.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.Total.EnqueuedNb, TEST_PRODUCER_NB * TEST_FRAME_NB);
+	BRG_TEST_CHECK_EQ(stats.Total.SentNb, TEST_PRODUCER_NB * TEST_FRAME_NB);
+	BRG_TEST_CHECK_EQ(stats.Total.DroppedFullNb, 0);
+	BRG_TEST_CHECK_EQ(stats.Total.Depth, 0);
+}
+
+// Full ring, writer not started: concurrent producers get exactly the capacity accepted
+static void TestOverrun(Brg &Bridge)
+{
+	BrgTxQueue queue(Bridge, 16);
+	std::vector<std::thread> producers;
+	int acceptedNb[TEST_PRODUCER_NB] = { 0 };
+	int overrunNb[TEST_PRODUCER_NB] = { 0 };
+	int accepted = 0, overrun = 0;
+	Brg_TxQueueStatsT stats;
+
+	ClearWire();
+	for( int p = 0; p < TEST_PRODUCER_NB; p++ ) {
+		producers.push_back(std::thread([&queue, &acceptedNb, &overrunNb, p]() {
+			for( int i = 0; i < 10; i++ ) {
+				Brg_StatusT brgStat = PushNb(queue, 0x200 + p, (uint16_t)i, BRG_TX_PRIO_BULK);
+				if( brgStat == BRG_NO_ERR ) {
+					acceptedNb[p]++;
+				} else if( brgStat == BRG_OVERRUN_ERR ) {
+					overrunNb[p]++;
+				}
+			}
+		}));
+	}
+	for( size_t p = 0; p < producers.size(); p++ ) {
+		producers[p].join();
+	}
+	for( int p = 0; p < TEST_PRODUCER_NB; p++ ) {
+		accepted += acceptedNb[p];
+		overrun += overrunNb[p];
+	}
+	BRG_TEST_CHECK_EQ(accepted, 16);
+	BRG_TEST_CHECK_EQ(overrun, TEST_PRODUCER_NB * 10 - 16);
+	queue.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_BULK].DroppedFullNb, (uint64_t)overrun);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_BULK].Depth, 16);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_BULK].MaxDepth, 16);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_NORMAL].Depth, 0);
+	// Other classes have their own ring
+	BRG_TEST_CHECK_EQ(PushNb(queue, 0x300, 0, BRG_TX_PRIO_NORMAL), BRG_NO_ERR);
+
+	// Drained at Stop(), the ring is usable again
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(queue.Stop(true), BRG_NO_ERR);
+	queue.GetStats(&stats);
+	BRG_TEST_CHECK_EQ(stats.Total.SentNb, 17);
+	BRG_TEST_CHECK_EQ(stats.Total.Depth, 0);
+	BRG_TEST_CHECK_EQ(PushNb(queue, 0x200, 0, BRG_TX_PRIO_BULK), BRG_NO_ERR);
+}
+
+// Stop() without drain: queued frames are discarded, not written
+static void TestDiscard(Brg &Bridge)
+{
+	BrgTxQueue queue(Bridge, 16);
+	Brg_TxQueueStatsT stats;
+
+	BrgSimSetLatency(2000, 0);
+	ClearWire();
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	for( int i = 0; i < 10; i++ ) {
+		BRG_TEST_CHECK_EQ(PushNb(queue, 0x400, (uint16_t)i, BRG_TX_PRIO_NORMAL), BRG_NO_ERR);
+	}
+	BRG_TEST_CHECK_EQ(queue.Stop(false), BRG_NO_ERR);
+	BrgSimSetLatency(0, 0);
+	queue.GetStats(&stats);
+	BRG_TEST_CHECK(stats.Total.DiscardedNb > 0);
+	BRG_TEST_CHECK_EQ(stats.Total.SentNb + stats.Total.WriteErrorNb + stats.Total.DiscardedNb, 10);
+	std::lock_guard<std::mutex> lock(g_wireMutex);
+	BRG_TEST_CHECK_EQ(g_wire.size(), 10 - stats.Total.DiscardedNb);
+}
+
+// Frames queued before the writer starts: written class by class, FIFO within a class
+static void TestPriorityOrder(Brg &Bridge)
+{
+	BrgTxQueue queue(Bridge, 64);
+	std::vector<TestWireFrameT> expected[BRG_TX_PRIO_NB];
+	Brg_TxQueueStatsT stats;
+	TestWireFrameT frame;
+	size_t pos = 0;
+	bool bOrdered = true;
+
+	ClearWire();
+	for( uint16_t i = 0; i < 12; i++ ) {
+		frame.Id = 0x500; frame.Nb = i;
+		expected[BRG_TX_PRIO_BULK].push_back(frame);
+		BRG_TEST_CHECK_EQ(PushNb(queue, frame.Id, frame.Nb, BRG_TX_PRIO_BULK), BRG_NO_ERR);
+		if( (i % 2) == 1 ) {
+			frame.Id = 0x100;
+			expected[BRG_TX_PRIO_NORMAL].push_back(frame);
+			BRG_TEST_CHECK_EQ(PushNb(queue, frame.Id, frame.Nb, BRG_TX_PRIO_NORMAL), BRG_NO_ERR);
+		}
+		if( (i % 3) == 2 ) {
+			frame.Id = 0x069;
+			expected[BRG_TX_PRIO_CONTROL].push_back(frame);
+			BRG_TEST_CHECK_EQ(PushNb(queue, frame.Id, frame.Nb, BRG_TX_PRIO_CONTROL), BRG_NO_ERR);
+		}
+	}
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(queue.Stop(true), BRG_NO_ERR);
+
+	std::lock_guard<std::mutex> lock(g_wireMutex);
+	BRG_TEST_CHECK_EQ(g_wire.size(), 12 + 6 + 4);
+	for( int prio = 0; prio < BRG_TX_PRIO_NB; prio++ ) {
+		for( size_t i = 0; i < expected[prio].size(); i++, pos++ ) {
+			if( (pos >= g_wire.size()) || (g_wire[pos].Id != expected[prio][i].Id) ||
+			    (g_wire[pos].Nb != expected[prio][i].Nb) ) {
+				bOrdered = false;
+			}
+		}
+	}
+	BRG_TEST_CHECK(bOrdered);
+	queue.GetStats(&stats);
+	// Every control and normal frame overtook waiting bulk frames
+	BRG_TEST_CHECK_EQ(stats.PreemptedNb, 4 + 6);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_CONTROL].SentNb, 4);
+}
+
+// Control frames behind a saturated bulk stream wait at most for the write in progress
+static void TestControlLatency(Brg &Bridge)
+{
+	BrgTxQueue queue(Bridge, 4096);
+	std::atomic<bool> bRun(true);
+	Brg_TxQueueStatsT stats;
+	const Brg_LatencySummaryT *pControl, *pBulk;
+	uint16_t bulkNb = 0, controlNb = 0;
+	std::chrono::steady_clock::time_point end;
+
+	BrgSimSetLatency(TEST_USB_US, 0);
+	ClearWire();
+	while( bulkNb < TEST_BULK_BACKLOG ) {
+		PushNb(queue, 0x500, bulkNb++, BRG_TX_PRIO_BULK);
+	}
+	BRG_TEST_CHECK_EQ(queue.Start(), BRG_NO_ERR);
+	// Bulk producer keeping the backlog full
+	std::thread bulk([&queue, &bRun, &bulkNb]() {
+		while( bRun.load() == true ) {
+			if( queue.GetDepth(BRG_TX_PRIO_BULK) < TEST_BULK_BACKLOG ) {
+				PushNb(queue, 0x500, bulkNb++, BRG_TX_PRIO_BULK);
+			} else {
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	});
+	end = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_BULK_RUN_MS);
+	while( std::chrono::steady_clock::now() < end ) {
+		BRG_TEST_CHECK_EQ(PushNb(queue, 0x069, controlNb++, BRG_TX_PRIO_CONTROL), BRG_NO_ERR);
+		std::this_thread::sleep_for(std::chrono::milliseconds(TEST_CONTROL_MS));
+	}
+	bRun.store(false);
+	bulk.join();
+	BRG_TEST_CHECK_EQ(queue.Stop(false), BRG_NO_ERR);
+	BrgSimSetLatency(0, 0);
+
+	queue.GetStats(&stats);
+	pControl = &stats.Class[BRG_TX_PRIO_CONTROL].EnqueueToWire;
+	pBulk = &stats.Class[BRG_TX_PRIO_BULK].EnqueueToWire;
+	printf("%u us per USB command, %u bulk frames queued, control frame every %u ms:\n",
+	       TEST_USB_US, TEST_BULK_BACKLOG, TEST_CONTROL_MS);
+	printf("  control: %llu frames, p50 %llu us, p99 %llu us\n", (unsigned long long)pControl->Count,
+	       (unsigned long long)pControl->P50Us, (unsigned long long)pControl->P99Us);
+	printf("  bulk:    %llu frames, p50 %llu us\n", (unsigned long long)pBulk->Count,
+	       (unsigned long long)pBulk->P50Us);
+	BRG_TEST_CHECK_EQ(stats.Class[BRG_TX_PRIO_CONTROL].SentNb, controlNb);
+	BRG_TEST_CHECK(pControl->P99Us < 20000);
+	BRG_TEST_CHECK(pBulk->P50Us > 100 * pControl->P50Us);
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BrgSimSetCanLoopback(false);
+	BrgSimSetHook(RecordWrite);
+	TestProducerOrder(bridge);
+	TestOverrun(bridge);
+	TestDiscard(bridge);
+	TestPriorityOrder(bridge);
+	TestControlLatency(bridge);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/
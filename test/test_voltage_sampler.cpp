@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file    test_voltage_sampler.cpp
+  * @author  GPM-AppliTools-HWBoards Team
+  * @brief   BrgVoltageSampler on the simulated bridge: no sample while another
+  *          thread holds the transaction lock, samples only after IdleGapUs
+  *          without bridge command, skipped when no idle slot comes.
+  ******************************************************************************
+  * @attention
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "brg_test.h"
+#include "brg_voltage_sampler.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_USB_US         100   // round trip of one USB command
+#define TEST_PERIOD_MS      5
+#define TEST_LOCK_MS        60    // transaction lock held by the test
+#define TEST_TRAFFIC_MS     100   // lane-like traffic: one command per TEST_PAUSE_US
+#define TEST_PAUSE_US       300
+#define TEST_SHORT_GAP_US   100   // shorter than the traffic pauses
+#define TEST_LONG_GAP_US    5000  // longer than the traffic pauses
+
+/* Private typedef -----------------------------------------------------------*/
+// Command seen by the simulated bridge
+typedef struct {
+	bool bVoltage;  // GET_TARGET_VOLTAGE (sampler), else a command of the test
+	uint64_t Us;    // command start
+} TestCmdT;
+
+/* Private variables ---------------------------------------------------------*/
+static std::mutex g_cmdMutex;
+static std::vector<TestCmdT> g_cmds;
+
+/* Private functions ---------------------------------------------------------*/
+static void RecordCmd(const STLink_DeviceRequestT *pRequest)
+{
+	TestCmdT cmd;
+
+	cmd.bVoltage = (pRequest->CDBByte[0] == STLINK_GET_TARGET_VOLTAGE);
+	cmd.Us = BrgGetMonotonicUs();
+	std::lock_guard<std::mutex> lock(g_cmdMutex);
+	g_cmds.push_back(cmd);
+}
+
+// Commands recorded since the last call, in time order
+static std::vector<TestCmdT> TakeCmds(void)
+{
+	std::vector<TestCmdT> cmds;
+
+	{
+		std::lock_guard<std::mutex> lock(g_cmdMutex);
+		cmds.swap(g_cmds);
+	}
+	std::sort(cmds.begin(), cmds.end(), [](const TestCmdT &a, const TestCmdT &b) { return a.Us < b.Us; });
+	return cmds;
+}
+
+static void SetConf(Brg_VoltageSamplerConfT *pConf, uint32_t IdleGapUs)
+{
+	memset(pConf, 0, sizeof(*pConf));
+	pConf->PeriodMs = TEST_PERIOD_MS;
+	pConf->WindowNb = 16;
+	pConf->IdleGapUs = IdleGapUs;
+}
+
+// Samples taken in [StartUs, EndUs], each one at least IdleGapUs after the end of the
+// previous command of the test (its start plus the USB latency)
+static uint32_t CheckSamples(const std::vector<TestCmdT> &Cmds, uint32_t IdleGapUs, uint64_t StartUs, uint64_t EndUs)
+{
+	uint64_t lastUs = 0;
+	uint32_t sampleNb = 0;
+
+	for( size_t i = 0; i < Cmds.size(); i++ ) {
+		if( Cmds[i].bVoltage == false ) {
+			lastUs = Cmds[i].Us;
+			continue;
+		}
+		if( (Cmds[i].Us >= StartUs) && (Cmds[i].Us <= EndUs) ) {
+			sampleNb++;
+		}
+		if( lastUs != 0 ) {
+			BRG_TEST_CHECK(Cmds[i].Us >= lastUs + TEST_USB_US + IdleGapUs);
+		}
+	}
+	return sampleNb;
+}
+
+// Transaction lock held (commands sent in between): the sampler does not wait for it,
+// its samples are skipped and resume after the release
+static void TestYieldToLockHolder(Brg &Bridge)
+{
+	Brg_VoltageSamplerConfT conf;
+	Brg_VoltageStatsT before, during, after;
+	std::vector<TestCmdT> cmds;
+	uint64_t lockUs, unlockUs;
+	uint32_t clk = 0, hclk = 0;
+
+	SetConf(&conf, TEST_SHORT_GAP_US);
+	BrgVoltageSampler sampler(Bridge, &conf);
+	BRG_TEST_CHECK_EQ(sampler.Start(), BRG_NO_ERR);
+	BRG_TEST_CHECK_EQ(sampler.Start(), BRG_CMD_NOT_ALLOWED);
+	std::this_thread::sleep_for(std::chrono::milliseconds(4 * TEST_PERIOD_MS));
+	sampler.GetStats(&before);
+	TakeCmds();
+	{
+		std::lock_guard<std::recursive_mutex> lock(Bridge.GetTransactionLock());
+		lockUs = BrgGetMonotonicUs();
+		while( BrgGetMonotonicUs() - lockUs < TEST_LOCK_MS * 1000 ) {
+			BRG_TEST_CHECK_EQ(Bridge.GetClk(COM_I2C, &clk, &hclk), BRG_NO_ERR);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		sampler.GetStats(&during);
+		unlockUs = BrgGetMonotonicUs();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(4 * TEST_PERIOD_MS));
+	BRG_TEST_CHECK_EQ(sampler.Stop(), BRG_NO_ERR);
+	sampler.GetStats(&after);
+	cmds = TakeCmds();
+
+	printf("Lock held %d ms: %llu samples skipped\n", TEST_LOCK_MS,
+	       (unsigned long long)(during.SkippedNb - before.SkippedNb));
+	BRG_TEST_CHECK(before.SampleNb > 0);
+	BRG_TEST_CHECK_EQ(CheckSamples(cmds, TEST_SHORT_GAP_US, lockUs, unlockUs), 0);
+	BRG_TEST_CHECK(during.SampleNb - before.SampleNb <= 1); // taken just before the lock
+	// A skipped sample takes two periods: deferred for one, then the next period
+	BRG_TEST_CHECK(during.SkippedNb - before.SkippedNb >= TEST_LOCK_MS / (2 * TEST_PERIOD_MS) - 1);
+	BRG_TEST_CHECK(after.SampleNb > during.SampleNb);
+	BRG_TEST_CHECK_EQ(after.ErrorNb, 0);
+	BRG_TEST_CHECK(after.Last > 3.2f);
+	BRG_TEST_CHECK(after.Last < 3.4f);
+	BRG_TEST_CHECK_EQ(after.WindowNb, (after.SampleNb < 16) ? after.SampleNb : 16);
+}
+
+// Back to back commands of another thread holding the lock for each one only: samples
+// go in the pauses longer than the idle gap, skipped with a gap longer than the pauses
+static void TestIdleGap(Brg &Bridge, uint32_t IdleGapUs, uint64_t *pSampleNb, uint64_t *pSkippedNb)
+{
+	Brg_VoltageSamplerConfT conf;
+	Brg_VoltageStatsT stats;
+	std::atomic<bool> bRun(true);
+	std::vector<TestCmdT> cmds;
+	uint64_t startUs, endUs;
+
+	SetConf(&conf, IdleGapUs);
+	BrgVoltageSampler sampler(Bridge, &conf);
+	TakeCmds();
+	std::thread traffic([&Bridge, &bRun]() {
+		uint32_t clk = 0, hclk = 0;
+
+		while( bRun.load() == true ) {
+			{
+				std::lock_guard<std::recursive_mutex> lock(Bridge.GetTransactionLock());
+				Bridge.GetClk(COM_I2C, &clk, &hclk);
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(TEST_PAUSE_US));
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	startUs = BrgGetMonotonicUs();
+	BRG_TEST_CHECK_EQ(sampler.Start(), BRG_NO_ERR);
+	std::this_thread::sleep_for(std::chrono::milliseconds(TEST_TRAFFIC_MS));
+	BRG_TEST_CHECK_EQ(sampler.Stop(), BRG_NO_ERR);
+	endUs = BrgGetMonotonicUs();
+	bRun.store(false);
+	traffic.join();
+	sampler.GetStats(&stats);
+	cmds = TakeCmds();
+
+	BRG_TEST_CHECK_EQ(CheckSamples(cmds, IdleGapUs, startUs, endUs), stats.SampleNb);
+	*pSampleNb = stats.SampleNb;
+	*pSkippedNb = stats.SkippedNb;
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	STLinkInterface stlinkIf(STLINK_BRIDGE);
+	Brg bridge(stlinkIf);
+	uint64_t shortSampleNb, shortSkippedNb, longSampleNb, longSkippedNb;
+
+	BRG_TEST_CHECK_EQ(BrgTestOpen(stlinkIf, bridge), BRG_NO_ERR);
+	BrgSimSetLatency(TEST_USB_US, 0);
+	BrgSimSetHook(RecordCmd);
+	TestYieldToLockHolder(bridge);
+
+	TestIdleGap(bridge, TEST_SHORT_GAP_US, &shortSampleNb, &shortSkippedNb);
+	TestIdleGap(bridge, TEST_LONG_GAP_US, &longSampleNb, &longSkippedNb);
+	printf("Traffic %d ms, %d us pauses: idle gap %d us %llu samples %llu skipped, "
+	       "idle gap %d us %llu samples %llu skipped\n", TEST_TRAFFIC_MS, TEST_PAUSE_US,
+	       TEST_SHORT_GAP_US, (unsigned long long)shortSampleNb, (unsigned long long)shortSkippedNb,
+	       TEST_LONG_GAP_US, (unsigned long long)longSampleNb, (unsigned long long)longSkippedNb);
+	BRG_TEST_CHECK(shortSampleNb >= TEST_TRAFFIC_MS / TEST_PERIOD_MS / 2);
+	BRG_TEST_CHECK(shortSkippedNb <= TEST_TRAFFIC_MS / TEST_PERIOD_MS / 4);
+	BRG_TEST_CHECK(longSkippedNb >= TEST_TRAFFIC_MS / (2 * TEST_PERIOD_MS) / 2);
+	BRG_TEST_CHECK(longSampleNb < shortSampleNb);
+	return BRG_TEST_RESULT();
+}
+
+/**********************************END OF FILE*********************************/